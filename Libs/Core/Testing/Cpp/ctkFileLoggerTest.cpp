@@ -1,8 +1,33 @@
+// Qt includes
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
 
 // CTK includes
 #include "ctkFileLogger.h"
 #include "ctkTest.h"
 
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+// ----------------------------------------------------------------------------
+QStringList readLines(const QString& filePath)
+{
+  QFile file(filePath);
+  if (!file.open(QFile::ReadOnly))
+  {
+    return QStringList();
+  }
+  return QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+}
+
+} // end of anonymous namespace
+
 // ----------------------------------------------------------------------------
 class ctkFileLoggerTester: public QObject
 {
@@ -12,12 +37,193 @@ public:
 private slots:
   void initTestCase();
 
+  void testDefaults();
+  void testSynchronous();
+  void testAsynchronous();
+  void testAsynchronousFlushInterval();
+  void testAsynchronousZeroFlushInterval();
+  void testAsynchronousFlushOnDestruction();
+  void testRotation();
+  void testRotation_data();
+  void testThroughput();
+
+private:
+  QTemporaryDir TemporaryDir;
 };
 
 // ----------------------------------------------------------------------------
 void ctkFileLoggerTester::initTestCase()
 {
+  QVERIFY(this->TemporaryDir.isValid());
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testDefaults()
+{
+  ctkFileLogger logger;
+  QCOMPARE(logger.enabled(), true);
+  QCOMPARE(logger.numberOfFilesToKeep(), 10);
+  QCOMPARE(logger.asynchronous(), false);
+  QCOMPARE(logger.flushInterval(), 1000);
+  QCOMPARE(logger.maximumBufferSize(), 65536);
+  QCOMPARE(logger.maximumFileSize(), qint64(0));
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testSynchronous()
+{
+  QString filePath = QDir(this->TemporaryDir.path()).filePath("synchronous.log");
+  ctkFileLogger logger;
+  logger.setFilePath(filePath);
+  logger.logMessage("message 1");
+  logger.logMessage("message 2");
+  QCOMPARE(readLines(filePath), QStringList() << "message 1" << "message 2");
+
+  logger.setEnabled(false);
+  logger.logMessage("message 3");
+  QCOMPARE(readLines(filePath).count(), 2);
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testAsynchronous()
+{
+  QString filePath = QDir(this->TemporaryDir.path()).filePath("asynchronous.log");
+  ctkFileLogger logger;
+  logger.setFilePath(filePath);
+  logger.setAsynchronous(true);
+  logger.setFlushInterval(60000);
+  QCOMPARE(logger.asynchronous(), true);
+
+  QStringList expectedLines;
+  for (int index = 0; index < 1000; ++index)
+  {
+    QString message = QString("message %1").arg(index);
+    logger.logMessage(message);
+    expectedLines << message;
+  }
+  logger.flush();
+  QCOMPARE(readLines(filePath), expectedLines);
+
+  // Pending messages are written in the previous file
+  QString otherFilePath = QDir(this->TemporaryDir.path()).filePath("asynchronous2.log");
+  logger.logMessage("last message");
+  logger.setFilePath(otherFilePath);
+  logger.logMessage("first message");
+  logger.flush();
+  QCOMPARE(readLines(filePath).last(), QString("last message"));
+  QCOMPARE(readLines(otherFilePath), QStringList() << "first message");
+
+  // Pending messages are written when switching back to synchronous mode
+  logger.logMessage("second message");
+  logger.setAsynchronous(false);
+  QCOMPARE(readLines(otherFilePath).count(), 2);
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testAsynchronousFlushInterval()
+{
+  QString filePath = QDir(this->TemporaryDir.path()).filePath("interval.log");
+  ctkFileLogger logger;
+  logger.setFilePath(filePath);
+  logger.setFlushInterval(50);
+  logger.setAsynchronous(true);
+  logger.logMessage("message");
+  QTRY_COMPARE(readLines(filePath).count(), 1);
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testAsynchronousZeroFlushInterval()
+{
+  QString filePath = QDir(this->TemporaryDir.path()).filePath("zerointerval.log");
+  ctkFileLogger logger;
+  logger.setFilePath(filePath);
+  logger.setFlushInterval(0);
+  logger.setAsynchronous(true);
+  logger.logMessage("message1");
+  QTRY_COMPARE(readLines(filePath).count(), 1);
+  logger.logMessage("message2");
+  QTRY_COMPARE(readLines(filePath), QStringList() << "message1" << "message2");
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testAsynchronousFlushOnDestruction()
+{
+  QString filePath = QDir(this->TemporaryDir.path()).filePath("destruction.log");
+  {
+    ctkFileLogger logger;
+    logger.setFilePath(filePath);
+    logger.setFlushInterval(60000);
+    logger.setAsynchronous(true);
+    logger.logMessage("message");
+  }
+  QCOMPARE(readLines(filePath), QStringList() << "message");
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testRotation()
+{
+  QFETCH(bool, asynchronous);
+  QString filePath = QDir(this->TemporaryDir.path()).filePath(
+    QString("rotation%1.log").arg(asynchronous));
+  ctkFileLogger logger;
+  logger.setFilePath(filePath);
+  logger.setMaximumFileSize(1000);
+  logger.setNumberOfFilesToKeep(3);
+  logger.setMaximumBufferSize(1);
+  logger.setAsynchronous(asynchronous);
+
+  QString message(99, 'x');
+  for (int index = 0; index < 100; ++index)
+  {
+    logger.logMessage(message);
+  }
+  logger.flush();
+
+  // Messages are written in batches, files are rotated before exceeding the maximum size
+  QVERIFY(QFileInfo(filePath).size() <= 1000);
+  QVERIFY(QFileInfo(filePath + ".1").size() > 0);
+  QVERIFY(QFileInfo(filePath + ".1").size() <= 1000);
+  QVERIFY(QFileInfo(filePath + ".2").size() > 0);
+  QVERIFY(QFileInfo(filePath + ".2").size() <= 1000);
+  QVERIFY(!QFile::exists(filePath + ".3"));
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testRotation_data()
+{
+  QTest::addColumn<bool>("asynchronous");
+  QTest::newRow("synchronous") << false;
+  QTest::newRow("asynchronous") << true;
+}
+
+// ----------------------------------------------------------------------------
+void ctkFileLoggerTester::testThroughput()
+{
+  const int numberOfMessages = 20000;
+  QString message = QString("2024-01-01 00:00:00.000 INFO: ctkDICOMQueryJob: query job %1 running");
+  qint64 elapsed[2];
+  for (int asynchronous = 0; asynchronous < 2; ++asynchronous)
+  {
+    QString filePath = QDir(this->TemporaryDir.path()).filePath(
+      QString("throughput%1.log").arg(asynchronous));
+    ctkFileLogger logger;
+    logger.setFilePath(filePath);
+    logger.setAsynchronous(asynchronous);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int index = 0; index < numberOfMessages; ++index)
+    {
+      logger.logMessage(message.arg(index));
+    }
+    logger.flush();
+    elapsed[asynchronous] = qMax<qint64>(timer.elapsed(), 1);
+    QCOMPARE(readLines(filePath).count(), numberOfMessages);
+  }
 
+  std::cout << numberOfMessages << " messages: "
+            << numberOfMessages * 1000 / elapsed[0] << " messages/s synchronous, "
+            << numberOfMessages * 1000 / elapsed[1] << " messages/s asynchronous" << std::endl;
 }
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,388 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+
+// CTK includes
+#include <ctkAbstractJob.h>
+#include <ctkAbstractWorker.h>
+#include <ctkCoreTestingMacros.h>
+#include <ctkJobScheduler.h>
+
+// STL includes
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+QMutex StartedJobsMutex;
+QList<QThread::Priority> StartedJobPriorities;
+QStringList StartedJobClasses;
+QAtomicInt FinishedJobsCount;
+/// Blocking jobs are running until the gate is opened (set to non-zero)
+QAtomicInt BlockingJobsGate;
+
+// ----------------------------------------------------------------------------
+class ctkJobSchedulerTestWorker : public ctkAbstractWorker
+{
+  Q_OBJECT
+public:
+  ctkJobSchedulerTestWorker(bool blocking)
+    : Blocking(blocking)
+  {
+  }
+
+  void run() override
+  {
+    QSharedPointer<ctkAbstractJob> job = this->Job;
+    job->setStatus(ctkAbstractJob::JobStatus::Running);
+    {
+      QMutexLocker locker(&StartedJobsMutex);
+      StartedJobPriorities.append(job->priority());
+      StartedJobClasses.append(job->className());
+    }
+    while (this->Blocking && BlockingJobsGate.loadAcquire() == 0)
+    {
+      QThread::msleep(1);
+    }
+    FinishedJobsCount.fetchAndAddOrdered(1);
+    job->setStatus(ctkAbstractJob::JobStatus::Finished);
+  }
+
+  void requestCancel() override
+  {
+  }
+
+  bool Blocking;
+};
+
+// ----------------------------------------------------------------------------
+class ctkJobSchedulerTestJob : public ctkAbstractJob
+{
+  Q_OBJECT
+public:
+  ctkJobSchedulerTestJob(QThread::Priority priority, int maximumConcurrentJobs, bool blocking = false)
+    : Blocking(blocking)
+  {
+    this->setPriority(priority);
+    this->setMaximumConcurrentJobsPerType(maximumConcurrentJobs);
+    this->setDestroyAfterUse(true);
+  }
+
+  ctkAbstractWorker* createWorker() override
+  {
+    ctkJobSchedulerTestWorker* worker = new ctkJobSchedulerTestWorker(this->Blocking);
+    worker->setJob(*this);
+    return worker;
+  }
+
+  ctkAbstractJob* clone() const override
+  {
+    return new ctkJobSchedulerTestJob(this->priority(), this->maximumConcurrentJobsPerType(), this->Blocking);
+  }
+
+  QString loggerReport(const QString& status) override
+  {
+    return QString("Test job %1 %2").arg(this->jobUID(), status);
+  }
+
+  void releaseResources() override
+  {
+  }
+
+  bool Blocking;
+};
+
+// ----------------------------------------------------------------------------
+/// Job of another class, for testing scheduling of different job types
+class ctkJobSchedulerOtherTestJob : public ctkJobSchedulerTestJob
+{
+  Q_OBJECT
+public:
+  ctkJobSchedulerOtherTestJob(QThread::Priority priority, int maximumConcurrentJobs, bool blocking = false)
+    : ctkJobSchedulerTestJob(priority, maximumConcurrentJobs, blocking)
+  {
+  }
+
+  ctkAbstractJob* clone() const override
+  {
+    return new ctkJobSchedulerOtherTestJob(this->priority(), this->maximumConcurrentJobsPerType(), this->Blocking);
+  }
+};
+
+// ----------------------------------------------------------------------------
+/// Job of a third class, for testing job class weights
+class ctkJobSchedulerThirdTestJob : public ctkJobSchedulerTestJob
+{
+  Q_OBJECT
+public:
+  ctkJobSchedulerThirdTestJob(QThread::Priority priority, int maximumConcurrentJobs, bool blocking = false)
+    : ctkJobSchedulerTestJob(priority, maximumConcurrentJobs, blocking)
+  {
+  }
+
+  ctkAbstractJob* clone() const override
+  {
+    return new ctkJobSchedulerThirdTestJob(this->priority(), this->maximumConcurrentJobsPerType(), this->Blocking);
+  }
+};
+
+// ----------------------------------------------------------------------------
+int numberOfStartedJobs(const QString& jobClass)
+{
+  QMutexLocker locker(&StartedJobsMutex);
+  return StartedJobClasses.count(jobClass);
+}
+
+// ----------------------------------------------------------------------------
+/// Process events for the specified time or until the expected number of jobs of the class is started
+bool waitForStartedJobs(const QString& jobClass, int expectedNumberOfStartedJobs, int timeoutMsec = 600000)
+{
+  QElapsedTimer timer;
+  timer.start();
+  while (numberOfStartedJobs(jobClass) < expectedNumberOfStartedJobs)
+  {
+    QCoreApplication::processEvents();
+    if (timer.elapsed() > timeoutMsec)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+bool waitForFinishedJobs(ctkJobScheduler& scheduler, int numberOfJobs)
+{
+  QElapsedTimer timer;
+  timer.start();
+  while (FinishedJobsCount.loadAcquire() < numberOfJobs)
+  {
+    QCoreApplication::processEvents();
+    if (timer.elapsed() > 600000)
+    {
+      std::cerr << "Timeout: " << FinishedJobsCount.loadAcquire() << " of "
+                << numberOfJobs << " jobs finished" << std::endl;
+      return false;
+    }
+  }
+  // Let the scheduler process the finished signals of the last jobs
+  while (scheduler.numberOfJobs() > 0 && timer.elapsed() < 600000)
+  {
+    QCoreApplication::processEvents();
+  }
+  return scheduler.numberOfJobs() == 0;
+}
+
+// ----------------------------------------------------------------------------
+void resetCounters()
+{
+  QMutexLocker locker(&StartedJobsMutex);
+  StartedJobPriorities.clear();
+  StartedJobClasses.clear();
+  FinishedJobsCount.storeRelease(0);
+  BlockingJobsGate.storeRelease(0);
+}
+
+} // end of anonymous namespace
+
+// ----------------------------------------------------------------------------
+int ctkJobSchedulerTest1(int argc, char * argv [])
+{
+  QCoreApplication app(argc, argv);
+
+  // Number of jobs of the benchmark can be specified in the command-line,
+  // the default is kept small for the regular test runs
+  int numberOfJobs = (argc > 1 ? QString(argv[1]).toInt() : 1000);
+
+  ctkJobScheduler scheduler;
+
+  // Jobs waiting for a worker are started in order of priority
+  {
+    resetCounters();
+    const int numberOfJobsPerPriority = 100;
+    // The first job is started immediately, all others are waiting since
+    // only one job of this type may run at a time
+    for (int i = 0; i < numberOfJobsPerPriority + 1; ++i)
+    {
+      scheduler.addJob(new ctkJobSchedulerTestJob(QThread::LowPriority, 1));
+    }
+    for (int i = 0; i < numberOfJobsPerPriority; ++i)
+    {
+      scheduler.addJob(new ctkJobSchedulerTestJob(QThread::HighestPriority, 1));
+    }
+    CHECK_BOOL(waitForFinishedJobs(scheduler, 2 * numberOfJobsPerPriority + 1), true);
+    CHECK_INT(StartedJobPriorities.count(), 2 * numberOfJobsPerPriority + 1);
+    for (int i = 1; i < StartedJobPriorities.count(); ++i)
+    {
+      CHECK_INT(StartedJobPriorities[i],
+        i <= numberOfJobsPerPriority ? QThread::HighestPriority : QThread::LowPriority);
+    }
+  }
+
+  // Raising the priority of a waiting job moves it ahead of the other waiting jobs
+  {
+    resetCounters();
+    scheduler.addJob(new ctkJobSchedulerTestJob(QThread::NormalPriority, 1, true));
+    QList<ctkAbstractJob*> waitingJobs;
+    for (int i = 0; i < 3; ++i)
+    {
+      ctkAbstractJob* job = new ctkJobSchedulerTestJob(QThread::LowPriority, 1);
+      scheduler.addJob(job);
+      waitingJobs << job;
+    }
+    CHECK_BOOL(waitForStartedJobs("ctkJobSchedulerTestJob", 1), true);
+    scheduler.setJobPriority(waitingJobs.last()->jobUID(), QThread::HighestPriority);
+
+    BlockingJobsGate.storeRelease(1);
+    CHECK_BOOL(waitForFinishedJobs(scheduler, 4), true);
+    CHECK_INT(StartedJobPriorities.count(), 4);
+    CHECK_INT(StartedJobPriorities[0], QThread::NormalPriority);
+    CHECK_INT(StartedJobPriorities[1], QThread::HighestPriority);
+    CHECK_INT(StartedJobPriorities[2], QThread::LowPriority);
+    CHECK_INT(StartedJobPriorities[3], QThread::LowPriority);
+  }
+
+  // A job class that reached its maximum number of concurrent jobs blocks
+  // lower priority jobs of other classes, unless fair scheduling is enabled
+  {
+    resetCounters();
+    const QString blockingJobClass("ctkJobSchedulerTestJob");
+    const QString otherJobClass("ctkJobSchedulerOtherTestJob");
+    CHECK_BOOL(scheduler.fairScheduling(), false);
+    for (int i = 0; i < 3; ++i)
+    {
+      scheduler.addJob(new ctkJobSchedulerTestJob(QThread::HighestPriority, 1, true));
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+      scheduler.addJob(new ctkJobSchedulerOtherTestJob(QThread::LowPriority, 4));
+    }
+    CHECK_BOOL(waitForStartedJobs(blockingJobClass, 1), true);
+    CHECK_BOOL(waitForStartedJobs(otherJobClass, 1, 200), false);
+
+    scheduler.setFairScheduling(true);
+    CHECK_BOOL(waitForStartedJobs(otherJobClass, 10), true);
+    CHECK_INT(numberOfStartedJobs(blockingJobClass), 1);
+
+    BlockingJobsGate.storeRelease(1);
+    CHECK_BOOL(waitForFinishedJobs(scheduler, 13), true);
+  }
+
+  // Job class quota overrides maximumConcurrentJobsPerType of the jobs
+  {
+    resetCounters();
+    const QString jobClass("ctkJobSchedulerOtherTestJob");
+    scheduler.setJobClassQuota(jobClass, 2);
+    CHECK_INT(scheduler.jobClassQuota(jobClass), 2);
+    for (int i = 0; i < 5; ++i)
+    {
+      scheduler.addJob(new ctkJobSchedulerOtherTestJob(QThread::NormalPriority, 4, true));
+    }
+    CHECK_BOOL(waitForStartedJobs(jobClass, 2), true);
+    CHECK_BOOL(waitForStartedJobs(jobClass, 3, 200), false);
+
+    scheduler.setJobClassQuota(jobClass, 0);
+    CHECK_INT(scheduler.jobClassQuota(jobClass), 0);
+    CHECK_BOOL(waitForStartedJobs(jobClass, 4), true);
+    CHECK_BOOL(waitForStartedJobs(jobClass, 5, 200), false);
+
+    BlockingJobsGate.storeRelease(1);
+    CHECK_BOOL(waitForFinishedJobs(scheduler, 5), true);
+  }
+
+  // Job class weights: classes of the same priority take turns, a class
+  // starting as many jobs as its weight in each turn
+  {
+    resetCounters();
+    const QString heavyJobClass("ctkJobSchedulerOtherTestJob");
+    const QString defaultJobClass("ctkJobSchedulerThirdTestJob");
+    CHECK_INT(scheduler.jobClassWeight(heavyJobClass), 1);
+    scheduler.setJobClassWeight(heavyJobClass, 3);
+    CHECK_INT(scheduler.jobClassWeight(heavyJobClass), 3);
+
+    // A single thread runs the workers in the order they are started
+    int maximumThreadCount = scheduler.maximumThreadCount();
+    scheduler.setMaximumThreadCount(1);
+
+    // Without fair scheduling, a saturated high priority class holds back
+    // the other jobs, so that they are all dispatched in a single pass
+    // once fair scheduling is enabled
+    scheduler.setFairScheduling(false);
+    scheduler.addJob(new ctkJobSchedulerTestJob(QThread::HighestPriority, 1, true));
+    CHECK_BOOL(waitForStartedJobs("ctkJobSchedulerTestJob", 1), true);
+    scheduler.addJob(new ctkJobSchedulerTestJob(QThread::HighestPriority, 1));
+    for (int i = 0; i < 6; ++i)
+    {
+      scheduler.addJob(new ctkJobSchedulerOtherTestJob(QThread::NormalPriority, 100));
+      scheduler.addJob(new ctkJobSchedulerThirdTestJob(QThread::NormalPriority, 100));
+    }
+    scheduler.setFairScheduling(true);
+
+    BlockingJobsGate.storeRelease(1);
+    CHECK_BOOL(waitForFinishedJobs(scheduler, 14), true);
+    scheduler.setMaximumThreadCount(maximumThreadCount);
+    scheduler.setJobClassWeight(heavyJobClass, 1);
+
+    QStringList weightedJobClasses;
+    foreach (const QString& jobClass, StartedJobClasses)
+    {
+      if (jobClass == heavyJobClass || jobClass == defaultJobClass)
+      {
+        weightedJobClasses << jobClass;
+      }
+    }
+    QStringList expectedJobClasses;
+    expectedJobClasses << heavyJobClass << heavyJobClass << heavyJobClass << defaultJobClass
+                       << heavyJobClass << heavyJobClass << heavyJobClass << defaultJobClass
+                       << defaultJobClass << defaultJobClass << defaultJobClass << defaultJobClass;
+    CHECK_QSTRINGLIST(weightedJobClasses, expectedJobClasses);
+  }
+
+  // Scheduling benchmark
+  {
+    resetCounters();
+    QList<QThread::Priority> priorities;
+    priorities << QThread::LowestPriority << QThread::LowPriority << QThread::NormalPriority
+               << QThread::HighPriority << QThread::HighestPriority;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < numberOfJobs; ++i)
+    {
+      scheduler.addJob(new ctkJobSchedulerTestJob(priorities[i % priorities.count()], 4));
+    }
+    qint64 addJobsElapsedMsec = timer.elapsed();
+    CHECK_BOOL(waitForFinishedJobs(scheduler, numberOfJobs), true);
+    qint64 totalElapsedMsec = timer.elapsed();
+    std::cout << "Added " << numberOfJobs << " jobs in " << addJobsElapsedMsec << "ms, "
+              << "all jobs finished in " << totalElapsedMsec << "ms" << std::endl;
+    CHECK_INT(FinishedJobsCount.loadAcquire(), numberOfJobs);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+#include "ctkJobSchedulerTest1.moc"
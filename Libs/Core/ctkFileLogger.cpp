@@ -19,13 +19,63 @@
 =========================================================================*/
 
 // Qt includes
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
+#include <QMutex>
 #include <QTextStream>
+#include <QThread>
+#include <QWaitCondition>
 
 // CTK includes
 #include "ctkFileLogger.h"
 #include "ctkUtils.h"
 
+// --------------------------------------------------------------------------
+// ctkFileLoggerWriter
+
+// --------------------------------------------------------------------------
+/// Write the messages appended by the logger into the log file in a
+/// background thread. The file is kept open between batches.
+class ctkFileLoggerWriter : public QThread
+{
+public:
+  ctkFileLoggerWriter();
+  ~ctkFileLoggerWriter() override;
+
+  void appendMessage(const QString& msg);
+  /// Wait until the messages appended before the call are written.
+  void flush();
+  /// Write the pending messages and stop the thread.
+  void stop();
+
+  void setFilePath(const QString& filePath);
+  void setNumberOfFilesToKeep(int value);
+  void setFlushInterval(int msecs);
+  void setMaximumBufferSize(int bytes);
+  void setMaximumFileSize(qint64 bytes);
+
+protected:
+  void run() override;
+
+  QMutex Mutex;
+  QWaitCondition MessagesAvailable;
+  QWaitCondition MessagesWritten;
+
+  // Members protected by Mutex
+  QStringList Messages;
+  int PendingBytes{0};
+  quint64 AppendedBatches{0};
+  quint64 WrittenBatches{0};
+  bool FlushRequested{false};
+  bool StopRequested{false};
+  QString FilePath;
+  int NumberOfFilesToKeep{10};
+  int FlushInterval{1000};
+  int MaximumBufferSize{65536};
+  qint64 MaximumFileSize{0};
+};
+
 // --------------------------------------------------------------------------
 // ctkFileLoggerPrivate
 
@@ -41,17 +91,182 @@ public:
 
   void init();
 
+  /// Rename \a filePath to \a filePath.1, \a filePath.1 to \a filePath.2, ...
+  /// keeping at most \a numberOfFilesToKeep files.
+  static void rotateFiles(const QString& filePath, int numberOfFilesToKeep);
+  /// Append \a data to \a filePath, opening \a file if needed.
+  static void appendData(QFile& file, const QString& filePath, const QByteArray& data);
+  /// Append \a messages to \a filePath, opening \a file if needed.
+  /// The files are rotated before a message would make the log file exceed
+  /// \a maximumFileSize.
+  static void writeMessages(QFile& file, const QString& filePath, const QStringList& messages,
+                            qint64 maximumFileSize, int numberOfFilesToKeep);
+
   bool Enabled;
   QString FilePath;
   int NumberOfFilesToKeep;
+  int FlushInterval;
+  int MaximumBufferSize;
+  qint64 MaximumFileSize;
+  QScopedPointer<ctkFileLoggerWriter> Writer;
 };
 
+// --------------------------------------------------------------------------
+ctkFileLoggerWriter::ctkFileLoggerWriter() = default;
+
+// --------------------------------------------------------------------------
+ctkFileLoggerWriter::~ctkFileLoggerWriter()
+{
+  this->stop();
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::appendMessage(const QString& msg)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->Messages.append(msg);
+  this->PendingBytes += msg.size() + 1;
+  // The writer waits for the first message before counting the flush interval
+  if (this->Messages.size() == 1 || this->FlushInterval <= 0
+      || this->PendingBytes >= this->MaximumBufferSize)
+  {
+    this->MessagesAvailable.wakeOne();
+  }
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::flush()
+{
+  QMutexLocker locker(&this->Mutex);
+  if (!this->isRunning())
+  {
+    return;
+  }
+  quint64 batch = ++this->AppendedBatches;
+  this->FlushRequested = true;
+  this->MessagesAvailable.wakeOne();
+  while (this->WrittenBatches < batch && this->isRunning())
+  {
+    this->MessagesWritten.wait(&this->Mutex, 100);
+  }
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::stop()
+{
+  {
+    QMutexLocker locker(&this->Mutex);
+    this->StopRequested = true;
+    this->MessagesAvailable.wakeOne();
+  }
+  this->wait();
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::setFilePath(const QString& filePath)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->FilePath = filePath;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::setNumberOfFilesToKeep(int value)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->NumberOfFilesToKeep = value;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::setFlushInterval(int msecs)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->FlushInterval = msecs;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::setMaximumBufferSize(int bytes)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->MaximumBufferSize = bytes;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::setMaximumFileSize(qint64 bytes)
+{
+  QMutexLocker locker(&this->Mutex);
+  this->MaximumFileSize = bytes;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerWriter::run()
+{
+  QFile file;
+  QElapsedTimer sinceLastWrite;
+  sinceLastWrite.start();
+
+  QMutexLocker locker(&this->Mutex);
+  while (true)
+  {
+    bool stop = this->StopRequested;
+    if (!stop && !this->FlushRequested)
+    {
+      if (this->Messages.isEmpty())
+      {
+        // Nothing to write until a message is logged
+        this->MessagesAvailable.wait(&this->Mutex);
+        sinceLastWrite.restart();
+        continue;
+      }
+      // A flush interval of 0 writes the messages immediately
+      qint64 remaining = this->FlushInterval - sinceLastWrite.elapsed();
+      if (remaining > 0 && this->PendingBytes < this->MaximumBufferSize)
+      {
+        this->MessagesAvailable.wait(&this->Mutex, static_cast<unsigned long>(remaining));
+        continue;
+      }
+    }
+
+    // Take the pending messages, the logger keeps appending while they are written
+    QStringList messages;
+    messages.swap(this->Messages);
+    this->PendingBytes = 0;
+    this->FlushRequested = false;
+    quint64 batch = this->AppendedBatches;
+    QString filePath = this->FilePath;
+    qint64 maximumFileSize = this->MaximumFileSize;
+    int numberOfFilesToKeep = this->NumberOfFilesToKeep;
+
+    locker.unlock();
+    if (file.isOpen() && file.fileName() != filePath)
+    {
+      file.close();
+    }
+    if (!messages.isEmpty())
+    {
+      ctkFileLoggerPrivate::writeMessages(file, filePath, messages, maximumFileSize, numberOfFilesToKeep);
+    }
+    sinceLastWrite.restart();
+    locker.relock();
+
+    this->WrittenBatches = batch;
+    this->MessagesWritten.wakeAll();
+    if (stop && this->Messages.isEmpty())
+    {
+      break;
+    }
+  }
+  file.close();
+}
+
 // --------------------------------------------------------------------------
 ctkFileLoggerPrivate::ctkFileLoggerPrivate(ctkFileLogger& object)
   : q_ptr(&object)
 {
   this->Enabled = true;
   this->NumberOfFilesToKeep = 10;
+  this->FlushInterval = 1000;
+  this->MaximumBufferSize = 65536;
+  this->MaximumFileSize = 0;
 }
 
 // --------------------------------------------------------------------------
@@ -64,6 +279,75 @@ void ctkFileLoggerPrivate::init()
 {
 }
 
+// --------------------------------------------------------------------------
+void ctkFileLoggerPrivate::rotateFiles(const QString& filePath, int numberOfFilesToKeep)
+{
+  if (numberOfFilesToKeep <= 1)
+  {
+    QFile::remove(filePath);
+    return;
+  }
+  QFile::remove(QString("%1.%2").arg(filePath).arg(numberOfFilesToKeep - 1));
+  for (int index = numberOfFilesToKeep - 2; index >= 1; --index)
+  {
+    QFile::rename(QString("%1.%2").arg(filePath).arg(index),
+                  QString("%1.%2").arg(filePath).arg(index + 1));
+  }
+  QFile::rename(filePath, filePath + ".1");
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerPrivate::appendData(QFile& file, const QString& filePath, const QByteArray& data)
+{
+  if (data.isEmpty())
+  {
+    return;
+  }
+  if (!file.isOpen())
+  {
+    file.setFileName(filePath);
+    if (!file.open(QFile::Append))
+    {
+      return;
+    }
+  }
+  file.write(data);
+  file.flush();
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLoggerPrivate::writeMessages(QFile& file, const QString& filePath, const QStringList& messages,
+                                         qint64 maximumFileSize, int numberOfFilesToKeep)
+{
+  if (filePath.isEmpty())
+  {
+    return;
+  }
+  qint64 fileSize = 0;
+  if (maximumFileSize > 0)
+  {
+    fileSize = file.isOpen() ? file.size() : QFileInfo(filePath).size();
+  }
+  QByteArray data;
+  for (const QString& msg : messages)
+  {
+    QByteArray line = msg.toUtf8();
+    line += '\n';
+    // A batch may hold many messages, the size is checked for each of them
+    if (maximumFileSize > 0 && fileSize > 0 && fileSize + line.size() > maximumFileSize)
+    {
+      ctkFileLoggerPrivate::appendData(file, filePath, data);
+      data.clear();
+      file.close();
+      ctkFileLoggerPrivate::rotateFiles(filePath, numberOfFilesToKeep);
+      fileSize = 0;
+    }
+    data += line;
+    fileSize += line.size();
+  }
+  ctkFileLoggerPrivate::appendData(file, filePath, data);
+}
+
 // --------------------------------------------------------------------------
 // ctkFileLogger
 
@@ -79,6 +363,8 @@ ctkFileLogger::ctkFileLogger(QObject* parentObject)
 // --------------------------------------------------------------------------
 ctkFileLogger::~ctkFileLogger()
 {
+  // The writer writes the pending messages before stopping
+  this->setAsynchronous(false);
 }
 
 // --------------------------------------------------------------------------
@@ -106,6 +392,12 @@ QString ctkFileLogger::filePath()const
 void ctkFileLogger::setFilePath(const QString& filePath)
 {
   Q_D(ctkFileLogger);
+  if (d->Writer)
+  {
+    // Pending messages are written in the previous file
+    d->Writer->flush();
+    d->Writer->setFilePath(filePath);
+  }
   d->FilePath = filePath;
 }
 
@@ -121,6 +413,94 @@ void ctkFileLogger::setNumberOfFilesToKeep(int value)
 {
   Q_D(ctkFileLogger);
   d->NumberOfFilesToKeep = value;
+  if (d->Writer)
+  {
+    d->Writer->setNumberOfFilesToKeep(value);
+  }
+}
+
+// --------------------------------------------------------------------------
+bool ctkFileLogger::asynchronous()const
+{
+  Q_D(const ctkFileLogger);
+  return !d->Writer.isNull();
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLogger::setAsynchronous(bool value)
+{
+  Q_D(ctkFileLogger);
+  if (value == this->asynchronous())
+  {
+    return;
+  }
+  if (!value)
+  {
+    d->Writer->stop();
+    d->Writer.reset();
+    return;
+  }
+  d->Writer.reset(new ctkFileLoggerWriter);
+  d->Writer->setFilePath(d->FilePath);
+  d->Writer->setNumberOfFilesToKeep(d->NumberOfFilesToKeep);
+  d->Writer->setFlushInterval(d->FlushInterval);
+  d->Writer->setMaximumBufferSize(d->MaximumBufferSize);
+  d->Writer->setMaximumFileSize(d->MaximumFileSize);
+  d->Writer->start(QThread::LowPriority);
+}
+
+// --------------------------------------------------------------------------
+int ctkFileLogger::flushInterval()const
+{
+  Q_D(const ctkFileLogger);
+  return d->FlushInterval;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLogger::setFlushInterval(int msecs)
+{
+  Q_D(ctkFileLogger);
+  d->FlushInterval = msecs;
+  if (d->Writer)
+  {
+    d->Writer->setFlushInterval(msecs);
+  }
+}
+
+// --------------------------------------------------------------------------
+int ctkFileLogger::maximumBufferSize()const
+{
+  Q_D(const ctkFileLogger);
+  return d->MaximumBufferSize;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLogger::setMaximumBufferSize(int bytes)
+{
+  Q_D(ctkFileLogger);
+  d->MaximumBufferSize = bytes;
+  if (d->Writer)
+  {
+    d->Writer->setMaximumBufferSize(bytes);
+  }
+}
+
+// --------------------------------------------------------------------------
+qint64 ctkFileLogger::maximumFileSize()const
+{
+  Q_D(const ctkFileLogger);
+  return d->MaximumFileSize;
+}
+
+// --------------------------------------------------------------------------
+void ctkFileLogger::setMaximumFileSize(qint64 bytes)
+{
+  Q_D(ctkFileLogger);
+  d->MaximumFileSize = bytes;
+  if (d->Writer)
+  {
+    d->Writer->setMaximumFileSize(bytes);
+  }
 }
 
 // --------------------------------------------------------------------------
@@ -131,6 +511,18 @@ void ctkFileLogger::logMessage(const QString& msg)
   {
     return;
   }
+  if (d->Writer)
+  {
+    d->Writer->appendMessage(msg);
+    return;
+  }
+  if (d->MaximumFileSize > 0)
+  {
+    QFile file;
+    ctkFileLoggerPrivate::writeMessages(file, d->FilePath, QStringList() << msg,
+                                        d->MaximumFileSize, d->NumberOfFilesToKeep);
+    return;
+  }
   QFile f(d->FilePath);
   if (!f.open(QFile::Append))
   {
@@ -140,3 +532,13 @@ void ctkFileLogger::logMessage(const QString& msg)
   s << msg << ctk::endl;
   f.close();
 }
+
+// --------------------------------------------------------------------------
+void ctkFileLogger::flush()
+{
+  Q_D(ctkFileLogger);
+  if (d->Writer)
+  {
+    d->Writer->flush();
+  }
+}
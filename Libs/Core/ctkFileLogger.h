@@ -32,11 +32,29 @@ class ctkFileLoggerPrivate;
 
 //------------------------------------------------------------------------------
 /// \ingroup Core
+///
+/// Append the logged messages to a text file.
+///
+/// By default each message is written synchronously: the file is opened, the
+/// message is appended and the file is closed. In asynchronous mode, messages are
+/// queued and written by a background thread that keeps the file open and writes
+/// them in batches, when flushInterval has elapsed or when maximumBufferSize bytes
+/// are pending. Pending messages are written by flush(), when the file path
+/// changes, and when the logger is destroyed.
+///
+/// If maximumFileSize is set, the log file is rotated before it exceeds that size:
+/// \a filePath is renamed to \a filePath.1, \a filePath.1 to \a filePath.2, ...
+/// and only numberOfFilesToKeep files (including the current one) are kept.
 class CTK_CORE_EXPORT ctkFileLogger : public QObject
 {
   Q_OBJECT
   Q_PROPERTY(bool enabled READ enabled WRITE setEnabled)
   Q_PROPERTY(QString filePath READ filePath WRITE setFilePath)
+  Q_PROPERTY(int numberOfFilesToKeep READ numberOfFilesToKeep WRITE setNumberOfFilesToKeep)
+  Q_PROPERTY(bool asynchronous READ asynchronous WRITE setAsynchronous)
+  Q_PROPERTY(int flushInterval READ flushInterval WRITE setFlushInterval)
+  Q_PROPERTY(int maximumBufferSize READ maximumBufferSize WRITE setMaximumBufferSize)
+  Q_PROPERTY(qint64 maximumFileSize READ maximumFileSize WRITE setMaximumFileSize)
 
 public:
   typedef QObject Superclass;
@@ -53,9 +71,33 @@ public:
   int numberOfFilesToKeep()const;
   void setNumberOfFilesToKeep(int value);
 
+  /// Write the messages in a background thread.
+  /// False by default.
+  bool asynchronous()const;
+  void setAsynchronous(bool value);
+
+  /// Maximum time in milliseconds a message waits in asynchronous mode
+  /// before being written, 0 to write each message as soon as it is logged.
+  /// 1000 by default.
+  int flushInterval()const;
+  void setFlushInterval(int msecs);
+
+  /// Number of pending bytes that triggers a write in asynchronous mode.
+  /// 65536 by default.
+  int maximumBufferSize()const;
+  void setMaximumBufferSize(int bytes);
+
+  /// Size in bytes above which the log file is rotated.
+  /// 0 (no rotation) by default.
+  qint64 maximumFileSize()const;
+  void setMaximumFileSize(qint64 bytes);
+
 public Q_SLOTS:
   void logMessage(const QString& msg);
 
+  /// Write the pending messages and wait until they are written.
+  void flush();
+
 protected:
   QScopedPointer<ctkFileLoggerPrivate> d_ptr;
 
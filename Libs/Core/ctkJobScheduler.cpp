@@ -67,7 +67,6 @@ void ctkJobSchedulerPrivate::init()
 //------------------------------------------------------------------------------
 void ctkJobSchedulerPrivate::queueJobsInThreadPool()
 {
-  Q_Q(ctkJobScheduler);
   // NOTE: No need to queue jobs with a signal/slot mechanism, since the mutex makes
   // sure that concurrent threads append/clean/delete the jobs map.
 
@@ -80,55 +79,149 @@ void ctkJobSchedulerPrivate::queueJobsInThreadPool()
     // The QWriteLocker is enclosed within brackets to restrict its scope and
     // prevent conflicts with other QWriteLockers within the scheduler's methods.
     QWriteLocker locker(&this->QueueLock);
-    foreach (QThread::Priority priority, (QList<QThread::Priority>()
-                                          << QThread::Priority::HighestPriority
-                                          << QThread::Priority::HighPriority
-                                          << QThread::Priority::NormalPriority
-                                          << QThread::Priority::LowPriority
-                                          << QThread::Priority::LowestPriority))
+    this->dispatchReadyJobs();
+  }
+}
+
+//------------------------------------------------------------------------------
+QThread::Priority ctkJobSchedulerPrivate::readyQueuePriority(QThread::Priority priority)
+{
+  if (priority == QThread::Priority::InheritPriority)
+  {
+    return QThread::Priority::NormalPriority;
+  }
+  return priority;
+}
+
+//------------------------------------------------------------------------------
+void ctkJobSchedulerPrivate::enqueueReadyJob(QSharedPointer<ctkAbstractJob> job)
+{
+  QThread::Priority priority = this->readyQueuePriority(job->priority());
+  this->ReadyJobsQueues[priority][job->className()].append(job->jobUID());
+}
+
+//------------------------------------------------------------------------------
+void ctkJobSchedulerPrivate::setJobPriority(QSharedPointer<ctkAbstractJob> job, QThread::Priority priority)
+{
+  QThread::Priority oldPriority = this->readyQueuePriority(job->priority());
+  job->setPriority(priority);
+  if (job->status() != ctkAbstractJob::JobStatus::Initialized ||
+      this->readyQueuePriority(priority) == oldPriority)
+  {
+    return;
+  }
+
+  // Move the waiting job to the ready queue of its new priority
+  QMap<QThread::Priority, QMap<QString, QList<QString>>>::iterator priorityIt =
+    this->ReadyJobsQueues.find(oldPriority);
+  if (priorityIt == this->ReadyJobsQueues.end())
+  {
+    return;
+  }
+  QMap<QString, QList<QString>>::iterator jobClassIt = priorityIt.value().find(job->className());
+  if (jobClassIt == priorityIt.value().end() || jobClassIt.value().removeAll(job->jobUID()) == 0)
+  {
+    return;
+  }
+  if (jobClassIt.value().isEmpty())
+  {
+    priorityIt.value().erase(jobClassIt);
+  }
+  if (priorityIt.value().isEmpty())
+  {
+    this->ReadyJobsQueues.erase(priorityIt);
+  }
+  this->enqueueReadyJob(job);
+}
+
+//------------------------------------------------------------------------------
+void ctkJobSchedulerPrivate::dispatchReadyJobs()
+{
+  // Ready queues are sorted by increasing priority
+  QMap<QThread::Priority, QMap<QString, QList<QString>>>::iterator priorityIt = this->ReadyJobsQueues.end();
+  while (priorityIt != this->ReadyJobsQueues.begin())
+  {
+    --priorityIt;
+    QMap<QString, QList<QString>>& readyJobsByClass = priorityIt.value();
+
+    // Job classes take turns until no more jobs can be started at this priority
+    bool jobStarted = true;
+    while (jobStarted)
     {
-      foreach (QSharedPointer<ctkAbstractJob> job, this->JobsQueue)
+      jobStarted = false;
+      QMap<QString, QList<QString>>::iterator jobClassIt = readyJobsByClass.begin();
+      while (jobClassIt != readyJobsByClass.end())
       {
-        if (this->FreezeJobsScheduling)
+        QList<QString>& readyJobUIDs = jobClassIt.value();
+        int weight = qMax(1, this->JobClassWeights.value(jobClassIt.key(), 1));
+        int numberOfStartedJobs = 0;
+        while (numberOfStartedJobs < weight && !readyJobUIDs.isEmpty())
         {
-          return;
+          if (this->FreezeJobsScheduling)
+          {
+            return;
+          }
+
+          QString jobUID = readyJobUIDs.takeFirst();
+          QSharedPointer<ctkAbstractJob> job = this->JobsQueue.value(jobUID);
+          if (!job || job->status() != ctkAbstractJob::JobStatus::Initialized)
+          {
+            // removed, stopped, or already started job
+            continue;
+          }
+
+          int numberOfRunningJobsWithSameType = this->getSameTypeJobsInThreadPoolQueueOrRunning(job);
+          if (numberOfRunningJobsWithSameType >= this->getMaximumConcurrentJobsOfSameType(job))
+          {
+            readyJobUIDs.prepend(jobUID);
+            if (!this->FairScheduling)
+            {
+              // When the maximum number of concurrent jobs of the same type is reached,
+              // return early instead of adding more jobs to an already crowded queue.
+              // This allows the scheduler time to finish the currently running jobs,
+              // preventing a jobs traffic jam.
+              return;
+            }
+            // Skip this job class, other classes may still start jobs
+            break;
+          }
+
+          this->startWorker(job);
+          numberOfStartedJobs++;
+          jobStarted = true;
         }
 
-        if (job->priority() != priority)
+        if (readyJobUIDs.isEmpty())
         {
-          continue;
+          jobClassIt = readyJobsByClass.erase(jobClassIt);
         }
-
-        if (job->status() != ctkAbstractJob::JobStatus::Initialized)
+        else
         {
-          continue;
+          ++jobClassIt;
         }
+      }
+    }
+  }
+}
 
-        int numberOfRunningJobsWithSameType = this->getSameTypeJobsInThreadPoolQueueOrRunning(job);
-        if (numberOfRunningJobsWithSameType >= job->maximumConcurrentJobsPerType())
-        {
-          // When the maximum number of concurrent jobs of the same type is reached,
-          // return early instead of adding more jobs to an already crowded queue.
-          // This allows the scheduler time to finish the currently running jobs,
-          // preventing a jobs traffic jam.
-          return;
-        }
+//------------------------------------------------------------------------------
+void ctkJobSchedulerPrivate::startWorker(QSharedPointer<ctkAbstractJob> job)
+{
+  Q_Q(ctkJobScheduler);
 
-        logger.debug(QString("ctkDICOMScheduler: creating worker for job %1 in thread %2.\n")
-                   .arg(job->jobUID())
-                   .arg(QString::number(reinterpret_cast<quint64>(QThread::currentThreadId())), 16));
+  logger.debug(QString("ctkDICOMScheduler: creating worker for job %1 in thread %2.\n")
+                 .arg(job->jobUID())
+                 .arg(QString::number(reinterpret_cast<quint64>(QThread::currentThreadId())), 16));
 
-        QSharedPointer<ctkAbstractWorker> worker = QSharedPointer<ctkAbstractWorker>(job->createWorker());
-        worker->setScheduler(*q);
-        this->Workers.insert(job->jobUID(), worker);
+  QSharedPointer<ctkAbstractWorker> worker = QSharedPointer<ctkAbstractWorker>(job->createWorker());
+  worker->setScheduler(*q);
+  this->Workers.insert(job->jobUID(), worker);
+  this->RunningJobsByJobClass[job->className()]++;
 
-        job->setStatus(ctkAbstractJob::JobStatus::Queued);
-        emit q->jobQueued(job->toVariant());
+  job->setStatus(ctkAbstractJob::JobStatus::Queued);
+  emit q->jobQueued(job->toVariant());
 
-        this->ThreadPool->start(worker.data(), job->priority());
-      }
-    }
-  }
+  this->ThreadPool->start(worker.data(), job->priority());
 }
 
 //------------------------------------------------------------------------------
@@ -185,39 +278,17 @@ bool ctkJobSchedulerPrivate::insertJob(QSharedPointer<ctkAbstractJob> job)
 
   emit q->jobInitialized(job->toVariant());
 
-  logger.debug(QString("ctkDICOMScheduler: creating worker for job %1 in thread %2.\n")
-                     .arg(job->jobUID())
-                     .arg(QString::number(reinterpret_cast<quint64>(QThread::currentThreadId())), 16));
-
-  QSharedPointer<ctkAbstractWorker> worker;
   {
     // The QWriteLocker is enclosed within brackets to restrict its scope and
     // prevent conflicts with other QWriteLockers within the scheduler's methods.
     QWriteLocker locker(&this->QueueLock);
     this->JobsQueue.insert(job->jobUID(), job);
     this->JobsConnections.insert(job->jobUID(), connections);
-
-    int numberOfRunningJobsWithSameType = this->getSameTypeJobsInThreadPoolQueueOrRunning(job);
-    if (numberOfRunningJobsWithSameType >= job->maximumConcurrentJobsPerType())
-    {
-      return false;
-    }
-
-    logger.debug(QString("ctkDICOMScheduler: creating worker for job %1 in thread %2.\n")
-                   .arg(job->jobUID())
-                   .arg(QString::number(reinterpret_cast<quint64>(QThread::currentThreadId())), 16));
-
-    QSharedPointer<ctkAbstractWorker> worker = QSharedPointer<ctkAbstractWorker>(job->createWorker());
-    worker->setScheduler(*q);
-    this->Workers.insert(job->jobUID(), worker);
-
-    job->setStatus(ctkAbstractJob::JobStatus::Queued);
-    emit q->jobQueued(job->toVariant());
-
-    this->ThreadPool->start(worker.data(), job->priority());
+    this->enqueueReadyJob(job);
+    this->dispatchReadyJobs();
   }
 
-  return true;
+  return job->status() != ctkAbstractJob::JobStatus::Initialized;
 }
 
 //------------------------------------------------------------------------------
@@ -329,31 +400,40 @@ void ctkJobSchedulerPrivate::removeJobs(const QStringList &jobUIDs)
       this->JobsConnections.remove(jobUID);
       this->JobsQueue.remove(jobUID);
     }
+
+    if (this->JobsQueue.isEmpty())
+    {
+      // all the remaining ready queue entries are obsolete
+      this->ReadyJobsQueues.clear();
+    }
   }
 }
 
 //------------------------------------------------------------------------------
 int ctkJobSchedulerPrivate::getSameTypeJobsInThreadPoolQueueOrRunning(QSharedPointer<ctkAbstractJob> job)
 {
-  int count = 0;
-  foreach (QSharedPointer<ctkAbstractJob> queuedJob, this->JobsQueue)
+  int count = this->RunningJobsByJobClass.value(job->className());
+  if (this->Workers.contains(job->jobUID()))
   {
-    if (queuedJob->jobUID() == job->jobUID())
-    {
-      continue;
-    }
-
-    if ((queuedJob->status() == ctkAbstractJob::JobStatus::Queued ||
-         queuedJob->status() == ctkAbstractJob::JobStatus::Running) &&
-        queuedJob->className() == job->className())
-    {
-      count++;
-    }
+    // do not count the job itself
+    count--;
   }
 
   return count;
 }
 
+//------------------------------------------------------------------------------
+int ctkJobSchedulerPrivate::getMaximumConcurrentJobsOfSameType(QSharedPointer<ctkAbstractJob> job)
+{
+  int quota = this->JobClassQuotas.value(job->className(), 0);
+  if (quota > 0)
+  {
+    return quota;
+  }
+
+  return job->maximumConcurrentJobsPerType();
+}
+
 //------------------------------------------------------------------------------
 QString ctkJobSchedulerPrivate::generateUniqueJobUID()
 {
@@ -412,6 +492,78 @@ CTK_GET_CPP(ctkJobScheduler, int, maximumNumberOfRetry, MaximumNumberOfRetry)
 CTK_SET_CPP(ctkJobScheduler, const int&, setRetryDelay, RetryDelay);
 CTK_GET_CPP(ctkJobScheduler, int, retryDelay, RetryDelay)
 
+//----------------------------------------------------------------------------
+bool ctkJobScheduler::fairScheduling() const
+{
+  Q_D(const ctkJobScheduler);
+  return d->FairScheduling;
+}
+
+//----------------------------------------------------------------------------
+void ctkJobScheduler::setFairScheduling(bool fairScheduling)
+{
+  Q_D(ctkJobScheduler);
+  {
+    // The QWriteLocker is enclosed within brackets to restrict its scope and
+    // prevent conflicts with other QWriteLockers within the scheduler's methods.
+    QWriteLocker locker(&d->QueueLock);
+    d->FairScheduling = fairScheduling;
+  }
+  d->queueJobsInThreadPool();
+}
+
+//----------------------------------------------------------------------------
+int ctkJobScheduler::jobClassWeight(const QString& jobClass) const
+{
+  Q_D(const ctkJobScheduler);
+  QReadLocker locker(&d->QueueLock);
+  return d->JobClassWeights.value(jobClass, 1);
+}
+
+//----------------------------------------------------------------------------
+void ctkJobScheduler::setJobClassWeight(const QString& jobClass, int weight)
+{
+  Q_D(ctkJobScheduler);
+  QWriteLocker locker(&d->QueueLock);
+  if (weight <= 1)
+  {
+    d->JobClassWeights.remove(jobClass);
+  }
+  else
+  {
+    d->JobClassWeights[jobClass] = weight;
+  }
+}
+
+//----------------------------------------------------------------------------
+int ctkJobScheduler::jobClassQuota(const QString& jobClass) const
+{
+  Q_D(const ctkJobScheduler);
+  QReadLocker locker(&d->QueueLock);
+  return d->JobClassQuotas.value(jobClass, 0);
+}
+
+//----------------------------------------------------------------------------
+void ctkJobScheduler::setJobClassQuota(const QString& jobClass, int maximumConcurrentJobs)
+{
+  Q_D(ctkJobScheduler);
+  {
+    // The QWriteLocker is enclosed within brackets to restrict its scope and
+    // prevent conflicts with other QWriteLockers within the scheduler's methods.
+    QWriteLocker locker(&d->QueueLock);
+    if (maximumConcurrentJobs <= 0)
+    {
+      d->JobClassQuotas.remove(jobClass);
+    }
+    else
+    {
+      d->JobClassQuotas[jobClass] = maximumConcurrentJobs;
+    }
+  }
+  // A larger quota may allow starting more jobs
+  d->queueJobsInThreadPool();
+}
+
 //----------------------------------------------------------------------------
 int ctkJobScheduler::numberOfJobs()
 {
@@ -478,6 +630,24 @@ void ctkJobScheduler::addJob(ctkAbstractJob* job)
   d->insertJob(jobShared);
 }
 
+//----------------------------------------------------------------------------
+void ctkJobScheduler::setJobPriority(const QString& jobUID, QThread::Priority priority)
+{
+  Q_D(ctkJobScheduler);
+  {
+    // The QWriteLocker is enclosed within brackets to restrict its scope and
+    // prevent conflicts with other QWriteLockers within the scheduler's methods.
+    QWriteLocker locker(&d->QueueLock);
+    QSharedPointer<ctkAbstractJob> job = d->JobsQueue.value(jobUID);
+    if (!job)
+    {
+      return;
+    }
+    d->setJobPriority(job, priority);
+  }
+  d->queueJobsInThreadPool();
+}
+
 //----------------------------------------------------------------------------
 void ctkJobScheduler::resetJob(const QString &jobUID)
 {
@@ -504,13 +674,29 @@ void ctkJobScheduler::deleteWorker(const QString& jobUID)
 {
   Q_D(ctkJobScheduler);
 
-  QMap<QString, QSharedPointer<ctkAbstractWorker>>::iterator it = d->Workers.find(jobUID);
-  if (it == d->Workers.end())
+  QSharedPointer<ctkAbstractWorker> worker;
   {
-    return;
-  }
+    // The QWriteLocker is enclosed within brackets to restrict its scope and
+    // prevent conflicts with other QWriteLockers within the scheduler's methods.
+    QWriteLocker locker(&d->QueueLock);
+    QMap<QString, QSharedPointer<ctkAbstractWorker>>::iterator it = d->Workers.find(jobUID);
+    if (it == d->Workers.end())
+    {
+      return;
+    }
 
-  d->Workers.remove(jobUID);
+    // The worker is destroyed after the lock is released
+    worker = it.value();
+    d->Workers.erase(it);
+    if (worker->job())
+    {
+      QString jobClass = worker->job()->className();
+      if (--d->RunningJobsByJobClass[jobClass] <= 0)
+      {
+        d->RunningJobsByJobClass.remove(jobClass);
+      }
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -755,6 +941,12 @@ bool ctkJobScheduler::retryJob(const QString &jobUID)
 
   job->setStatus(ctkAbstractJob::JobStatus::Initialized);
   emit this->jobInitialized(job->toVariant());
+  {
+    // The QWriteLocker is enclosed within brackets to restrict its scope and
+    // prevent conflicts with other QWriteLockers within the scheduler's methods.
+    QWriteLocker locker(&d->QueueLock);
+    d->enqueueReadyJob(job);
+  }
   d->queueJobsInThreadPool();
   return true;
 }
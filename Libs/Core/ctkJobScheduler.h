@@ -31,6 +31,7 @@
 // Qt includes
 #include <QReadWriteLock>
 #include <QSharedPointer>
+#include <QThread>
 #include <QTimer>
 class QThreadPool;
 
@@ -53,6 +54,7 @@ class CTK_CORE_EXPORT ctkJobScheduler : public QObject
   Q_PROPERTY(int maximumThreadCount READ maximumThreadCount WRITE setMaximumThreadCount);
   Q_PROPERTY(int maximumNumberOfRetry READ maximumNumberOfRetry WRITE setMaximumNumberOfRetry);
   Q_PROPERTY(int retryDelay READ retryDelay WRITE setRetryDelay);
+  Q_PROPERTY(bool fairScheduling READ fairScheduling WRITE setFairScheduling);
 
 public:
   typedef QObject Superclass;
@@ -65,6 +67,9 @@ public:
   int numberOfPersistentJobs();
   int numberOfRunningJobs();
   Q_INVOKABLE virtual void addJob(ctkAbstractJob* job);
+  /// Change the priority of a job. A job waiting for a worker is moved
+  /// to the ready queue of its new priority.
+  Q_INVOKABLE virtual void setJobPriority(const QString& jobUID, QThread::Priority priority);
   Q_INVOKABLE virtual void resetJob(const QString& jobUID);
   Q_INVOKABLE virtual void deleteJob(const QString& jobUID);
   Q_INVOKABLE virtual void deleteJobs(const QStringList& jobUIDs);
@@ -108,6 +113,32 @@ public:
   void setRetryDelay(const int& retryDelay);
   ///@}
 
+  ///@{
+  /// If set to true, job classes that reached their maximum number of concurrent jobs
+  /// are skipped and jobs of other classes keep being started.
+  /// If false, scheduling stops at the first job whose class reached its maximum
+  /// (lower priority jobs of other classes wait until one of the running jobs is done).
+  /// default: false
+  bool fairScheduling() const;
+  void setFairScheduling(bool fairScheduling);
+  ///@}
+
+  ///@{
+  /// Weight of a job class: number of jobs of the class that are started in turn
+  /// before starting jobs of other classes of the same priority.
+  /// default: 1
+  Q_INVOKABLE int jobClassWeight(const QString& jobClass) const;
+  Q_INVOKABLE void setJobClassWeight(const QString& jobClass, int weight);
+  ///@}
+
+  ///@{
+  /// Maximum number of concurrent jobs of a job class. If set to a positive value
+  /// then it overrides the maximumConcurrentJobsPerType value of the jobs of that class.
+  /// default: 0 (the job's maximumConcurrentJobsPerType is used)
+  Q_INVOKABLE int jobClassQuota(const QString& jobClass) const;
+  Q_INVOKABLE void setJobClassQuota(const QString& jobClass, int maximumConcurrentJobs);
+  ///@}
+
   /// Return the threadPool.
   Q_INVOKABLE QThreadPool* threadPool() const;
 
@@ -166,20 +197,46 @@ public:
   virtual bool removeJob(const QString& jobUID);
   virtual void removeJobs(const QStringList& jobUIDs);
   virtual int getSameTypeJobsInThreadPoolQueueOrRunning(QSharedPointer<ctkAbstractJob> job);
+  /// Maximum number of concurrent jobs of the same class as the job (quota or job setting).
+  /// QueueLock must be locked.
+  virtual int getMaximumConcurrentJobsOfSameType(QSharedPointer<ctkAbstractJob> job);
   virtual QString generateUniqueJobUID();
   virtual void queueJobsInThreadPool();
+  /// Append the job to the ready queue of its priority.
+  /// QueueLock must be locked for writing.
+  virtual void enqueueReadyJob(QSharedPointer<ctkAbstractJob> job);
+  /// Set the priority of the job and, if it is waiting for a worker, move it
+  /// to the ready queue of its new priority, after the jobs already waiting there.
+  /// QueueLock must be locked for writing.
+  virtual void setJobPriority(QSharedPointer<ctkAbstractJob> job, QThread::Priority priority);
+  /// Priority of the ready queue of jobs with the given priority.
+  static QThread::Priority readyQueuePriority(QThread::Priority priority);
+  /// Start workers for ready jobs, highest priority first. Job classes of the same priority
+  /// take turns, each starting as many jobs as its weight.
+  /// QueueLock must be locked for writing.
+  virtual void dispatchReadyJobs();
+  /// Create a worker for the job and add it to the thread pool.
+  /// QueueLock must be locked for writing.
+  virtual void startWorker(QSharedPointer<ctkAbstractJob> job);
   virtual void clearBactchedJobsLists();
 
-  QReadWriteLock QueueLock;
+  mutable QReadWriteLock QueueLock;
 
   int RetryDelay{100};
   int MaximumNumberOfRetry{3};
   bool FreezeJobsScheduling{false};
+  bool FairScheduling{false};
 
   QSharedPointer<QThreadPool> ThreadPool;
   QMap<QString, QSharedPointer<ctkAbstractJob>> JobsQueue;
   QMap<QString, QMap<QString, QMetaObject::Connection>> JobsConnections;
   QMap<QString, QSharedPointer<ctkAbstractWorker>> Workers;
+  /// UIDs of jobs waiting for a worker (Initialized status) by priority and job class, in insertion order.
+  /// Entries of jobs that have been removed, stopped, or started meanwhile are skipped when dequeued.
+  QMap<QThread::Priority, QMap<QString, QList<QString>>> ReadyJobsQueues;
+  QMap<QString, int> JobClassWeights;
+  QMap<QString, int> JobClassQuotas;
+  /// Number of jobs with a worker (queued in the thread pool or running) by job class
   QMap<QString, int> RunningJobsByJobClass;
   QList<QVariant> BatchedJobsStarted;
   QList<QVariant> BatchedJobsUserStopped;
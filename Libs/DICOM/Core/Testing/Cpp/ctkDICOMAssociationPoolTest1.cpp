@@ -0,0 +1,183 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThread>
+
+// ctkCore includes
+#include <ctkCoreTestingMacros.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMAssociationPool.h"
+#include "ctkDICOMQuery.h"
+#include "ctkDICOMTester.h"
+
+// DCMTK includes
+#include <dcmtk/dcmnet/scu.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Run the study level query the way the query worker does: a new ctkDICOMQuery for each job.
+bool runQueries(int numberOfQueries, int port, ctkDICOMAssociationPool* associationPool)
+{
+  for (int index = 0; index < numberOfQueries; ++index)
+  {
+    ctkDICOMQuery query;
+    query.setCallingAETitle("CTK_AE");
+    query.setCalledAETitle("CTK_AE");
+    query.setHost("localhost");
+    query.setPort(port);
+    if (associationPool)
+    {
+      query.setAssociationPool(*associationPool);
+    }
+    if (!query.queryStudies(""))
+    {
+      return false;
+    }
+    if (query.jobResponseSetsShared().count() != 1)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPoolTest1(int argc, char * argv [])
+{
+  QCoreApplication app(argc, argv);
+
+  QStringList arguments = app.arguments();
+  QString testName = arguments.takeFirst();
+
+  if (!arguments.count())
+  {
+    std::cerr << "Usage: " << qPrintable(testName)
+              << " <path-to-image> [...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  //
+  // Pool bookkeeping
+  //
+  {
+    ctkDICOMAssociationPool pool;
+    CHECK_INT(pool.maximumAssociationsPerServer(), 4);
+    CHECK_INT(pool.idleTimeout(), 10000);
+
+    QString key = ctkDICOMAssociationPool::associationKey("FIND", "CTK_AE", "PACS", "LocalHost", 11112);
+    CHECK_QSTRING(key, ctkDICOMAssociationPool::associationKey("FIND", "CTK_AE", "PACS", "localhost", 11112));
+    CHECK_QSTRING_DIFFERENT(key, ctkDICOMAssociationPool::associationKey("RETRIEVE", "CTK_AE", "PACS", "localhost", 11112));
+
+    // Nothing to reuse: the caller has to negotiate
+    CHECK_NULL(pool.leaseAssociation(key).data());
+    CHECK_INT(pool.numberOfLeasedAssociations(), 1);
+    CHECK_INT(pool.numberOfNegotiatedAssociations(), 1);
+
+    // Associations that are not connected are never kept
+    pool.returnAssociation(key, QSharedPointer<DcmSCU>(new DcmSCU));
+    CHECK_INT(pool.numberOfLeasedAssociations(), 0);
+    CHECK_INT(pool.numberOfIdleAssociations(), 0);
+
+    // The maximum number of leases per server is enforced until the lease timeout
+    pool.setMaximumAssociationsPerServer(1);
+    pool.setLeaseTimeout(200);
+    pool.leaseAssociation(key);
+    QElapsedTimer timer;
+    timer.start();
+    pool.leaseAssociation(key);
+    CHECK_BOOL(timer.elapsed() >= 150, true);
+    CHECK_INT(pool.numberOfLeasedAssociations(), 2);
+
+    // Leases of other servers are not limited
+    timer.restart();
+    QString otherKey = ctkDICOMAssociationPool::associationKey("FIND", "CTK_AE", "PACS", "otherhost", 11112);
+    pool.leaseAssociation(otherKey);
+    CHECK_BOOL(timer.elapsed() < 150, true);
+
+    pool.returnAssociation(key, QSharedPointer<DcmSCU>(), false);
+    pool.returnAssociation(key, QSharedPointer<DcmSCU>(), false);
+    pool.returnAssociation(otherKey, QSharedPointer<DcmSCU>(), false);
+    CHECK_INT(pool.numberOfLeasedAssociations(), 0);
+
+    pool.resetStatistics();
+    CHECK_INT(pool.numberOfNegotiatedAssociations(), 0);
+    CHECK_INT(pool.numberOfReusedAssociations(), 0);
+  }
+
+  //
+  // Handshake count and latency against a local DICOM server
+  //
+  ctkDICOMTester tester;
+  tester.startDCMQRSCP();
+  CHECK_BOOL(tester.storeData(arguments), true);
+
+  const int numberOfQueries = 20;
+
+  QElapsedTimer timer;
+  timer.start();
+  CHECK_BOOL(runQueries(numberOfQueries, tester.dcmqrscpPort(), nullptr), true);
+  qint64 elapsedWithoutPool = timer.elapsed();
+
+  ctkDICOMAssociationPool pool;
+  timer.restart();
+  CHECK_BOOL(runQueries(numberOfQueries, tester.dcmqrscpPort(), &pool), true);
+  qint64 elapsedWithPool = timer.elapsed();
+
+  std::cout << numberOfQueries << " study queries: "
+            << elapsedWithoutPool << " ms without association pool, "
+            << elapsedWithPool << " ms with association pool ("
+            << pool.numberOfNegotiatedAssociations() << " associations negotiated, "
+            << pool.numberOfReusedAssociations() << " reused)" << std::endl;
+
+  CHECK_INT(pool.numberOfNegotiatedAssociations(), 1);
+  CHECK_INT(pool.numberOfReusedAssociations(), numberOfQueries - 1);
+  CHECK_INT(pool.numberOfLeasedAssociations(), 0);
+  CHECK_INT(pool.numberOfIdleAssociations(), 1);
+
+  // Idle associations expire
+  pool.setIdleTimeout(50);
+  QThread::msleep(100);
+  pool.resetStatistics();
+  CHECK_BOOL(runQueries(1, tester.dcmqrscpPort(), &pool), true);
+  CHECK_INT(pool.numberOfNegotiatedAssociations(), 1);
+  CHECK_INT(pool.numberOfReusedAssociations(), 0);
+
+  // Disabling pooling releases the associations when they are returned
+  pool.setIdleTimeout(0);
+  CHECK_INT(pool.numberOfIdleAssociations(), 0);
+  CHECK_BOOL(runQueries(2, tester.dcmqrscpPort(), &pool), true);
+  CHECK_INT(pool.numberOfIdleAssociations(), 0);
+
+  pool.releaseIdleAssociations();
+  return EXIT_SUCCESS;
+}
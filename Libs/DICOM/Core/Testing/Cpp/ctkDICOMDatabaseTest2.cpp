@@ -191,6 +191,47 @@ int ctkDICOMDatabaseTest2( int argc, char * argv [] )
     return EXIT_FAILURE;
   }
 
+  //
+  // Test bulk accessors
+  //
+  QString seriesUID = database.seriesForFile(dicomFilePath);
+  QString studyUID = database.studyForSeries(seriesUID);
+  QString patientUID = database.patientForStudy(studyUID);
+
+  QMap<QString, QMap<QString, QString> > studiesFields = database.studiesFieldsForPatient(patientUID);
+  CHECK_INT(studiesFields.count(), 1);
+  CHECK_QSTRING(studiesFields[studyUID]["StudyID"], database.fieldForStudy("StudyID", studyUID));
+
+  QMap<QString, QMap<QString, QString> > seriesFields = database.seriesFieldsForStudy(studyUID);
+  CHECK_INT(seriesFields.count(), 1);
+  CHECK_QSTRING(seriesFields[seriesUID]["SeriesDescription"], database.fieldForSeries("SeriesDescription", seriesUID));
+  CHECK_QSTRING(seriesFields[seriesUID]["InstanceCount"], QString("1"));
+  CHECK_QSTRING(seriesFields[seriesUID]["LoadedInstanceCount"], QString("1"));
+  CHECK_QSTRING(seriesFields[seriesUID]["URLCount"], QString("0"));
+  CHECK_QSTRING(seriesFields[seriesUID]["FirstInstanceUID"], instanceUID);
+
+  QMap<QString, QMap<QString, QString> > instanceValues =
+    database.instanceValuesForTags(QStringList() << instanceUID, QStringList() << tag << "0028,0010");
+  CHECK_QSTRING(instanceValues[instanceUID][tag], knownSeriesDescription);
+  CHECK_QSTRING(instanceValues[instanceUID]["0028,0010"], database.instanceValue(instanceUID, "0028,0010"));
+
+  //
+  // Test the lookup cache
+  //
+  CHECK_INT(database.lookupCacheSize(), 0);
+  database.setLookupCacheSize(100);
+  database.resetLookupCacheStatistics();
+  QString seriesDescription = database.fieldForSeries("SeriesDescription", seriesUID);
+  CHECK_QSTRING(database.fieldForSeries("SeriesDescription", seriesUID), seriesDescription);
+  CHECK_INT(database.lookupCacheHitCount(), 1);
+  CHECK_INT(database.lookupCacheMissCount(), 1);
+  // Writing a tag value must not return the previously cached value
+  CHECK_QSTRING(database.cachedTag(instanceUID, tag), knownSeriesDescription);
+  CHECK_BOOL(database.cacheTag(instanceUID, tag, "modified"), true);
+  CHECK_QSTRING(database.cachedTag(instanceUID, tag), QString("modified"));
+  CHECK_BOOL(database.cacheTag(instanceUID, tag, knownSeriesDescription), true);
+  database.setLookupCacheSize(0);
+
   // now update the database
   database.updateSchema();
 
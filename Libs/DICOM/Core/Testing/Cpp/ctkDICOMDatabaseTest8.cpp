@@ -0,0 +1,212 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+// ctkCore includes
+#include <ctkCoreTestingMacros.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMItem.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMItem> createDataset(int instanceIndex, int instancesPerSeries, int seriesPerStudy)
+{
+  int seriesIndex = instanceIndex / instancesPerSeries;
+  int studyIndex = seriesIndex / seriesPerStudy;
+  QString uidRoot("1.2.826.0.1.3680043.2.1125.999.");
+
+  QSharedPointer<ctkDICOMItem> dataset(new ctkDICOMItem);
+  dataset->InitializeFromItem(new DcmDataset, true);
+  dataset->SetElementAsString(DCM_PatientID, QString("Patient%1").arg(studyIndex));
+  dataset->SetElementAsString(DCM_PatientName, QString("Patient^%1").arg(studyIndex));
+  dataset->SetElementAsString(DCM_StudyInstanceUID, uidRoot + QString("1.%1").arg(studyIndex));
+  dataset->SetElementAsString(DCM_SeriesInstanceUID, uidRoot + QString("2.%1").arg(seriesIndex));
+  dataset->SetElementAsString(DCM_SOPInstanceUID, uidRoot + QString("3.%1").arg(instanceIndex));
+  dataset->SetElementAsString(DCM_Modality, "CT");
+  return dataset;
+}
+
+//------------------------------------------------------------------------------
+bool insertInstances(int numberOfInstances)
+{
+  const int instancesPerSeries = 100;
+  const int seriesPerStudy = 5;
+  // Same number of results per call as the indexer typically collects between database writes
+  const int batchSize = 1000;
+
+  QTemporaryDir tempDirectory;
+  if (!tempDirectory.isValid())
+  {
+    std::cerr << "Failed to create temporary directory" << std::endl;
+    return false;
+  }
+  QString databaseFilePath = QDir(tempDirectory.path()).absoluteFilePath("ctkDICOM.sql");
+  ctkDICOMDatabase database;
+  database.openDatabase(databaseFilePath);
+  database.setTagsToPrecache(QStringList() << "0008,0060" << "0020,0011");
+
+  qint64 elapsedMsec = 0;
+  for (int batchStart = 0; batchStart < numberOfInstances; batchStart += batchSize)
+  {
+    QList<ctkDICOMDatabase::IndexingResult> indexingResults;
+    for (int instanceIndex = batchStart; instanceIndex < qMin(numberOfInstances, batchStart + batchSize); ++instanceIndex)
+    {
+      ctkDICOMDatabase::IndexingResult indexingResult;
+      indexingResult.filePath = QString("/nonexistent/%1.dcm").arg(instanceIndex);
+      indexingResult.dataset = createDataset(instanceIndex, instancesPerSeries, seriesPerStudy);
+      indexingResult.copyFile = false;
+      indexingResult.overwriteExistingDataset = false;
+      indexingResults << indexingResult;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    database.insert(indexingResults);
+    elapsedMsec += timer.elapsed();
+  }
+
+  int imagesCount = database.imagesCount();
+  std::cout << "Inserted " << imagesCount << " instances in " << elapsedMsec << "ms ("
+            << (elapsedMsec > 0 ? imagesCount * 1000.0 / elapsedMsec : 0.0) << " inserts/s)" << std::endl;
+  if (imagesCount != numberOfInstances)
+  {
+    std::cerr << "Expected " << numberOfInstances << " images, found " << imagesCount << std::endl;
+    return false;
+  }
+
+  int expectedSeriesCount = (numberOfInstances + instancesPerSeries - 1) / instancesPerSeries;
+  int expectedStudiesCount = (expectedSeriesCount + seriesPerStudy - 1) / seriesPerStudy;
+  if (database.seriesCount() != expectedSeriesCount
+    || database.studiesCount() != expectedStudiesCount
+    || database.patientsCount() != expectedStudiesCount)
+  {
+    std::cerr << "Unexpected number of patients, studies, or series" << std::endl;
+    return false;
+  }
+
+  // Displayed fields update of all the inserted instances
+  QElapsedTimer displayedFieldsTimer;
+  displayedFieldsTimer.start();
+  database.updateDisplayedFields();
+  std::cout << "Updated displayed fields of " << imagesCount << " instances in "
+            << displayedFieldsTimer.elapsed() << "ms" << std::endl;
+
+  // Inserting the same instances again must not create new records
+  QList<ctkDICOMDatabase::IndexingResult> indexingResults;
+  ctkDICOMDatabase::IndexingResult indexingResult;
+  indexingResult.filePath = QString("/nonexistent/%1.dcm").arg(0);
+  indexingResult.dataset = createDataset(0, instancesPerSeries, seriesPerStudy);
+  indexingResult.copyFile = false;
+  indexingResult.overwriteExistingDataset = true;
+  indexingResults << indexingResult;
+  database.insert(indexingResults);
+  if (database.imagesCount() != numberOfInstances)
+  {
+    std::cerr << "Reinserting an existing instance changed the number of images" << std::endl;
+    return false;
+  }
+
+  // Only the reinserted instance needs displayed fields update
+  displayedFieldsTimer.start();
+  database.updateDisplayedFields();
+  std::cout << "Updated displayed fields of 1 reinserted instance in "
+            << displayedFieldsTimer.elapsed() << "ms" << std::endl;
+  QString seriesInstanceUID = indexingResult.dataset->GetElementAsString(DCM_SeriesInstanceUID);
+  if (database.instancesForSeries(seriesInstanceUID).count() != qMin(instancesPerSeries, numberOfInstances))
+  {
+    std::cerr << "Unexpected number of instances in series after displayed fields update" << std::endl;
+    return false;
+  }
+
+  // Instances inserted through another database object are updated even if
+  // instances were also inserted through this one since the last update
+  QSharedPointer<ctkDICOMItem> otherDataset = createDataset(numberOfInstances, instancesPerSeries, seriesPerStudy);
+  {
+    ctkDICOMDatabase otherDatabase;
+    otherDatabase.openDatabase(databaseFilePath);
+    ctkDICOMDatabase::IndexingResult otherIndexingResult;
+    otherIndexingResult.filePath = QString("/nonexistent/%1.dcm").arg(numberOfInstances);
+    otherIndexingResult.dataset = otherDataset;
+    otherIndexingResult.copyFile = false;
+    otherIndexingResult.overwriteExistingDataset = false;
+    otherDatabase.insert(QList<ctkDICOMDatabase::IndexingResult>() << otherIndexingResult);
+    otherDatabase.closeDatabase();
+  }
+  database.insert(indexingResults);
+  database.updateDisplayedFields();
+  if (database.fieldForSeries("DisplayedCount", otherDataset->GetElementAsString(DCM_SeriesInstanceUID)).isEmpty())
+  {
+    std::cerr << "Displayed fields of an instance inserted by another database object are not updated" << std::endl;
+    return false;
+  }
+
+  if (database.instanceValue(createDataset(0, instancesPerSeries, seriesPerStudy)->GetElementAsString(DCM_SOPInstanceUID),
+    "0008,0060") != "CT")
+  {
+    std::cerr << "Precached tag value is not stored" << std::endl;
+    return false;
+  }
+
+  database.closeDatabase();
+  return true;
+}
+
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabaseTest8( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  // Number of inserted instances can be specified in the command-line
+  // (for example 10000 100000 1000000) to measure insert throughput.
+  QList<int> numberOfInstancesList;
+  for (int i = 1; i < argc; ++i)
+  {
+    numberOfInstancesList << QString(argv[i]).toInt();
+  }
+  if (numberOfInstancesList.isEmpty())
+  {
+    numberOfInstancesList << 10000;
+  }
+
+  foreach(int numberOfInstances, numberOfInstancesList)
+  {
+    CHECK_BOOL(insertInstances(numberOfInstances), true);
+  }
+
+  return EXIT_SUCCESS;
+}
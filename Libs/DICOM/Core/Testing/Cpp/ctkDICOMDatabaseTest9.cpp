@@ -0,0 +1,220 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+
+// ctkCore includes
+#include <ctkCoreTestingMacros.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMItem.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+// STD includes
+#include <iostream>
+#include <cstdlib>
+
+namespace
+{
+
+const int InstancesPerSeries = 50;
+const int SeriesPerStudy = 4;
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMItem> createDataset(int instanceIndex)
+{
+  int seriesIndex = instanceIndex / InstancesPerSeries;
+  int studyIndex = seriesIndex / SeriesPerStudy;
+  QString uidRoot("1.2.826.0.1.3680043.2.1125.998.");
+
+  QSharedPointer<ctkDICOMItem> dataset(new ctkDICOMItem);
+  dataset->InitializeFromItem(new DcmDataset, true);
+  dataset->SetElementAsString(DCM_PatientID, QString("Patient%1").arg(studyIndex));
+  dataset->SetElementAsString(DCM_PatientName, QString("Patient^%1").arg(studyIndex));
+  dataset->SetElementAsString(DCM_StudyInstanceUID, uidRoot + QString("1.%1").arg(studyIndex));
+  dataset->SetElementAsString(DCM_SeriesInstanceUID, uidRoot + QString("2.%1").arg(seriesIndex));
+  dataset->SetElementAsString(DCM_SOPInstanceUID, uidRoot + QString("3.%1").arg(instanceIndex));
+  dataset->SetElementAsString(DCM_Modality, "MR");
+  return dataset;
+}
+
+//------------------------------------------------------------------------------
+/// Inserts instances in small batches using its own database connection,
+/// the same way as indexer and inserter jobs do.
+class ctkDICOMDatabaseWriterThread : public QThread
+{
+public:
+  ctkDICOMDatabaseWriterThread(const QString& databaseFile, int firstInstance, int numberOfInstances)
+    : DatabaseFile(databaseFile)
+    , FirstInstance(firstInstance)
+    , NumberOfInstances(numberOfInstances)
+    , Success(false)
+  {
+  }
+
+  void run() override
+  {
+    const int batchSize = 100;
+    ctkDICOMDatabase database;
+    if (!database.openDatabase(this->DatabaseFile, QString("writer_%1").arg(this->FirstInstance)))
+    {
+      return;
+    }
+    int lastInstance = this->FirstInstance + this->NumberOfInstances;
+    for (int batchStart = this->FirstInstance; batchStart < lastInstance; batchStart += batchSize)
+    {
+      QList<ctkDICOMDatabase::IndexingResult> indexingResults;
+      for (int instanceIndex = batchStart; instanceIndex < qMin(lastInstance, batchStart + batchSize); ++instanceIndex)
+      {
+        ctkDICOMDatabase::IndexingResult indexingResult;
+        indexingResult.filePath = QString("/nonexistent/%1.dcm").arg(instanceIndex);
+        indexingResult.dataset = createDataset(instanceIndex);
+        indexingResult.copyFile = false;
+        indexingResult.overwriteExistingDataset = false;
+        indexingResults << indexingResult;
+      }
+      database.insert(indexingResults);
+      database.updateDisplayedFields();
+    }
+    database.closeDatabase();
+    this->Success = true;
+  }
+
+  QString DatabaseFile;
+  int FirstInstance;
+  int NumberOfInstances;
+  bool Success;
+};
+
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabaseTest9( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  // Number of instances inserted by each writer thread can be specified in the command-line
+  int numberOfInstancesPerWriter = (argc > 1 ? QString(argv[1]).toInt() : 2000);
+  const int instancesPerStudy = InstancesPerSeries * SeriesPerStudy;
+  // Each writer inserts complete studies
+  numberOfInstancesPerWriter = qMax(1, numberOfInstancesPerWriter / instancesPerStudy) * instancesPerStudy;
+  const int numberOfWriters = 2;
+
+  QTemporaryDir tempDirectory;
+  CHECK_BOOL(tempDirectory.isValid(), true);
+  QString databaseFile = QDir(tempDirectory.path()).absoluteFilePath("ctkDICOM.sql");
+
+  // The database is created and switched to WAL mode by the reader (user interface) connection
+  ctkDICOMDatabase database;
+  database.setJournalMode("WAL");
+  CHECK_BOOL(database.openDatabase(databaseFile), true);
+  CHECK_QSTRING(database.journalMode(), QString("WAL"));
+  {
+    QSqlQuery journalModeQuery(database.database());
+    CHECK_BOOL(journalModeQuery.exec("PRAGMA journal_mode"), true);
+    CHECK_BOOL(journalModeQuery.next(), true);
+    CHECK_QSTRING(journalModeQuery.value(0).toString().toUpper(), QString("WAL"));
+  }
+
+  QList<ctkDICOMDatabaseWriterThread*> writers;
+  for (int writerIndex = 0; writerIndex < numberOfWriters; ++writerIndex)
+  {
+    writers << new ctkDICOMDatabaseWriterThread(databaseFile,
+      writerIndex * numberOfInstancesPerWriter, numberOfInstancesPerWriter);
+  }
+  foreach(ctkDICOMDatabaseWriterThread* writer, writers)
+  {
+    writer->start();
+  }
+
+  // Repopulate patient, study, and series lists the same way as the browser models do,
+  // while the writers are inserting. Number of records may only grow.
+  int numberOfReads = 0;
+  int lastImagesCount = 0;
+  bool readFailed = false;
+  bool writersRunning = true;
+  while (writersRunning)
+  {
+    writersRunning = false;
+    foreach(ctkDICOMDatabaseWriterThread* writer, writers)
+    {
+      writersRunning = writersRunning || writer->isRunning();
+    }
+
+    int imagesCount = database.imagesCount();
+    if (imagesCount < lastImagesCount)
+    {
+      std::cerr << "Number of images decreased from " << lastImagesCount << " to " << imagesCount << std::endl;
+      readFailed = true;
+      break;
+    }
+    lastImagesCount = imagesCount;
+    foreach(const QString& patientUID, database.patients())
+    {
+      QMap<QString, QMap<QString, QString> > studiesFields = database.studiesFieldsForPatient(patientUID);
+      foreach(const QString& studyInstanceUID, studiesFields.keys())
+      {
+        database.seriesFieldsForStudy(studyInstanceUID);
+      }
+    }
+    numberOfReads++;
+  }
+
+  foreach(ctkDICOMDatabaseWriterThread* writer, writers)
+  {
+    writer->wait();
+    CHECK_BOOL(writer->Success, true);
+    delete writer;
+  }
+  CHECK_BOOL(readFailed, false);
+
+  std::cout << "Repopulated models " << numberOfReads << " times during import" << std::endl;
+
+  int expectedImagesCount = numberOfWriters * numberOfInstancesPerWriter;
+  int expectedStudiesCount = expectedImagesCount / instancesPerStudy;
+  CHECK_INT(database.imagesCount(), expectedImagesCount);
+  CHECK_INT(database.seriesCount(), expectedStudiesCount * SeriesPerStudy);
+  CHECK_INT(database.studiesCount(), expectedStudiesCount);
+  CHECK_INT(database.patientsCount(), expectedStudiesCount);
+
+  // All writers updated displayed fields of their instances. Each series is
+  // inserted by a single batch, so its displayed image count is complete.
+  QString studyInstanceUID = createDataset(0)->GetElementAsString(DCM_StudyInstanceUID);
+  QMap<QString, QMap<QString, QString> > seriesFields = database.seriesFieldsForStudy(studyInstanceUID);
+  CHECK_INT(seriesFields.count(), SeriesPerStudy);
+  foreach(const QString& seriesInstanceUID, seriesFields.keys())
+  {
+    CHECK_QSTRING(seriesFields[seriesInstanceUID]["InstanceCount"], QString::number(InstancesPerSeries));
+    CHECK_QSTRING(seriesFields[seriesInstanceUID]["DisplayedCount"], QString::number(InstancesPerSeries));
+    CHECK_BOOL(seriesFields[seriesInstanceUID]["DisplayedFieldsUpdatedTimestamp"].isEmpty(), false);
+  }
+
+  database.closeDatabase();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
+#include <QThread>
+
+// ctkCore includes
+#include <ctkCoreTestingMacros.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMDatabase.h"
+#include "ctkDICOMIndexer.h"
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+int indexDirectory(const QString& dicomDir, int numberOfParserThreads, double& filesPerSecond)
+{
+  ctkDICOMDatabase database;
+  database.openDatabase(":memory:");
+  ctkDICOMIndexer indexer;
+  indexer.setDatabase(&database);
+  indexer.setNumberOfParserThreads(numberOfParserThreads);
+
+  QElapsedTimer timer;
+  timer.start();
+  indexer.addDirectory(dicomDir, false);
+  indexer.waitForImportFinished();
+  qint64 elapsedMsec = timer.elapsed();
+
+  int imagesCount = database.imagesCount();
+  filesPerSecond = elapsedMsec > 0 ? imagesCount * 1000.0 / elapsedMsec : 0.0;
+  std::cout << "Indexed " << imagesCount << " files using " << numberOfParserThreads
+            << " parser threads in " << elapsedMsec << "ms ("
+            << filesPerSecond << " files/s)" << std::endl;
+  return imagesCount;
+}
+
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMIndexerTest2( int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  // Get data directory from environment
+  QDir dataDir = QDir(QProcessEnvironment::systemEnvironment().value("CTKData_DIR", ""));
+  QString dicomDir = dataDir.filePath("Data/DICOM");
+  if (!QDir(dicomDir).exists())
+  {
+    std::cerr << "Directory does not exist: " << qPrintable(dicomDir) << std::endl;
+    std::cerr << "Make sure CTKData_DIR environment variable is set correctly" << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  ctkDICOMIndexer indexer;
+  CHECK_INT(indexer.numberOfParserThreads(), QThread::idealThreadCount());
+  indexer.setNumberOfParserThreads(0);
+  CHECK_INT(indexer.numberOfParserThreads(), QThread::idealThreadCount());
+
+  // Throughput of serial parsing versus parallel parsing.
+  // Both runs must index exactly the same number of files.
+  double serialFilesPerSecond = 0.0;
+  int serialImagesCount = indexDirectory(dicomDir, 1, serialFilesPerSecond);
+
+  int numberOfThreads = qMax(2, QThread::idealThreadCount());
+  double parallelFilesPerSecond = 0.0;
+  int parallelImagesCount = indexDirectory(dicomDir, numberOfThreads, parallelFilesPerSecond);
+
+  CHECK_INT(parallelImagesCount, serialImagesCount);
+  if (serialFilesPerSecond > 0.0)
+  {
+    std::cout << "Speedup: " << parallelFilesPerSecond / serialFilesPerSecond << "x" << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -31,6 +31,12 @@ int ctkDICOMItemTest1( int argc, char * argv [] )
   ctkDICOMItem dataset;
   dataset.InitializeFromItem(0);
   dataset.InitializeFromFile(QString());
+  if (dataset.InitializeFromFileHeader(QString()) != -1)
+  {
+    std::cerr << "ctkDICOMItem::InitializeFromFileHeader() failed: "
+              << "reading an empty filename should fail" << std::endl;
+    return EXIT_FAILURE;
+  }
   try
   {
     dataset.Serialize();
@@ -34,6 +34,7 @@
 #include "ctkDICOMRetrieveJob.h"
 #include "ctkDICOMServer.h"
 #include "ctkDICOMStorageListenerJob.h"
+#include "ctkDICOMThumbnailGeneratorJob.h"
 
 int ctkDICOMJobTest1(int argc, char* argv[])
 {
@@ -137,5 +138,52 @@ int ctkDICOMJobTest1(int argc, char* argv[])
   storageListenerJob.setConnectionTimeout(5);
   CHECK_INT(storageListenerJob.connectionTimeout(), 5);
 
+  ctkDICOMThumbnailGeneratorJob thumbnailGeneratorJob;
+
+  // Test the default values
+  CHECK_INT(thumbnailGeneratorJob.numberOfItems(), 0);
+  CHECK_BOOL(thumbnailGeneratorJob.packedThumbnailStorage(), false);
+
+  // Test the batched thumbnails
+  QList<ctkDICOMThumbnailGeneratorItem> thumbnailItems;
+  for (int index = 0; index < 3; ++index)
+  {
+    ctkDICOMThumbnailGeneratorItem item;
+    item.DicomFilePath = QString("file%1.dcm").arg(index);
+    item.PatientID = "patientID";
+    item.StudyInstanceUID = "studyInstanceUID";
+    item.SeriesInstanceUID = QString("series%1").arg(index);
+    item.SOPInstanceUID = QString("instance%1").arg(index);
+    item.Modality = "CT";
+    thumbnailItems.append(item);
+  }
+  CHECK_BOOL(thumbnailGeneratorJob.appendItems(thumbnailItems.mid(0, 1)), true);
+  CHECK_QSTRING(thumbnailGeneratorJob.seriesInstanceUID(), "series0");
+  CHECK_BOOL(thumbnailGeneratorJob.appendItems(thumbnailItems.mid(1)), true);
+  CHECK_INT(thumbnailGeneratorJob.numberOfItems(), 3);
+  CHECK_QSTRING(thumbnailGeneratorJob.patientID(), "patientID");
+  CHECK_QSTRING(thumbnailGeneratorJob.studyInstanceUID(), "studyInstanceUID");
+  CHECK_QSTRING(thumbnailGeneratorJob.seriesInstanceUID(), "");
+  CHECK_QSTRING(thumbnailGeneratorJob.sopInstanceUID(), "");
+  CHECK_BOOL(thumbnailGeneratorJob.containsItems({}, {}, {"series1"}, {}), true);
+  CHECK_BOOL(thumbnailGeneratorJob.containsItems({}, {}, {"series3"}, {}), false);
+
+  QScopedPointer<ctkDICOMThumbnailGeneratorJob> clonedThumbnailGeneratorJob(
+    qobject_cast<ctkDICOMThumbnailGeneratorJob*>(thumbnailGeneratorJob.clone()));
+  CHECK_INT(clonedThumbnailGeneratorJob->numberOfItems(), 3);
+
+  CHECK_INT(thumbnailGeneratorJob.removeItems({}, {}, {"series1", "series3"}, {}), 1);
+  CHECK_INT(thumbnailGeneratorJob.numberOfItems(), 2);
+  ctkDICOMThumbnailGeneratorItem thumbnailItem;
+  CHECK_BOOL(thumbnailGeneratorJob.takeNextItem(thumbnailItem), true);
+  CHECK_QSTRING(thumbnailItem.SeriesInstanceUID, "series0");
+
+  // No thumbnails are added once the worker runs
+  thumbnailGeneratorJob.setStatus(ctkAbstractJob::JobStatus::Running);
+  CHECK_BOOL(thumbnailGeneratorJob.appendItems(thumbnailItems.mid(1, 1)), false);
+  CHECK_BOOL(thumbnailGeneratorJob.takeNextItem(thumbnailItem), true);
+  CHECK_QSTRING(thumbnailItem.SeriesInstanceUID, "series2");
+  CHECK_BOOL(thumbnailGeneratorJob.takeNextItem(thumbnailItem), false);
+
   return EXIT_SUCCESS;
 }
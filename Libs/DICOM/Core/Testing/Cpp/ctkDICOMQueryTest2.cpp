@@ -30,6 +30,7 @@
 
 // ctkDICOMCore includes
 #include "ctkDICOMDatabase.h"
+#include "ctkDICOMJobResponseSet.h"
 #include "ctkDICOMQuery.h"
 #include "ctkDICOMTester.h"
 
@@ -84,5 +85,56 @@ int ctkDICOMQueryTest2( int argc, char * argv [] )
               << "No study instance retrieved" << std::endl;
     return EXIT_FAILURE;
   }
+
+  // Concurrent series queries find the same series
+  ctkDICOMQuery concurrentQuery;
+  concurrentQuery.setCallingAETitle("CTK_AE");
+  concurrentQuery.setCalledAETitle("CTK_AE");
+  concurrentQuery.setHost("localhost");
+  concurrentQuery.setPort(tester.dcmqrscpPort());
+  CHECK_INT(concurrentQuery.maximumConcurrentSeriesQueries(), 1);
+  concurrentQuery.setMaximumConcurrentSeriesQueries(4);
+  CHECK_BOOL(concurrentQuery.query(database), true);
+  CHECK_INT(concurrentQuery.studyAndSeriesInstanceUIDQueried().count(),
+            query.studyAndSeriesInstanceUIDQueried().count());
+  for (const QPair<QString, QString>& studyAndSeries : query.studyAndSeriesInstanceUIDQueried())
+  {
+    CHECK_BOOL(concurrentQuery.studyAndSeriesInstanceUIDQueried().contains(studyAndSeries), true);
+  }
+
+  // Instances streamed by batches while the C-FIND is running
+  QPair<QString, QString> studyAndSeries = query.studyAndSeriesInstanceUIDQueried().first();
+  ctkDICOMQuery instancesQuery;
+  instancesQuery.setCallingAETitle("CTK_AE");
+  instancesQuery.setCalledAETitle("CTK_AE");
+  instancesQuery.setHost("localhost");
+  instancesQuery.setPort(tester.dcmqrscpPort());
+  CHECK_BOOL(instancesQuery.queryInstances("", studyAndSeries.first, studyAndSeries.second), true);
+  CHECK_INT(instancesQuery.jobResponseSetsShared().count(), 1);
+  int numberOfInstances = instancesQuery.jobResponseSetsShared().first()->datasetsShared().count();
+  CHECK_BOOL(numberOfInstances > 1, true);
+
+  ctkDICOMQuery batchQuery;
+  batchQuery.setCallingAETitle("CTK_AE");
+  batchQuery.setCalledAETitle("CTK_AE");
+  batchQuery.setHost("localhost");
+  batchQuery.setPort(tester.dcmqrscpPort());
+  CHECK_INT(batchQuery.responseBatchSize(), 0);
+  batchQuery.setResponseBatchSize(1);
+  int numberOfBatches = 0;
+  int numberOfStreamedInstances = 0;
+  QObject::connect(&batchQuery, &ctkDICOMQuery::jobResponseSetAvailable,
+                   [&](QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet)
+                   {
+                     numberOfBatches++;
+                     numberOfStreamedInstances += jobResponseSet->datasetsShared().count();
+                   });
+  CHECK_BOOL(batchQuery.queryInstances("", studyAndSeries.first, studyAndSeries.second), true);
+  // the last batch is kept in the response sets
+  CHECK_INT(numberOfBatches, numberOfInstances - 1);
+  CHECK_INT(batchQuery.jobResponseSetsShared().count(), 1);
+  CHECK_INT(numberOfStreamedInstances + batchQuery.jobResponseSetsShared().first()->datasetsShared().count(),
+            numberOfInstances);
+
   return EXIT_SUCCESS;
 }
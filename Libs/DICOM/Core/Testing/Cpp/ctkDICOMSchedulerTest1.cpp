@@ -24,16 +24,25 @@
 
 // Qt includes
 #include <QCoreApplication>
+#include <QFile>
+#include <QSet>
 #include <QTemporaryDir>
+#include <QUuid>
 
 // ctkCore includes
 #include <ctkCoreTestingMacros.h>
 
 // ctkDICOMCore includes
+#include "ctkDICOMJobResponseSet.h"
+#include "ctkDICOMRetrieve.h"
 #include "ctkDICOMScheduler.h"
 #include "ctkDICOMServer.h"
 #include "ctkDICOMTester.h"
 
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+
 int ctkDICOMSchedulerTest1(int argc, char* argv[])
 {
   QCoreApplication app(argc, argv);
@@ -68,6 +77,9 @@ int ctkDICOMSchedulerTest1(int argc, char* argv[])
   CHECK_INT(scheduler.maximumNumberOfRetry(), 3);
   CHECK_INT(scheduler.retryDelay(), 100);
   CHECK_INT(scheduler.maximumPatientsQuery(), 0);
+  CHECK_BOOL(scheduler.spoolRetrievedInstances(), false);
+  CHECK_INT(scheduler.insertCoalescingWindow(), 0);
+  CHECK_INT(scheduler.maximumCoalescedJobResponseSets(), 500);
 
   // Test setting and getting
   scheduler.setMaximumThreadCount(19);
@@ -78,6 +90,8 @@ int ctkDICOMSchedulerTest1(int argc, char* argv[])
   CHECK_INT(scheduler.retryDelay(), 300);
   scheduler.setMaximumPatientsQuery(30);
   CHECK_INT(scheduler.maximumPatientsQuery(), 30);
+  scheduler.setMaximumCoalescedJobResponseSets(1000);
+  CHECK_INT(scheduler.maximumCoalescedJobResponseSets(), 1000);
 
   // Test scheduler
   std::cout << qPrintable(testName) << ": Setting up scheduler" << std::endl;
@@ -145,6 +159,18 @@ int ctkDICOMSchedulerTest1(int argc, char* argv[])
             << "Running multiple retrieveSOPInstance. "
             << "This will test " << numberOfImages << " retrieve concorrent jobs" << std::endl;
 
+  // The responses of the retrieve jobs are coalesced by the inserter jobs
+  scheduler.setInsertCoalescingWindow(200);
+  CHECK_INT(scheduler.insertCoalescingWindow(), 200);
+  int numberOfInsertions = 0;
+  int numberOfInsertedJobResponseSets = 0;
+  QObject::connect(&scheduler, &ctkDICOMScheduler::jobResponseSetsInserted,
+                   [&numberOfInsertions, &numberOfInsertedJobResponseSets](QList<QVariant> datas)
+  {
+    numberOfInsertions++;
+    numberOfInsertedJobResponseSets += datas.count();
+  });
+
   foreach (const QString& sopIstanceUID, instances)
   {
     scheduler.retrieveSOPInstance(patientID, studyIstanceUID, seriesIstanceUID,
@@ -166,6 +192,74 @@ int ctkDICOMSchedulerTest1(int argc, char* argv[])
   CHECK_INT(instances.count(), numberOfImages);
   CHECK_INT(files.count(), numberOfImages);
   CHECK_INT(urls.count(), 0);
+  CHECK_INT(numberOfInsertedJobResponseSets, numberOfImages);
+  scheduler.setInsertCoalescingWindow(0);
+
+  std::cout << qPrintable(testName) << ": Running retrieveSeries with spooling" << std::endl;
+  // Files left in the spool directory by a killed application are removed
+  // when the spool directory is first used, unless their job is still active
+  QString retrieveSpoolDirectory = database.databaseDirectory() + "/spool";
+  CHECK_BOOL(QDir().mkpath(retrieveSpoolDirectory), true);
+  QString staleJobUID = QUuid::createUuid().toString(QUuid::StringFormat::WithoutBraces);
+  QString staleFilePath = retrieveSpoolDirectory + "/" + staleJobUID + "-1.2.3.4.dcm";
+  QFile staleFile(staleFilePath);
+  CHECK_BOOL(staleFile.open(QIODevice::WriteOnly), true);
+  staleFile.close();
+  CHECK_INT(ctkDICOMRetrieve::removeStaleSpooledFiles(retrieveSpoolDirectory, QStringList() << staleJobUID), 0);
+  CHECK_BOOL(QFile::exists(staleFilePath), true);
+
+  scheduler.setSpoolRetrievedInstances(true);
+  CHECK_BOOL(scheduler.spoolRetrievedInstances(), true);
+  CHECK_QSTRING(scheduler.retrieveSpoolDirectory(), retrieveSpoolDirectory);
+  CHECK_BOOL(QFile::exists(staleFilePath), false);
+  scheduler.retrieveSeries(patientID, studyIstanceUID, seriesIstanceUID, QThread::LowPriority, QStringList("Test"));
+  scheduler.waitForFinish(false, true);
+
+  files = database.filesForSeries(seriesIstanceUID);
+  files.removeAll(QString(""));
+  CHECK_INT(files.count(), numberOfImages);
+  foreach (const QString& file, files)
+  {
+    CHECK_BOOL(QFile::exists(file), true);
+  }
+
+  // The spooled files are moved into the database or removed
+  QDir spoolDirectory(database.databaseDirectory() + "/spool");
+  CHECK_INT(spoolDirectory.entryList(QDir::Files).count(), 0);
+
+  std::cout << qPrintable(testName) << ": Inserting job response sets within the coalescing window" << std::endl;
+  // All the response sets are passed well within the window: a single inserter job inserts them
+  const int numberOfJobResponseSets = 10;
+  const QString coalescedSeriesInstanceUID = "1.2.826.0.1.3680043.2.1125.999.2.1";
+  scheduler.setInsertCoalescingWindow(2000);
+  numberOfInsertions = 0;
+  numberOfInsertedJobResponseSets = 0;
+  QSet<QString> inserterJobUIDs;
+  for (int index = 0; index < numberOfJobResponseSets; ++index)
+  {
+    DcmDataset* dataset = new DcmDataset;
+    dataset->putAndInsertString(DCM_PatientID, patientID.toStdString().c_str());
+    dataset->putAndInsertString(DCM_StudyInstanceUID, studyIstanceUID.toStdString().c_str());
+    dataset->putAndInsertString(DCM_SeriesInstanceUID, coalescedSeriesInstanceUID.toStdString().c_str());
+    dataset->putAndInsertString(DCM_SOPInstanceUID,
+      QString("1.2.826.0.1.3680043.2.1125.999.3.%1").arg(index).toStdString().c_str());
+
+    QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet(new ctkDICOMJobResponseSet);
+    jobResponseSet->setJobType(ctkDICOMJobResponseSet::JobType::QueryInstances);
+    jobResponseSet->setConnectionName("Test");
+    jobResponseSet->setPatientID(patientID);
+    jobResponseSet->setStudyInstanceUID(studyIstanceUID);
+    jobResponseSet->setSeriesInstanceUID(coalescedSeriesInstanceUID);
+    jobResponseSet->setDataset(dataset);
+    inserterJobUIDs.insert(scheduler.insertJobResponseSet(jobResponseSet, QThread::LowPriority));
+  }
+  scheduler.waitForFinish(false, true);
+
+  CHECK_INT(inserterJobUIDs.count(), 1);
+  CHECK_INT(numberOfInsertedJobResponseSets, numberOfJobResponseSets);
+  CHECK_BOOL(numberOfInsertions < numberOfJobResponseSets, true);
+  CHECK_INT(database.instancesForSeries(coalescedSeriesInstanceUID).count(), numberOfJobResponseSets);
+  scheduler.setInsertCoalescingWindow(0);
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,143 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QFile>
+#include <QImage>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+// ctkCore includes
+#include <ctkCoreTestingMacros.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMThumbnailCache.h"
+#include "ctkDICOMThumbnailStore.h"
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+bool writeThumbnail(const QString& thumbnailPath, int width, int height, QColor color)
+{
+  QImage image(width, height, QImage::Format_RGB32);
+  image.fill(color);
+  return image.save(thumbnailPath, "PNG");
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailCacheTest1(int argc, char* argv[])
+{
+  QApplication app(argc, argv);
+
+  QTemporaryDir tempDirectory;
+  CHECK_BOOL(tempDirectory.isValid(), true);
+
+  QString thumbnailPath = tempDirectory.filePath("thumbnail.png");
+  CHECK_BOOL(writeThumbnail(thumbnailPath, 256, 128, Qt::red), true);
+
+  QString invalidPath = tempDirectory.filePath("invalid.png");
+  QFile invalidFile(invalidPath);
+  CHECK_BOOL(invalidFile.open(QIODevice::WriteOnly), true);
+  invalidFile.write("not an image");
+  invalidFile.close();
+
+  CHECK_BOOL(ctkDICOMThumbnailCache::isValidThumbnailFile(thumbnailPath), true);
+  CHECK_BOOL(ctkDICOMThumbnailCache::isValidThumbnailFile(invalidPath), false);
+  CHECK_BOOL(ctkDICOMThumbnailCache::isValidThumbnailFile(tempDirectory.filePath("missing.png")), false);
+
+  ctkDICOMThumbnailCache cache;
+  CHECK_INT(cache.maximumCacheSize(), 64 * 1024 * 1024);
+  CHECK_INT(cache.numberOfThumbnails(), 0);
+  QSignalSpy loadedSpy(&cache, SIGNAL(thumbnailLoaded(QString)));
+
+  // The thumbnail is decoded in the background
+  CHECK_BOOL(cache.thumbnail(thumbnailPath).isNull(), true);
+  CHECK_BOOL(loadedSpy.wait(5000), true);
+  CHECK_QSTRING(loadedSpy.at(0).at(0).toString(), thumbnailPath);
+  CHECK_BOOL(cache.isThumbnailLoaded(thumbnailPath), true);
+  CHECK_INT(cache.numberOfThumbnails(), 1);
+  CHECK_BOOL(cache.cacheSize() >= 256 * 128 * 3, true);
+
+  QColor backgroundColor;
+  QPixmap thumbnail = cache.thumbnail(thumbnailPath, QSize(), &backgroundColor);
+  CHECK_INT(thumbnail.width(), 256);
+  CHECK_INT(thumbnail.height(), 128);
+  CHECK_BOOL(backgroundColor == QColor(Qt::red), true);
+
+  // Scaled to fit, keeping the aspect ratio
+  QPixmap scaledThumbnail = cache.thumbnail(thumbnailPath, QSize(64, 64));
+  CHECK_INT(scaledThumbnail.width(), 64);
+  CHECK_INT(scaledThumbnail.height(), 32);
+  CHECK_INT(cache.thumbnail(thumbnailPath, QSize(64, 64)).cacheKey(), scaledThumbnail.cacheKey());
+
+  // A regenerated file is decoded again
+  CHECK_BOOL(writeThumbnail(thumbnailPath, 128, 128, Qt::blue), true);
+  CHECK_BOOL(cache.isThumbnailLoaded(thumbnailPath), false);
+  CHECK_BOOL(cache.thumbnail(thumbnailPath).isNull(), true);
+  CHECK_BOOL(loadedSpy.wait(5000), true);
+  thumbnail = cache.thumbnail(thumbnailPath, QSize(), &backgroundColor);
+  CHECK_INT(thumbnail.width(), 128);
+  CHECK_BOOL(backgroundColor == QColor(Qt::blue), true);
+  CHECK_INT(cache.numberOfThumbnails(), 1);
+
+  // Files that cannot be decoded are not decoded again
+  loadedSpy.clear();
+  CHECK_BOOL(cache.thumbnail(invalidPath).isNull(), true);
+  CHECK_BOOL(loadedSpy.wait(500), false);
+  cache.requestThumbnail(invalidPath);
+  CHECK_BOOL(cache.isThumbnailLoaded(invalidPath), false);
+
+  // Thumbnails of packed thumbnail stores
+  QString storeFilePath = tempDirectory.filePath("study" + ctkDICOMThumbnailStore::fileExtension());
+  QFile thumbnailFile(thumbnailPath);
+  CHECK_BOOL(thumbnailFile.open(QIODevice::ReadOnly), true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::writeThumbnail(storeFilePath, "series/instance", thumbnailFile.readAll()), true);
+  QString packedThumbnailPath = ctkDICOMThumbnailStore::packedThumbnailPath(storeFilePath, "series/instance");
+  CHECK_BOOL(ctkDICOMThumbnailCache::isValidThumbnailFile(packedThumbnailPath), true);
+  CHECK_BOOL(ctkDICOMThumbnailCache::isValidThumbnailFile(
+    ctkDICOMThumbnailStore::packedThumbnailPath(storeFilePath, "series/missing")), false);
+  CHECK_BOOL(cache.thumbnail(packedThumbnailPath).isNull(), true);
+  CHECK_BOOL(loadedSpy.wait(5000), true);
+  CHECK_INT(cache.thumbnail(packedThumbnailPath).width(), 128);
+
+  // The memory used is bounded
+  cache.clear();
+  CHECK_INT(cache.numberOfThumbnails(), 0);
+  cache.setMaximumCacheSize(256 * 1024);
+  for (int index = 0; index < 8; ++index)
+  {
+    QString path = tempDirectory.filePath(QString("thumbnail%1.png").arg(index));
+    CHECK_BOOL(writeThumbnail(path, 128, 128, Qt::green), true);
+    cache.requestThumbnail(path);
+    CHECK_BOOL(loadedSpy.wait(5000), true);
+    CHECK_BOOL(cache.cacheSize() <= cache.maximumCacheSize(), true);
+  }
+  CHECK_BOOL(cache.numberOfThumbnails() < 8, true);
+  CHECK_BOOL(cache.isThumbnailLoaded(tempDirectory.filePath("thumbnail7.png")), true);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QVector>
+
+// ctkCore includes
+#include <ctkCoreTestingMacros.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMThumbnailGenerator.h"
+
+// DCMTK includes
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+void setImagePixelModule(DcmItem* item, int columns, int rows, int samplesPerPixel, int bitsAllocated)
+{
+  item->putAndInsertUint16(DCM_Columns, static_cast<Uint16>(columns));
+  item->putAndInsertUint16(DCM_Rows, static_cast<Uint16>(rows));
+  item->putAndInsertUint16(DCM_SamplesPerPixel, static_cast<Uint16>(samplesPerPixel));
+  item->putAndInsertString(DCM_PhotometricInterpretation, samplesPerPixel == 3 ? "RGB" : "MONOCHROME2");
+  if (samplesPerPixel == 3)
+  {
+    item->putAndInsertUint16(DCM_PlanarConfiguration, 0);
+  }
+  item->putAndInsertUint16(DCM_BitsAllocated, static_cast<Uint16>(bitsAllocated));
+  item->putAndInsertUint16(DCM_BitsStored, static_cast<Uint16>(bitsAllocated == 16 ? 12 : 8));
+  item->putAndInsertUint16(DCM_HighBit, static_cast<Uint16>(bitsAllocated == 16 ? 11 : 7));
+  item->putAndInsertUint16(DCM_PixelRepresentation, 0);
+}
+
+//------------------------------------------------------------------------------
+/// Write a synthetic image of \a modality with a gradient pattern. If \a iconSize
+/// is not zero, a uniform white icon image of that size is embedded.
+bool writeImage(const QString& filePath, const char* modality, int columns, int rows,
+                int samplesPerPixel, int bitsAllocated, int numberOfFrames = 1, int iconSize = 0)
+{
+  DcmFileFormat fileFormat;
+  DcmDataset* dataset = fileFormat.getDataset();
+  char uid[100];
+  dataset->putAndInsertString(DCM_SOPClassUID, UID_SecondaryCaptureImageStorage);
+  dataset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+  dataset->putAndInsertString(DCM_StudyInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_STUDY_UID_ROOT));
+  dataset->putAndInsertString(DCM_SeriesInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_SERIES_UID_ROOT));
+  dataset->putAndInsertString(DCM_Modality, modality);
+  setImagePixelModule(dataset, columns, rows, samplesPerPixel, bitsAllocated);
+  if (numberOfFrames > 1)
+  {
+    dataset->putAndInsertString(DCM_NumberOfFrames, QString::number(numberOfFrames).toLatin1().data());
+  }
+
+  const unsigned long numberOfSamples =
+    static_cast<unsigned long>(columns) * rows * samplesPerPixel * numberOfFrames;
+  if (bitsAllocated == 16)
+  {
+    QVector<Uint16> pixels(static_cast<int>(numberOfSamples));
+    for (unsigned long index = 0; index < numberOfSamples; ++index)
+    {
+      pixels[static_cast<int>(index)] = static_cast<Uint16>((index % columns) * 4095 / columns);
+    }
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(), numberOfSamples);
+  }
+  else
+  {
+    QVector<Uint8> pixels(static_cast<int>(numberOfSamples));
+    for (unsigned long index = 0; index < numberOfSamples; ++index)
+    {
+      pixels[static_cast<int>(index)] = static_cast<Uint8>(((index / samplesPerPixel) % columns) * 255 / columns);
+    }
+    dataset->putAndInsertUint8Array(DCM_PixelData, pixels.data(), numberOfSamples);
+  }
+
+  if (iconSize > 0)
+  {
+    DcmItem* iconItem = nullptr;
+    if (dataset->findOrCreateSequenceItem(DCM_IconImageSequence, iconItem).bad())
+    {
+      return false;
+    }
+    setImagePixelModule(iconItem, iconSize, iconSize, 1, 8);
+    QVector<Uint8> iconPixels(iconSize * iconSize, 255);
+    iconItem->putAndInsertUint8Array(DCM_PixelData, iconPixels.data(), iconPixels.size());
+  }
+
+  return fileFormat.saveFile(filePath.toUtf8().data(), EXS_LittleEndianExplicit).good();
+}
+
+//------------------------------------------------------------------------------
+/// Return the number of thumbnails generated per second from \a filePath.
+double benchmark(ctkDICOMThumbnailGenerator& generator, const QString& filePath, int iterations)
+{
+  QElapsedTimer timer;
+  timer.start();
+  for (int iteration = 0; iteration < iterations; ++iteration)
+  {
+    QImage image;
+    if (!generator.generateThumbnail(filePath, image))
+    {
+      return 0.;
+    }
+  }
+  return iterations * 1000. / qMax<qint64>(timer.elapsed(), 1);
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailGeneratorTest1(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QTemporaryDir tempDirectory;
+  CHECK_BOOL(tempDirectory.isValid(), true);
+
+  struct TestImage
+  {
+    QString Name;
+    QString FilePath;
+    int Width;
+    int Height;
+  };
+  QList<TestImage> testImages;
+
+  QString ctFilePath = tempDirectory.filePath("ct.dcm");
+  CHECK_BOOL(writeImage(ctFilePath, "CT", 512, 512, 1, 16), true);
+  testImages << TestImage{"CT 512x512", ctFilePath, 512, 512};
+
+  QString mgFilePath = tempDirectory.filePath("mg.dcm");
+  CHECK_BOOL(writeImage(mgFilePath, "MG", 2048, 2560, 1, 16), true);
+  testImages << TestImage{"MG 2048x2560", mgFilePath, 2048, 2560};
+
+  QString usFilePath = tempDirectory.filePath("us.dcm");
+  CHECK_BOOL(writeImage(usFilePath, "US", 640, 480, 3, 8, 30), true);
+  testImages << TestImage{"US 640x480x30 RGB", usFilePath, 640, 480};
+
+  // Real data given as arguments
+  for (int argIndex = 1; argIndex < argc; ++argIndex)
+  {
+    testImages << TestImage{QString("File %1").arg(argv[argIndex]), QString(argv[argIndex]), 0, 0};
+  }
+
+  ctkDICOMThumbnailGenerator generator;
+  generator.setWidth(128);
+  generator.setHeight(128);
+  CHECK_BOOL(generator.scaleBeforeRendering(), true);
+  CHECK_BOOL(generator.useIconImage(), false);
+
+  // Thumbnails fit in the requested size, with or without scaling before rendering
+  for (const TestImage& testImage : testImages)
+  {
+    for (int scaleBeforeRendering = 0; scaleBeforeRendering < 2; ++scaleBeforeRendering)
+    {
+      generator.setScaleBeforeRendering(scaleBeforeRendering);
+      QImage image;
+      CHECK_BOOL(generator.generateThumbnail(testImage.FilePath, image), true);
+      CHECK_BOOL(image.width() == 128 || image.height() == 128, true);
+      CHECK_BOOL(image.width() <= 128 && image.height() <= 128, true);
+      if (testImage.Width > 0)
+      {
+        QSize expectedSize = QSize(testImage.Width, testImage.Height).scaled(128, 128, Qt::KeepAspectRatio);
+        CHECK_INT(image.width(), expectedSize.width());
+        CHECK_INT(image.height(), expectedSize.height());
+      }
+    }
+  }
+
+  // The gradient is preserved by the scaled rendering
+  generator.setScaleBeforeRendering(true);
+  QImage ctImage;
+  CHECK_BOOL(generator.generateThumbnail(ctFilePath, ctImage), true);
+  CHECK_BOOL(qGray(ctImage.pixel(4, 64)) < qGray(ctImage.pixel(123, 64)), true);
+
+  // Icon images are used when they are large enough or when requested
+  QString smallIconFilePath = tempDirectory.filePath("smallicon.dcm");
+  CHECK_BOOL(writeImage(smallIconFilePath, "CT", 512, 512, 1, 16, 1, 64), true);
+  QString largeIconFilePath = tempDirectory.filePath("largeicon.dcm");
+  CHECK_BOOL(writeImage(largeIconFilePath, "CT", 512, 512, 1, 16, 1, 128), true);
+
+  QImage iconImage;
+  CHECK_BOOL(generator.generateThumbnail(smallIconFilePath, iconImage), true);
+  CHECK_BOOL(qGray(iconImage.pixel(4, 64)) < qGray(iconImage.pixel(123, 64)), true);
+  CHECK_BOOL(generator.generateThumbnail(largeIconFilePath, iconImage), true);
+  CHECK_INT(iconImage.width(), 128);
+  CHECK_INT(qGray(iconImage.pixel(4, 64)), qGray(iconImage.pixel(123, 64)));
+  generator.setUseIconImage(true);
+  CHECK_BOOL(generator.generateThumbnail(smallIconFilePath, iconImage), true);
+  CHECK_INT(iconImage.width(), 128);
+  CHECK_INT(qGray(iconImage.pixel(4, 64)), qGray(iconImage.pixel(123, 64)));
+  generator.setUseIconImage(false);
+
+  // Thumbnail throughput
+  const int iterations = 10;
+  for (const TestImage& testImage : testImages)
+  {
+    generator.setScaleBeforeRendering(false);
+    double fullResolution = benchmark(generator, testImage.FilePath, iterations);
+    generator.setScaleBeforeRendering(true);
+    double scaled = benchmark(generator, testImage.FilePath, iterations);
+    std::cout << qPrintable(testImage.Name) << ": "
+              << fullResolution << " thumbnails/s rendered at full resolution, "
+              << scaled << " thumbnails/s scaled before rendering" << std::endl;
+  }
+  double icon = benchmark(generator, largeIconFilePath, iterations);
+  std::cout << "CT 512x512 with 128x128 icon: " << icon << " thumbnails/s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QTemporaryDir>
+
+// ctkCore includes
+#include <ctkCoreTestingMacros.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMThumbnailStore.h"
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+QByteArray encodedThumbnail(int seed)
+{
+  QImage image(128, 128, QImage::Format_RGB32);
+  for (int y = 0; y < image.height(); ++y)
+  {
+    for (int x = 0; x < image.width(); ++x)
+    {
+      image.setPixel(x, y, qRgb((x * seed) % 256, (y + seed) % 256, (x + y) % 256));
+    }
+  }
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  image.save(&buffer, "PNG");
+  return data;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailStoreTest1(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QTemporaryDir tempDirectory;
+  CHECK_BOOL(tempDirectory.isValid(), true);
+  QDir thumbnailsDir(tempDirectory.path());
+
+  //
+  // Packed thumbnail paths
+  //
+  QString storeFilePath = thumbnailsDir.filePath("study" + ctkDICOMThumbnailStore::fileExtension());
+  QString packedPath = ctkDICOMThumbnailStore::packedThumbnailPath(storeFilePath, "series/instance");
+  QString splitStoreFilePath;
+  QString splitKey;
+  CHECK_BOOL(ctkDICOMThumbnailStore::splitPackedThumbnailPath(packedPath, splitStoreFilePath, splitKey), true);
+  CHECK_QSTRING(splitStoreFilePath, storeFilePath);
+  CHECK_QSTRING(splitKey, "series/instance");
+  CHECK_BOOL(ctkDICOMThumbnailStore::isPackedThumbnailPath(thumbnailsDir.filePath("series/instance.png")), false);
+  CHECK_BOOL(ctkDICOMThumbnailStore::isPackedThumbnailPath(storeFilePath + "#"), false);
+
+  //
+  // Write, replace and remove thumbnails
+  //
+  QByteArray thumbnail1 = encodedThumbnail(1);
+  QByteArray thumbnail2 = encodedThumbnail(2);
+  CHECK_INT(ctkDICOMThumbnailStore::thumbnailOffset(storeFilePath, "a"), -1);
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "a").isEmpty(), true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::writeThumbnail(storeFilePath, "a", thumbnail1), true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::writeThumbnail(storeFilePath, "b", thumbnail2), true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "a") == thumbnail1, true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "b") == thumbnail2, true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::thumbnailDateTime(storeFilePath, "a").isValid(), true);
+  CHECK_INT(ctkDICOMThumbnailStore::keys(storeFilePath).size(), 2);
+
+  // The index is rebuilt from the file
+  ctkDICOMThumbnailStore::clearIndex();
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "b") == thumbnail2, true);
+
+  // Replaced thumbnails get a new offset
+  qint64 offset = ctkDICOMThumbnailStore::thumbnailOffset(storeFilePath, "a");
+  CHECK_BOOL(ctkDICOMThumbnailStore::writeThumbnail(storeFilePath, "a", thumbnail2), true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::thumbnailOffset(storeFilePath, "a") != offset, true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "a") == thumbnail2, true);
+
+  // Superseded records are compacted
+  qint64 storeSize = QFileInfo(storeFilePath).size();
+  for (int index = 0; index < 10; ++index)
+  {
+    CHECK_BOOL(ctkDICOMThumbnailStore::writeThumbnail(storeFilePath, "a", index % 2 ? thumbnail1 : thumbnail2), true);
+  }
+  CHECK_BOOL(QFileInfo(storeFilePath).size() < storeSize + 4 * qMin(thumbnail1.size(), thumbnail2.size()), true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "a") == thumbnail1, true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "b") == thumbnail2, true);
+
+  CHECK_BOOL(ctkDICOMThumbnailStore::removeThumbnails(storeFilePath, QStringList() << "a"), true);
+  CHECK_INT(ctkDICOMThumbnailStore::thumbnailOffset(storeFilePath, "a"), -1);
+  CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, "b") == thumbnail2, true);
+  CHECK_BOOL(ctkDICOMThumbnailStore::removeThumbnails(storeFilePath, QStringList() << "b"), true);
+  CHECK_BOOL(QFile::exists(storeFilePath), false);
+
+  // Files that are not stores are left untouched
+  QString otherFilePath = thumbnailsDir.filePath("other" + ctkDICOMThumbnailStore::fileExtension());
+  QFile otherFile(otherFilePath);
+  CHECK_BOOL(otherFile.open(QIODevice::WriteOnly), true);
+  otherFile.write("not a thumbnail store");
+  otherFile.close();
+  CHECK_BOOL(ctkDICOMThumbnailStore::writeThumbnail(otherFilePath, "a", thumbnail1), false);
+  CHECK_INT(QFileInfo(otherFilePath).size(), 21);
+
+  //
+  // Migration and cold open of a 500 series study
+  //
+  const int numberOfSeries = 500;
+  QDir studyDir(thumbnailsDir.filePath("study500"));
+  QStringList thumbnailFilePaths;
+  for (int seriesIndex = 0; seriesIndex < numberOfSeries; ++seriesIndex)
+  {
+    QString seriesFolder = QString("series%1").arg(seriesIndex);
+    CHECK_BOOL(studyDir.mkpath(seriesFolder), true);
+    QString thumbnailFilePath = studyDir.filePath(seriesFolder + "/instance.png");
+    QFile thumbnailFile(thumbnailFilePath);
+    CHECK_BOOL(thumbnailFile.open(QIODevice::WriteOnly), true);
+    thumbnailFile.write(encodedThumbnail(seriesIndex));
+    thumbnailFilePaths << thumbnailFilePath;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  qint64 fileBytes = 0;
+  for (const QString& thumbnailFilePath : thumbnailFilePaths)
+  {
+    QFile thumbnailFile(thumbnailFilePath);
+    CHECK_BOOL(thumbnailFile.open(QIODevice::ReadOnly), true);
+    fileBytes += thumbnailFile.readAll().size();
+  }
+  qint64 elapsedFiles = timer.elapsed();
+
+  QString studyStoreFilePath = thumbnailsDir.filePath("study500" + ctkDICOMThumbnailStore::fileExtension());
+  CHECK_INT(ctkDICOMThumbnailStore::importThumbnailDirectory(studyDir.path(), studyStoreFilePath), numberOfSeries);
+  CHECK_BOOL(studyDir.exists(), false);
+
+  // Cold open: the index is built when the store is first read
+  ctkDICOMThumbnailStore::clearIndex();
+  timer.restart();
+  QMap<QString, QByteArray> thumbnails = ctkDICOMThumbnailStore::readThumbnails(studyStoreFilePath);
+  qint64 elapsedStore = timer.elapsed();
+  CHECK_INT(thumbnails.size(), numberOfSeries);
+  qint64 storeBytes = 0;
+  for (const QByteArray& thumbnail : thumbnails)
+  {
+    storeBytes += thumbnail.size();
+  }
+  CHECK_BOOL(storeBytes == fileBytes, true);
+  CHECK_BOOL(thumbnails.value("series42/instance") == encodedThumbnail(42), true);
+
+  ctkDICOMThumbnailStore::clearIndex();
+  timer.restart();
+  for (int seriesIndex = 0; seriesIndex < numberOfSeries; ++seriesIndex)
+  {
+    CHECK_BOOL(ctkDICOMThumbnailStore::readThumbnail(studyStoreFilePath,
+      QString("series%1/instance").arg(seriesIndex)).isEmpty(), false);
+  }
+  qint64 elapsedStoreByThumbnail = timer.elapsed();
+
+  std::cout << numberOfSeries << " series thumbnails: "
+            << elapsedFiles << " ms from files, "
+            << elapsedStore << " ms from the packed store at once, "
+            << elapsedStoreByThumbnail << " ms from the packed store one by one" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,416 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+
+// ctkCore includes
+#include <ctkLogger.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMAssociationPool.h"
+
+// DCMTK includes
+#include <dcmtk/dcmnet/scu.h>
+
+static ctkLogger logger("org.commontk.dicom.DICOMAssociationPool");
+
+//------------------------------------------------------------------------------
+class ctkDICOMAssociationPoolPrivate
+{
+public:
+  ctkDICOMAssociationPoolPrivate();
+
+  struct IdleAssociation
+  {
+    QSharedPointer<DcmSCU> SCU;
+    QElapsedTimer IdleTimer;
+  };
+
+  /// Remove the idle associations that exceeded the idle timeout.
+  /// Must be called with Mutex locked.
+  QList<QSharedPointer<DcmSCU>> takeExpiredAssociations();
+
+  /// Release the associations. Must be called without Mutex locked,
+  /// as an A-RELEASE waits for the answer of the peer.
+  static void releaseAssociations(const QList<QSharedPointer<DcmSCU>>& associations);
+
+  /// Register a lease for the key and return the most recently returned idle association
+  /// if any. Must be called with Mutex locked.
+  QSharedPointer<DcmSCU> lease(const QString& key);
+
+  int MaximumAssociationsPerServer;
+  int IdleTimeout;
+  int LeaseTimeout;
+
+  mutable QMutex Mutex;
+  QWaitCondition AssociationReturned;
+  /// map from association key to idle associations, most recently returned last
+  QMap<QString, QList<IdleAssociation>> IdleAssociations;
+  /// map from association key to number of leased associations
+  QMap<QString, int> LeasedAssociations;
+
+  int NegotiatedCount;
+  int ReusedCount;
+};
+
+//------------------------------------------------------------------------------
+// ctkDICOMAssociationPoolPrivate methods
+
+//------------------------------------------------------------------------------
+ctkDICOMAssociationPoolPrivate::ctkDICOMAssociationPoolPrivate()
+{
+  this->MaximumAssociationsPerServer = 4;
+  this->IdleTimeout = 10000;
+  this->LeaseTimeout = 60000;
+  this->NegotiatedCount = 0;
+  this->ReusedCount = 0;
+}
+
+//------------------------------------------------------------------------------
+QList<QSharedPointer<DcmSCU>> ctkDICOMAssociationPoolPrivate::takeExpiredAssociations()
+{
+  QList<QSharedPointer<DcmSCU>> expiredAssociations;
+  QMap<QString, QList<IdleAssociation>>::iterator it = this->IdleAssociations.begin();
+  while (it != this->IdleAssociations.end())
+  {
+    QList<IdleAssociation>& idleAssociations = it.value();
+    for (int index = idleAssociations.count() - 1; index >= 0; --index)
+    {
+      if (idleAssociations[index].IdleTimer.elapsed() >= this->IdleTimeout)
+      {
+        expiredAssociations.append(idleAssociations.takeAt(index).SCU);
+      }
+    }
+
+    if (idleAssociations.isEmpty())
+    {
+      it = this->IdleAssociations.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  return expiredAssociations;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPoolPrivate::releaseAssociations(const QList<QSharedPointer<DcmSCU>>& associations)
+{
+  foreach (QSharedPointer<DcmSCU> scu, associations)
+  {
+    if (scu && scu->isConnected())
+    {
+      scu->releaseAssociation();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<DcmSCU> ctkDICOMAssociationPoolPrivate::lease(const QString& key)
+{
+  // Reuse the most recently returned association, the peer is the least
+  // likely to have closed it.
+  QSharedPointer<DcmSCU> scu;
+  if (this->IdleAssociations.contains(key))
+  {
+    QList<IdleAssociation>& idleAssociations = this->IdleAssociations[key];
+    while (!scu && !idleAssociations.isEmpty())
+    {
+      QSharedPointer<DcmSCU> idleSCU = idleAssociations.takeLast().SCU;
+      if (idleSCU->isConnected())
+      {
+        scu = idleSCU;
+      }
+    }
+    if (idleAssociations.isEmpty())
+    {
+      this->IdleAssociations.remove(key);
+    }
+  }
+
+  this->LeasedAssociations[key] += 1;
+  if (scu)
+  {
+    this->ReusedCount++;
+  }
+  else
+  {
+    this->NegotiatedCount++;
+  }
+
+  return scu;
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMAssociationPool methods
+
+//------------------------------------------------------------------------------
+ctkDICOMAssociationPool::ctkDICOMAssociationPool(QObject* parent)
+  : QObject(parent),
+    d_ptr(new ctkDICOMAssociationPoolPrivate)
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMAssociationPool::~ctkDICOMAssociationPool()
+{
+  this->releaseIdleAssociations();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::setMaximumAssociationsPerServer(int maximumAssociationsPerServer)
+{
+  Q_D(ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  d->MaximumAssociationsPerServer = qMax(1, maximumAssociationsPerServer);
+  d->AssociationReturned.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::maximumAssociationsPerServer() const
+{
+  Q_D(const ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  return d->MaximumAssociationsPerServer;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::setIdleTimeout(int idleTimeout)
+{
+  Q_D(ctkDICOMAssociationPool);
+  QList<QSharedPointer<DcmSCU>> expiredAssociations;
+  {
+    QMutexLocker locker(&d->Mutex);
+    d->IdleTimeout = qMax(0, idleTimeout);
+    expiredAssociations = d->takeExpiredAssociations();
+  }
+  d->releaseAssociations(expiredAssociations);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::idleTimeout() const
+{
+  Q_D(const ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  return d->IdleTimeout;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::setLeaseTimeout(int leaseTimeout)
+{
+  Q_D(ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  d->LeaseTimeout = qMax(0, leaseTimeout);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::leaseTimeout() const
+{
+  Q_D(const ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  return d->LeaseTimeout;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMAssociationPool::associationKey(const QString& serviceType,
+                                               const QString& callingAETitle,
+                                               const QString& calledAETitle,
+                                               const QString& host,
+                                               int port)
+{
+  return QString("%1|%2|%3|%4|%5").arg(serviceType, callingAETitle, calledAETitle,
+                                       host.toLower(), QString::number(port));
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<DcmSCU> ctkDICOMAssociationPool::leaseAssociation(const QString& key)
+{
+  Q_D(ctkDICOMAssociationPool);
+  QSharedPointer<DcmSCU> scu;
+  QList<QSharedPointer<DcmSCU>> expiredAssociations;
+  {
+    QMutexLocker locker(&d->Mutex);
+    expiredAssociations = d->takeExpiredAssociations();
+
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+    while (!d->IdleAssociations.contains(key) &&
+           d->LeasedAssociations.value(key, 0) >= d->MaximumAssociationsPerServer)
+    {
+      qint64 remainingTime = d->LeaseTimeout - waitTimer.elapsed();
+      if (remainingTime <= 0 ||
+          !d->AssociationReturned.wait(&d->Mutex, static_cast<unsigned long>(remainingTime)))
+      {
+        logger.warn(QString("Timeout while waiting for a free association for %1, "
+                            "exceeding the maximum of %2 associations.")
+                      .arg(key)
+                      .arg(d->MaximumAssociationsPerServer));
+        break;
+      }
+    }
+
+    scu = d->lease(key);
+  }
+
+  d->releaseAssociations(expiredAssociations);
+  return scu;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMAssociationPool::tryLeaseAssociation(const QString& key, QSharedPointer<DcmSCU>& scu)
+{
+  Q_D(ctkDICOMAssociationPool);
+  bool leased = false;
+  QList<QSharedPointer<DcmSCU>> expiredAssociations;
+  {
+    QMutexLocker locker(&d->Mutex);
+    expiredAssociations = d->takeExpiredAssociations();
+    if (d->IdleAssociations.contains(key) ||
+        d->LeasedAssociations.value(key, 0) < d->MaximumAssociationsPerServer)
+    {
+      scu = d->lease(key);
+      leased = true;
+    }
+  }
+
+  d->releaseAssociations(expiredAssociations);
+  return leased;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::returnAssociation(const QString& key,
+                                                QSharedPointer<DcmSCU> scu,
+                                                bool reusable)
+{
+  Q_D(ctkDICOMAssociationPool);
+  QList<QSharedPointer<DcmSCU>> associationsToRelease;
+  {
+    QMutexLocker locker(&d->Mutex);
+    associationsToRelease = d->takeExpiredAssociations();
+
+    int leasedAssociations = d->LeasedAssociations.value(key, 0) - 1;
+    if (leasedAssociations > 0)
+    {
+      d->LeasedAssociations[key] = leasedAssociations;
+    }
+    else
+    {
+      d->LeasedAssociations.remove(key);
+    }
+
+    if (scu)
+    {
+      if (reusable && scu->isConnected() && d->IdleTimeout > 0 &&
+          d->IdleAssociations.value(key).count() < d->MaximumAssociationsPerServer)
+      {
+        ctkDICOMAssociationPoolPrivate::IdleAssociation idleAssociation;
+        idleAssociation.SCU = scu;
+        idleAssociation.IdleTimer.start();
+        d->IdleAssociations[key].append(idleAssociation);
+      }
+      else
+      {
+        associationsToRelease.append(scu);
+      }
+    }
+
+    d->AssociationReturned.wakeAll();
+  }
+
+  d->releaseAssociations(associationsToRelease);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::releaseIdleAssociations()
+{
+  Q_D(ctkDICOMAssociationPool);
+  QList<QSharedPointer<DcmSCU>> idleAssociations;
+  {
+    QMutexLocker locker(&d->Mutex);
+    foreach (const QList<ctkDICOMAssociationPoolPrivate::IdleAssociation>& associations, d->IdleAssociations)
+    {
+      foreach (const ctkDICOMAssociationPoolPrivate::IdleAssociation& association, associations)
+      {
+        idleAssociations.append(association.SCU);
+      }
+    }
+    d->IdleAssociations.clear();
+  }
+
+  d->releaseAssociations(idleAssociations);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::numberOfIdleAssociations() const
+{
+  Q_D(const ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  int count = 0;
+  foreach (const QList<ctkDICOMAssociationPoolPrivate::IdleAssociation>& associations, d->IdleAssociations)
+  {
+    count += associations.count();
+  }
+  return count;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::numberOfLeasedAssociations() const
+{
+  Q_D(const ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  int count = 0;
+  foreach (int leasedAssociations, d->LeasedAssociations)
+  {
+    count += leasedAssociations;
+  }
+  return count;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::numberOfNegotiatedAssociations() const
+{
+  Q_D(const ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  return d->NegotiatedCount;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMAssociationPool::numberOfReusedAssociations() const
+{
+  Q_D(const ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  return d->ReusedCount;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMAssociationPool::resetStatistics()
+{
+  Q_D(ctkDICOMAssociationPool);
+  QMutexLocker locker(&d->Mutex);
+  d->NegotiatedCount = 0;
+  d->ReusedCount = 0;
+}
@@ -0,0 +1,134 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMAssociationPool_h
+#define __ctkDICOMAssociationPool_h
+
+// Qt includes
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+
+// ctkDICOMCore includes
+#include "ctkDICOMCoreExport.h"
+class ctkDICOMAssociationPoolPrivate;
+
+// DCMTK includes
+class DcmSCU;
+
+/// \ingroup DICOM_Core
+///
+/// Pool of negotiated DIMSE associations shared by the query and retrieve workers.
+///
+/// Associations are identified by a key made of the service type and the
+/// connection parameters (see associationKey()). A worker leases an association
+/// before issuing its requests and returns it when it is done, so that the next
+/// job for the same server can skip the TCP connection and A-ASSOCIATE handshake.
+/// The number of associations leased at the same time for a given key is limited
+/// by maximumAssociationsPerServer, and idle associations are released once they
+/// have not been used for idleTimeout milliseconds.
+///
+/// All methods are thread safe.
+class CTK_DICOM_CORE_EXPORT ctkDICOMAssociationPool : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(int maximumAssociationsPerServer READ maximumAssociationsPerServer WRITE setMaximumAssociationsPerServer);
+  Q_PROPERTY(int idleTimeout READ idleTimeout WRITE setIdleTimeout);
+  Q_PROPERTY(int leaseTimeout READ leaseTimeout WRITE setLeaseTimeout);
+
+public:
+  explicit ctkDICOMAssociationPool(QObject* parent = 0);
+  virtual ~ctkDICOMAssociationPool();
+
+  ///@{
+  /// Maximum number of associations leased at the same time for the same key.
+  /// Additional lease requests wait until an association is returned.
+  /// 4 by default.
+  void setMaximumAssociationsPerServer(int maximumAssociationsPerServer);
+  int maximumAssociationsPerServer() const;
+  ///@}
+
+  ///@{
+  /// Time in milliseconds after which an unused association is released.
+  /// 0 disables pooling (associations are released as soon as they are returned).
+  /// 10000 by default.
+  void setIdleTimeout(int idleTimeout);
+  int idleTimeout() const;
+  ///@}
+
+  ///@{
+  /// Maximum time in milliseconds a lease request waits for an association
+  /// when maximumAssociationsPerServer is reached. When the time is elapsed the
+  /// lease is granted anyway, so that a leaked association cannot block the workers.
+  /// 60000 by default.
+  void setLeaseTimeout(int leaseTimeout);
+  int leaseTimeout() const;
+  ///@}
+
+  /// Build the key identifying associations that can be shared.
+  /// \a serviceType distinguishes associations negotiated with different
+  /// presentation contexts (e.g. "FIND" or "RETRIEVE").
+  static QString associationKey(const QString& serviceType,
+                                const QString& callingAETitle,
+                                const QString& calledAETitle,
+                                const QString& host,
+                                int port);
+
+  /// Lease an association for \a key.
+  /// Return an idle, already negotiated association if available. Otherwise
+  /// return a null pointer and the caller is expected to negotiate a new association
+  /// and hand it over with returnAssociation() when done.
+  /// In both cases returnAssociation() must be called exactly once for each lease.
+  QSharedPointer<DcmSCU> leaseAssociation(const QString& key);
+
+  /// Lease an association for \a key without waiting.
+  /// Return false if maximumAssociationsPerServer associations are already leased
+  /// and none is idle. Otherwise \a scu is set as in leaseAssociation().
+  bool tryLeaseAssociation(const QString& key, QSharedPointer<DcmSCU>& scu);
+
+  /// Return a leased association.
+  /// If \a reusable is true and the association is still connected then it is kept
+  /// for the next lease of the same \a key, otherwise it is released.
+  /// \a scu may be null if the caller could not negotiate an association.
+  void returnAssociation(const QString& key, QSharedPointer<DcmSCU> scu, bool reusable = true);
+
+  /// Release all idle associations.
+  Q_INVOKABLE void releaseIdleAssociations();
+
+  ///@{
+  /// Statistics
+  Q_INVOKABLE int numberOfIdleAssociations() const;
+  Q_INVOKABLE int numberOfLeasedAssociations() const;
+  /// Number of leases that required the negotiation of a new association
+  Q_INVOKABLE int numberOfNegotiatedAssociations() const;
+  /// Number of leases served with an idle association
+  Q_INVOKABLE int numberOfReusedAssociations() const;
+  Q_INVOKABLE void resetStatistics();
+  ///@}
+
+protected:
+  QScopedPointer<ctkDICOMAssociationPoolPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMAssociationPool);
+  Q_DISABLE_COPY(ctkDICOMAssociationPool);
+};
+
+#endif
@@ -296,6 +296,27 @@ public slots:
     return td->DICOMLevel;
   }
 
+  void setMemoryHighWaterMark(ctkDICOMJobDetail* td, qint64 memoryHighWaterMark)
+  {
+    if (td == nullptr)
+    {
+      logger.error("ctkDICOMJobDetail::setMemoryHighWaterMark - Invalid ctkJobDetail");
+      return;
+    }
+
+    td->MemoryHighWaterMark = memoryHighWaterMark;
+  }
+  qint64 memoryHighWaterMark(ctkDICOMJobDetail* td)
+  {
+    if (td == nullptr)
+    {
+      logger.error("ctkDICOMJobDetail::memoryHighWaterMark - Invalid ctkJobDetail");
+      return -1;
+    }
+
+    return td->MemoryHighWaterMark;
+  }
+
   void setJobType(ctkDICOMJobDetail* td, ctkDICOMJobResponseSet::JobType jobType)
   {
     if (td == nullptr)
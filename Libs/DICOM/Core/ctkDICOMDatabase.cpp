@@ -19,16 +19,22 @@
 =========================================================================*/
 
 // Qt includes
+#include <QBuffer>
 #include <QDate>
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QImage>
+#include <QMutexLocker>
 #include <QSet>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QStringList>
+#include <QTemporaryFile>
 #include <QUuid>
 #include <QVariant>
 
@@ -37,6 +43,8 @@
 #include "ctkDICOMAbstractThumbnailGenerator.h"
 #include "ctkDICOMItem.h"
 #include "ctkDICOMJobResponseSet.h"
+#include "ctkDICOMThumbnailGenerator.h"
+#include "ctkDICOMThumbnailStore.h"
 
 #include "ctkLogger.h"
 #include "ctkUtils.h"
@@ -83,12 +91,24 @@ ctkDICOMDatabasePrivate::ctkDICOMDatabasePrivate(ctkDICOMDatabase& o)
   , DisplayedFieldsTableAvailable(false)
   , UseShortStoragePath(true)
   , UseSystemFileCopy(false)
+  , PackedThumbnailStorage(false)
   , ThumbnailGenerator(nullptr)
+  , WriteMutex(nullptr)
+  , LookupCache(0)
+  , LookupCacheHitCount(0)
+  , LookupCacheMissCount(0)
   , TagCacheVerified(false)
   , SchemaVersion("0.8.1")
 {
   this->resetLastInsertedValues();
   this->DisplayedFieldGenerator = new ctkDICOMDisplayedFieldGenerator(q_ptr);
+
+  // Cached lookup results may become obsolete when records are added or removed
+  QObject::connect(q_ptr, &ctkDICOMDatabase::patientAdded, q_ptr, [this]() { this->clearLookupCache(); });
+  QObject::connect(q_ptr, &ctkDICOMDatabase::studyAdded, q_ptr, [this]() { this->clearLookupCache(); });
+  QObject::connect(q_ptr, &ctkDICOMDatabase::seriesAdded, q_ptr, [this]() { this->clearLookupCache(); });
+  QObject::connect(q_ptr, &ctkDICOMDatabase::seriesRemoved, q_ptr, [this]() { this->clearLookupCache(); });
+  QObject::connect(q_ptr, &ctkDICOMDatabase::instanceAdded, q_ptr, [this]() { this->clearLookupCache(); });
 }
 
 //------------------------------------------------------------------------------
@@ -98,6 +118,117 @@ void ctkDICOMDatabasePrivate::resetLastInsertedValues()
   this->InsertedConnectionsIDCache.clear();
   this->InsertedStudyUIDsCache.clear();
   this->InsertedSeriesUIDsCache.clear();
+  this->DisplayedFieldsDirtySOPInstanceUIDs.clear();
+  this->DisplayedFieldsDataVersion = -1;
+  this->clearLookupCache();
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMDatabasePrivate::WriteMutexType* ctkDICOMDatabasePrivate::writeMutexForFile(const QString& databaseFileName)
+{
+  if (databaseFileName.isEmpty() || databaseFileName == ":memory:")
+  {
+    return nullptr;
+  }
+  static QMutex writeMutexesLock;
+  static QMap<QString, QSharedPointer<WriteMutexType> > writeMutexes;
+  QString key = QFileInfo(databaseFileName).absoluteFilePath();
+  QMutexLocker locker(&writeMutexesLock);
+  QSharedPointer<WriteMutexType>& writeMutex = writeMutexes[key];
+  if (writeMutex.isNull())
+  {
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
+    writeMutex = QSharedPointer<WriteMutexType>(new WriteMutexType());
+#else
+    writeMutex = QSharedPointer<WriteMutexType>(new WriteMutexType(QMutex::Recursive));
+#endif
+  }
+  return writeMutex.data();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::applyJournalMode(QSqlDatabase& database)
+{
+  if (this->JournalMode.isEmpty() || !database.isOpen())
+  {
+    return true;
+  }
+  QSqlQuery journalModeQuery(database);
+  if (!journalModeQuery.exec(QString("PRAGMA journal_mode = %1").arg(this->JournalMode))
+    || !journalModeQuery.next())
+  {
+    logger.error("SQLITE ERROR setting journal mode: " + journalModeQuery.lastError().driverText());
+    return false;
+  }
+  // SQLite returns the journal mode that is actually in effect, which may differ from the
+  // requested one (for example, in-memory databases do not support WAL)
+  QString actualJournalMode = journalModeQuery.value(0).toString();
+  journalModeQuery.finish();
+  if (actualJournalMode.compare(this->JournalMode, Qt::CaseInsensitive) != 0)
+  {
+    logger.warn(QString("Requested journal mode %1 but %2 is used for database %3")
+      .arg(this->JournalMode).arg(actualJournalMode).arg(database.databaseName()));
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMDatabasePrivate::lookupCachedValue(const QString& key, QString& value)
+{
+  if (this->LookupCache.maxCost() <= 0)
+  {
+    return false;
+  }
+  QString* cachedValue = this->LookupCache.object(key);
+  if (!cachedValue)
+  {
+    this->LookupCacheMissCount++;
+    return false;
+  }
+  this->LookupCacheHitCount++;
+  value = *cachedValue;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::setLookupCachedValue(const QString& key, const QString& value)
+{
+  if (this->LookupCache.maxCost() <= 0)
+  {
+    return;
+  }
+  this->LookupCache.insert(key, new QString(value));
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::clearLookupCache()
+{
+  this->LookupCache.clear();
+}
+
+//------------------------------------------------------------------------------
+QSqlQuery& ctkDICOMDatabasePrivate::preparedQuery(const QSqlDatabase& database, const QString& statement)
+{
+  QString key = database.connectionName() + ":" + statement;
+  QSharedPointer<QSqlQuery> query = this->PreparedQueries.value(key);
+  if (!query)
+  {
+    query = QSharedPointer<QSqlQuery>(new QSqlQuery(database));
+    if (!query->prepare(statement))
+    {
+      logger.error(QString("SQL prepare failed: \n%1 \nError: \n%2")
+        .arg(statement, query->lastError().text()));
+    }
+    this->PreparedQueries[key] = query;
+  }
+  return *query;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabasePrivate::clearPreparedQueries()
+{
+  this->PreparedQueries.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -183,6 +314,17 @@ bool ctkDICOMDatabasePrivate::loggedExec(QSqlQuery& query, const QString& queryS
   return (success);
 }
 
+//------------------------------------------------------------------------------
+qint64 ctkDICOMDatabasePrivate::dataVersion()
+{
+  QSqlQuery dataVersionQuery(this->Database);
+  if (!this->loggedExec(dataVersionQuery, QString("PRAGMA data_version")) || !dataVersionQuery.next())
+  {
+    return -1;
+  }
+  return dataVersionQuery.value(0).toLongLong();
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabasePrivate::loggedExecBatch(QSqlQuery& query)
 {
@@ -330,8 +472,8 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::insertPatient(
   }
   patientsBirthDate = dataset.GetElementAsString(DCM_PatientBirthDate);
 
-  QSqlQuery checkPatientExistsQuery(this->Database);
-  checkPatientExistsQuery.prepare("SELECT * FROM Patients WHERE PatientID = ? AND PatientsName = ?");
+  QSqlQuery& checkPatientExistsQuery = this->preparedQuery(this->Database,
+    "SELECT UID FROM Patients WHERE PatientID = ? AND PatientsName = ?");
   checkPatientExistsQuery.bindValue(0, tempPatientID);
   checkPatientExistsQuery.bindValue(1, tempPatientsName);
   loggedExec(checkPatientExistsQuery);
@@ -341,7 +483,8 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::insertPatient(
   if (patientFound)
   {
     // patient found
-    dbPatientID = checkPatientExistsQuery.value(checkPatientExistsQuery.record().indexOf("UID")).toInt();
+    dbPatientID = checkPatientExistsQuery.value(0).toInt();
+    checkPatientExistsQuery.finish();
     logger.debug("Found patient in the database as UID: " + QString::number(dbPatientID));
     logger.debug("New patient ID cache item: " + compositeID + "->" + QString::number(dbPatientID));
   }
@@ -352,8 +495,8 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::insertPatient(
     QString patientsSex(dataset.GetElementAsString(DCM_PatientSex));
     QString patientComments(dataset.GetElementAsString(DCM_PatientComments));
 
-    QSqlQuery insertPatientStatement(this->Database);
-    insertPatientStatement.prepare("INSERT INTO Patients "
+    checkPatientExistsQuery.finish();
+    QSqlQuery& insertPatientStatement = this->preparedQuery(this->Database, "INSERT INTO Patients "
       "('UID', 'PatientsName', 'PatientID', 'PatientsBirthDate', 'PatientsBirthTime', 'PatientsSex', 'PatientsAge', 'PatientsComments', "
       "'InsertTimestamp', 'DisplayedPatientsName', 'DisplayedNumberOfStudies', 'DisplayedFieldsUpdatedTimestamp', 'Connections')"
       "VALUES ( NULL, ?, ?, ?, ?, ?, ?, ?, ?, NULL, NULL, NULL, NULL)");
@@ -365,6 +508,7 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::insertPatient(
     // TODO: shift patient's age to study,
     // since this is not a patient level attribute in images
     // insertPatientStatement.bindValue(5, patientsAge);
+    insertPatientStatement.bindValue(5, QVariant());
     insertPatientStatement.bindValue(6, patientComments);
     insertPatientStatement.bindValue(7, QDateTime::currentDateTime());
     if (!loggedExec(insertPatientStatement))
@@ -413,6 +557,7 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::insertConnectionName(
     {
       return ctkDICOMDatabase::InsertResult::Failed;
     }
+    this->clearLookupCache();
     logger.debug("New connection name inserted: patient database item ID = " + QString().setNum(dbPatientID));
   }
 
@@ -442,6 +587,7 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::updateConnections(
   updateConnectionsStatement.bindValue(":connectionsData", connectionsData);
   updateConnectionsStatement.bindValue(":uid", dbPatientID);
 
+  this->clearLookupCache();
   if (!loggedExec(updateConnectionsStatement))
   {
     return ctkDICOMDatabase::InsertResult::Failed;
@@ -455,62 +601,50 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::insertStudy(
   const ctkDICOMItem& dataset, const int& dbPatientID)
 {
   QString studyInstanceUID(dataset.GetElementAsString(DCM_StudyInstanceUID) );
-  QSqlQuery checkStudyExistsQuery(this->Database);
-  checkStudyExistsQuery.prepare( "SELECT * FROM Studies WHERE StudyInstanceUID = ?" );
-  checkStudyExistsQuery.bindValue( 0, studyInstanceUID );
-  if (!loggedExec(checkStudyExistsQuery))
-  {
+  QString studyID(dataset.GetElementAsString(DCM_StudyID) );
+  QString studyDate(dataset.GetElementAsString(DCM_StudyDate) );
+  QString studyTime(dataset.GetElementAsString(DCM_StudyTime) );
+  QString accessionNumber(dataset.GetElementAsString(DCM_AccessionNumber) );
+  QString modalitiesInStudy(dataset.GetElementAsString(DCM_ModalitiesInStudy) );
+  QString institutionName(dataset.GetElementAsString(DCM_InstitutionName) );
+  QString performingPhysiciansName(dataset.GetElementAsString(DCM_PerformingPhysicianName) );
+  QString referringPhysician(dataset.GetElementAsString(DCM_ReferringPhysicianName) );
+  QString studyDescription(dataset.GetElementAsString(DCM_StudyDescription) );
+
+  // The study is only inserted if it is not in the database yet (StudyInstanceUID is the primary key),
+  // which saves a separate existence check query.
+  QSqlQuery& insertStudyStatement = this->preparedQuery(this->Database, "INSERT OR IGNORE INTO Studies "
+    "( 'StudyInstanceUID', 'PatientsUID', 'StudyID', 'StudyDate', 'StudyTime', 'AccessionNumber', 'ModalitiesInStudy', 'InstitutionName', 'ReferringPhysician', 'PerformingPhysiciansName', "
+      "'StudyDescription', 'InsertTimestamp', 'DisplayedNumberOfSeries', 'DisplayedFieldsUpdatedTimestamp' ) "
+    "VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, NULL, NULL)");
+  insertStudyStatement.bindValue(0, studyInstanceUID);
+  insertStudyStatement.bindValue(1, dbPatientID);
+  insertStudyStatement.bindValue(2, studyID);
+  insertStudyStatement.bindValue(3, QDate::fromString(studyDate, "yyyyMMdd"));
+  insertStudyStatement.bindValue(4, studyTime);
+  insertStudyStatement.bindValue(5, accessionNumber);
+  insertStudyStatement.bindValue(6, modalitiesInStudy);
+  insertStudyStatement.bindValue(7, institutionName);
+  insertStudyStatement.bindValue(8, referringPhysician);
+  insertStudyStatement.bindValue(9, performingPhysiciansName);
+  insertStudyStatement.bindValue(10, studyDescription);
+  insertStudyStatement.bindValue(11, QDateTime::currentDateTime());
+  if (!insertStudyStatement.exec())
+  {
+    logger.error("Error executing statement: " + insertStudyStatement.lastQuery() + " Error: " + insertStudyStatement.lastError().text() );
     return ctkDICOMDatabase::InsertResult::Failed;
   }
-  if (!checkStudyExistsQuery.next())
-  {
-    logger.debug("Need to insert new study: " + studyInstanceUID);
-
-    QString studyID(dataset.GetElementAsString(DCM_StudyID) );
-    QString studyDate(dataset.GetElementAsString(DCM_StudyDate) );
-    QString studyTime(dataset.GetElementAsString(DCM_StudyTime) );
-    QString accessionNumber(dataset.GetElementAsString(DCM_AccessionNumber) );
-    QString modalitiesInStudy(dataset.GetElementAsString(DCM_ModalitiesInStudy) );
-    QString institutionName(dataset.GetElementAsString(DCM_InstitutionName) );
-    QString performingPhysiciansName(dataset.GetElementAsString(DCM_PerformingPhysicianName) );
-    QString referringPhysician(dataset.GetElementAsString(DCM_ReferringPhysicianName) );
-    QString studyDescription(dataset.GetElementAsString(DCM_StudyDescription) );
-
-    QSqlQuery insertStudyStatement(this->Database);
-    insertStudyStatement.prepare("INSERT INTO Studies "
-      "( 'StudyInstanceUID', 'PatientsUID', 'StudyID', 'StudyDate', 'StudyTime', 'AccessionNumber', 'ModalitiesInStudy', 'InstitutionName', 'ReferringPhysician', 'PerformingPhysiciansName', "
-        "'StudyDescription', 'InsertTimestamp', 'DisplayedNumberOfSeries', 'DisplayedFieldsUpdatedTimestamp' ) "
-      "VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, NULL, NULL)");
-    insertStudyStatement.addBindValue(studyInstanceUID);
-    insertStudyStatement.addBindValue(dbPatientID);
-    insertStudyStatement.addBindValue(studyID);
-    insertStudyStatement.addBindValue(QDate::fromString(studyDate, "yyyyMMdd"));
-    insertStudyStatement.addBindValue(studyTime);
-    insertStudyStatement.addBindValue(accessionNumber);
-    insertStudyStatement.addBindValue(modalitiesInStudy);
-    insertStudyStatement.addBindValue(institutionName);
-    insertStudyStatement.addBindValue(referringPhysician );
-    insertStudyStatement.addBindValue(performingPhysiciansName);
-    insertStudyStatement.addBindValue(studyDescription);
-    insertStudyStatement.addBindValue(QDateTime::currentDateTime());
-    if (!insertStudyStatement.exec())
-    {
-      logger.error("Error executing statement: " + insertStudyStatement.lastQuery() + " Error: " + insertStudyStatement.lastError().text() );
-      return ctkDICOMDatabase::InsertResult::Failed;
-    }
-    else
-    {
-      this->InsertedStudyUIDsCache.insert(studyInstanceUID);
-    }
+  bool inserted = (insertStudyStatement.numRowsAffected() > 0);
+  insertStudyStatement.finish();
 
-    return ctkDICOMDatabase::InsertResult::Inserted;
-  }
-  else
+  this->InsertedStudyUIDsCache.insert(studyInstanceUID);
+  if (!inserted)
   {
     logger.debug("Used existing study: " + studyInstanceUID);
-    this->InsertedStudyUIDsCache.insert(studyInstanceUID);
     return ctkDICOMDatabase::InsertResult::NotInserted;
   }
+  logger.debug("Inserted new study: " + studyInstanceUID);
+  return ctkDICOMDatabase::InsertResult::Inserted;
 }
 
 //------------------------------------------------------------------------------
@@ -518,71 +652,58 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabasePrivate::insertSeries(
   const ctkDICOMItem& dataset, const QString& studyInstanceUID)
 {
   QString seriesInstanceUID(dataset.GetElementAsString(DCM_SeriesInstanceUID) );
-  QSqlQuery checkSeriesExistsQuery(this->Database);
-  checkSeriesExistsQuery.prepare( "SELECT * FROM Series WHERE SeriesInstanceUID = ?" );
-  checkSeriesExistsQuery.bindValue( 0, seriesInstanceUID );
-  logger.debug("Statement: " + checkSeriesExistsQuery.lastQuery() );
-  if (!loggedExec(checkSeriesExistsQuery))
-  {
+  QString seriesDate(dataset.GetElementAsString(DCM_SeriesDate) );
+  QString seriesTime(dataset.GetElementAsString(DCM_SeriesTime) );
+  QString seriesDescription(dataset.GetElementAsString(DCM_SeriesDescription) );
+  QString modality(dataset.GetElementAsString(DCM_Modality) );
+  QString bodyPartExamined(dataset.GetElementAsString(DCM_BodyPartExamined) );
+  QString frameOfReferenceUID(dataset.GetElementAsString(DCM_FrameOfReferenceUID) );
+  QString contrastAgent(dataset.GetElementAsString(DCM_ContrastBolusAgent) );
+  QString scanningSequence(dataset.GetElementAsString(DCM_ScanningSequence) );
+  long seriesNumber(dataset.GetElementAsInteger(DCM_SeriesNumber) );
+  long acquisitionNumber(dataset.GetElementAsInteger(DCM_AcquisitionNumber) );
+  long echoNumber(dataset.GetElementAsInteger(DCM_EchoNumbers) );
+  long temporalPosition(dataset.GetElementAsInteger(DCM_TemporalPositionIdentifier) );
+
+  // The series is only inserted if it is not in the database yet (SeriesInstanceUID is the primary key),
+  // which saves a separate existence check query.
+  QSqlQuery& insertSeriesStatement = this->preparedQuery(this->Database, "INSERT OR IGNORE INTO Series "
+    "( 'SeriesInstanceUID', 'StudyInstanceUID', 'SeriesNumber', 'SeriesDate', 'SeriesTime', 'SeriesDescription', 'Modality', 'BodyPartExamined', "
+      "'FrameOfReferenceUID', 'AcquisitionNumber', 'ContrastAgent', 'ScanningSequence', 'EchoNumber', 'TemporalPosition', 'InsertTimestamp' ) "
+    "VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
+  insertSeriesStatement.bindValue(0, seriesInstanceUID);
+  insertSeriesStatement.bindValue(1, studyInstanceUID);
+  insertSeriesStatement.bindValue(2, static_cast<int>(seriesNumber));
+  insertSeriesStatement.bindValue(3, QDate::fromString ( seriesDate, "yyyyMMdd" ));
+  insertSeriesStatement.bindValue(4, seriesTime);
+  insertSeriesStatement.bindValue(5, seriesDescription);
+  insertSeriesStatement.bindValue(6, modality);
+  insertSeriesStatement.bindValue(7, bodyPartExamined);
+  insertSeriesStatement.bindValue(8, frameOfReferenceUID);
+  insertSeriesStatement.bindValue(9, static_cast<int>(acquisitionNumber));
+  insertSeriesStatement.bindValue(10, contrastAgent);
+  insertSeriesStatement.bindValue(11, scanningSequence);
+  insertSeriesStatement.bindValue(12, static_cast<int>(echoNumber));
+  insertSeriesStatement.bindValue(13, static_cast<int>(temporalPosition));
+  insertSeriesStatement.bindValue(14, QDateTime::currentDateTime());
+  if (!insertSeriesStatement.exec())
+  {
+    logger.error("Error executing statement: "
+                   + insertSeriesStatement.lastQuery()
+                   + " Error: " + insertSeriesStatement.lastError().text());
     return ctkDICOMDatabase::InsertResult::Failed;
   }
-  if (!checkSeriesExistsQuery.next())
-  {
-    logger.debug("Need to insert new series: " + seriesInstanceUID);
-
-    QString seriesDate(dataset.GetElementAsString(DCM_SeriesDate) );
-    QString seriesTime(dataset.GetElementAsString(DCM_SeriesTime) );
-    QString seriesDescription(dataset.GetElementAsString(DCM_SeriesDescription) );
-    QString modality(dataset.GetElementAsString(DCM_Modality) );
-    QString bodyPartExamined(dataset.GetElementAsString(DCM_BodyPartExamined) );
-    QString frameOfReferenceUID(dataset.GetElementAsString(DCM_FrameOfReferenceUID) );
-    QString contrastAgent(dataset.GetElementAsString(DCM_ContrastBolusAgent) );
-    QString scanningSequence(dataset.GetElementAsString(DCM_ScanningSequence) );
-    long seriesNumber(dataset.GetElementAsInteger(DCM_SeriesNumber) );
-    long acquisitionNumber(dataset.GetElementAsInteger(DCM_AcquisitionNumber) );
-    long echoNumber(dataset.GetElementAsInteger(DCM_EchoNumbers) );
-    long temporalPosition(dataset.GetElementAsInteger(DCM_TemporalPositionIdentifier) );
-
-    QSqlQuery insertSeriesStatement(this->Database);
-    insertSeriesStatement.prepare( "INSERT INTO Series "
-      "( 'SeriesInstanceUID', 'StudyInstanceUID', 'SeriesNumber', 'SeriesDate', 'SeriesTime', 'SeriesDescription', 'Modality', 'BodyPartExamined', "
-        "'FrameOfReferenceUID', 'AcquisitionNumber', 'ContrastAgent', 'ScanningSequence', 'EchoNumber', 'TemporalPosition', 'InsertTimestamp' ) "
-      "VALUES ( ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ? )" );
-    insertSeriesStatement.addBindValue(seriesInstanceUID);
-    insertSeriesStatement.addBindValue(studyInstanceUID);
-    insertSeriesStatement.addBindValue(static_cast<int>(seriesNumber));
-    insertSeriesStatement.addBindValue(QDate::fromString ( seriesDate, "yyyyMMdd" ));
-    insertSeriesStatement.addBindValue(seriesTime);
-    insertSeriesStatement.addBindValue(seriesDescription);
-    insertSeriesStatement.addBindValue(modality);
-    insertSeriesStatement.addBindValue(bodyPartExamined);
-    insertSeriesStatement.addBindValue(frameOfReferenceUID);
-    insertSeriesStatement.addBindValue(static_cast<int>(acquisitionNumber));
-    insertSeriesStatement.addBindValue(contrastAgent);
-    insertSeriesStatement.addBindValue(scanningSequence);
-    insertSeriesStatement.addBindValue(static_cast<int>(echoNumber));
-    insertSeriesStatement.addBindValue(static_cast<int>(temporalPosition));
-    insertSeriesStatement.addBindValue(QDateTime::currentDateTime());
-    if (!insertSeriesStatement.exec())
-    {
-      logger.error("Error executing statement: "
-                     + insertSeriesStatement.lastQuery()
-                     + " Error: " + insertSeriesStatement.lastError().text());
-      return ctkDICOMDatabase::InsertResult::Failed;
-    }
-    else
-    {
-      this->InsertedSeriesUIDsCache.insert(seriesInstanceUID);
-    }
+  bool inserted = (insertSeriesStatement.numRowsAffected() > 0);
+  insertSeriesStatement.finish();
 
-    return ctkDICOMDatabase::InsertResult::Inserted;
-  }
-  else
+  this->InsertedSeriesUIDsCache.insert(seriesInstanceUID);
+  if (!inserted)
   {
     logger.debug("Used existing series: " + seriesInstanceUID);
-    this->InsertedSeriesUIDsCache.insert(seriesInstanceUID);
     return ctkDICOMDatabase::InsertResult::NotInserted;
   }
+  logger.debug("Inserted new series: " + seriesInstanceUID);
+  return ctkDICOMDatabase::InsertResult::Inserted;
 }
 
 //------------------------------------------------------------------------------
@@ -594,6 +715,7 @@ bool ctkDICOMDatabasePrivate::openTagCacheDatabase()
     return true;
   }
   QString tagCacheConnectionName = this->Database.connectionName() + "TagCache";
+  this->clearPreparedQueries();
   if (QSqlDatabase::contains(tagCacheConnectionName))
   {
     QSqlDatabase::removeDatabase(tagCacheConnectionName);
@@ -614,6 +736,8 @@ bool ctkDICOMDatabasePrivate::openTagCacheDatabase()
   pragmaSyncQuery.exec("PRAGMA synchronous = OFF");
   pragmaSyncQuery.finish();
 
+  this->applyJournalMode(this->TagCacheDatabase);
+
   return true;
 }
 
@@ -665,6 +789,7 @@ bool ctkDICOMDatabasePrivate::removeImage(const QString& sopInstanceUID)
   {
     logger.error("SQLITE ERROR deleting old image row: " + deleteFile.lastError().driverText());
   }
+  this->clearLookupCache();
   return success;
 }
 
@@ -697,10 +822,26 @@ QString ctkDICOMDatabasePrivate::internalStoragePath(const QString& studyInstanc
   return path;
 }
 
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabasePrivate::thumbnailStoreFilePath(const QString& studyInstanceUID,
+  const QString& seriesInstanceUID, const QString& sopInstanceUID)
+{
+  Q_Q(ctkDICOMDatabase);
+  QString studyComponent = this->internalStoragePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID).section('/', 0, 0);
+  return q->databaseDirectory() + "/thumbs/" + studyComponent + ctkDICOMThumbnailStore::fileExtension();
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabasePrivate::thumbnailStoreKey(const QString& studyInstanceUID,
+  const QString& seriesInstanceUID, const QString& sopInstanceUID)
+{
+  return this->internalStoragePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID).section('/', 1);
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabasePrivate::storeDatasetFile(const ctkDICOMItem& dataset, const QString& originalFilePath,
   const QString& studyInstanceUID, const QString& seriesInstanceUID, const QString& sopInstanceUID,
-  QString& storedFilePath)
+  QString& storedFilePath, bool moveFile)
 {
   Q_Q(ctkDICOMDatabase);
 
@@ -736,6 +877,14 @@ bool ctkDICOMDatabasePrivate::storeDatasetFile(const ctkDICOMItem& dataset, cons
       QFile::remove(storedFilePath);
     }
 
+    // Renaming is instantaneous when the original file is on the same volume
+    // as the database (e.g. spooled in the database directory).
+    if (moveFile && QFile::rename(originalFilePath, storedFilePath))
+    {
+      logger.debug("Move file from: " + originalFilePath + " to: " + storedFilePath);
+      return true;
+    }
+
     bool copySuccess = false;
     if (this->UseSystemFileCopy)
     {
@@ -795,6 +944,10 @@ bool ctkDICOMDatabasePrivate::storeDatasetFile(const ctkDICOMItem& dataset, cons
     if (copySuccess)
     {
       logger.debug("Copy file from: " + originalFilePath + " to: " + storedFilePath);
+      if (moveFile)
+      {
+        QFile::remove(originalFilePath);
+      }
     }
   }
 
@@ -809,8 +962,8 @@ bool ctkDICOMDatabasePrivate::indexingStatusForFile(const QString& filePath, con
   datasetUpToDate = false;
   databaseFilename.clear();
 
-  QSqlQuery fileExistsQuery(Database);
-  fileExistsQuery.prepare("SELECT InsertTimestamp,Filename FROM Images WHERE SOPInstanceUID == :sopInstanceUID");
+  QSqlQuery& fileExistsQuery = this->preparedQuery(this->Database,
+    "SELECT InsertTimestamp,Filename FROM Images WHERE SOPInstanceUID == :sopInstanceUID");
   fileExistsQuery.bindValue(":sopInstanceUID", sopInstanceUID);
   bool success = fileExistsQuery.exec();
   if (!success)
@@ -822,6 +975,7 @@ bool ctkDICOMDatabasePrivate::indexingStatusForFile(const QString& filePath, con
   if (!foundSOPInstanceUID)
   {
     // this data set is not in the database yet
+    fileExistsQuery.finish();
     return true;
   }
 
@@ -830,13 +984,15 @@ bool ctkDICOMDatabasePrivate::indexingStatusForFile(const QString& filePath, con
   // The SOP instance UID exists in the database. In theory, new SOP instance UID must be generated if
   // a file is modified, but some software may not respect this, so check if the file was modified.
   databaseFilename = fileExistsQuery.value(1).toString();
+  QString databaseInsertTimestampString = fileExistsQuery.value(0).toString();
+  fileExistsQuery.finish();
   QFileInfo databaseFileInfo(databaseFilename);
   if (!databaseFileInfo.isRelative())
   {
     // database stores a link to an external file, if it is the same filename and the file has not changed
     // since insertion date then it means that the dataset is up-to-date
     QDateTime fileLastModified(databaseFileInfo.lastModified());
-    QDateTime databaseInsertTimestamp(QDateTime::fromString(fileExistsQuery.value(0).toString(), Qt::ISODate));
+    QDateTime databaseInsertTimestamp(QDateTime::fromString(databaseInsertTimestampString, Qt::ISODate));
     // Compare QFileInfo objects instead of path strings to ensure equivalent file names
     // (such as same file name in uppercase/lowercase on Windows) are considered as equal.
     if (databaseFileInfo == QFileInfo(filePath) && fileLastModified < databaseInsertTimestamp)
@@ -993,6 +1149,7 @@ bool ctkDICOMDatabasePrivate::uidsForDataSet(QString& patientsName, QString& pat
 void ctkDICOMDatabasePrivate::insert(const ctkDICOMItem& dataset, const QString& filePath, bool storeFile, bool generateThumbnail)
 {
   Q_Q(ctkDICOMDatabase);
+  QMutexLocker writeLocker(this->WriteMutex);
 
   // this is the method that all other insert signatures end up calling
   // after they have pre-parsed their arguments
@@ -1053,14 +1210,15 @@ void ctkDICOMDatabasePrivate::insert(const ctkDICOMItem& dataset, const QString&
     if (!storeFile)
     {
       // file is linked, maybe it is already inserted
-      QSqlQuery checkImageExistsQuery(Database);
-      checkImageExistsQuery.prepare("SELECT * FROM Images WHERE SOPInstanceUID = ?");
-      checkImageExistsQuery.addBindValue(sopInstanceUID);
+      QSqlQuery& checkImageExistsQuery = this->preparedQuery(this->Database,
+        "SELECT SOPInstanceUID FROM Images WHERE SOPInstanceUID = ?");
+      checkImageExistsQuery.bindValue(0, sopInstanceUID);
       if (!loggedExec(checkImageExistsQuery))
       {
         return;
       }
       alreadyInserted = checkImageExistsQuery.next();
+      checkImageExistsQuery.finish();
     }
     if (!alreadyInserted)
     {
@@ -1077,13 +1235,13 @@ void ctkDICOMDatabasePrivate::insert(const ctkDICOMItem& dataset, const QString&
         storedFilePathInDatabase = storedFilePath;
       }
 
-      QSqlQuery insertImageStatement(Database);
-      insertImageStatement.prepare("INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'URL', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ?, ? )");
-      insertImageStatement.addBindValue(sopInstanceUID);
-      insertImageStatement.addBindValue(storedFilePathInDatabase);
-      insertImageStatement.addBindValue(QString(""));
-      insertImageStatement.addBindValue(seriesInstanceUID);
-      insertImageStatement.addBindValue(QDateTime::currentDateTime());
+      QSqlQuery& insertImageStatement = this->preparedQuery(this->Database,
+        "INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'URL', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ?, ? )");
+      insertImageStatement.bindValue(0, sopInstanceUID);
+      insertImageStatement.bindValue(1, storedFilePathInDatabase);
+      insertImageStatement.bindValue(2, QString(""));
+      insertImageStatement.bindValue(3, seriesInstanceUID);
+      insertImageStatement.bindValue(4, QDateTime::currentDateTime());
 
       if (!insertImageStatement.exec())
       {
@@ -1099,6 +1257,7 @@ void ctkDICOMDatabasePrivate::insert(const ctkDICOMItem& dataset, const QString&
 
       // let users of this class track when things happen
       emit q->instanceAdded(sopInstanceUID);
+      this->DisplayedFieldsDirtySOPInstanceUIDs.insert(sopInstanceUID);
 
       insertOperationResult = ctkDICOMDatabase::InsertResult::Inserted;
     }
@@ -1160,12 +1319,9 @@ QString ctkDICOMDatabasePrivate::getDisplayPatientFieldsKey(const QString& patie
 QString ctkDICOMDatabasePrivate::getDisplayStudyFieldsKey(QString studyInstanceUID, QMap<QString, QMap<QString, QString> > &displayedFieldsMapStudy)
 {
   // Look for the study in the displayed fields cache first
-  for (auto it = displayedFieldsMapStudy.constBegin(); it != displayedFieldsMapStudy.constEnd(); ++it)
+  if (displayedFieldsMapStudy.contains(studyInstanceUID))
   {
-    if ( !it.value()["StudyInstanceUID"].compare(studyInstanceUID) )
-    {
-      return studyInstanceUID;
-    }
+    return studyInstanceUID;
   }
 
   // Look for the study in the display database
@@ -1201,12 +1357,9 @@ QString ctkDICOMDatabasePrivate::getDisplayStudyFieldsKey(QString studyInstanceU
 QString ctkDICOMDatabasePrivate::getDisplaySeriesFieldsKey(QString seriesInstanceUID, QMap<QString, QMap<QString, QString> > &displayedFieldsMapSeries)
 {
   // Look for the series in the displayed fields cache first
-  for (auto it = displayedFieldsMapSeries.constBegin(); it != displayedFieldsMapSeries.constEnd(); ++it)
+  if (displayedFieldsMapSeries.contains(seriesInstanceUID))
   {
-    if ( !it.value()["SeriesInstanceUID"].compare(seriesInstanceUID) )
-    {
-      return seriesInstanceUID;
-    }
+    return seriesInstanceUID;
   }
 
   // Look for the series in the display database
@@ -1264,8 +1417,8 @@ bool ctkDICOMDatabasePrivate::applyDisplayedFieldsChanges( QMap<QString, QMap<QS
       continue;
     }
 
-    QSqlQuery displayPatientsQuery(this->Database);
-    displayPatientsQuery.prepare( "SELECT * FROM Patients WHERE PatientID=:patientID AND PatientsName=:patientsName ;" );
+    QSqlQuery& displayPatientsQuery = this->preparedQuery(this->Database,
+      "SELECT UID FROM Patients WHERE PatientID=:patientID AND PatientsName=:patientsName ;" );
     displayPatientsQuery.bindValue(":patientID", currentPatient["PatientID"]);
     displayPatientsQuery.bindValue(":patientsName", currentPatient["PatientsName"]);
     if (!displayPatientsQuery.exec())
@@ -1275,7 +1428,11 @@ bool ctkDICOMDatabasePrivate::applyDisplayedFieldsChanges( QMap<QString, QMap<QS
     }
     if (displayPatientsQuery.next())
     {
-      QString displayPatientsFieldUpdateString;
+      int patientUID = displayPatientsQuery.value(0).toInt();
+      displayPatientsQuery.finish();
+
+      // Displayed fields and update timestamp are written in a single statement
+      QStringList displayPatientsFieldUpdates;
       QList<QString> boundValues;
       for (auto tagIt = currentPatient.constBegin(); tagIt != currentPatient.constEnd(); ++tagIt)
       {
@@ -1283,30 +1440,21 @@ bool ctkDICOMDatabasePrivate::applyDisplayedFieldsChanges( QMap<QString, QMap<QS
         {
           continue; // Do not write patient index that is only used internally and temporarily
         }
-        displayPatientsFieldUpdateString.append( tagIt.key() + " = ? , " );
+        displayPatientsFieldUpdates << tagIt.key() + " = ?";
         boundValues << tagIt.value();
       }
+      displayPatientsFieldUpdates << "DisplayedFieldsUpdatedTimestamp = CURRENT_TIMESTAMP";
 
-      // Trim the separators from the end
-      displayPatientsFieldUpdateString = displayPatientsFieldUpdateString.left(displayPatientsFieldUpdateString.size() - 3);
-
-      QSqlRecord patientRecord = displayPatientsQuery.record();
-      int patientUID = patientRecord.value("UID").toInt();
-
-      QSqlQuery updateDisplayPatientStatement(this->Database);
-      updateDisplayPatientStatement.prepare( QString("UPDATE Patients SET %1 WHERE UID = ? ;").arg(displayPatientsFieldUpdateString) );
+      QSqlQuery& updateDisplayPatientStatement = this->preparedQuery(this->Database,
+        QString("UPDATE Patients SET %1 WHERE UID = ? ;").arg(displayPatientsFieldUpdates.join(", ")) );
+      int bindIndex = 0;
       foreach (QString boundValue, boundValues)
       {
-        updateDisplayPatientStatement.addBindValue(boundValue);
+        updateDisplayPatientStatement.bindValue(bindIndex++, boundValue);
       }
-      updateDisplayPatientStatement.addBindValue(patientUID);
+      updateDisplayPatientStatement.bindValue(bindIndex, patientUID);
       this->loggedExec(updateDisplayPatientStatement);
 
-      QSqlQuery updateDisplayedFieldsUpdatedTimestampStatement(this->Database);
-      updateDisplayedFieldsUpdatedTimestampStatement.prepare("UPDATE Patients SET DisplayedFieldsUpdatedTimestamp=CURRENT_TIMESTAMP WHERE UID = ? ;");
-      updateDisplayedFieldsUpdatedTimestampStatement.addBindValue(patientUID);
-      this->loggedExec(updateDisplayedFieldsUpdatedTimestampStatement);
-
       patientCompositeIdToPatientUidMap[compositeID] = patientUID;
     }
     else
@@ -1325,50 +1473,40 @@ bool ctkDICOMDatabasePrivate::applyDisplayedFieldsChanges( QMap<QString, QMap<QS
       continue;
     }
     QMap<QString, QString> currentStudy = studyIt.value();
-    QSqlQuery displayStudiesQuery(this->Database);
-    displayStudiesQuery.prepare("SELECT StudyInstanceUID FROM Studies WHERE StudyInstanceUID = ? ;");
-    displayStudiesQuery.addBindValue(currentStudyInstanceUid);
-    if (!displayStudiesQuery.exec())
-    {
-      logger.error("SQLITE ERROR: " + displayStudiesQuery.lastError().driverText());
-      return false;
-    }
-    if (displayStudiesQuery.next())
+
+    // Displayed fields and update timestamp are written in a single statement,
+    // the number of affected rows tells if the study exists.
+    QStringList displayStudiesFieldUpdates;
+    QList<QString> boundValues;
+    for (auto tagIt = currentStudy.constBegin(); tagIt != currentStudy.constEnd(); ++tagIt)
     {
-      QString displayStudiesFieldUpdateString;
-      QList<QString> boundValues;
-      for (auto tagIt = currentStudy.constBegin(); tagIt != currentStudy.constEnd(); ++tagIt)
+      const QString& tagName = tagIt.key();
+      if (!tagName.compare("PatientCompositeID"))
       {
-        const QString& tagName = tagIt.key();
-        if (!tagName.compare("PatientCompositeID"))
-        {
-          displayStudiesFieldUpdateString.append( "PatientsUID = ? , " );
-          boundValues << QString::number(patientCompositeIdToPatientUidMap[tagIt.value()]);
-        }
-        else
-        {
-          displayStudiesFieldUpdateString.append( tagName + " = ? , " );
-          boundValues << tagIt.value();
-        }
+        displayStudiesFieldUpdates << "PatientsUID = ?";
+        boundValues << QString::number(patientCompositeIdToPatientUidMap[tagIt.value()]);
       }
-      // Trim the separators from the end
-      displayStudiesFieldUpdateString = displayStudiesFieldUpdateString.left(displayStudiesFieldUpdateString.size() - 3);
-
-      QSqlQuery updateDisplayStudyStatement(this->Database);
-      updateDisplayStudyStatement.prepare( QString("UPDATE Studies SET %1 WHERE StudyInstanceUID = ? ;").arg(displayStudiesFieldUpdateString) );
-      foreach (QString boundValue, boundValues)
+      else
       {
-        updateDisplayStudyStatement.addBindValue(boundValue);
+        displayStudiesFieldUpdates << tagName + " = ?";
+        boundValues << tagIt.value();
       }
-      updateDisplayStudyStatement.addBindValue(currentStudy.value("StudyInstanceUID"));
-      this->loggedExec(updateDisplayStudyStatement);
+    }
+    displayStudiesFieldUpdates << "DisplayedFieldsUpdatedTimestamp = CURRENT_TIMESTAMP";
 
-      QSqlQuery updateDisplayedFieldsUpdatedTimestampStatement(this->Database);
-      updateDisplayedFieldsUpdatedTimestampStatement.prepare("UPDATE Studies SET DisplayedFieldsUpdatedTimestamp=CURRENT_TIMESTAMP WHERE StudyInstanceUID = ? ;");
-      updateDisplayedFieldsUpdatedTimestampStatement.addBindValue(currentStudy.value("StudyInstanceUID"));
-      this->loggedExec(updateDisplayedFieldsUpdatedTimestampStatement);
+    QSqlQuery& updateDisplayStudyStatement = this->preparedQuery(this->Database,
+      QString("UPDATE Studies SET %1 WHERE StudyInstanceUID = ? ;").arg(displayStudiesFieldUpdates.join(", ")) );
+    int bindIndex = 0;
+    foreach (QString boundValue, boundValues)
+    {
+      updateDisplayStudyStatement.bindValue(bindIndex++, boundValue);
     }
-    else
+    updateDisplayStudyStatement.bindValue(bindIndex, currentStudyInstanceUid);
+    if (!this->loggedExec(updateDisplayStudyStatement))
+    {
+      continue;
+    }
+    if (updateDisplayStudyStatement.numRowsAffected() <= 0)
     {
       logger.error("in applyDisplayedFieldsChanges: Failed to find study with StudyInstanceUID=" + currentStudyInstanceUid);
       continue;
@@ -1383,43 +1521,32 @@ bool ctkDICOMDatabasePrivate::applyDisplayedFieldsChanges( QMap<QString, QMap<QS
     {
       continue;
     }
-    // Insert row into Series if does not exist
     QMap<QString, QString> currentSeries = seriesIt.value();
-    QSqlQuery displaySeriesQuery(this->Database);
-    displaySeriesQuery.prepare("SELECT SeriesInstanceUID FROM Series WHERE SeriesInstanceUID = ? ;");
-    displaySeriesQuery.addBindValue(currentSeriesInstanceUid);
-    if (!displaySeriesQuery.exec())
+
+    // Displayed fields and update timestamp are written in a single statement,
+    // the number of affected rows tells if the series exists.
+    QStringList displaySeriesFieldUpdates;
+    QList<QString> boundValues;
+    for (auto tagIt = currentSeries.constBegin(); tagIt != currentSeries.constEnd(); ++tagIt)
     {
-      logger.error("SQLITE ERROR: " + displaySeriesQuery.lastError().driverText());
-      return false;
+      displaySeriesFieldUpdates << tagIt.key() + " = ?";
+      boundValues << tagIt.value();
     }
-    if (displaySeriesQuery.next())
-    {
-      QString displaySeriesFieldUpdateString;
-      QList<QString> boundValues;
-      for (auto tagIt = currentSeries.constBegin(); tagIt != currentSeries.constEnd(); ++tagIt)
-      {
-        displaySeriesFieldUpdateString.append( tagIt.key() + " = ? , " );
-        boundValues << tagIt.value();
-      }
-      // Trim the separators from the end
-      displaySeriesFieldUpdateString = displaySeriesFieldUpdateString.left(displaySeriesFieldUpdateString.size() - 3);
-
-      QSqlQuery updateDisplaySeriesStatement(this->Database);
-      updateDisplaySeriesStatement.prepare( QString("UPDATE Series SET %1 WHERE SeriesInstanceUID = ? ;").arg(displaySeriesFieldUpdateString) );
-      foreach (QString boundValue, boundValues)
-      {
-        updateDisplaySeriesStatement.addBindValue(boundValue);
-      }
-      updateDisplaySeriesStatement.addBindValue(currentSeries.value("SeriesInstanceUID"));
-      this->loggedExec(updateDisplaySeriesStatement);
+    displaySeriesFieldUpdates << "DisplayedFieldsUpdatedTimestamp = CURRENT_TIMESTAMP";
 
-      QSqlQuery updateDisplayedFieldsUpdatedTimestampStatement(this->Database);
-      updateDisplayedFieldsUpdatedTimestampStatement.prepare("UPDATE Series SET DisplayedFieldsUpdatedTimestamp=CURRENT_TIMESTAMP WHERE SeriesInstanceUID = ? ;");
-      updateDisplayedFieldsUpdatedTimestampStatement.addBindValue(currentSeries.value("SeriesInstanceUID"));
-      this->loggedExec(updateDisplayedFieldsUpdatedTimestampStatement);
+    QSqlQuery& updateDisplaySeriesStatement = this->preparedQuery(this->Database,
+      QString("UPDATE Series SET %1 WHERE SeriesInstanceUID = ? ;").arg(displaySeriesFieldUpdates.join(", ")) );
+    int bindIndex = 0;
+    foreach (QString boundValue, boundValues)
+    {
+      updateDisplaySeriesStatement.bindValue(bindIndex++, boundValue);
     }
-    else
+    updateDisplaySeriesStatement.bindValue(bindIndex, currentSeriesInstanceUid);
+    if (!this->loggedExec(updateDisplaySeriesStatement))
+    {
+      continue;
+    }
+    if (updateDisplaySeriesStatement.numRowsAffected() <= 0)
     {
       logger.error("in applyDisplayedFieldsChanges: Failed to find series with SeriesInstanceUID=" + currentSeriesInstanceUid);
       continue;
@@ -1489,6 +1616,52 @@ CTK_GET_CPP(ctkDICOMDatabase, bool, useShortStoragePath, UseShortStoragePath);
 CTK_SET_CPP(ctkDICOMDatabase, bool, setUseShortStoragePath, UseShortStoragePath);
 CTK_GET_CPP(ctkDICOMDatabase, bool, useSystemFileCopy, UseSystemFileCopy);
 CTK_SET_CPP(ctkDICOMDatabase, bool, setUseSystemFileCopy, UseSystemFileCopy);
+CTK_GET_CPP(ctkDICOMDatabase, bool, packedThumbnailStorage, PackedThumbnailStorage);
+CTK_SET_CPP(ctkDICOMDatabase, bool, setPackedThumbnailStorage, PackedThumbnailStorage);
+CTK_GET_CPP(ctkDICOMDatabase, qint64, lookupCacheHitCount, LookupCacheHitCount);
+CTK_GET_CPP(ctkDICOMDatabase, qint64, lookupCacheMissCount, LookupCacheMissCount);
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::setJournalMode(const QString& journalMode)
+{
+  Q_D(ctkDICOMDatabase);
+  d->JournalMode = journalMode;
+  if (this->isOpen())
+  {
+    QMutexLocker writeLocker(d->WriteMutex);
+    d->applyJournalMode(d->Database);
+    d->applyJournalMode(d->TagCacheDatabase);
+  }
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabase::journalMode() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return d->JournalMode;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::setLookupCacheSize(int size)
+{
+  Q_D(ctkDICOMDatabase);
+  d->LookupCache.setMaxCost(qMax(0, size));
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::lookupCacheSize() const
+{
+  Q_D(const ctkDICOMDatabase);
+  return static_cast<int>(d->LookupCache.maxCost());
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMDatabase::resetLookupCacheStatistics()
+{
+  Q_D(ctkDICOMDatabase);
+  d->LookupCacheHitCount = 0;
+  d->LookupCacheMissCount = 0;
+}
 
 //------------------------------------------------------------------------------
 // ctkDICOMDatabase methods
@@ -1525,6 +1698,7 @@ bool ctkDICOMDatabase::openDatabase(const QString& databaseFile,
 {
   Q_D(ctkDICOMDatabase);
   bool wasOpen = this->isOpen();
+  d->clearPreparedQueries();
   d->DatabaseFileName = databaseFile;
 
   if (this->isInMemory())
@@ -1569,6 +1743,9 @@ bool ctkDICOMDatabase::openDatabase(const QString& databaseFile,
   pragmaSyncQuery.exec("PRAGMA synchronous = OFF");
   pragmaSyncQuery.finish();
 
+  d->applyJournalMode(d->Database);
+  d->WriteMutex = ctkDICOMDatabasePrivate::writeMutexForFile(databaseFile);
+
   if ( d->Database.tables().empty() )
   {
     if (!this->initializeDatabase())
@@ -1796,6 +1973,8 @@ void ctkDICOMDatabase::closeDatabase()
 {
   Q_D(ctkDICOMDatabase);
   bool wasOpen = this->isOpen();
+  d->clearPreparedQueries();
+  d->clearLookupCache();
   d->Database.close();
   d->TagCacheDatabase.close();
   if (wasOpen)
@@ -2025,6 +2204,7 @@ bool ctkDICOMDatabase::updateConnectionsForPatient(const QString patientUID,
                                                    const QStringList denyList)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
   return d->updateConnections(patientUID, allowList, denyList);
 }
 
@@ -2113,6 +2293,11 @@ QString ctkDICOMDatabase::fieldForPatient(const QString field, const QString pat
   Q_D(ctkDICOMDatabase);
 
   QString result;
+  QString cacheKey = QString("Patients|%1|%2").arg(field, patientUID);
+  if (d->lookupCachedValue(cacheKey, result))
+  {
+    return result;
+  }
 
   QSqlQuery query(d->Database);
   QString queryStr = QString("SELECT %1 FROM Patients WHERE UID= ?" ).arg(field);
@@ -2127,6 +2312,7 @@ QString ctkDICOMDatabase::fieldForPatient(const QString field, const QString pat
     result = query.value(0).toString();
   }
 
+  d->setLookupCachedValue(cacheKey, result);
   return result;
 }
 
@@ -2136,6 +2322,11 @@ QString ctkDICOMDatabase::fieldForStudy(const QString field, const QString study
   Q_D(ctkDICOMDatabase);
 
   QString result;
+  QString cacheKey = QString("Studies|%1|%2").arg(field, studyInstanceUID);
+  if (d->lookupCachedValue(cacheKey, result))
+  {
+    return result;
+  }
 
   QSqlQuery query(d->Database);
   QString queryStr = QString("SELECT %1 FROM Studies WHERE StudyInstanceUID= ?" ).arg(field);
@@ -2150,6 +2341,7 @@ QString ctkDICOMDatabase::fieldForStudy(const QString field, const QString study
     result = query.value(0).toString();
   }
 
+  d->setLookupCachedValue(cacheKey, result);
   return result;
 }
 
@@ -2159,6 +2351,11 @@ QString ctkDICOMDatabase::fieldForSeries(const QString field, const QString seri
   Q_D(ctkDICOMDatabase);
 
   QString result;
+  QString cacheKey = QString("Series|%1|%2").arg(field, seriesInstanceUID);
+  if (d->lookupCachedValue(cacheKey, result))
+  {
+    return result;
+  }
 
   QSqlQuery query(d->Database);
   QString queryStr = QString("SELECT %1 FROM Series WHERE SeriesInstanceUID= ?" ).arg(field);
@@ -2173,6 +2370,68 @@ QString ctkDICOMDatabase::fieldForSeries(const QString field, const QString seri
     result = query.value(0).toString();
   }
 
+  d->setLookupCachedValue(cacheKey, result);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+QMap<QString, QMap<QString, QString> > ctkDICOMDatabase::studiesFieldsForPatient(const QString patientUID)
+{
+  Q_D(ctkDICOMDatabase);
+
+  QMap<QString, QMap<QString, QString> > result;
+  QSqlQuery query(d->Database);
+  query.prepare("SELECT * FROM Studies WHERE PatientsUID = ?");
+  query.addBindValue(patientUID);
+  if (!d->loggedExec(query))
+  {
+    return result;
+  }
+  QSqlRecord record = query.record();
+  while (query.next())
+  {
+    QMap<QString, QString> studyFields;
+    for (int fieldIndex = 0; fieldIndex < record.count(); ++fieldIndex)
+    {
+      studyFields.insert(record.fieldName(fieldIndex), query.value(fieldIndex).toString());
+    }
+    result.insert(studyFields["StudyInstanceUID"], studyFields);
+  }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+QMap<QString, QMap<QString, QString> > ctkDICOMDatabase::seriesFieldsForStudy(const QString studyUID)
+{
+  Q_D(ctkDICOMDatabase);
+
+  QMap<QString, QMap<QString, QString> > result;
+  QSqlQuery query(d->Database);
+  query.prepare(
+    "SELECT Series.*, "
+      "COUNT(Images.SOPInstanceUID) AS InstanceCount, "
+      "SUM(CASE WHEN Images.Filename IS NOT NULL AND Images.Filename <> '' THEN 1 ELSE 0 END) AS LoadedInstanceCount, "
+      "SUM(CASE WHEN Images.URL IS NOT NULL AND Images.URL <> '' THEN 1 ELSE 0 END) AS URLCount, "
+      "(SELECT FirstImage.SOPInstanceUID FROM Images AS FirstImage "
+        "WHERE FirstImage.SeriesInstanceUID = Series.SeriesInstanceUID LIMIT 1) AS FirstInstanceUID "
+    "FROM Series LEFT JOIN Images ON Images.SeriesInstanceUID = Series.SeriesInstanceUID "
+    "WHERE Series.StudyInstanceUID = ? "
+    "GROUP BY Series.SeriesInstanceUID");
+  query.addBindValue(studyUID);
+  if (!d->loggedExec(query))
+  {
+    return result;
+  }
+  QSqlRecord record = query.record();
+  while (query.next())
+  {
+    QMap<QString, QString> seriesFields;
+    for (int fieldIndex = 0; fieldIndex < record.count(); ++fieldIndex)
+    {
+      seriesFields.insert(record.fieldName(fieldIndex), query.value(fieldIndex).toString());
+    }
+    result.insert(seriesFields["SeriesInstanceUID"], seriesFields);
+  }
   return result;
 }
 
@@ -2337,6 +2596,12 @@ QString ctkDICOMDatabase::fileForInstance(QString sopInstanceUID)
   Q_D(ctkDICOMDatabase);
 
   QString result;
+  QString cacheKey = QString("Images|Filename|%1").arg(sopInstanceUID);
+  if (d->lookupCachedValue(cacheKey, result))
+  {
+    return result;
+  }
+
   QSqlQuery query(d->Database);
   query.prepare("SELECT Filename FROM Images WHERE SOPInstanceUID=?");
   query.addBindValue(sopInstanceUID);
@@ -2348,6 +2613,7 @@ QString ctkDICOMDatabase::fileForInstance(QString sopInstanceUID)
   {
     result = d->absolutePathFromInternal(query.value(0).toString());
   }
+  d->setLookupCachedValue(cacheKey, result);
   return result;
 }
 
@@ -2470,6 +2736,23 @@ QString ctkDICOMDatabase::thumbnailPathForInstance(const QString &studyInstanceU
   }
 }
 
+//------------------------------------------------------------------------------
+QString ctkDICOMDatabase::packedThumbnailPathForInstance(const QString &studyInstanceUID,
+                                                         const QString &seriesInstanceUID,
+                                                         const QString &sopInstanceUID)
+{
+  Q_D(ctkDICOMDatabase);
+  // Thumbnail stores are looked up even if packedThumbnailStorage is disabled,
+  // they may have been written by another session
+  QString storeFilePath = d->thumbnailStoreFilePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+  QString storeKey = d->thumbnailStoreKey(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+  if (ctkDICOMThumbnailStore::thumbnailOffset(storeFilePath, storeKey) < 0)
+  {
+    return QString();
+  }
+  return ctkDICOMThumbnailStore::packedThumbnailPath(storeFilePath, storeKey);
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::storeThumbnailFile(const QString &originalFilePath,
                                           const QString &studyInstanceUID,
@@ -2483,6 +2766,15 @@ bool ctkDICOMDatabase::storeThumbnailFile(const QString &originalFilePath,
     return false;
   }
 
+  QString storeFilePath = d->thumbnailStoreFilePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+  QString storeKey = d->thumbnailStoreKey(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+  if (d->PackedThumbnailStorage &&
+      ctkDICOMThumbnailStore::thumbnailDateTime(storeFilePath, storeKey) > QFileInfo(originalFilePath).lastModified())
+  {
+    // thumbnail already exists and it is up-to-date
+    return true;
+  }
+
   QString thumbnailPath = this->databaseDirectory() +
     "/thumbs/" + d->internalStoragePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID) + ".png";
 
@@ -2493,12 +2785,6 @@ bool ctkDICOMDatabase::storeThumbnailFile(const QString &originalFilePath,
     return true;
   }
 
-  QDir destinationDir(thumbnailInfo.dir());
-  if (!destinationDir.exists())
-  {
-    destinationDir.mkpath(".");
-  }
-
   if (modality == "SEG")
   {
     // NOTE: currently SEG objects are not fully supported by ctkDICOMThumbnailGenerator,
@@ -2508,11 +2794,149 @@ bool ctkDICOMDatabase::storeThumbnailFile(const QString &originalFilePath,
     logger.warn(QString("SEG thumbnail generation is not available"));
     return false;
   }
+
+  // ctkDICOMThumbnailGenerator renders embedded icon images when they are suitable,
+  // other generators are given the first frame only.
+  ctkDICOMThumbnailGenerator* thumbnailGenerator = qobject_cast<ctkDICOMThumbnailGenerator*>(d->ThumbnailGenerator);
+  if (!d->PackedThumbnailStorage)
+  {
+    QDir destinationDir(thumbnailInfo.dir());
+    if (!destinationDir.exists())
+    {
+      destinationDir.mkpath(".");
+    }
+    if (thumbnailGenerator)
+    {
+      if (!thumbnailGenerator->generateThumbnail(originalFilePath, thumbnailPath))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      DicomImage dcmImage(QDir::toNativeSeparators(originalFilePath).toUtf8().data(),
+                          CIF_UsePartialAccessToPixelData, 0, 1);
+      if (!d->ThumbnailGenerator->generateThumbnail(&dcmImage, thumbnailPath))
+      {
+        return false;
+      }
+    }
+    // The file would be shadowed by a thumbnail written in the store by another session
+    if (QFile::exists(storeFilePath))
+    {
+      ctkDICOMThumbnailStore::removeThumbnails(storeFilePath, QStringList() << storeKey);
+    }
+    return true;
+  }
+
+  QByteArray thumbnailData;
+  if (thumbnailGenerator)
+  {
+    QImage thumbnailImage;
+    if (!thumbnailGenerator->generateThumbnail(originalFilePath, thumbnailImage))
+    {
+      return false;
+    }
+    QBuffer buffer(&thumbnailData);
+    buffer.open(QIODevice::WriteOnly);
+    thumbnailImage.save(&buffer, "PNG");
+  }
   else
   {
-    DicomImage dcmImage(QDir::toNativeSeparators(originalFilePath).toUtf8().data());
-    return d->ThumbnailGenerator->generateThumbnail(&dcmImage, thumbnailPath);
+    // Other generators can only write files
+    QDir thumbnailsDir(QFileInfo(storeFilePath).dir());
+    thumbnailsDir.mkpath(".");
+    QTemporaryFile temporaryFile(thumbnailsDir.filePath("XXXXXX.png"));
+    if (!temporaryFile.open())
+    {
+      logger.error(QString("Failed to create temporary thumbnail file in %1").arg(thumbnailsDir.path()));
+      return false;
+    }
+    temporaryFile.close();
+    DicomImage dcmImage(QDir::toNativeSeparators(originalFilePath).toUtf8().data(),
+                        CIF_UsePartialAccessToPixelData, 0, 1);
+    if (!d->ThumbnailGenerator->generateThumbnail(&dcmImage, temporaryFile.fileName()) || !temporaryFile.open())
+    {
+      return false;
+    }
+    thumbnailData = temporaryFile.readAll();
+  }
+  // The file is superseded by the store
+  if (thumbnailInfo.exists())
+  {
+    QFile::remove(thumbnailPath);
+  }
+  return ctkDICOMThumbnailStore::writeThumbnail(storeFilePath, storeKey, thumbnailData);
+}
+
+//------------------------------------------------------------------------------
+QMap<QString, QByteArray> ctkDICOMDatabase::thumbnailsForStudy(const QString& studyInstanceUID)
+{
+  Q_D(ctkDICOMDatabase);
+  QMap<QString, QByteArray> thumbnails;
+
+  QSqlQuery query(d->Database);
+  query.prepare("SELECT SOPInstanceUID, Images.SeriesInstanceUID FROM Images, Series "
+                "WHERE Series.SeriesInstanceUID = Images.SeriesInstanceUID AND Series.StudyInstanceUID = :studyID");
+  query.bindValue(":studyID", studyInstanceUID);
+  if (!query.exec())
+  {
+    logger.error("SQLITE ERROR: " + query.lastError().driverText());
+    return thumbnails;
+  }
+
+  QString storeFilePath;
+  QMap<QString, QByteArray> storeThumbnails;
+  while (query.next())
+  {
+    QString sopInstanceUID = query.value(0).toString();
+    QString seriesInstanceUID = query.value(1).toString();
+    if (storeFilePath.isEmpty())
+    {
+      // All the instances of the study share the same store, it is read at once
+      storeFilePath = d->thumbnailStoreFilePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+      storeThumbnails = ctkDICOMThumbnailStore::readThumbnails(storeFilePath);
+    }
+    QString storeKey = d->thumbnailStoreKey(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+    if (storeThumbnails.contains(storeKey))
+    {
+      thumbnails.insert(sopInstanceUID, storeThumbnails.value(storeKey));
+      continue;
+    }
+    QFile thumbnailFile(this->databaseDirectory() + "/thumbs/" +
+      d->internalStoragePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID) + ".png");
+    if (thumbnailFile.open(QIODevice::ReadOnly))
+    {
+      thumbnails.insert(sopInstanceUID, thumbnailFile.readAll());
+    }
+  }
+  return thumbnails;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMDatabase::migrateThumbnailsToPackedStorage()
+{
+  QDir thumbnailsDir(this->databaseDirectory() + "/thumbs");
+  if (!thumbnailsDir.exists())
+  {
+    return 0;
   }
+
+  int migratedThumbnailsCount = 0;
+  QStringList studyFolders = thumbnailsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+  foreach (QString studyFolder, studyFolders)
+  {
+    int studyThumbnailsCount = ctkDICOMThumbnailStore::importThumbnailDirectory(
+      thumbnailsDir.filePath(studyFolder),
+      thumbnailsDir.filePath(studyFolder + ctkDICOMThumbnailStore::fileExtension()));
+    if (studyThumbnailsCount < 0)
+    {
+      logger.error("Failed to migrate thumbnails of " + thumbnailsDir.filePath(studyFolder));
+      return -1;
+    }
+    migratedThumbnailsCount += studyThumbnailsCount;
+  }
+  return migratedThumbnailsCount;
 }
 
 //------------------------------------------------------------------------------
@@ -2784,6 +3208,100 @@ QMap<QString, QString> ctkDICOMDatabase::instanceValues(const QStringList& sopIn
   return result;
 }
 
+//------------------------------------------------------------------------------
+QMap<QString, QMap<QString, QString> > ctkDICOMDatabase::instanceValuesForTags(
+  const QStringList& sopInstanceUIDs, const QStringList& tags)
+{
+  Q_D(ctkDICOMDatabase);
+  QMap<QString, QMap<QString, QString> > result;
+
+  if (sopInstanceUIDs.isEmpty() || tags.isEmpty())
+  {
+    return result;
+  }
+
+  QStringList upperTags;
+  foreach (const QString& tag, tags)
+  {
+    upperTags << tag.toUpper();
+  }
+
+  // Instance and tag pairs that are found in the tag cache (including empty values)
+  QSet<QString> cachedInstanceTags;
+
+  if (this->tagCacheExists())
+  {
+    QStringList tagPlaceholders;
+    for (int i = 0; i < upperTags.size(); ++i)
+    {
+      tagPlaceholders << "?";
+    }
+
+    // Limit the number of bound values per query to remain below SQLite's host parameter limit
+    const int maximumNumberOfInstancesPerQuery = 500;
+    for (int chunkStart = 0; chunkStart < sopInstanceUIDs.size(); chunkStart += maximumNumberOfInstancesPerQuery)
+    {
+      QStringList chunk = sopInstanceUIDs.mid(chunkStart, maximumNumberOfInstancesPerQuery);
+      QStringList instancePlaceholders;
+      for (int i = 0; i < chunk.size(); ++i)
+      {
+        instancePlaceholders << "?";
+      }
+
+      QSqlQuery query(d->TagCacheDatabase);
+      query.prepare(QString(
+        "SELECT SOPInstanceUID, Tag, Value FROM TagCache "
+        "WHERE SOPInstanceUID IN (%1) AND Tag IN (%2)"
+        ).arg(instancePlaceholders.join(","), tagPlaceholders.join(",")));
+      foreach (const QString& sopInstanceUID, chunk)
+      {
+        query.addBindValue(sopInstanceUID);
+      }
+      foreach (const QString& tag, upperTags)
+      {
+        query.addBindValue(tag);
+      }
+      if (!d->loggedExec(query))
+      {
+        continue;
+      }
+      while (query.next())
+      {
+        QString sopInstanceUID = query.value(0).toString();
+        QString tag = query.value(1).toString();
+        QString value = query.value(2).toString();
+        cachedInstanceTags.insert(sopInstanceUID + "|" + tag);
+        if (!value.isEmpty() &&
+            value != TagNotInInstance &&
+            value != ValueIsEmptyString &&
+            value != ValueIsNotStored)
+        {
+          result[sopInstanceUID][tag] = value;
+        }
+      }
+    }
+  }
+
+  // Read values that are not cached yet from the files
+  foreach (const QString& sopInstanceUID, sopInstanceUIDs)
+  {
+    foreach (const QString& tag, upperTags)
+    {
+      if (cachedInstanceTags.contains(sopInstanceUID + "|" + tag))
+      {
+        continue;
+      }
+      QString value = this->instanceValue(sopInstanceUID, tag);
+      if (!value.isEmpty())
+      {
+        result[sopInstanceUID][tag] = value;
+      }
+    }
+  }
+
+  return result;
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMDatabase::instanceValueExists(const QString sopInstanceUID, const QString tag)
 {
@@ -2940,12 +3458,22 @@ void ctkDICOMDatabase::insert( const QString& filePath, bool storeFile, bool gen
 void ctkDICOMDatabase::insert(const QList<ctkDICOMDatabase::IndexingResult>& indexingResults)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
   ctkDICOMDatabase::InsertResult insertOperationResult =
     ctkDICOMDatabase::InsertResult::NotInserted;
 
   d->TagCacheDatabase.transaction();
   d->Database.transaction();
 
+  // Image and tag cache rows are collected and written using a single batch statement each
+  // at the end, instead of preparing and executing a statement for each row.
+  // Images are keyed by SOPInstanceUID so that only the last file is kept if the same
+  // instance occurs multiple times in the list.
+  QMap<QString, QVariantList> imageRowsBySOPInstanceUID;
+  QVariantList tagCacheSOPInstanceUIDs;
+  QVariantList tagCacheTags;
+  QVariantList tagCacheValues;
+
   foreach(const ctkDICOMDatabase::IndexingResult & indexingResult, indexingResults)
   {
     const ctkDICOMItem& dataset = *indexingResult.dataset.data();
@@ -3013,10 +3541,7 @@ void ctkDICOMDatabase::insert(const QList<ctkDICOMDatabase::IndexingResult>& ind
     }
     if (!storedFilePath.isEmpty() && !seriesInstanceUID.isEmpty())
     {
-      // Insert all pre-cached fields into tag cache
-      QSqlQuery insertTags(d->TagCacheDatabase);
-      insertTags.prepare("INSERT OR REPLACE INTO TagCache VALUES(?,?,?)");
-      insertTags.bindValue(0, sopInstanceUID);
+      // Collect all pre-cached fields for the tag cache
       foreach(const QString & tag, d->TagsToPrecache)
       {
         unsigned short group, element;
@@ -3038,29 +3563,16 @@ void ctkDICOMDatabase::insert(const QList<ctkDICOMDatabase::IndexingResult>& ind
         {
           value = dataset.GetAllElementValuesAsString(tagKey);
         }
-        insertTags.bindValue(1, tag);
-        if (value.isEmpty())
-        {
-          insertTags.bindValue(2, TagNotInInstance);
-        }
-        else
-        {
-          insertTags.bindValue(2, value);
-        }
-        insertTags.exec();
+        tagCacheSOPInstanceUIDs << sopInstanceUID;
+        tagCacheTags << tag;
+        tagCacheValues << (value.isEmpty() ? TagNotInInstance : value);
       }
 
-      // Insert image files
-      QSqlQuery insertImageStatement(d->Database);
-      insertImageStatement.prepare("INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'URL', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ?, ? )");
-      insertImageStatement.addBindValue(sopInstanceUID);
-      insertImageStatement.addBindValue(d->internalPathFromAbsolute(storedFilePath));
-      insertImageStatement.addBindValue(QString(""));
-      insertImageStatement.addBindValue(seriesInstanceUID);
-      insertImageStatement.addBindValue(QDateTime::currentDateTime());
-      insertImageStatement.exec();
-      emit instanceAdded(sopInstanceUID);
-      insertOperationResult = ctkDICOMDatabase::InsertResult::Inserted;
+      // Collect image files
+      imageRowsBySOPInstanceUID[sopInstanceUID] = QVariantList()
+        << d->internalPathFromAbsolute(storedFilePath)
+        << seriesInstanceUID
+        << QDateTime::currentDateTime();
 
       if (generateThumbnail)
       {
@@ -3069,8 +3581,54 @@ void ctkDICOMDatabase::insert(const QList<ctkDICOMDatabase::IndexingResult>& ind
     }
   }
 
+  if (!tagCacheSOPInstanceUIDs.isEmpty())
+  {
+    QSqlQuery insertTags(d->TagCacheDatabase);
+    insertTags.prepare("INSERT OR REPLACE INTO TagCache VALUES(?,?,?)");
+    insertTags.addBindValue(tagCacheSOPInstanceUIDs);
+    insertTags.addBindValue(tagCacheTags);
+    insertTags.addBindValue(tagCacheValues);
+    d->loggedExecBatch(insertTags);
+  }
+
+  if (!imageRowsBySOPInstanceUID.isEmpty())
+  {
+    QVariantList sopInstanceUIDs;
+    QVariantList filenames;
+    QVariantList urls;
+    QVariantList seriesInstanceUIDs;
+    QVariantList insertTimestamps;
+    for (QMap<QString, QVariantList>::const_iterator it = imageRowsBySOPInstanceUID.constBegin();
+      it != imageRowsBySOPInstanceUID.constEnd(); ++it)
+    {
+      sopInstanceUIDs << it.key();
+      filenames << it.value()[0];
+      urls << QString("");
+      seriesInstanceUIDs << it.value()[1];
+      insertTimestamps << it.value()[2];
+    }
+    QSqlQuery insertImageStatement(d->Database);
+    insertImageStatement.prepare("INSERT OR REPLACE INTO Images ( 'SOPInstanceUID', 'Filename', 'URL', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ?, ? )");
+    insertImageStatement.addBindValue(sopInstanceUIDs);
+    insertImageStatement.addBindValue(filenames);
+    insertImageStatement.addBindValue(urls);
+    insertImageStatement.addBindValue(seriesInstanceUIDs);
+    insertImageStatement.addBindValue(insertTimestamps);
+    if (d->loggedExecBatch(insertImageStatement))
+    {
+      foreach(const QVariant& sopInstanceUID, sopInstanceUIDs)
+      {
+        emit instanceAdded(sopInstanceUID.toString());
+        d->DisplayedFieldsDirtySOPInstanceUIDs.insert(sopInstanceUID.toString());
+      }
+      insertOperationResult = ctkDICOMDatabase::InsertResult::Inserted;
+    }
+  }
+
   d->Database.commit();
   d->TagCacheDatabase.commit();
+  d->clearPreparedQueries();
+  d->clearLookupCache();
 
   if (insertOperationResult == ctkDICOMDatabase::InsertResult::Inserted && this->isInMemory())
   {
@@ -3082,6 +3640,7 @@ void ctkDICOMDatabase::insert(const QList<ctkDICOMDatabase::IndexingResult>& ind
 ctkDICOMDatabase::InsertResult ctkDICOMDatabase::insert(const QList<ctkDICOMJobResponseSet*>& jobResponseSets)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
 
   bool databaseWasChanged = false;
   bool insertFailed = false;
@@ -3268,7 +3827,8 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabase::insert(const QList<ctkDICOMJobR
       QString storedFilePath = filePath;
       if (storeFile && !seriesInstanceUID.isEmpty() && !this->isInMemory())
       {
-        if (!d->storeDatasetFile(*dataset, filePath, studyInstanceUID, seriesInstanceUID, sopInstanceUID, storedFilePath))
+        if (!d->storeDatasetFile(*dataset, filePath, studyInstanceUID, seriesInstanceUID, sopInstanceUID, storedFilePath,
+                                 jobResponseSet->moveFile()))
         {
           continue;
         }
@@ -3295,15 +3855,16 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabase::insert(const QList<ctkDICOMJobR
         if (!storeFile)
         {
           // file is linked, maybe it is already inserted
-          QSqlQuery checkImageExistsQuery(d->Database);
-          checkImageExistsQuery.prepare("SELECT * FROM Images WHERE SOPInstanceUID = ?");
-          checkImageExistsQuery.addBindValue(sopInstanceUID);
+          QSqlQuery& checkImageExistsQuery = d->preparedQuery(d->Database,
+            "SELECT SOPInstanceUID FROM Images WHERE SOPInstanceUID = ?");
+          checkImageExistsQuery.bindValue(0, sopInstanceUID);
           if (!d->loggedExec(checkImageExistsQuery))
           {
             insertFailed = true;
             continue;
           }
           alreadyInserted = checkImageExistsQuery.next();
+          checkImageExistsQuery.finish();
         }
         if (!alreadyInserted)
         {
@@ -3320,13 +3881,13 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabase::insert(const QList<ctkDICOMJobR
             storedFilePathInDatabase = storedFilePath;
           }
 
-          QSqlQuery insertImageStatement(d->Database);
-          insertImageStatement.prepare("INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'URL', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ?, ? )");
-          insertImageStatement.addBindValue(sopInstanceUID);
-          insertImageStatement.addBindValue(storedFilePathInDatabase);
-          insertImageStatement.addBindValue(url);
-          insertImageStatement.addBindValue(seriesInstanceUID);
-          insertImageStatement.addBindValue(QDateTime::currentDateTime());
+          QSqlQuery& insertImageStatement = d->preparedQuery(d->Database,
+            "INSERT INTO Images ( 'SOPInstanceUID', 'Filename', 'URL', 'SeriesInstanceUID', 'InsertTimestamp' ) VALUES ( ?, ?, ?, ?, ? )");
+          insertImageStatement.bindValue(0, sopInstanceUID);
+          insertImageStatement.bindValue(1, storedFilePathInDatabase);
+          insertImageStatement.bindValue(2, url);
+          insertImageStatement.bindValue(3, seriesInstanceUID);
+          insertImageStatement.bindValue(4, QDateTime::currentDateTime());
 
           if (!insertImageStatement.exec())
           {
@@ -3344,6 +3905,7 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabase::insert(const QList<ctkDICOMJobR
 
           // let users of this class track when things happen
           emit instanceAdded(sopInstanceUID);
+          d->DisplayedFieldsDirtySOPInstanceUIDs.insert(sopInstanceUID);
           databaseWasChanged = true;
         }
         if (generateThumbnail)
@@ -3352,10 +3914,20 @@ ctkDICOMDatabase::InsertResult ctkDICOMDatabase::insert(const QList<ctkDICOMJobR
         }
       }
     }
+
+    // A temporary file that was not moved into the database (e.g. because the
+    // instance is already up to date) is not needed anymore.
+    if (jobResponseSet->moveFile() && storeFile && !this->isInMemory() &&
+        !filePath.isEmpty() && QFile::exists(filePath))
+    {
+      QFile::remove(filePath);
+    }
   }
 
   d->Database.commit();
   d->TagCacheDatabase.commit();
+  d->clearPreparedQueries();
+  d->clearLookupCache();
 
   if (insertFailed)
   {
@@ -3473,6 +4045,7 @@ bool ctkDICOMDatabase::isInMemory() const
 bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID, bool clearCachedTags/*=false*/, bool cleanup/*=true*/)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
 
   // get all images from series
   QSqlQuery fileExistsQuery(d->Database);
@@ -3487,6 +4060,7 @@ bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID, bool clear
 
   QList< QPair<QString, QString> > removeList;
   QStringList removeTagCacheSOPInstanceUIDs;
+  QMap<QString, QStringList> removeThumbnailStoreKeys;
   while (fileExistsQuery.next())
   {
     QString dbFilePath = fileExistsQuery.value(fileExistsQuery.record().indexOf("Filename")).toString();
@@ -3494,6 +4068,8 @@ bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID, bool clear
     QString sopInstanceUID = fileExistsQuery.value(fileExistsQuery.record().indexOf("SOPInstanceUID")).toString();
     QString thumbnailPath = "thumbs/" + d->internalStoragePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID) + ".png";
     removeList << qMakePair(dbFilePath, thumbnailPath);
+    removeThumbnailStoreKeys[d->thumbnailStoreFilePath(studyInstanceUID, seriesInstanceUID, sopInstanceUID)]
+      << d->thumbnailStoreKey(studyInstanceUID, seriesInstanceUID, sopInstanceUID);
     if (clearCachedTags)
     {
       removeTagCacheSOPInstanceUIDs << sopInstanceUID;
@@ -3573,6 +4149,16 @@ bool ctkDICOMDatabase::removeSeries(const QString& seriesInstanceUID, bool clear
     QDir().rmpath(folderToRemove);
   }
 
+  // Remove packed thumbnails (if any)
+  for (QMap<QString, QStringList>::const_iterator it = removeThumbnailStoreKeys.constBegin();
+       it != removeThumbnailStoreKeys.constEnd(); ++it)
+  {
+    if (QFile::exists(it.key()) && !ctkDICOMThumbnailStore::removeThumbnails(it.key(), it.value()))
+    {
+      logger.warn("Failed to remove thumbnails from " + it.key());
+    }
+  }
+
   if (cleanup && !this->cleanupSeries(seriesInstanceUID))
   {
     return false;
@@ -3603,6 +4189,7 @@ bool ctkDICOMDatabase::cleanupEntityIfEmpty(
   bool vacuum)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
 
   QSqlQuery deleteQuery(d->Database);
   deleteQuery.prepare(deleteQueryString);
@@ -3613,6 +4200,7 @@ bool ctkDICOMDatabase::cleanupEntityIfEmpty(
   }
   if (deleteQuery.numRowsAffected() > 0)
   {
+    d->clearLookupCache();
     if (vacuum)
     {
       this->vacuumDatabases();
@@ -3676,6 +4264,7 @@ bool ctkDICOMDatabase::cleanupPatient(const QString& patientUID, bool vacuum/*=f
 bool ctkDICOMDatabase::cleanup(bool vacuum/*=false*/)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
   QSqlQuery seriesCleanup ( d->Database );
   seriesCleanup.exec("DELETE FROM Series WHERE ( SELECT COUNT(*) FROM Images WHERE Images.SeriesInstanceUID = Series.SeriesInstanceUID ) = 0;");
   seriesCleanup.exec("DELETE FROM Studies WHERE ( SELECT COUNT(*) FROM Series WHERE Series.StudyInstanceUID = Studies.StudyInstanceUID ) = 0;");
@@ -3692,6 +4281,7 @@ bool ctkDICOMDatabase::cleanup(bool vacuum/*=false*/)
 bool ctkDICOMDatabase::removeStudy(const QString& studyInstanceUID, bool cleanup/*=true*/)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
 
   QSqlQuery seriesForStudy( d->Database );
   seriesForStudy.prepare("SELECT SeriesInstanceUID FROM Series WHERE StudyInstanceUID = :studyID");
@@ -3731,6 +4321,7 @@ bool ctkDICOMDatabase::removeStudy(const QString& studyInstanceUID, bool cleanup
 bool ctkDICOMDatabase::removePatient(const QString& patientUID, bool cleanup/*=true*/)
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
 
   QString patientID = this->fieldForPatient("PatientID", patientUID);
 
@@ -3845,12 +4436,17 @@ QString ctkDICOMDatabase::cachedTag(const QString sopInstanceUID, const QString
       return( "" );
     }
   }
+  QString result("");
+  QString cacheKey = QString("TagCache|%1|%2").arg(tag.toUpper(), sopInstanceUID);
+  if (d->lookupCachedValue(cacheKey, result))
+  {
+    return result;
+  }
   QSqlQuery selectValue( d->TagCacheDatabase );
   selectValue.prepare( "SELECT Value FROM TagCache WHERE SOPInstanceUID = :sopInstanceUID AND Tag = :tag" );
   selectValue.bindValue(":sopInstanceUID",sopInstanceUID);
   selectValue.bindValue(":tag",tag.toUpper());
   d->loggedExec(selectValue);
-  QString result("");
   if (selectValue.next())
   {
     result = selectValue.value(0).toString();
@@ -3859,6 +4455,7 @@ QString ctkDICOMDatabase::cachedTag(const QString sopInstanceUID, const QString
       result = ValueIsEmptyString;
     }
   }
+  d->setLookupCachedValue(cacheKey, result);
   return( result );
 }
 
@@ -3933,6 +4530,7 @@ bool ctkDICOMDatabase::cacheTags(const QStringList sopInstanceUIDs, const QStrin
   bool success = true;
   for (int i = 0; i<itemCount; ++i)
   {
+    d->LookupCache.remove(QString("TagCache|%1|%2").arg((*tagsIt).toUpper(), *sopInstanceUIDsIt));
     insertTags.bindValue(0, *sopInstanceUIDsIt);
     insertTags.bindValue(1, (*tagsIt).toUpper());
     if (valuesIt->isEmpty())
@@ -3969,6 +4567,7 @@ void ctkDICOMDatabase::removeCachedTags(const QString sopInstanceUID)
   QSqlQuery deleteFile(d->TagCacheDatabase);
   deleteFile.prepare("DELETE FROM TagCache WHERE SOPInstanceUID == :sopInstanceUID");
   deleteFile.bindValue(":sopInstanceUID", sopInstanceUID);
+  d->clearLookupCache();
   bool success = deleteFile.exec();
   if (!success)
   {
@@ -3980,12 +4579,48 @@ void ctkDICOMDatabase::removeCachedTags(const QString sopInstanceUID)
 void ctkDICOMDatabase::updateDisplayedFields()
 {
   Q_D(ctkDICOMDatabase);
+  QMutexLocker writeLocker(d->WriteMutex);
+
+  QElapsedTimer timer;
+  timer.start();
 
   // Get the files for which the displayed fields have not been created yet (DisplayedFieldsUpdatedTimestamp is NULL)
   // Note: The per-instance update only covers insertion and schema update. If fields on the series/study/patient level need to be
   // updated on the insertion of a new instance, then it can be handled using the startUpdate/endUpdate functions of the rules.
-  QSqlQuery newFilesQuery(d->Database);
-  d->loggedExec(newFilesQuery,QString("SELECT SOPInstanceUID, SeriesInstanceUID FROM Images WHERE DisplayedFieldsUpdatedTimestamp IS NULL;"));
+  QStringList newSOPInstanceUIDs;
+  QStringList newSeriesInstanceUIDs;
+  QSet<QString> dirtySOPInstanceUIDs = d->DisplayedFieldsDirtySOPInstanceUIDs;
+  qint64 dataVersion = d->dataVersion();
+  if (dirtySOPInstanceUIDs.isEmpty() || dataVersion < 0 || dataVersion != d->DisplayedFieldsDataVersion)
+  {
+    // No instances were inserted using this object since the last update (for example the database was
+    // just opened or the schema was updated), or instances may have been inserted by other connections
+    // (indexer, inserter or retrieve jobs using their own database object), so all instances need to be checked.
+    QSqlQuery newFilesQuery(d->Database);
+    d->loggedExec(newFilesQuery,QString("SELECT SOPInstanceUID, SeriesInstanceUID FROM Images WHERE DisplayedFieldsUpdatedTimestamp IS NULL;"));
+    while (newFilesQuery.next())
+    {
+      newSOPInstanceUIDs << newFilesQuery.value(0).toString();
+      newSeriesInstanceUIDs << newFilesQuery.value(1).toString();
+    }
+  }
+  else
+  {
+    // Only look up the instances that were inserted since the last update, to avoid a full scan
+    // of the Images table when a few files are added to a large database.
+    QSqlQuery& newFileQuery = d->preparedQuery(d->Database,
+      "SELECT SeriesInstanceUID FROM Images WHERE SOPInstanceUID = ? AND DisplayedFieldsUpdatedTimestamp IS NULL;");
+    foreach (const QString& sopInstanceUID, dirtySOPInstanceUIDs)
+    {
+      newFileQuery.bindValue(0, sopInstanceUID);
+      if (d->loggedExec(newFileQuery) && newFileQuery.next())
+      {
+        newSOPInstanceUIDs << sopInstanceUID;
+        newSeriesInstanceUIDs << newFileQuery.value(0).toString();
+      }
+      newFileQuery.finish();
+    }
+  }
 
   // Populate displayed fields maps from the current display tables
   QMap<QString /*SeriesInstanceUID*/, QMap<QString /*DisplayField*/, QString /*Value*/> > displayedFieldsMapSeries;
@@ -3994,15 +4629,16 @@ void ctkDICOMDatabase::updateDisplayedFields()
 
   int progressValue = 0;
   emit displayedFieldsUpdateProgress(++progressValue);
+  emit displayedFieldsUpdateTime(progressValue, timer.elapsed());
 
   // Initialize rules for starting the update
   d->DisplayedFieldGenerator->startUpdate();
 
   // Get display names for newly added files and add them into the display tables
-  while (newFilesQuery.next())
+  for (int instanceIndex = 0; instanceIndex < newSOPInstanceUIDs.size(); ++instanceIndex)
   {
-    QString sopInstanceUID = newFilesQuery.value(0).toString();
-    QString seriesInstanceUID = newFilesQuery.value(1).toString();
+    QString sopInstanceUID = newSOPInstanceUIDs[instanceIndex];
+    QString seriesInstanceUID = newSeriesInstanceUIDs[instanceIndex];
     QMap<QString, QString> cachedTags;
     this->getCachedTags(sopInstanceUID, cachedTags);
 
@@ -4057,33 +4693,60 @@ void ctkDICOMDatabase::updateDisplayedFields()
   } // For each instance
 
   emit displayedFieldsUpdateProgress(++progressValue);
+  emit displayedFieldsUpdateTime(progressValue, timer.elapsed());
 
   // Finalize update by giving the rules the chance to write the final results in the maps
   d->DisplayedFieldGenerator->endUpdate(displayedFieldsMapSeries, displayedFieldsMapStudy, displayedFieldsMapPatient);
 
   emit displayedFieldsUpdateProgress(++progressValue);
+  emit displayedFieldsUpdateTime(progressValue, timer.elapsed());
 
   // Update/insert the display values
+  bool success = true;
   if (displayedFieldsMapSeries.count() > 0)
   {
     d->Database.transaction();
 
-    if (d->applyDisplayedFieldsChanges(displayedFieldsMapSeries, displayedFieldsMapStudy, displayedFieldsMapPatient))
+    success = d->applyDisplayedFieldsChanges(displayedFieldsMapSeries, displayedFieldsMapStudy, displayedFieldsMapPatient);
+    if (success)
     {
       // Update image timestamp
-      newFilesQuery.first();
-      newFilesQuery.previous(); // Need to go one before the first record
-      while (newFilesQuery.next())
+      QVariantList sopInstanceUIDs;
+      foreach (const QString& sopInstanceUID, newSOPInstanceUIDs)
       {
-        QSqlQuery updateDisplayedFieldsUpdatedTimestampStatement(d->Database);
-        QString updateDisplayedFieldsUpdatedTimestampStatementString =
-          QString("UPDATE IMAGES SET DisplayedFieldsUpdatedTimestamp=CURRENT_TIMESTAMP WHERE SOPInstanceUID='%1';").arg(newFilesQuery.value(0).toString());
-        d->loggedExec(updateDisplayedFieldsUpdatedTimestampStatement, updateDisplayedFieldsUpdatedTimestampStatementString);
+        sopInstanceUIDs << sopInstanceUID;
       }
+      QSqlQuery updateDisplayedFieldsUpdatedTimestampStatement(d->Database);
+      updateDisplayedFieldsUpdatedTimestampStatement.prepare(
+        "UPDATE Images SET DisplayedFieldsUpdatedTimestamp=CURRENT_TIMESTAMP WHERE SOPInstanceUID = ? ;");
+      updateDisplayedFieldsUpdatedTimestampStatement.addBindValue(sopInstanceUIDs);
+      success = d->loggedExecBatch(updateDisplayedFieldsUpdatedTimestampStatement);
     }
 
-    d->Database.commit();
+    if (success)
+    {
+      success = d->Database.commit();
+    }
+    if (!success)
+    {
+      d->Database.rollback();
+    }
+    d->clearLookupCache();
   }
+  d->clearPreparedQueries();
+
+  // Instances that failed to be updated are still dirty and processed at the next update
+  if (success)
+  {
+    d->DisplayedFieldsDirtySOPInstanceUIDs.subtract(dirtySOPInstanceUIDs);
+    d->DisplayedFieldsDataVersion = dataVersion;
+  }
+
+  emit displayedFieldsUpdateProgress(++progressValue);
+  emit displayedFieldsUpdateTime(progressValue, timer.elapsed());
+  logger.debug(QString("Updated displayed fields for %1 instances, %2 series, %3 studies, %4 patients [%5s]")
+    .arg(newSOPInstanceUIDs.size()).arg(displayedFieldsMapSeries.size()).arg(displayedFieldsMapStudy.size())
+    .arg(displayedFieldsMapPatient.size()).arg(QString::number(timer.elapsed() / 1000.0, 'f', 2)));
 
   emit displayedFieldsUpdated();
   emit databaseChanged();
@@ -72,6 +72,9 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMDatabase : public QObject
   Q_PROPERTY(QStringList loadedSeriesInstanceUIDs READ loadedSeriesInstanceUIDs WRITE setLoadedSeriesInstanceUIDs NOTIFY loadedSeriesInstanceUIDsChanged)
   Q_PROPERTY(bool useShortStoragePath READ useShortStoragePath WRITE setUseShortStoragePath)
   Q_PROPERTY(bool useSystemFileCopy READ useSystemFileCopy WRITE setUseSystemFileCopy)
+  Q_PROPERTY(bool packedThumbnailStorage READ packedThumbnailStorage WRITE setPackedThumbnailStorage)
+  Q_PROPERTY(int lookupCacheSize READ lookupCacheSize WRITE setLookupCacheSize)
+  Q_PROPERTY(QString journalMode READ journalMode WRITE setJournalMode)
 
 public:
   struct IndexingResult
@@ -196,6 +199,18 @@ public:
   Q_INVOKABLE QString fieldForStudy(const QString field, const QString studyInstanceUID);
   Q_INVOKABLE QString fieldForSeries(const QString field, const QString seriesInstanceUID);
 
+  /// \brief Bulk accessors retrieving all the records that belong to a patient or study in a single query.
+  /// They avoid running a separate query for each field and record when populating models.
+  /// Returns map of StudyInstanceUID -> (field name -> value) containing all columns of the Studies table.
+  Q_INVOKABLE QMap<QString, QMap<QString, QString> > studiesFieldsForPatient(const QString patientUID);
+  /// Returns map of SeriesInstanceUID -> (field name -> value) containing all columns of the Series table
+  /// and these additional fields computed from the Images table:
+  /// - InstanceCount: number of instances in the series
+  /// - LoadedInstanceCount: number of instances that have a file
+  /// - URLCount: number of instances that have a URL
+  /// - FirstInstanceUID: SOPInstanceUID of the first instance, same as instancesForSeries(seriesUID, 1)
+  Q_INVOKABLE QMap<QString, QMap<QString, QString> > seriesFieldsForStudy(const QString studyUID);
+
   /// Provide lists of allow and deny servers associated with the patient.
   Q_INVOKABLE QMap<QString, QStringList> connectionsInformationForPatient(const QString patientUID);
   /// Set the allow and deny servers for the patient
@@ -213,15 +228,33 @@ public:
   Q_INVOKABLE QString seriesForFile(QString fileName);
   Q_INVOKABLE QString instanceForFile(const QString fileName);
   Q_INVOKABLE QDateTime insertDateTimeForInstance(const QString fileName);
+  /// Path of the thumbnail image file of the instance, or an empty string if there is none.
+  /// Thumbnails written in packed thumbnail stores are not image files and are not
+  /// returned, see packedThumbnailPathForInstance().
   Q_INVOKABLE QString thumbnailPathForInstance(const QString& studyInstanceUID,
                                                const QString& seriesInstanceUID,
                                                const QString& sopInstanceUID);
+  /// Packed thumbnail path of the instance (see ctkDICOMThumbnailStore::packedThumbnailPath()),
+  /// or an empty string if the thumbnail is not in a thumbnail store.
+  /// The path can be read with ctkDICOMThumbnailStore or ctkDICOMThumbnailCache, not as an image file.
+  Q_INVOKABLE QString packedThumbnailPathForInstance(const QString& studyInstanceUID,
+                                                     const QString& seriesInstanceUID,
+                                                     const QString& sopInstanceUID);
   Q_INVOKABLE bool storeThumbnailFile(const QString& originalFilePath,
                                       const QString& studyInstanceUID,
                                       const QString& seriesInstanceUID,
                                       const QString& sopInstanceUID,
                                       const QString& modality = "");
 
+  /// Encoded (PNG) thumbnails of all the instances of a study, by SOPInstanceUID.
+  /// With packedThumbnailStorage the thumbnails are read at once from the study thumbnail store.
+  QMap<QString, QByteArray> thumbnailsForStudy(const QString& studyInstanceUID);
+
+  /// Move the thumbnail files of the "thumbs" directory to packed thumbnail stores
+  /// (one per study, see packedThumbnailStorage).
+  /// Return the number of migrated thumbnails, or -1 in case of error.
+  Q_INVOKABLE int migrateThumbnailsToPackedStorage();
+
   Q_INVOKABLE int patientsCount();
   Q_INVOKABLE int studiesCount();
   Q_INVOKABLE int seriesCount();
@@ -313,6 +346,40 @@ public:
   void setUseSystemFileCopy(bool useSystemCopy);
   bool useSystemFileCopy()const;
 
+  /// If packedThumbnailStorage is true then the thumbnails generated by storeThumbnailFile()
+  /// are written in a single file per study (see ctkDICOMThumbnailStore) instead of
+  /// one PNG file per instance, which avoids creating a large number of small files.
+  /// packedThumbnailPathForInstance() then returns packed thumbnail paths, that can be read with
+  /// ctkDICOMThumbnailStore or ctkDICOMThumbnailCache but not as image files.
+  /// Thumbnail files created before are still used, see migrateThumbnailsToPackedStorage().
+  /// False by default.
+  void setPackedThumbnailStorage(bool packed);
+  bool packedThumbnailStorage()const;
+
+  /// SQLite journal mode of the database and tag cache files (for example "WAL" or "DELETE").
+  /// In "WAL" mode reading is not blocked while another connection (such as the indexer
+  /// or a retrieve job) writes the database, which keeps the user interface responsive during imports.
+  /// The journal mode is stored in the database file, therefore it applies to all connections.
+  /// WAL mode requires all connections to be on the same computer (not supported on network file systems).
+  /// If empty (this is the default) then the journal mode of the database file is not changed.
+  /// The journal mode is set when the database is opened, or immediately if the database is already open.
+  void setJournalMode(const QString& journalMode);
+  QString journalMode()const;
+
+  /// Maximum number of lookup results kept in memory by fieldForPatient, fieldForStudy, fieldForSeries,
+  /// fileForInstance, and cachedTag. When the cache is full, least recently used results are discarded.
+  /// The cache is cleared when records are added, modified, or removed through this object.
+  /// Changes made through other connections to the same database file are not detected, therefore
+  /// the cache should only be enabled if this object is the only one writing the database.
+  /// If 0 (this is the default) then lookup results are not cached.
+  void setLookupCacheSize(int size);
+  int lookupCacheSize()const;
+  /// Number of lookups found in the cache since the cache statistics were reset.
+  Q_INVOKABLE qint64 lookupCacheHitCount()const;
+  /// Number of lookups not found in the cache since the cache statistics were reset.
+  Q_INVOKABLE qint64 lookupCacheMissCount()const;
+  Q_INVOKABLE void resetLookupCacheStatistics();
+
   /// Update the fields in the database that are used for displaying information
   /// from information stored in the tag-cache.
   /// Displayed fields are useful if the raw DICOM tags are not human readable, or
@@ -388,6 +455,12 @@ public:
   /// @returns Map of sopInstanceUID -> tag value. Missing or empty values are not included.
   Q_INVOKABLE QMap<QString, QString> instanceValues(const QStringList& sopInstanceUIDs, const QString& tag);
 
+  /// \brief Retrieve values of multiple tags for multiple instances
+  /// Values are read from the tag cache in a single query, values that are not in the tag cache yet
+  /// are read from the files (and added to the tag cache) as in instanceValue().
+  /// @returns Map of sopInstanceUID -> (tag -> value). Missing or empty values are not included.
+  Q_INVOKABLE QMap<QString, QMap<QString, QString> > instanceValuesForTags(const QStringList& sopInstanceUIDs, const QStringList& tags);
+
   /// Convert between string and (unsigned short int, unsigned short int) representation of a DICOM tag.
   Q_INVOKABLE bool tagToGroupElement (const QString tag, unsigned short& group, unsigned short& element);
   Q_INVOKABLE QString groupElementToTag (const unsigned short& group, const unsigned short& element);
@@ -537,6 +610,9 @@ Q_SIGNALS:
   void displayedFieldsUpdateStarted();
   /// Indicate progress in updating displayed fields (int is step number)
   void displayedFieldsUpdateProgress(int);
+  /// Emitted together with displayedFieldsUpdateProgress, with the time elapsed
+  /// since the start of the displayed fields update.
+  void displayedFieldsUpdateTime(int step, qint64 elapsedMsec);
   /// Indicate displayed fields update finished
   void displayedFieldsUpdated();
 
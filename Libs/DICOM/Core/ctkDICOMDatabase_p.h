@@ -32,6 +32,10 @@
 // We mean it.
 //
 
+// Qt includes
+#include <QCache>
+#include <QMutex>
+
 // ctkDICOM includes
 #include "ctkDICOMDatabase.h"
 #include "ctkDICOMDisplayedFieldGenerator.h"
@@ -50,11 +54,35 @@ public:
   void registerCompressionLibraries();
   bool executeScript(const QString script);
 
+  /// Mutex type used for serializing write operations
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
+  typedef QRecursiveMutex WriteMutexType;
+#else
+  typedef QMutex WriteMutexType;
+#endif
+
+  /// Get the mutex that serializes write operations of all ctkDICOMDatabase objects
+  /// in this process that use the same database file (indexer, inserter, user interface, ...).
+  /// Writers wait for each other instead of failing with "database is locked" errors.
+  /// Returns nullptr for in-memory databases, as they cannot be shared between connections.
+  static WriteMutexType* writeMutexForFile(const QString& databaseFileName);
+
+  /// Set SQLite journal mode on the connection. Does nothing if journalMode is empty.
+  bool applyJournalMode(QSqlDatabase& database);
+
   /// Run a query and prints debug output of status
   bool loggedExec(QSqlQuery& query);
   bool loggedExec(QSqlQuery& query, const QString& queryString);
   bool loggedExecBatch(QSqlQuery& query);
 
+  /// Get a prepared query for the statement on the given database connection.
+  /// The query is prepared only once and then reused until clearPreparedQueries() is called,
+  /// which avoids parsing the same statements again for each inserted instance.
+  QSqlQuery& preparedQuery(const QSqlDatabase& database, const QString& statement);
+  /// Release all cached prepared queries. Must be called at the end of bulk insert transactions
+  /// and before the database connection is closed.
+  void clearPreparedQueries();
+
   bool removeImage(const QString& sopInstanceUID);
 
   /// Read DICOM tag value from file and store it in the tag cache
@@ -62,14 +90,24 @@ public:
 
   /// Store copy of the dataset in database folder.
   /// If the original file is available then that will be inserted. If not then a file is created from the dataset object.
+  /// If \a moveFile is true then the original file is moved instead of copied.
   bool storeDatasetFile(const ctkDICOMItem& dataset, const QString& originalFilePath,
-    const QString& studyInstanceUID, const QString& seriesInstanceUID, const QString& sopInstanceUID, QString& storedFilePath);
+    const QString& studyInstanceUID, const QString& seriesInstanceUID, const QString& sopInstanceUID, QString& storedFilePath,
+    bool moveFile = false);
 
   /// Helper function that generates folders for storing an instance in the database.
   /// Folders are based on UIDs, but may be shortened.
   QString internalStoragePath(const QString& studyInstanceUID,
     const QString& seriesInstanceUID, const QString& sopInstanceUID);
 
+  /// Packed thumbnail store of the study and key of an instance thumbnail in the store.
+  /// The key is the path of the thumbnail file in the study folder of the "thumbs" directory,
+  /// so that thumbnail files can be migrated to the store.
+  QString thumbnailStoreFilePath(const QString& studyInstanceUID,
+    const QString& seriesInstanceUID, const QString& sopInstanceUID);
+  QString thumbnailStoreKey(const QString& studyInstanceUID,
+    const QString& seriesInstanceUID, const QString& sopInstanceUID);
+
   /// Returns false in case of an error
   bool indexingStatusForFile(const QString& filePath, const QString& sopInstanceUID, bool& datasetInDatabase, bool& datasetUpToDate, QString& databaseFilename);
 
@@ -84,6 +122,10 @@ public:
   /// Copy the complete list of files to an extra table
   QStringList allFilesInDatabase();
 
+  /// Return the SQLite data_version of the database connection, -1 on error.
+  /// It changes when another connection commits changes to the database.
+  qint64 dataVersion();
+
   /// Update database tables from the displayed fields determined by the plugin rules
   /// \return Success flag
   bool applyDisplayedFieldsChanges( QMap<QString, QMap<QString, QString> > &displayedFieldsMapSeries,
@@ -128,6 +170,11 @@ public:
   /// Name of the database file (i.e. for SQLITE the sqlite file)
   QString DatabaseFileName;
 
+  /// SQLite journal mode set when the database is opened (empty if left unchanged)
+  QString JournalMode;
+  /// Write mutex shared by all connections of the current database file
+  WriteMutexType* WriteMutex;
+
   /// Name of the database folder (empty if in-memory database).
   /// Cached because it needs to be accessed each time a filename is converted
   /// between absolute and relative path.
@@ -140,6 +187,7 @@ public:
 
   bool UseShortStoragePath;
   bool UseSystemFileCopy;
+  bool PackedThumbnailStorage;
 
   ctkDICOMAbstractThumbnailGenerator* ThumbnailGenerator;
 
@@ -161,9 +209,31 @@ public:
   QSet<QString> InsertedStudyUIDsCache;
   QSet<QString> InsertedSeriesUIDsCache;
 
+  /// Instances inserted since the last displayed fields update.
+  /// If empty then updateDisplayedFields processes all instances that have no displayed fields yet.
+  QSet<QString> DisplayedFieldsDirtySOPInstanceUIDs;
+  /// Data version of the database at the last successful displayed fields update, -1 if unknown.
+  /// If it changed, instances may have been inserted by other connections and all instances are processed.
+  qint64 DisplayedFieldsDataVersion;
+
   /// resets the variables to new inserts won't be fooled by leftover values
   void resetLastInsertedValues();
 
+  /// map from connection name and SQL statement to prepared query
+  QMap<QString, QSharedPointer<QSqlQuery> > PreparedQueries;
+
+  /// Bounded cache of field and tag lookup results, least recently used items are discarded first.
+  /// Keys are composed of the table (or "TagCache"), field (or tag) and UID.
+  /// Disabled if maximum cost is 0.
+  QCache<QString, QString> LookupCache;
+  qint64 LookupCacheHitCount;
+  qint64 LookupCacheMissCount;
+  /// Returns true and sets value if the key is found in the lookup cache.
+  bool lookupCachedValue(const QString& key, QString& value);
+  void setLookupCachedValue(const QString& key, const QString& value);
+  /// Discard all lookup results. Must be called whenever records are added, modified, or removed.
+  void clearLookupCache();
+
   /// tagCache table has been checked to exist
   bool TagCacheVerified;
   /// tag cache has independent database to avoid locking issue
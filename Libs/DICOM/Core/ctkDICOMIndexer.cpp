@@ -29,6 +29,7 @@
 #include <QFile>
 #include <QDirIterator>
 #include <QFileInfo>
+#include <QRunnable>
 #include <QDebug>
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
 #include <QElapsedTimer>
@@ -60,21 +61,167 @@ static ctkLogger logger("org.commontk.dicom.DICOMIndexer" );
 /// Increasing cache size increases maximum memory usage, very low cache size
 /// slows down database insertion.
 static int REQUEST_RESULTS_CACHE_MAXIMUM_SIZE = 5000;
+
+/// How many files may be waiting for parsing or insertion per parser thread.
+/// Limits memory usage while keeping all parser threads busy.
+static int PARSER_PENDING_FILES_PER_THREAD = 4;
+
+/// Maximum time (in milliseconds) parsed results are kept before inserting them into the database.
+/// Ensures that the first results of a long indexing operation appear quickly.
+static qint64 REQUEST_RESULTS_CACHE_MAXIMUM_AGE_MSEC = 3000;
 //------------------------------------------------------------------------------
 
 
 //------------------------------------------------------------------------------
-// ctkDICOMIndexerPrivate methods
+class ctkDICOMIndexerParseTask : public QRunnable
+{
+public:
+  ctkDICOMIndexerParseTask(ctkDICOMIndexerParser* parser, qint64 index, const QString& filePath)
+    : Parser(parser)
+    , Index(index)
+    , FilePath(filePath)
+  {
+  }
+
+  void run() override
+  {
+    QSharedPointer<ctkDICOMItem> dataset;
+    qint64 bytesRead = 0;
+    if (!this->Parser->RequestQueue->isStopRequested())
+    {
+      // Only metadata is stored in the database, therefore pixel data is not read
+      dataset = QSharedPointer<ctkDICOMItem>(new ctkDICOMItem);
+      bytesRead = dataset->InitializeFromFileHeader(this->FilePath);
+    }
+    this->Parser->setParsed(this->Index, dataset, bytesRead);
+  }
+
+protected:
+  ctkDICOMIndexerParser* Parser;
+  qint64 Index;
+  QString FilePath;
+};
+
+//------------------------------------------------------------------------------
+// ctkDICOMIndexerParser methods
+
+//------------------------------------------------------------------------------
+ctkDICOMIndexerParser::ctkDICOMIndexerParser(DICOMIndexingQueue* queue)
+  : RequestQueue(queue)
+  , NextIndexToEnqueue(0)
+  , NextIndexToTake(0)
+{
+  this->ThreadPool.setMaxThreadCount(queue->numberOfParserThreads());
+}
 
+//------------------------------------------------------------------------------
+ctkDICOMIndexerParser::~ctkDICOMIndexerParser()
+{
+  this->clear();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerParser::setNumberOfThreads(int count)
+{
+  if (count < 1)
+  {
+    return;
+  }
+  this->ThreadPool.setMaxThreadCount(count);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMIndexerParser::numberOfThreads() const
+{
+  return this->ThreadPool.maxThreadCount();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerParser::enqueue(const QString& filePath, bool overwriteExistingDataset)
+{
+  qint64 index = 0;
+  {
+    QMutexLocker locker(&this->Mutex);
+    index = this->NextIndexToEnqueue++;
+    ParsedFile& parsedFile = this->ParsedFiles[index];
+    parsedFile.FilePath = filePath;
+    parsedFile.OverwriteExistingDataset = overwriteExistingDataset;
+    parsedFile.BytesRead = 0;
+    parsedFile.Done = false;
+  }
+  this->ThreadPool.start(new ctkDICOMIndexerParseTask(this, index, filePath));
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMIndexerParser::pendingCount() const
+{
+  QMutexLocker locker(&this->Mutex);
+  return this->ParsedFiles.size();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMIndexerParser::takeNext(ParsedFile& parsedFile)
+{
+  QMutexLocker locker(&this->Mutex);
+  if (this->ParsedFiles.isEmpty())
+  {
+    return false;
+  }
+  qint64 index = this->NextIndexToTake;
+  while (!this->ParsedFiles[index].Done)
+  {
+    this->ParsedCondition.wait(&this->Mutex);
+  }
+  parsedFile = this->ParsedFiles.take(index);
+  this->NextIndexToTake++;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerParser::clear()
+{
+  // Remove tasks that have not started yet and wait for the running ones
+  this->ThreadPool.clear();
+  this->ThreadPool.waitForDone();
+
+  QMutexLocker locker(&this->Mutex);
+  this->ParsedFiles.clear();
+  this->NextIndexToTake = this->NextIndexToEnqueue;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMIndexerParser::setParsed(qint64 index, QSharedPointer<ctkDICOMItem> dataset, qint64 bytesRead)
+{
+  QMutexLocker locker(&this->Mutex);
+  if (!this->ParsedFiles.contains(index))
+  {
+    return;
+  }
+  ParsedFile& parsedFile = this->ParsedFiles[index];
+  parsedFile.Dataset = dataset;
+  parsedFile.BytesRead = bytesRead;
+  parsedFile.Done = true;
+  this->ParsedCondition.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMIndexerPrivateWorker methods
 
 //------------------------------------------------------------------------------
 ctkDICOMIndexerPrivateWorker::ctkDICOMIndexerPrivateWorker(DICOMIndexingQueue* queue, QObject* parent)
 : QObject(parent)
 , RequestQueue(queue)
+, Parser(queue)
 , TimePercentageIndexing(95.0)
 , RemainingRequestCount(0)
 , CompletedRequestCount(0)
+, CurrentRequestFileCount(0)
+, CurrentRequestDiscoveredFileCount(0)
+, CurrentRequestParsedFileCount(0)
+, CurrentRequestBytesRead(0)
+, CurrentRequestEnumerationCompleted(true)
 {
+  this->TimeSinceLastDatabaseWrite.start();
 }
 
 //------------------------------------------------------------------------------
@@ -158,25 +305,6 @@ void ctkDICOMIndexerPrivateWorker::start()
 //------------------------------------------------------------------------------
 void ctkDICOMIndexerPrivateWorker::processIndexingRequest(DICOMIndexingQueue::IndexingRequest& indexingRequest, ctkDICOMDatabase& database)
 {
-  if (!indexingRequest.inputFolderPath.isEmpty())
-  {
-    QDir::Filters filters = QDir::Files;
-    if (indexingRequest.includeHidden)
-    {
-      filters |= QDir::Hidden;
-    }
-    QDirIterator::IteratorFlags flags = QDirIterator::Subdirectories;
-    if (indexingRequest.followSymlinks)
-    {
-      flags |= QDirIterator::FollowSymlinks;
-    }
-    QDirIterator it(indexingRequest.inputFolderPath, filters, flags);
-    while (it.hasNext())
-    {
-      indexingRequest.inputFilesPath << it.next();
-    }
-  }
-
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
   QElapsedTimer timeProbe;
 #else
@@ -184,56 +312,86 @@ void ctkDICOMIndexerPrivateWorker::processIndexingRequest(DICOMIndexingQueue::In
 #endif
   timeProbe.start();
 
-  int currentFileIndex = 0;
+  this->Parser.setNumberOfThreads(this->RequestQueue->numberOfParserThreads());
+  int maximumPendingFileCount = this->Parser.numberOfThreads() * PARSER_PENDING_FILES_PER_THREAD;
+
+  // When indexing a folder the total number of files is not known until the
+  // enumeration is completed, files are parsed while the folder is enumerated.
+  this->CurrentRequestFileCount = indexingRequest.inputFilesPath.size();
+  this->CurrentRequestDiscoveredFileCount = 0;
+  this->CurrentRequestParsedFileCount = 0;
+  this->CurrentRequestBytesRead = 0;
+  this->CurrentRequestEnumerationCompleted = indexingRequest.inputFolderPath.isEmpty();
+
   int alreadyAddedFileCount = 0;
   QStringList alreadyAddedFiles;
-  foreach(const QString& filePath, indexingRequest.inputFilesPath)
+  auto indexFile = [&](const QString& filePath)
   {
-    int percent = int(this->TimePercentageIndexing * (this->CompletedRequestCount + double(currentFileIndex++) / double(indexingRequest.inputFilesPath.size()))
-      / double(this->CompletedRequestCount + this->RemainingRequestCount + 1));
-    emit this->progress(percent);
-    emit progressDetail(filePath);
+    this->CurrentRequestDiscoveredFileCount++;
 
     QDateTime fileModifiedTime = QFileInfo(filePath).lastModified();
     bool datasetAlreadyInDatabase = this->ModifiedTimeForFilepath.contains(filePath);
     if (datasetAlreadyInDatabase && this->ModifiedTimeForFilepath[filePath] >= fileModifiedTime)
     {
+      this->CurrentRequestParsedFileCount++;
       alreadyAddedFileCount++;
       if (alreadyAddedFileCount < 10)
       {
         alreadyAddedFiles << filePath;
       }
-      continue;
+      return;
     }
     this->ModifiedTimeForFilepath[filePath] = fileModifiedTime;
 
-    ctkDICOMDatabase::IndexingResult indexingResult;
-    indexingResult.dataset = QSharedPointer<ctkDICOMItem>(new ctkDICOMItem);
-    indexingResult.dataset->InitializeFromFile(filePath);
-    if (indexingResult.dataset->IsInitialized())
+    // Parsing is done in the background, results are consumed in order
+    // once enough files are in flight to keep all parser threads busy.
+    this->Parser.enqueue(filePath, datasetAlreadyInDatabase);
+    while (this->Parser.pendingCount() >= maximumPendingFileCount)
     {
-      indexingResult.filePath = filePath;
-      indexingResult.copyFile = indexingRequest.copyFile;
-      indexingResult.overwriteExistingDataset = datasetAlreadyInDatabase;
-      int resultsCount = this->RequestQueue->pushIndexingResult(indexingResult);
-      if (resultsCount >= REQUEST_RESULTS_CACHE_MAXIMUM_SIZE)
-      {
-        emit progressStep(ctkDICOMIndexer::tr("Updating database fields"));
-        this->writeIndexingResultsToDatabase(database);
-        emit progressStep(ctkDICOMIndexer::tr("Parsing DICOM files"));
-      }
+      this->takeParsedFile(indexingRequest, database);
+    }
+  };
+
+  if (!indexingRequest.inputFolderPath.isEmpty())
+  {
+    QDir::Filters filters = QDir::Files;
+    if (indexingRequest.includeHidden)
+    {
+      filters |= QDir::Hidden;
     }
-    else
+    QDirIterator::IteratorFlags flags = QDirIterator::Subdirectories;
+    if (indexingRequest.followSymlinks)
     {
-      logger.warn(QString("Could not read DICOM file:") + filePath);
+      flags |= QDirIterator::FollowSymlinks;
     }
-
-    if (this->RequestQueue->isStopRequested())
+    QDirIterator it(indexingRequest.inputFolderPath, filters, flags);
+    while (it.hasNext() && !this->RequestQueue->isStopRequested())
     {
-      break;
+      indexFile(it.next());
+    }
+    this->CurrentRequestFileCount = this->CurrentRequestDiscoveredFileCount;
+    this->CurrentRequestEnumerationCompleted = true;
+  }
+  else
+  {
+    foreach(const QString& filePath, indexingRequest.inputFilesPath)
+    {
+      if (this->RequestQueue->isStopRequested())
+      {
+        break;
+      }
+      indexFile(filePath);
     }
   }
 
+  if (this->RequestQueue->isStopRequested())
+  {
+    this->Parser.clear();
+  }
+  while (this->takeParsedFile(indexingRequest, database))
+  {
+  }
+
   if (alreadyAddedFileCount > 0)
   {
     logger.debug(
@@ -251,16 +409,77 @@ void ctkDICOMIndexerPrivateWorker::processIndexingRequest(DICOMIndexingQueue::In
   }
 
   float elapsedTimeInSeconds = timeProbe.elapsed() / 1000.0;
-  logger.info(QString("DICOM indexer has successfully processed %1 files [%2s]")
-              .arg(currentFileIndex).arg(QString::number(elapsedTimeInSeconds, 'f', 2)));
+  logger.info(QString("DICOM indexer has successfully processed %1 files using %2 parser threads [%3s]")
+              .arg(this->CurrentRequestParsedFileCount)
+              .arg(this->Parser.numberOfThreads())
+              .arg(QString::number(elapsedTimeInSeconds, 'f', 2)));
+  int readFileCount = this->CurrentRequestParsedFileCount - alreadyAddedFileCount;
+  if (readFileCount > 0)
+  {
+    logger.info(QString("DICOM indexer has read %1 MB of file headers (%2 bytes per file)")
+                .arg(QString::number(this->CurrentRequestBytesRead / 1048576.0, 'f', 2))
+                .arg(this->CurrentRequestBytesRead / readFileCount));
+  }
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMIndexerPrivateWorker::takeParsedFile(DICOMIndexingQueue::IndexingRequest& indexingRequest, ctkDICOMDatabase& database)
+{
+  ctkDICOMIndexerParser::ParsedFile parsedFile;
+  if (!this->Parser.takeNext(parsedFile))
+  {
+    return false;
+  }
+
+  this->CurrentRequestParsedFileCount++;
+  double requestFraction = 0.0;
+  if (this->CurrentRequestEnumerationCompleted && this->CurrentRequestFileCount > 0)
+  {
+    requestFraction = double(this->CurrentRequestParsedFileCount) / double(this->CurrentRequestFileCount);
+  }
+  int percent = int(this->TimePercentageIndexing * (this->CompletedRequestCount + requestFraction)
+    / double(this->CompletedRequestCount + this->RemainingRequestCount + 1));
+  emit this->progress(percent);
+  emit progressDetail(parsedFile.FilePath);
+  emit progressFileCount(this->CurrentRequestParsedFileCount, this->CurrentRequestDiscoveredFileCount);
+
+  if (parsedFile.Dataset.isNull())
+  {
+    // parsing was skipped because stop was requested
+    return true;
+  }
+  if (!parsedFile.Dataset->IsInitialized())
+  {
+    logger.warn(QString("Could not read DICOM file:") + parsedFile.FilePath);
+    return true;
+  }
+  this->CurrentRequestBytesRead += parsedFile.BytesRead;
+  logger.debug(QString("Read %1 bytes from %2").arg(parsedFile.BytesRead).arg(parsedFile.FilePath));
+
+  ctkDICOMDatabase::IndexingResult indexingResult;
+  indexingResult.dataset = parsedFile.Dataset;
+  indexingResult.filePath = parsedFile.FilePath;
+  indexingResult.copyFile = indexingRequest.copyFile;
+  indexingResult.overwriteExistingDataset = parsedFile.OverwriteExistingDataset;
+  int resultsCount = this->RequestQueue->pushIndexingResult(indexingResult);
+  // Write results in large batches for efficiency, but do not keep them
+  // for too long so that the first results are available quickly.
+  if (resultsCount >= REQUEST_RESULTS_CACHE_MAXIMUM_SIZE
+    || this->TimeSinceLastDatabaseWrite.elapsed() >= REQUEST_RESULTS_CACHE_MAXIMUM_AGE_MSEC)
+  {
+    emit progressStep(ctkDICOMIndexer::tr("Updating database fields"));
+    this->writeIndexingResultsToDatabase(database);
+    emit progressStep(ctkDICOMIndexer::tr("Parsing DICOM files"));
+  }
+  return true;
+}
 
 //------------------------------------------------------------------------------
 void ctkDICOMIndexerPrivateWorker::writeIndexingResultsToDatabase(ctkDICOMDatabase& database)
 {
   QList<ctkDICOMDatabase::IndexingResult> indexingResults;
   this->RequestQueue->popAllIndexingResults(indexingResults);
+  this->TimeSinceLastDatabaseWrite.restart();
   if (indexingResults.isEmpty())
   {
     return;
@@ -294,6 +513,7 @@ ctkDICOMIndexerPrivate::ctkDICOMIndexerPrivate(ctkDICOMIndexer& o)
   , Database(nullptr)
   , BackgroundImportEnabled(false)
   , FollowSymlinks(true)
+  , NumberOfParserThreads(QThread::idealThreadCount())
 {
   ctkDICOMIndexerPrivateWorker* worker = new ctkDICOMIndexerPrivateWorker(&this->RequestQueue);
   worker->moveToThread(&this->WorkerThread);
@@ -305,6 +525,7 @@ ctkDICOMIndexerPrivate::ctkDICOMIndexerPrivate(ctkDICOMIndexer& o)
   connect(worker, &ctkDICOMIndexerPrivateWorker::progress, q_ptr, &ctkDICOMIndexer::progress);
   connect(worker, &ctkDICOMIndexerPrivateWorker::progressDetail, q_ptr, &ctkDICOMIndexer::progressDetail);
   connect(worker, &ctkDICOMIndexerPrivateWorker::progressStep, q_ptr, &ctkDICOMIndexer::progressStep);
+  connect(worker, &ctkDICOMIndexerPrivateWorker::progressFileCount, q_ptr, &ctkDICOMIndexer::progressFileCount);
   connect(worker, &ctkDICOMIndexerPrivateWorker::updatingDatabase, q_ptr, &ctkDICOMIndexer::updatingDatabase);
   connect(worker, &ctkDICOMIndexerPrivateWorker::indexingComplete, q_ptr, &ctkDICOMIndexer::indexingComplete);
 
@@ -351,6 +572,21 @@ CTK_SET_CPP(ctkDICOMIndexer, bool, setBackgroundImportEnabled, BackgroundImportE
 CTK_GET_CPP(ctkDICOMIndexer, bool, followSymlinks, FollowSymlinks);
 CTK_SET_CPP(ctkDICOMIndexer, bool, setFollowSymlinks, FollowSymlinks);
 
+//------------------------------------------------------------------------------
+void ctkDICOMIndexer::setNumberOfParserThreads(int count)
+{
+  Q_D(ctkDICOMIndexer);
+  if (count < 1)
+  {
+    return;
+  }
+  d->NumberOfParserThreads = count;
+  d->RequestQueue.setNumberOfParserThreads(count);
+}
+
+//------------------------------------------------------------------------------
+CTK_GET_CPP(ctkDICOMIndexer, int, numberOfParserThreads, NumberOfParserThreads);
+
 //------------------------------------------------------------------------------
 // ctkDICOMIndexer methods
 
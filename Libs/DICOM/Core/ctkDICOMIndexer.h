@@ -40,6 +40,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMIndexer : public QObject
   Q_PROPERTY(bool backgroundImportEnabled READ isBackgroundImportEnabled WRITE setBackgroundImportEnabled)
   Q_PROPERTY(bool followSymlinks READ followSymlinks WRITE setFollowSymlinks)
   Q_PROPERTY(bool importing READ isImporting)
+  Q_PROPERTY(int numberOfParserThreads READ numberOfParserThreads WRITE setNumberOfParserThreads)
 
 public:
   explicit ctkDICOMIndexer(QObject *parent = 0);
@@ -61,6 +62,14 @@ public:
   void setFollowSymlinks(bool);
   bool followSymlinks() const;
 
+  /// Number of threads used for parsing DICOM files during indexing.
+  /// Parsed datasets are still inserted into the database by a single writer,
+  /// in the same order as the files were found.
+  /// Values smaller than 1 are ignored.
+  /// Default is QThread::idealThreadCount().
+  void setNumberOfParserThreads(int);
+  int numberOfParserThreads() const;
+
   /// Returns with true if background importing is currently in progress.
   bool isImporting();
 
@@ -128,6 +137,10 @@ Q_SIGNALS:
   void progressDetail(QString);
   /// Progress in percentage
   void progress(int);
+  /// Number of files parsed and number of files found so far in the current indexing request.
+  /// When a directory is indexed, files are parsed while the directory is still being
+  /// enumerated, therefore the number of found files may increase during indexing.
+  void progressFileCount(int parsedFileCount, int discoveredFileCount);
   /// Indexing is completed.
   void indexingComplete(int patientsAdded, int studiesAdded, int seriesAdded, int imagesAdded);
   void updatingDatabase(bool);
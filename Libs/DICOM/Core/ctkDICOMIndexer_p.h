@@ -21,7 +21,14 @@
 #ifndef CTKDICOMINDEXERPRIVATE_H
 #define CTKDICOMINDEXERPRIVATE_H
 
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
 #include <QObject>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
 
 #include "ctkDICOMIndexer.h"
 #include "ctkDICOMItem.h"
@@ -48,7 +55,8 @@ public:
   };
 
   DICOMIndexingQueue()
-    : IsIndexing(false)
+    : NumberOfParserThreads(QThread::idealThreadCount())
+    , IsIndexing(false)
     , StopRequested(false)
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
     , Mutex()
@@ -98,6 +106,18 @@ public:
     this->TagsToExcludeFromStorage = tags;
   }
 
+  int numberOfParserThreads()
+  {
+    QMutexLocker locker(&this->Mutex);
+    return this->NumberOfParserThreads;
+  }
+
+  void setNumberOfParserThreads(int count)
+  {
+    QMutexLocker locker(&this->Mutex);
+    this->NumberOfParserThreads = count;
+  }
+
   void clear()
   {
     QMutexLocker locker(&this->Mutex);
@@ -198,6 +218,7 @@ protected:
   QString DatabaseFilename;
   QStringList TagsToPrecache;
   QStringList TagsToExcludeFromStorage;
+  int NumberOfParserThreads;
 
   bool IsIndexing;
   bool StopRequested;
@@ -210,6 +231,58 @@ protected:
 };
 
 
+/// Parses DICOM files on a pool of threads and returns the parsed datasets
+/// in the order the files were enqueued, so that a single writer can insert
+/// them into the database and report progress deterministically.
+class ctkDICOMIndexerParser
+{
+public:
+  ctkDICOMIndexerParser(DICOMIndexingQueue* queue);
+  ~ctkDICOMIndexerParser();
+
+  void setNumberOfThreads(int count);
+  int numberOfThreads() const;
+
+  struct ParsedFile
+  {
+    QString FilePath;
+    bool OverwriteExistingDataset;
+    QSharedPointer<ctkDICOMItem> Dataset;
+    qint64 BytesRead;
+    bool Done;
+  };
+
+  /// Schedule parsing of a file in the background.
+  void enqueue(const QString& filePath, bool overwriteExistingDataset);
+
+  /// Number of files that have been enqueued but not taken yet.
+  int pendingCount() const;
+
+  /// Wait until the oldest enqueued file is parsed and return it.
+  /// Only the file header is read (see ctkDICOMItem::InitializeFromFileHeader),
+  /// BytesRead is set to the number of bytes that were read from the file.
+  /// The dataset is null if parsing was skipped because stop was requested.
+  /// Returns false if there are no pending files.
+  bool takeNext(ParsedFile& parsedFile);
+
+  /// Discard all pending files. Parsing that is already in progress is
+  /// completed but the results are dropped.
+  void clear();
+
+protected:
+  friend class ctkDICOMIndexerParseTask;
+  void setParsed(qint64 index, QSharedPointer<ctkDICOMItem> dataset, qint64 bytesRead);
+
+  DICOMIndexingQueue* RequestQueue;
+  QThreadPool ThreadPool;
+  QMap<qint64, ParsedFile> ParsedFiles;
+  qint64 NextIndexToEnqueue;
+  qint64 NextIndexToTake;
+  mutable QMutex Mutex;
+  QWaitCondition ParsedCondition;
+};
+
+
 class ctkDICOMIndexerPrivateWorker : public QObject
 {
   Q_OBJECT
@@ -225,15 +298,20 @@ Q_SIGNALS:
   void progress(int);
   void progressDetail(QString);
   void progressStep(QString);
+  void progressFileCount(int, int);
   void updatingDatabase(bool);
   void indexingComplete(int, int, int, int);
 
 private:
 
   void processIndexingRequest(DICOMIndexingQueue::IndexingRequest& request, ctkDICOMDatabase& database);
+  /// Wait for the next file to be parsed and push it to the indexing results.
+  /// Returns false if no file is pending.
+  bool takeParsedFile(DICOMIndexingQueue::IndexingRequest& request, ctkDICOMDatabase& database);
   void writeIndexingResultsToDatabase(ctkDICOMDatabase& database);
 
   DICOMIndexingQueue* RequestQueue;
+  ctkDICOMIndexerParser Parser;
   int NumberOfInstancesToInsert;
   int NumberOfInstancesInserted;
 
@@ -242,6 +320,15 @@ private:
   int RemainingRequestCount; // the current request in progress is not included
   int CompletedRequestCount; // the current request in progress is not included
 
+  // Progress of the current request
+  int CurrentRequestFileCount;
+  int CurrentRequestDiscoveredFileCount;
+  int CurrentRequestParsedFileCount;
+  qint64 CurrentRequestBytesRead;
+  bool CurrentRequestEnumerationCompleted;
+
+  QElapsedTimer TimeSinceLastDatabaseWrite;
+
   // List of already indexed file paths and oldest file modified time in the database.
   // Cached here to avoid locking/unlocking a mutex each time a file is looked up.
   QMap<QString, QDateTime> ModifiedTimeForFilepath;
@@ -273,6 +360,7 @@ public:
   ctkDICOMDatabase* Database;
   bool BackgroundImportEnabled;
   bool FollowSymlinks;
+  int NumberOfParserThreads;
 };
 
 
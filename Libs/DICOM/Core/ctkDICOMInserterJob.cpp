@@ -36,6 +36,9 @@ ctkDICOMInserterJob::ctkDICOMInserterJob(QObject* parent)
   : Superclass(parent)
 {
   this->MaximumConcurrentJobsPerType = 1;
+  this->CoalescingWindow = 0;
+  this->MaximumCoalescedJobResponseSets = 0;
+  this->JobResponseSetsClosed = false;
 }
 
 //------------------------------------------------------------------------------
@@ -110,6 +113,78 @@ QStringList ctkDICOMInserterJob::tagsToExcludeFromStorage() const
   return this->TagsToExcludeFromStorage;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMInserterJob::setCoalescingWindow(int coalescingWindow)
+{
+  this->CoalescingWindow = coalescingWindow;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMInserterJob::coalescingWindow() const
+{
+  return this->CoalescingWindow;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMInserterJob::setMaximumCoalescedJobResponseSets(int maximumCoalescedJobResponseSets)
+{
+  this->MaximumCoalescedJobResponseSets = maximumCoalescedJobResponseSets;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMInserterJob::maximumCoalescedJobResponseSets() const
+{
+  return this->MaximumCoalescedJobResponseSets;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMInserterJob::appendJobResponseSets(const QList<QSharedPointer<ctkDICOMJobResponseSet>>& jobResponseSets)
+{
+  // Clone outside of the lock, the worker may be waiting for it
+  QList<QSharedPointer<ctkDICOMJobResponseSet>> jobResponseSetCopies;
+  foreach (QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet, jobResponseSets)
+  {
+    jobResponseSetCopies.append(QSharedPointer<ctkDICOMJobResponseSet>(jobResponseSet->clone()));
+  }
+
+  QMutexLocker locker(&this->JobResponseSetsMutex);
+  if (this->JobResponseSetsClosed ||
+      this->status() >= ctkAbstractJob::JobStatus::UserStopped)
+  {
+    return false;
+  }
+  if (this->MaximumCoalescedJobResponseSets > 0 &&
+      this->JobResponseSets.count() + jobResponseSetCopies.count() > this->MaximumCoalescedJobResponseSets)
+  {
+    return false;
+  }
+
+  this->JobResponseSets.append(jobResponseSetCopies);
+  this->JobResponseSetsAppended.wakeAll();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMInserterJob::waitForJobResponseSets(int timeout)
+{
+  QMutexLocker locker(&this->JobResponseSetsMutex);
+  if (this->MaximumCoalescedJobResponseSets > 0 &&
+      this->JobResponseSets.count() >= this->MaximumCoalescedJobResponseSets)
+  {
+    return true;
+  }
+  this->JobResponseSetsAppended.wait(&this->JobResponseSetsMutex, timeout);
+  return this->MaximumCoalescedJobResponseSets > 0 &&
+    this->JobResponseSets.count() >= this->MaximumCoalescedJobResponseSets;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMInserterJob::closeJobResponseSets()
+{
+  QMutexLocker locker(&this->JobResponseSetsMutex);
+  this->JobResponseSetsClosed = true;
+}
+
 //------------------------------------------------------------------------------
 ctkAbstractJob* ctkDICOMInserterJob::clone() const
 {
@@ -128,6 +203,8 @@ ctkAbstractJob* ctkDICOMInserterJob::clone() const
   newInserterJob->setDatabaseFilename(this->databaseFilename());
   newInserterJob->setTagsToPrecache(this->tagsToPrecache());
   newInserterJob->setTagsToExcludeFromStorage(this->tagsToExcludeFromStorage());
+  newInserterJob->setCoalescingWindow(this->coalescingWindow());
+  newInserterJob->setMaximumCoalescedJobResponseSets(this->maximumCoalescedJobResponseSets());
 
   return newInserterJob;
 }
@@ -25,8 +25,10 @@
 #define __ctkDICOMInserterJob_h
 
 // Qt includes
+#include <QMutex>
 #include <QObject>
 #include <QSharedPointer>
+#include <QWaitCondition>
 
 // ctkCore includes
 class ctkAbstractWorker;
@@ -43,6 +45,8 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMInserterJob : public ctkDICOMJob
   Q_PROPERTY(QString databaseFilename READ databaseFilename WRITE setDatabaseFilename);
   Q_PROPERTY(QStringList tagsToPrecache READ tagsToPrecache WRITE setTagsToPrecache);
   Q_PROPERTY(QStringList tagsToExcludeFromStorage READ tagsToExcludeFromStorage WRITE setTagsToExcludeFromStorage);
+  Q_PROPERTY(int coalescingWindow READ coalescingWindow WRITE setCoalescingWindow);
+  Q_PROPERTY(int maximumCoalescedJobResponseSets READ maximumCoalescedJobResponseSets WRITE setMaximumCoalescedJobResponseSets);
 
 public:
   typedef ctkDICOMJob Superclass;
@@ -70,6 +74,37 @@ public:
   QStringList tagsToExcludeFromStorage() const;
   ///}@
 
+  ///@{
+  /// Time in milliseconds during which the worker waits for more response sets
+  /// (see appendJobResponseSets()) before inserting them in a single transaction.
+  /// 0 by default (the response sets are inserted right away).
+  void setCoalescingWindow(int coalescingWindow);
+  int coalescingWindow() const;
+  ///}@
+
+  ///@{
+  /// Maximum number of response sets inserted by the job.
+  /// When it is reached, appendJobResponseSets() fails and the worker stops
+  /// waiting for the end of the coalescing window.
+  /// 0 by default (unlimited).
+  void setMaximumCoalescedJobResponseSets(int maximumCoalescedJobResponseSets);
+  int maximumCoalescedJobResponseSets() const;
+  ///}@
+
+  /// Append copies of \a jobResponseSets to the response sets to insert.
+  /// Return false if the worker already started the insertion, the job is stopped,
+  /// or maximumCoalescedJobResponseSets would be exceeded. The response sets are not
+  /// appended in that case.
+  /// This method is thread safe.
+  bool appendJobResponseSets(const QList<QSharedPointer<ctkDICOMJobResponseSet>>& jobResponseSets);
+
+  /// Wait at most \a timeout milliseconds for response sets to be appended.
+  /// Return true if maximumCoalescedJobResponseSets is reached.
+  bool waitForJobResponseSets(int timeout);
+
+  /// Stop accepting response sets. Called by the worker before the insertion.
+  void closeJobResponseSets();
+
   /// \see ctkAbstractJob::clone()
   Q_INVOKABLE ctkAbstractJob* clone() const override;
 
@@ -83,6 +118,11 @@ protected:
   QString DatabaseFilename;
   QStringList TagsToPrecache;
   QStringList TagsToExcludeFromStorage;
+  int CoalescingWindow;
+  int MaximumCoalescedJobResponseSets;
+  bool JobResponseSetsClosed;
+  QMutex JobResponseSetsMutex;
+  QWaitCondition JobResponseSetsAppended;
 
 private:
   Q_DISABLE_COPY(ctkDICOMInserterJob);
@@ -22,6 +22,7 @@
 =========================================================================*/
 
 // Qt includes
+#include <QElapsedTimer>
 #include <QThread>
 
 // ctkCore includes
@@ -118,6 +119,28 @@ void ctkDICOMInserterWorker::run()
                        .arg(inserterJob->jobUID())
                        .arg(QString::number(reinterpret_cast<quint64>(QThread::currentThreadId())), 16));
 
+  // Let the scheduler append the response sets of other jobs during the coalescing
+  // window, so that they are all inserted in a single transaction.
+  QElapsedTimer coalescingTimer;
+  coalescingTimer.start();
+  while (coalescingTimer.elapsed() < inserterJob->coalescingWindow() &&
+         !d->Inserter->wasCanceled())
+  {
+    // Wake up regularly to check if the job was canceled
+    int timeout = static_cast<int>(qMin<qint64>(100, inserterJob->coalescingWindow() - coalescingTimer.elapsed()));
+    if (inserterJob->waitForJobResponseSets(timeout))
+    {
+      break;
+    }
+  }
+  inserterJob->closeJobResponseSets();
+
+  if (d->Inserter->wasCanceled())
+  {
+    this->onJobCanceled(d->Inserter->wasCanceled());
+    return;
+  }
+
   QList<ctkDICOMJobResponseSet*> jobResponseSets = inserterJob->jobResponseSets();
   if (!d->Inserter->addJobResponseSets(jobResponseSets))
   {
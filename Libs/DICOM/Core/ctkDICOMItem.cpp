@@ -131,6 +131,35 @@ void ctkDICOMItem::InitializeFromFile(const QString& filename,
   InitializeFromItem(dataset, true);
 }
 
+qint64 ctkDICOMItem::InitializeFromFileHeader(const QString& filename)
+{
+  DcmInputFileStream fileStream(filename.toUtf8().data());
+  OFCondition status = fileStream.status();
+  if (!status.good())
+  {
+    qDebug() << "Could not open " << filename << "\nDCMTK says: " << status.text();
+    return -1;
+  }
+
+  DcmFileFormat fileformat;
+  fileformat.setReadMode(ERM_autoDetect);
+  fileformat.transferInit();
+  status = fileformat.readUntilTag(fileStream, EXS_Unknown, EGL_noChange, DCM_MaxReadLength, DCM_PixelData);
+  fileformat.transferEnd();
+  qint64 bytesRead = static_cast<qint64>(fileStream.tell());
+
+  DcmDataset* dataset = fileformat.getAndRemoveDataset();
+  if (!status.good())
+  {
+    qDebug() << "Could not load " << filename << "\nDCMTK says: " << status.text();
+    delete dataset;
+    return -1;
+  }
+
+  InitializeFromItem(dataset, true);
+  return bytesRead;
+}
+
 ctkDICOMItem* ctkDICOMItem::Clone()
 {
   Q_D(ctkDICOMItem);
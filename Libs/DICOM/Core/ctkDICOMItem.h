@@ -96,6 +96,17 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMItem
                     const Uint32 maxReadLength = DCM_MaxReadLength,
                     const E_FileReadMode readMode = ERM_autoDetect);
 
+    ///
+    /// \brief For initialization from the header of a file, without reading the pixel data.
+    ///
+    /// Parsing stops before the PixelData (7FE0,0010) element, therefore only the
+    /// elements preceding the pixel data are available in the item. This is much
+    /// faster than InitializeFromFile when only metadata is needed, especially
+    /// for large multiframe images.
+    ///
+    /// \return Number of bytes read from the file, or -1 if the file could not be read.
+    virtual qint64 InitializeFromFileHeader(const QString& filename);
+
     /// \brief Clone this object.
     ///
     /// \returns deep copy of this object.
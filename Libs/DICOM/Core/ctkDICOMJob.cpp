@@ -38,6 +38,7 @@ ctkDICOMJob::ctkDICOMJob(QObject* parent)
   : Superclass(parent)
 {
   this->DICOMLevel = DICOMLevels::None;
+  this->MemoryHighWaterMark = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -115,6 +116,18 @@ QString ctkDICOMJob::referenceInserterJobUID() const
   return this->ReferenceInserterJobUID;
 }
 
+//----------------------------------------------------------------------------
+void ctkDICOMJob::setMemoryHighWaterMark(qint64 memoryHighWaterMark)
+{
+  this->MemoryHighWaterMark = memoryHighWaterMark;
+}
+
+//----------------------------------------------------------------------------
+qint64 ctkDICOMJob::memoryHighWaterMark() const
+{
+  return this->MemoryHighWaterMark;
+}
+
 //----------------------------------------------------------------------------
 static void skipDelete(QObject* obj)
 {
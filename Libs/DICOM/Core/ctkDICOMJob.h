@@ -46,6 +46,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMJob : public ctkAbstractJob
   Q_PROPERTY(QString sopInstanceUID READ sopInstanceUID WRITE setSOPInstanceUID);
   Q_PROPERTY(DICOMLevels dicomLevel READ dicomLevel WRITE setDICOMLevel);
   Q_PROPERTY(QString referenceInserterJobUID READ referenceInserterJobUID WRITE setReferenceInserterJobUID);
+  Q_PROPERTY(qint64 memoryHighWaterMark READ memoryHighWaterMark WRITE setMemoryHighWaterMark);
 
 public:
   typedef ctkAbstractJob Superclass;
@@ -98,6 +99,14 @@ public:
   QString referenceInserterJobUID() const;
   ///@}
 
+  ///@{
+  /// Peak number of bytes of DICOM datasets held in memory by the job
+  /// (e.g. retrieved instances waiting for the inserter).
+  /// 0 by default.
+  void setMemoryHighWaterMark(qint64 memoryHighWaterMark);
+  qint64 memoryHighWaterMark() const;
+  ///@}
+
   ///@{
   /// Access the list of responses.
   Q_INVOKABLE QList<ctkDICOMJobResponseSet*> jobResponseSets() const;
@@ -134,6 +143,7 @@ protected:
   QString SeriesInstanceUID;
   QString SOPInstanceUID;
   QString ReferenceInserterJobUID;
+  qint64 MemoryHighWaterMark;
   ctkDICOMJob::DICOMLevels DICOMLevel;
   QList<QSharedPointer<ctkDICOMJobResponseSet>> JobResponseSets;
   QStringList QueryWarningMessages;
@@ -156,6 +166,7 @@ struct CTK_DICOM_CORE_EXPORT ctkDICOMJobDetail : ctkJobDetail
     this->SeriesInstanceUID = job.seriesInstanceUID();
     this->SOPInstanceUID = job.sopInstanceUID();
     this->ReferenceInserterJobUID = job.referenceInserterJobUID();
+    this->MemoryHighWaterMark = job.memoryHighWaterMark();
     this->QueryWarningMessages = job.queryWarningMessages();
   }
 
@@ -209,6 +220,7 @@ struct CTK_DICOM_CORE_EXPORT ctkDICOMJobDetail : ctkJobDetail
 
   // Specific to DICOM Query and Retrieve jobs
   ctkDICOMJob::DICOMLevels DICOMLevel{ctkDICOMJob::DICOMLevels::None};
+  qint64 MemoryHighWaterMark{0};
 
   // Specific to DICOM JobResponseSet
   ctkDICOMJobResponseSet::JobType JobType{ctkDICOMJobResponseSet::JobType::None};
@@ -48,6 +48,7 @@ public:
 
   QString FilePath;
   bool CopyFile;
+  bool MoveFile;
   bool OverwriteExistingDataset;
 
   ctkDICOMJobResponseSet::JobType JobType;
@@ -70,6 +71,7 @@ ctkDICOMJobResponseSetPrivate::ctkDICOMJobResponseSetPrivate(ctkDICOMJobResponse
 {
   this->JobType = ctkDICOMJobResponseSet::JobType::None;
   this->CopyFile = false;
+  this->MoveFile = false;
   this->OverwriteExistingDataset = false;
 }
 
@@ -96,6 +98,8 @@ ctkDICOMJobResponseSet::~ctkDICOMJobResponseSet() = default;
 CTK_GET_CPP(ctkDICOMJobResponseSet, QString, filePath, FilePath);
 CTK_SET_CPP(ctkDICOMJobResponseSet, bool, setCopyFile, CopyFile);
 CTK_GET_CPP(ctkDICOMJobResponseSet, bool, copyFile, CopyFile);
+CTK_SET_CPP(ctkDICOMJobResponseSet, bool, setMoveFile, MoveFile);
+CTK_GET_CPP(ctkDICOMJobResponseSet, bool, moveFile, MoveFile);
 CTK_SET_CPP(ctkDICOMJobResponseSet, bool, setOverwriteExistingDataset, OverwriteExistingDataset);
 CTK_GET_CPP(ctkDICOMJobResponseSet, bool, overwriteExistingDataset, OverwriteExistingDataset);
 CTK_SET_CPP(ctkDICOMJobResponseSet, ctkDICOMJobResponseSet::JobType, setJobType, JobType);
@@ -124,11 +128,13 @@ void ctkDICOMJobResponseSet::setFilePath(const QString& filePath)
     return;
   }
 
+  // The file itself is copied or linked when inserted into the database,
+  // therefore only the metadata is needed here.
   QSharedPointer<ctkDICOMItem> dataset =
     QSharedPointer<ctkDICOMItem>(new ctkDICOMItem);
-  dataset->InitializeFromFile(filePath);
+  dataset->InitializeFromFileHeader(filePath);
 
-  DcmItem dcmItem = dataset->GetDcmItem();
+  DcmItem& dcmItem = dataset->GetDcmItem();
   OFString SOPInstanceUID;
   dcmItem.findAndGetOFString(DCM_SOPInstanceUID, SOPInstanceUID);
 
@@ -263,8 +269,11 @@ ctkDICOMJobResponseSet* ctkDICOMJobResponseSet::clone()
 {
   ctkDICOMJobResponseSet* newJobResponseSet = new ctkDICOMJobResponseSet;
 
-  newJobResponseSet->setFilePath(this->filePath());
+  // The header read by setFilePath is already in the cloned datasets,
+  // do not read the file again.
+  newJobResponseSet->d_func()->FilePath = this->filePath();
   newJobResponseSet->setCopyFile(this->copyFile());
+  newJobResponseSet->setMoveFile(this->moveFile());
   newJobResponseSet->setOverwriteExistingDataset(this->overwriteExistingDataset());
   newJobResponseSet->setJobType(this->jobType());
   newJobResponseSet->setJobUID(this->jobUID());
@@ -41,6 +41,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMJobResponseSet : public QObject
   Q_OBJECT
   Q_PROPERTY(QString filePath READ filePath WRITE setFilePath);
   Q_PROPERTY(bool copyFile READ copyFile WRITE setCopyFile);
+  Q_PROPERTY(bool moveFile READ moveFile WRITE setMoveFile);
   Q_PROPERTY(bool overwriteExistingDataset READ overwriteExistingDataset WRITE setOverwriteExistingDataset);
   Q_PROPERTY(JobType jobType READ jobType WRITE setJobType);
   Q_PROPERTY(QString jobUID READ jobUID WRITE setJobUID);
@@ -67,6 +68,16 @@ public:
   bool copyFile() const;
   ///@}
 
+  ///@{
+  /// Move File
+  /// The file at filePath is a temporary copy (e.g. spooled by ctkDICOMRetrieve)
+  /// that is moved into the database instead of being copied, and removed if
+  /// it is not inserted.
+  /// false as default
+  void setMoveFile(bool moveFile);
+  bool moveFile() const;
+  ///@}
+
   ///@{
   /// Overwrite existing dataset
   /// false as default
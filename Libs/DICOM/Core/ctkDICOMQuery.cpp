@@ -31,13 +31,16 @@
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QStringList>
+#include <QThread>
 #include <QVariant>
+#include <QWaitCondition>
 
 // ctkCore includes
 #include <ctkPimpl.h>
 
 // ctkDICOMCore includes
 #include "ctkDICOMQuery.h"
+#include "ctkDICOMAssociationPool.h"
 #include "ctkDICOMJobResponseSet.h"
 #include "ctkDICOMQueryLimitWarning.h"
 
@@ -85,31 +88,41 @@ class ctkDICOMQuerySCUPrivate : public DcmSCU
 {
 public:
   ctkDICOMQuery *query;
+  /// Release the association of the query when a response is received after cancel.
+  /// Disabled for the additional associations of concurrent series queries, which
+  /// are closed by the thread using them.
+  bool ReleaseAssociationOnCancel;
   ctkDICOMQuerySCUPrivate()
   {
     this->query = 0;
+    this->ReleaseAssociationOnCancel = true;
   };
   ~ctkDICOMQuerySCUPrivate() {};
   virtual OFCondition handleFINDResponse(const T_ASC_PresentationContextID  presID,
                                          QRResponse *response,
-                                         OFBool &waitForNextResponse)
-  {
-    if (!this->query)
-    {
-      return EC_IllegalCall;
-    }
-
-    if (this->query->wasCanceled())
-    {
-      // send cancel can fail and be ignored (but DCMTK will report still good == true).
-      // Therefore, we need to force the release of the association to cancel the worker
-      this->query->releaseAssociation();
-      return EC_IllegalCall;
-    }
+                                         OFBool &waitForNextResponse);
+};
 
-    LOG_AND_EMIT_DEBUG(QString("FIND RESPONSE"), this->query->debug);
-    return this->DcmSCU::handleFINDResponse(presID, response, waitForNextResponse);
+//------------------------------------------------------------------------------
+// State shared by the threads sending the series level C-FIND requests of query()
+struct ctkDICOMQuerySeriesRequests
+{
+  struct Result
+  {
+    QString StudyInstanceUID;
+    OFList<QRResponse*> Responses;
+    bool Success = false;
   };
+
+  QMutex Mutex;
+  QWaitCondition ResultAvailable;
+  /// Studies not requested yet
+  QStringList PendingStudyInstanceUIDs;
+  /// Completed requests not inserted in the database yet
+  QList<Result> Results;
+  int RunningThreads = 0;
+  Uint32 ACSETimeout = 10;
+  Sint32 ConnectionTimeout = 10;
 };
 
 //------------------------------------------------------------------------------
@@ -153,10 +166,75 @@ public:
                                const DcmTagKey& tag,
                                const QString& value) const;
 
+  /// Query the series of all the studies in StudyDatasets using up to
+  /// MaximumConcurrentSeriesQueries associations, and insert them in \a database
+  /// as the requests complete. Return false if canceled.
+  bool querySeriesConcurrently(ctkDICOMQuery* queryObject,
+                               ctkDICOMDatabase& database,
+                               Uint16 presentationContext);
+
+  /// Send series level C-FIND requests for the pending studies until none is left.
+  /// If \a scu is null, an additional association is leased or negotiated.
+  /// Called from the threads started by querySeriesConcurrently().
+  void sendSeriesRequests(ctkDICOMQuery* queryObject,
+                          ctkDICOMQuerySeriesRequests* requests,
+                          DcmDataset* requestDataset,
+                          QSharedPointer<ctkDICOMQuerySCUPrivate> scu,
+                          Uint16 presentationContext);
+
+  /// Lease from the association pool (without waiting) or negotiate an additional association.
+  /// Return null if no association could be opened.
+  QSharedPointer<ctkDICOMQuerySCUPrivate> openAdditionalAssociation(ctkDICOMQuery* queryObject,
+                                                                    const ctkDICOMQuerySeriesRequests* requests,
+                                                                    bool& leased);
+  void closeAdditionalAssociation(QSharedPointer<ctkDICOMQuerySCUPrivate> scu, bool leased, bool reusable);
+
+  /// State of the C-FIND request sent by sendFINDRequestInBatches()
+  struct ResponseStream
+  {
+    bool Active = false;
+    /// Job type and identifiers of the emitted batches
+    QSharedPointer<ctkDICOMJobResponseSet> Header;
+    /// Attribute identifying the datasets of a batch
+    DcmTagKey KeyTag;
+    QStringList ModalityFilter;
+    int MaximumResponses = 0;
+    int NumberOfResponses = 0;
+    bool LimitReached = false;
+    Uint16 FinalStatus = STATUS_Success;
+    QMap<QString, DcmItem*> Datasets;
+  };
+
+  /// Send the C-FIND request of QueryDcmDataset without collecting the responses:
+  /// the datasets are emitted with jobResponseSetAvailable() by batches of ResponseBatchSize.
+  /// The datasets received after the last batch are returned in \a lastDatasets.
+  /// If \a maximumResponses is reached, a C-CANCEL is sent and the following responses are ignored.
+  OFCondition sendFINDRequestInBatches(ctkDICOMQuery* queryObject,
+                                       Uint16 presentationContext,
+                                       QSharedPointer<ctkDICOMJobResponseSet> header,
+                                       const DcmTagKey& keyTag,
+                                       const QString& level,
+                                       QMap<QString, DcmItem*>& lastDatasets,
+                                       int maximumResponses = 0,
+                                       const QStringList& modalityFilter = QStringList());
+
+  /// Called by the SCU for each response received by sendFINDRequestInBatches().
+  void streamFINDResponse(ctkDICOMQuery* queryObject,
+                          DcmSCU* scu,
+                          T_ASC_PresentationContextID presentationContext,
+                          QRResponse* response);
+
   /// \warning: releaseAssociation is not a thread safe method.
   /// If called concurrently from different threads DCMTK can crash.
   /// Therefore use this method instead of calling directly SCU->releaseAssociation()
-  OFCondition releaseAssociation();
+  /// If the association was leased from the association pool and \a reusable is true,
+  /// then it is returned to the pool instead of being released.
+  OFCondition releaseAssociation(bool reusable = true);
+
+  /// Replace the SCU by \a scu (or by a new SCU if null), copying the connection settings
+  /// of the current SCU. Must be called with AssociationMutex locked.
+  /// Returns the previous SCU.
+  QSharedPointer<ctkDICOMQuerySCUPrivate> replaceSCU(QSharedPointer<ctkDICOMQuerySCUPrivate> scu);
 
   QString ConnectionName;
   QString CallingAETitle;
@@ -164,7 +242,10 @@ public:
   QString Host;
   int Port;
   QMap<QString,QVariant> Filters;
-  ctkDICOMQuerySCUPrivate *SCU;
+  QSharedPointer<ctkDICOMQuerySCUPrivate> SCU;
+  QSharedPointer<ctkDICOMAssociationPool> AssociationPool;
+  QString AssociationPoolKey;
+  bool AssociationLeased;
   Uint16 PresentationContext;
   QSharedPointer<DcmDataset> QueryDcmDataset;
   QList<QPair<QString,QString>> StudyAndSeriesInstanceUIDPairList;
@@ -173,11 +254,84 @@ public:
   bool AssociationClosing;
   QMutex AssociationMutex;
   int MaximumPatientsQuery;
+  int MaximumConcurrentSeriesQueries;
+  int ResponseBatchSize;
+  ResponseStream Stream;
   QString JobUID;
   QList<QSharedPointer<ctkDICOMJobResponseSet>> JobResponseSets;
   QList<ctkDICOMQueryLimitWarning> QueryLimitWarnings;
 };
 
+//------------------------------------------------------------------------------
+class ctkDICOMQuerySeriesThread : public QThread
+{
+public:
+  ctkDICOMQuerySeriesThread(ctkDICOMQueryPrivate* queryPrivate,
+                            ctkDICOMQuery* queryObject,
+                            ctkDICOMQuerySeriesRequests* requests,
+                            QSharedPointer<DcmDataset> requestDataset,
+                            QSharedPointer<ctkDICOMQuerySCUPrivate> scu,
+                            Uint16 presentationContext)
+    : QueryPrivate(queryPrivate)
+    , QueryObject(queryObject)
+    , Requests(requests)
+    , RequestDataset(requestDataset)
+    , SCU(scu)
+    , PresentationContext(presentationContext)
+  {
+  }
+
+protected:
+  void run() override
+  {
+    this->QueryPrivate->sendSeriesRequests(
+      this->QueryObject, this->Requests, this->RequestDataset.data(), this->SCU, this->PresentationContext);
+    this->SCU.clear();
+  }
+
+  ctkDICOMQueryPrivate* QueryPrivate;
+  ctkDICOMQuery* QueryObject;
+  ctkDICOMQuerySeriesRequests* Requests;
+  QSharedPointer<DcmDataset> RequestDataset;
+  QSharedPointer<ctkDICOMQuerySCUPrivate> SCU;
+  Uint16 PresentationContext;
+};
+
+//------------------------------------------------------------------------------
+// ctkDICOMQuerySCUPrivate methods
+
+//------------------------------------------------------------------------------
+OFCondition ctkDICOMQuerySCUPrivate::handleFINDResponse(const T_ASC_PresentationContextID  presID,
+                                                        QRResponse *response,
+                                                        OFBool &waitForNextResponse)
+{
+  if (!this->query)
+  {
+    return EC_IllegalCall;
+  }
+
+  if (this->query->wasCanceled())
+  {
+    // send cancel can fail and be ignored (but DCMTK will report still good == true).
+    // Therefore, we need to force the release of the association to cancel the worker
+    if (this->ReleaseAssociationOnCancel)
+    {
+      this->query->releaseAssociation();
+    }
+    return EC_IllegalCall;
+  }
+
+  LOG_AND_EMIT_DEBUG(QString("FIND RESPONSE"), this->query->debug);
+  OFCondition status = this->DcmSCU::handleFINDResponse(presID, response, waitForNextResponse);
+
+  ctkDICOMQueryPrivate* queryPrivate = this->query->d_func();
+  if (status.good() && queryPrivate->Stream.Active)
+  {
+    queryPrivate->streamFINDResponse(this->query, this, presID, response);
+  }
+  return status;
+}
+
 //------------------------------------------------------------------------------
 // ctkDICOMQueryPrivate methods
 
@@ -188,10 +342,13 @@ ctkDICOMQueryPrivate::ctkDICOMQueryPrivate()
   this->Port = 0;
   this->Canceled = false;
   this->AssociationClosing = false;
+  this->AssociationLeased = false;
   this->MaximumPatientsQuery = 0; // unlimited
+  this->MaximumConcurrentSeriesQueries = 1;
+  this->ResponseBatchSize = 0;
 
   this->PresentationContext = 0;
-  this->SCU = new ctkDICOMQuerySCUPrivate();
+  this->SCU = QSharedPointer<ctkDICOMQuerySCUPrivate>(new ctkDICOMQuerySCUPrivate);
   this->SCU->setACSETimeout(10);
   this->SCU->setConnectionTimeout(10);
 }
@@ -199,16 +356,11 @@ ctkDICOMQueryPrivate::ctkDICOMQueryPrivate()
 //------------------------------------------------------------------------------
 ctkDICOMQueryPrivate::~ctkDICOMQueryPrivate()
 {
-  if (this->SCU && this->SCU->isConnected())
+  if (this->SCU && (this->AssociationLeased || this->SCU->isConnected()))
   {
     this->releaseAssociation();
   }
 
-  if (this->SCU)
-  {
-    delete this->SCU;
-  }
-
   this->JobResponseSets.clear();
 }
 
@@ -225,7 +377,7 @@ void ctkDICOMQueryPrivate::addStudyInstanceUIDAndDataset( const QString& studyIn
 }
 
 //------------------------------------------------------------------------------
-OFCondition ctkDICOMQueryPrivate::releaseAssociation()
+OFCondition ctkDICOMQueryPrivate::releaseAssociation(bool reusable)
 {
   OFCondition status = EC_IllegalCall;
   if (!this->SCU)
@@ -239,13 +391,50 @@ OFCondition ctkDICOMQueryPrivate::releaseAssociation()
     return status;
   }
 
+  if (this->AssociationLeased && reusable && !this->Canceled && this->SCU->isConnected())
+  {
+    // Hand the association over to the pool and continue with a new SCU
+    this->AssociationLeased = false;
+    this->AssociationPool->returnAssociation(this->AssociationPoolKey, this->replaceSCU(nullptr));
+    return EC_Normal;
+  }
+
   this->AssociationClosing = true;
-  status = this->SCU->releaseAssociation();
+  if (this->SCU->isConnected())
+  {
+    status = this->SCU->releaseAssociation();
+  }
   this->AssociationClosing = false;
 
+  if (this->AssociationLeased)
+  {
+    // The SCU is kept because this method may be called from one of its callbacks,
+    // only the pool slot is given back.
+    this->AssociationLeased = false;
+    this->AssociationPool->returnAssociation(this->AssociationPoolKey, QSharedPointer<DcmSCU>(), false);
+  }
+
   return status;
 }
 
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMQuerySCUPrivate> ctkDICOMQueryPrivate::replaceSCU(QSharedPointer<ctkDICOMQuerySCUPrivate> scu)
+{
+  QSharedPointer<ctkDICOMQuerySCUPrivate> previousSCU = this->SCU;
+  if (!scu)
+  {
+    scu = QSharedPointer<ctkDICOMQuerySCUPrivate>(new ctkDICOMQuerySCUPrivate);
+  }
+  scu->setACSETimeout(previousSCU->getACSETimeout());
+  scu->setConnectionTimeout(previousSCU->getConnectionTimeout());
+  scu->setVerbosePCMode(false);
+  scu->ReleaseAssociationOnCancel = true;
+  scu->query = previousSCU->query;
+  previousSCU->query = 0;
+  this->SCU = scu;
+  return previousSCU;
+}
+
 //------------------------------------------------------------------------------
 ctkDICOMQueryPrivate::StudyMetadata ctkDICOMQueryPrivate::queryStudyMetadata(
   ctkDICOMQuery* queryObject,
@@ -388,6 +577,370 @@ void ctkDICOMQueryPrivate::enrichSeriesDataset(DcmDataset* dataset,
   this->putDatasetStringIfEmpty(dataset, DCM_ModalitiesInStudy, studyMetadata.ModalitiesInStudy);
 }
 
+//------------------------------------------------------------------------------
+OFCondition ctkDICOMQueryPrivate::sendFINDRequestInBatches(ctkDICOMQuery* queryObject,
+                                                           Uint16 presentationContext,
+                                                           QSharedPointer<ctkDICOMJobResponseSet> header,
+                                                           const DcmTagKey& keyTag,
+                                                           const QString& level,
+                                                           QMap<QString, DcmItem*>& lastDatasets,
+                                                           int maximumResponses,
+                                                           const QStringList& modalityFilter)
+{
+  this->Stream = ResponseStream();
+  this->Stream.Header = header;
+  this->Stream.KeyTag = keyTag;
+  this->Stream.ModalityFilter = modalityFilter;
+  this->Stream.MaximumResponses = maximumResponses;
+  this->Stream.Active = true;
+
+  // Without a response list, DcmSCU deletes each response once handled
+  OFCondition status = this->SCU->sendFINDRequest(presentationContext, this->QueryDcmDataset.data(), NULL);
+
+  this->Stream.Active = false;
+  this->Stream.Header.clear();
+  lastDatasets = this->Stream.Datasets;
+  this->Stream.Datasets.clear();
+
+  if (status.good())
+  {
+    // the final response is the only one carrying a non pending status
+    QRResponse finalResponse;
+    finalResponse.m_status = this->Stream.FinalStatus;
+    OFList<QRResponse*> finalResponses;
+    finalResponses.push_back(&finalResponse);
+    queryObject->reportIncompleteFindStatus(finalResponses, level);
+  }
+  else
+  {
+    qDeleteAll(lastDatasets);
+    lastDatasets.clear();
+  }
+
+  return status;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQueryPrivate::streamFINDResponse(ctkDICOMQuery* queryObject,
+                                              DcmSCU* scu,
+                                              T_ASC_PresentationContextID presentationContext,
+                                              QRResponse* response)
+{
+  ResponseStream& stream = this->Stream;
+  if (!DICOM_PENDING_STATUS(response->m_status))
+  {
+    stream.FinalStatus = response->m_status;
+    return;
+  }
+
+  DcmDataset* dataset = response->m_dataset;
+  if (stream.LimitReached || !dataset)
+  {
+    return;
+  }
+
+  if (!stream.ModalityFilter.isEmpty())
+  {
+    OFString modality;
+    dataset->findAndGetOFString(DCM_Modality, modality);
+    if (!stream.ModalityFilter.contains(QString(modality.c_str()), Qt::CaseInsensitive))
+    {
+      return;
+    }
+  }
+
+  stream.NumberOfResponses++;
+  if (stream.MaximumResponses != 0 && stream.NumberOfResponses > stream.MaximumResponses)
+  {
+    ctkDICOMQueryLimitWarning limitWarning;
+    limitWarning.Reason = ctkDICOMQueryLimitReason::ClientMaximumReached;
+    limitWarning.Level = QStringLiteral("patient");
+    limitWarning.Limit = stream.MaximumResponses;
+    queryObject->recordQueryLimitWarning(limitWarning);
+
+    // No need to wait for the remaining matches
+    stream.LimitReached = true;
+    scu->sendCANCELRequest(presentationContext);
+    return;
+  }
+
+  // A full batch is only handed over when a new dataset arrives, so that the
+  // datasets returned at the end of the request are never empty if there was a match.
+  if (stream.Datasets.count() >= this->ResponseBatchSize)
+  {
+    QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet(stream.Header->clone());
+    jobResponseSet->setDatasets(stream.Datasets);
+    stream.Datasets.clear();
+    emit queryObject->jobResponseSetAvailable(jobResponseSet);
+  }
+
+  OFString key;
+  dataset->findAndGetOFString(stream.KeyTag, key);
+  delete stream.Datasets.take(key.c_str());
+  stream.Datasets.insert(key.c_str(), dataset);
+  // the dataset is now owned by the batch
+  response->m_dataset = NULL;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMQueryPrivate::querySeriesConcurrently(ctkDICOMQuery* queryObject,
+                                                   ctkDICOMDatabase& database,
+                                                   Uint16 presentationContext)
+{
+  ctkDICOMQuerySeriesRequests requests;
+  requests.PendingStudyInstanceUIDs = this->StudyDatasets.keys();
+  requests.ACSETimeout = this->SCU->getACSETimeout();
+  requests.ConnectionTimeout = this->SCU->getConnectionTimeout();
+  int numberOfStudies = requests.PendingStudyInstanceUIDs.count();
+  int numberOfThreads = qMin(this->MaximumConcurrentSeriesQueries, numberOfStudies);
+  requests.RunningThreads = numberOfThreads;
+
+  // The first thread keeps using the association of the study level query,
+  // the other ones open their own association.
+  QList<QSharedPointer<ctkDICOMQuerySeriesThread>> threads;
+  for (int index = 0; index < numberOfThreads; ++index)
+  {
+    QSharedPointer<ctkDICOMQuerySeriesThread> thread(new ctkDICOMQuerySeriesThread(
+      this, queryObject, &requests, QSharedPointer<DcmDataset>(new DcmDataset(*this->QueryDcmDataset)),
+      index == 0 ? this->SCU : QSharedPointer<ctkDICOMQuerySCUPrivate>(), presentationContext));
+    threads.append(thread);
+    thread->start();
+  }
+
+  // The database is not thread safe: the responses are inserted from this thread
+  // as soon as each request completes.
+  int numberOfResults = 0;
+  while (true)
+  {
+    ctkDICOMQuerySeriesRequests::Result result;
+    {
+      QMutexLocker locker(&requests.Mutex);
+      while (requests.Results.isEmpty() && requests.RunningThreads > 0)
+      {
+        requests.ResultAvailable.wait(&requests.Mutex);
+      }
+      if (requests.Results.isEmpty())
+      {
+        break;
+      }
+      result = requests.Results.takeFirst();
+    }
+
+    if (!result.Success)
+    {
+      LOG_AND_EMIT_ERROR(QString("Find at Series level failed for Study: %1").arg(result.StudyInstanceUID), queryObject->error)
+    }
+    else if (!this->Canceled)
+    {
+      DcmDataset *studyDataset = this->StudyDatasets.value(result.StudyInstanceUID);
+      DcmElement *patientName = NULL, *patientID = NULL;
+      studyDataset->findAndGetElement(DCM_PatientName, patientName);
+      studyDataset->findAndGetElement(DCM_PatientID, patientID);
+
+      for (OFListIterator(QRResponse*) it = result.Responses.begin(); it != result.Responses.end(); it++)
+      {
+        DcmDataset *dataset = (*it)->m_dataset;
+        if (dataset != NULL)
+        {
+          OFString seriesInstanceUID;
+          dataset->findAndGetOFString(DCM_SeriesInstanceUID, seriesInstanceUID);
+          this->addStudyAndSeriesInstanceUID(result.StudyInstanceUID, seriesInstanceUID.c_str());
+          // add the patient elements not provided for the series level query,
+          // copied because the responses are deleted once inserted
+          if (patientName)
+          {
+            dataset->insert(OFstatic_cast(DcmElement*, patientName->clone()), true);
+          }
+          if (patientID)
+          {
+            dataset->insert(OFstatic_cast(DcmElement*, patientID->clone()), true);
+          }
+          // insert series dataset
+          database.insert(dataset, false /* do not store */, false /* no thumbnail */);
+        }
+      }
+
+      queryObject->reportIncompleteFindStatus(result.Responses, "series");
+      LOG_AND_EMIT_DEBUG(QString("Find succeeded at Series level for Study: %1").arg(result.StudyInstanceUID), queryObject->debug)
+    }
+
+    for (OFListIterator(QRResponse*) it = result.Responses.begin(); it != result.Responses.end(); it++)
+    {
+      delete *it;
+    }
+
+    emit queryObject->progress(50 + (50 * ++numberOfResults) / numberOfStudies);
+  }
+
+  foreach (QSharedPointer<ctkDICOMQuerySeriesThread> thread, threads)
+  {
+    thread->wait();
+  }
+
+  return !this->Canceled;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQueryPrivate::sendSeriesRequests(ctkDICOMQuery* queryObject,
+                                              ctkDICOMQuerySeriesRequests* requests,
+                                              DcmDataset* requestDataset,
+                                              QSharedPointer<ctkDICOMQuerySCUPrivate> scu,
+                                              Uint16 presentationContext)
+{
+  bool additionalAssociation = scu.isNull();
+  bool leased = false;
+  if (additionalAssociation && !this->Canceled)
+  {
+    scu = this->openAdditionalAssociation(queryObject, requests, leased);
+    if (scu)
+    {
+      presentationContext = scu->findPresentationContextID(UID_FINDStudyRootQueryRetrieveInformationModel, "");
+    }
+  }
+
+  bool reusable = true;
+  while (scu && presentationContext != 0)
+  {
+    ctkDICOMQuerySeriesRequests::Result result;
+    {
+      QMutexLocker locker(&requests->Mutex);
+      if (this->Canceled || requests->PendingStudyInstanceUIDs.isEmpty())
+      {
+        break;
+      }
+      result.StudyInstanceUID = requests->PendingStudyInstanceUIDs.takeFirst();
+    }
+
+    LOG_AND_EMIT_DEBUG(QString("Starting Series C-FIND for Study: %1").arg(result.StudyInstanceUID), queryObject->debug)
+    requestDataset->putAndInsertString(DCM_StudyInstanceUID, result.StudyInstanceUID.toStdString().c_str());
+    result.Success = scu->sendFINDRequest(presentationContext, requestDataset, &result.Responses).good();
+    reusable = reusable && result.Success;
+
+    {
+      QMutexLocker locker(&requests->Mutex);
+      requests->Results.append(result);
+      requests->ResultAvailable.wakeAll();
+    }
+
+    if (!scu->isConnected())
+    {
+      // leave the remaining studies to the other associations
+      break;
+    }
+  }
+
+  if (additionalAssociation && scu)
+  {
+    this->closeAdditionalAssociation(scu, leased, reusable && !this->Canceled);
+  }
+
+  QMutexLocker locker(&requests->Mutex);
+  requests->RunningThreads--;
+  if (requests->RunningThreads == 0 && !this->Canceled)
+  {
+    // no association is left to request the remaining studies
+    foreach (const QString& studyInstanceUID, requests->PendingStudyInstanceUIDs)
+    {
+      ctkDICOMQuerySeriesRequests::Result result;
+      result.StudyInstanceUID = studyInstanceUID;
+      result.Success = false;
+      requests->Results.append(result);
+    }
+    requests->PendingStudyInstanceUIDs.clear();
+  }
+  requests->ResultAvailable.wakeAll();
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMQuerySCUPrivate> ctkDICOMQueryPrivate::openAdditionalAssociation(
+  ctkDICOMQuery* queryObject,
+  const ctkDICOMQuerySeriesRequests* requests,
+  bool& leased)
+{
+  leased = false;
+  QSharedPointer<ctkDICOMQuerySCUPrivate> scu;
+  if (this->AssociationPool)
+  {
+    // Do not wait for the other jobs to return an association: meanwhile the
+    // studies are requested on the associations already open.
+    QSharedPointer<DcmSCU> pooledSCU;
+    if (!this->AssociationPool->tryLeaseAssociation(this->AssociationPoolKey, pooledSCU))
+    {
+      return scu;
+    }
+    leased = true;
+    scu = qSharedPointerDynamicCast<ctkDICOMQuerySCUPrivate>(pooledSCU);
+    if (scu && scu->isConnected())
+    {
+      scu->ReleaseAssociationOnCancel = false;
+      scu->query = queryObject;
+      return scu;
+    }
+  }
+
+  scu = QSharedPointer<ctkDICOMQuerySCUPrivate>(new ctkDICOMQuerySCUPrivate);
+  scu->ReleaseAssociationOnCancel = false;
+  scu->query = queryObject;
+  scu->setVerbosePCMode(false);
+  scu->setACSETimeout(requests->ACSETimeout);
+  scu->setConnectionTimeout(requests->ConnectionTimeout);
+  scu->setAETitle(OFString(this->CallingAETitle.toStdString().c_str()));
+  scu->setPeerAETitle(OFString(this->CalledAETitle.toStdString().c_str()));
+  scu->setPeerHostName(OFString(this->Host.toStdString().c_str()));
+  scu->setPeerPort(this->Port);
+
+  OFList<OFString> transferSyntaxes;
+  transferSyntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+  transferSyntaxes.push_back(UID_BigEndianExplicitTransferSyntax);
+  transferSyntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+  scu->addPresentationContext(UID_FINDStudyRootQueryRetrieveInformationModel, transferSyntaxes);
+
+  OFCondition result = scu->initNetwork();
+  if (result.good())
+  {
+    result = scu->negotiateAssociation();
+  }
+  if (result.bad())
+  {
+    LOG_AND_EMIT_WARN(QString("Error negotiating an additional association for series queries: %1").arg(result.text()), queryObject->warn)
+    this->closeAdditionalAssociation(scu, leased, false);
+    return QSharedPointer<ctkDICOMQuerySCUPrivate>();
+  }
+
+  return scu;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQueryPrivate::closeAdditionalAssociation(QSharedPointer<ctkDICOMQuerySCUPrivate> scu,
+                                                      bool leased,
+                                                      bool reusable)
+{
+  scu->query = 0;
+  if (leased && reusable && scu->isConnected())
+  {
+    this->AssociationPool->returnAssociation(this->AssociationPoolKey, scu);
+    return;
+  }
+
+  if (scu->isConnected())
+  {
+    // an association interrupted in the middle of a C-FIND cannot be released
+    if (reusable)
+    {
+      scu->releaseAssociation();
+    }
+    else
+    {
+      scu->abortAssociation();
+    }
+  }
+
+  if (leased)
+  {
+    this->AssociationPool->returnAssociation(this->AssociationPoolKey, QSharedPointer<DcmSCU>(), false);
+  }
+}
+
 //------------------------------------------------------------------------------
 // ctkDICOMQuery methods
 
@@ -420,6 +973,10 @@ CTK_SET_CPP(ctkDICOMQuery, const int&, setPort, Port);
 CTK_GET_CPP(ctkDICOMQuery, int, port, Port)
 CTK_SET_CPP(ctkDICOMQuery, const int&, setMaximumPatientsQuery, MaximumPatientsQuery);
 CTK_GET_CPP(ctkDICOMQuery, int, maximumPatientsQuery, MaximumPatientsQuery);
+CTK_SET_CPP(ctkDICOMQuery, const int&, setMaximumConcurrentSeriesQueries, MaximumConcurrentSeriesQueries);
+CTK_GET_CPP(ctkDICOMQuery, int, maximumConcurrentSeriesQueries, MaximumConcurrentSeriesQueries);
+CTK_SET_CPP(ctkDICOMQuery, const int&, setResponseBatchSize, ResponseBatchSize);
+CTK_GET_CPP(ctkDICOMQuery, int, responseBatchSize, ResponseBatchSize);
 CTK_SET_CPP(ctkDICOMQuery, const QString&, setJobUID, JobUID);
 CTK_GET_CPP(ctkDICOMQuery, QString, jobUID, JobUID)
 
@@ -438,6 +995,35 @@ int ctkDICOMQuery::connectionTimeout() const
   return d->SCU->getConnectionTimeout();
 }
 
+//------------------------------------------------------------------------------
+static void skipDelete(QObject* obj)
+{
+  Q_UNUSED(obj);
+  // this deleter does not delete the object from memory
+  // useful if the pointer is not owned by the smart pointer
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQuery::setAssociationPool(ctkDICOMAssociationPool& associationPool)
+{
+  Q_D(ctkDICOMQuery);
+  d->AssociationPool = QSharedPointer<ctkDICOMAssociationPool>(&associationPool, skipDelete);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQuery::setAssociationPool(QSharedPointer<ctkDICOMAssociationPool> associationPool)
+{
+  Q_D(ctkDICOMQuery);
+  d->AssociationPool = associationPool;
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMAssociationPool* ctkDICOMQuery::associationPool() const
+{
+  Q_D(const ctkDICOMQuery);
+  return d->AssociationPool.data();
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMQuery::wasCanceled()
 {
@@ -568,7 +1154,7 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database)
   if (!status.good())
   {
     LOG_AND_EMIT_ERROR(QString("Find failed"), error);
-    d->releaseAssociation();
+    d->releaseAssociation(false);
     emit done(false);
     return false;
   }
@@ -620,6 +1206,20 @@ bool ctkDICOMQuery::query(ctkDICOMDatabase& database)
 
   // Now search each within each Study that was identified
   d->QueryDcmDataset->putAndInsertString(DCM_QueryRetrieveLevel, "SERIES");
+
+  if (d->MaximumConcurrentSeriesQueries > 1 && d->StudyDatasets.count() > 1)
+  {
+    if (!d->querySeriesConcurrently(this, database, presentationContext))
+    {
+      emit done(false);
+      return false;
+    }
+    d->releaseAssociation();
+    emit progress(100);
+    emit done(true);
+    return true;
+  }
+
   float progressRatio = 25. / d->StudyDatasets.count();
   int i = 0;
 
@@ -764,7 +1364,10 @@ bool ctkDICOMQuery::queryPatients()
 
   QMap<QString, DcmItem*> datasetsMap;
   OFList<QRResponse *> responses;
-  OFCondition status = d->SCU->sendFINDRequest(presentationContext, d->QueryDcmDataset.data(), &responses);
+  OFCondition status = d->ResponseBatchSize > 0 ?
+    d->sendFINDRequestInBatches(this, presentationContext, JobResponseSet, DCM_PatientID,
+                                "patient", datasetsMap, d->MaximumPatientsQuery) :
+    d->SCU->sendFINDRequest(presentationContext, d->QueryDcmDataset.data(), &responses);
   if (status.good())
   {
     int contResponses = 0;
@@ -791,7 +1394,7 @@ bool ctkDICOMQuery::queryPatients()
 
     this->reportIncompleteFindStatus(responses, "patient");
 
-    if (contResponses == 0)
+    if (contResponses == 0 && datasetsMap.isEmpty())
     {
       LOG_AND_EMIT_WARN(QString("The patients query provided no results. Please refine your filters."), warn)
     }
@@ -813,7 +1416,7 @@ bool ctkDICOMQuery::queryPatients()
     return false;
   }
 
-  d->releaseAssociation();
+  d->releaseAssociation(status.good());
   emit done(true);
   return true;
 }
@@ -912,7 +1515,10 @@ bool ctkDICOMQuery::queryStudies(const QString& patientID)
   QMap<QString, DcmItem*> datasetsMap;
 
   OFList<QRResponse *> responses;
-  OFCondition status = d->SCU->sendFINDRequest(presentationContext, d->QueryDcmDataset.data(), &responses);
+  OFCondition status = d->ResponseBatchSize > 0 ?
+    d->sendFINDRequestInBatches(this, presentationContext, JobResponseSet, DCM_StudyInstanceUID,
+                                "study", datasetsMap) :
+    d->SCU->sendFINDRequest(presentationContext, d->QueryDcmDataset.data(), &responses);
   if (status.good())
   {
     for (OFListIterator(QRResponse*) it = responses.begin(); it != responses.end(); it++)
@@ -945,7 +1551,7 @@ bool ctkDICOMQuery::queryStudies(const QString& patientID)
     return false;
   }
 
-  d->releaseAssociation();
+  d->releaseAssociation(status.good());
   emit done(true);
   return true;
 }
@@ -1185,7 +1791,7 @@ bool ctkDICOMQuery::querySeries(const QString& patientID,
     return false;
   }
 
-  d->releaseAssociation();
+  d->releaseAssociation(status.good());
   emit done(true);
   return true;
 }
@@ -1281,17 +1887,20 @@ bool ctkDICOMQuery::queryInstances(const QString& patientID,
 
   QMap<QString, DcmItem*> datasetsMap;
 
+  // Get modality filter if present
+  QStringList modalityFilter;
+  if (d->Filters.contains("Modalities") && d->Filters["Modalities"].toStringList().count() > 0)
+  {
+    modalityFilter = d->Filters["Modalities"].toStringList();
+  }
+
   OFList<QRResponse *> responses;
-  OFCondition status = d->SCU->sendFINDRequest(d->PresentationContext, d->QueryDcmDataset.data(), &responses);
+  OFCondition status = d->ResponseBatchSize > 0 ?
+    d->sendFINDRequestInBatches(this, d->PresentationContext, JobResponseSet, DCM_SOPInstanceUID,
+                                "instance", datasetsMap, 0, modalityFilter) :
+    d->SCU->sendFINDRequest(d->PresentationContext, d->QueryDcmDataset.data(), &responses);
   if (status.good())
   {
-    // Get modality filter if present
-    QStringList modalityFilter;
-    if (d->Filters.contains("Modalities") && d->Filters["Modalities"].toStringList().count() > 0)
-    {
-      modalityFilter = d->Filters["Modalities"].toStringList();
-    }
-
     for (OFListIterator(QRResponse*) it = responses.begin(); it != responses.end(); it++)
     {
       DcmItem *dataset = (*it)->m_dataset;
@@ -1333,7 +1942,7 @@ bool ctkDICOMQuery::queryInstances(const QString& patientID,
     return false;
   }
 
-  d->releaseAssociation();
+  d->releaseAssociation(status.good());
   emit done(true);
   return true;
 }
@@ -1346,7 +1955,12 @@ void ctkDICOMQuery::cancel()
 
   if (d->PresentationContext != 0)
   {
-    d->SCU->sendCANCELRequest(d->PresentationContext);
+    QSharedPointer<ctkDICOMQuerySCUPrivate> scu;
+    {
+      QMutexLocker locker(&d->AssociationMutex);
+      scu = d->SCU;
+    }
+    scu->sendCANCELRequest(d->PresentationContext);
     d->PresentationContext = 0;
   }
 }
@@ -1439,6 +2053,23 @@ bool ctkDICOMQuery::initializeSCU()
     return false;
   }
 
+  if (d->AssociationPool && !d->AssociationLeased)
+  {
+    d->AssociationPoolKey = ctkDICOMAssociationPool::associationKey(
+      "FIND", this->callingAETitle(), this->calledAETitle(), this->host(), this->port());
+    QSharedPointer<ctkDICOMQuerySCUPrivate> pooledSCU =
+      qSharedPointerDynamicCast<ctkDICOMQuerySCUPrivate>(d->AssociationPool->leaseAssociation(d->AssociationPoolKey));
+    d->AssociationLeased = true;
+    if (pooledSCU && pooledSCU->isConnected())
+    {
+      QMutexLocker locker(&d->AssociationMutex);
+      d->replaceSCU(pooledSCU);
+      LOG_AND_EMIT_DEBUG(QString("Reusing pooled association"), debug)
+      emit progress(20);
+      return true;
+    }
+  }
+
   OFList<OFString> transferSyntaxes;
   transferSyntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
   transferSyntaxes.push_back(UID_BigEndianExplicitTransferSyntax);
@@ -1448,6 +2079,7 @@ bool ctkDICOMQuery::initializeSCU()
   if (!d->SCU->initNetwork().good())
   {
     LOG_AND_EMIT_ERROR(QString("Error initializing the network"), error)
+    d->releaseAssociation(false);
     return false;
   }
 
@@ -1455,6 +2087,7 @@ bool ctkDICOMQuery::initializeSCU()
   emit progress(20);
   if (d->Canceled)
   {
+    d->releaseAssociation(false);
     return false;
   }
 
@@ -1462,6 +2095,7 @@ bool ctkDICOMQuery::initializeSCU()
   if (result.bad())
   {
     LOG_AND_EMIT_ERROR(QString("Error negotiating the association: %1").arg(result.text()), error)
+    d->releaseAssociation(false);
     return false;
   }
 
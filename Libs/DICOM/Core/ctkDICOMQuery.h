@@ -25,6 +25,7 @@
 #include <QList>
 #include <QObject>
 #include <QMap>
+#include <QSharedPointer>
 #include <QString>
 
 // ctkCore includes
@@ -38,9 +39,10 @@
 // ctkDICOMCore includes
 #include "ctkDICOMCoreExport.h"
 #include "ctkDICOMDatabase.h"
+#include "ctkDICOMJobResponseSet.h"
 #include "ctkDICOMQueryLimitWarning.h"
 class ctkDICOMQueryPrivate;
-class ctkDICOMJobResponseSet;
+class ctkDICOMAssociationPool;
 class QRResponse;
 
 /// \ingroup DICOM_Core
@@ -54,6 +56,8 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMQuery : public QObject
   Q_PROPERTY(int port READ port WRITE setPort);
   Q_PROPERTY(int connectionTimeout READ connectionTimeout WRITE setConnectionTimeout);
   Q_PROPERTY(int maximumPatientsQuery READ maximumPatientsQuery WRITE setMaximumPatientsQuery);
+  Q_PROPERTY(int maximumConcurrentSeriesQueries READ maximumConcurrentSeriesQueries WRITE setMaximumConcurrentSeriesQueries);
+  Q_PROPERTY(int responseBatchSize READ responseBatchSize WRITE setResponseBatchSize);
   Q_PROPERTY(QList<QPair<QString,QString>> studyAndSeriesInstanceUIDQueried READ studyAndSeriesInstanceUIDQueried);
   Q_PROPERTY(QString jobUID READ jobUID WRITE setJobUID);
 
@@ -112,6 +116,30 @@ public:
   int maximumPatientsQuery() const;
   ///@}
 
+  ///@{
+  /// Maximum number of series level C-FIND requests in flight in query().
+  /// DCMTK does not support asynchronous operations on an association, therefore
+  /// additional requests are sent on additional associations (leased from the
+  /// association pool if any). The series of each study are inserted in the database
+  /// as soon as its request completes.
+  /// 1 by default (the studies are queried one after the other).
+  void setMaximumConcurrentSeriesQueries(const int& maximumConcurrentSeriesQueries);
+  int maximumConcurrentSeriesQueries() const;
+  ///@}
+
+  ///@{
+  /// Number of datasets handed over at once while the C-FIND of queryPatients(),
+  /// queryStudies() and queryInstances() is still running.
+  /// When greater than 0, the responses are not collected until the end of the request:
+  /// every responseBatchSize datasets a ctkDICOMJobResponseSet is emitted with
+  /// jobResponseSetAvailable() and released, and only the last datasets are kept in
+  /// jobResponseSets(). At patient level, the request is canceled as soon as
+  /// maximumPatientsQuery is reached.
+  /// 0 by default (all the responses are kept in jobResponseSets()).
+  void setResponseBatchSize(const int& responseBatchSize);
+  int responseBatchSize() const;
+  ///@}
+
   ///@{
   /// Filters are keyword/value pairs as generated by
   /// the ctkDICOMWidgets in a human readable (and editable)
@@ -133,6 +161,16 @@ public:
   Q_INVOKABLE QMap<QString,QVariant> filters()const;
   ///@}
 
+  ///@{
+  /// Pool from which associations are leased instead of negotiating a new
+  /// association for each query. Associations are returned to the pool at the
+  /// end of each query operation.
+  /// No pool by default.
+  Q_INVOKABLE void setAssociationPool(ctkDICOMAssociationPool& associationPool);
+  void setAssociationPool(QSharedPointer<ctkDICOMAssociationPool> associationPool);
+  Q_INVOKABLE ctkDICOMAssociationPool* associationPool() const;
+  ///@}
+
   /// Return true if the operation was canceled.
   Q_INVOKABLE bool wasCanceled();
 
@@ -202,6 +240,9 @@ Q_SIGNALS:
   /// Signal is emitted inside the query() function when finished with value
   /// true for success or false for error
   void done(const bool& error);
+  /// Signal is emitted from the thread of the query with each batch of
+  /// responseBatchSize datasets received while a C-FIND is running.
+  void jobResponseSetAvailable(QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet);
 
 public Q_SLOTS:
   /// Cancel the current operation
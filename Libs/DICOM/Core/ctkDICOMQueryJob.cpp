@@ -41,6 +41,7 @@ ctkDICOMQueryJobPrivate::ctkDICOMQueryJobPrivate(ctkDICOMQueryJob* object)
 {
   this->Server = nullptr;
   this->MaximumPatientsQuery = 0; // unlimited
+  this->ResponseBatchSize = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -74,6 +75,8 @@ ctkDICOMQueryJob::ctkDICOMQueryJob(ctkDICOMQueryJobPrivate* pimpl)
 //------------------------------------------------------------------------------
 CTK_SET_CPP(ctkDICOMQueryJob, const int&, setMaximumPatientsQuery, MaximumPatientsQuery);
 CTK_GET_CPP(ctkDICOMQueryJob, int, maximumPatientsQuery, MaximumPatientsQuery)
+CTK_SET_CPP(ctkDICOMQueryJob, const int&, setResponseBatchSize, ResponseBatchSize);
+CTK_GET_CPP(ctkDICOMQueryJob, int, responseBatchSize, ResponseBatchSize)
 
 //----------------------------------------------------------------------------
 void ctkDICOMQueryJob::setFilters(const QMap<QString, QVariant>& filters)
@@ -166,6 +169,7 @@ ctkAbstractJob* ctkDICOMQueryJob::clone() const
 {
   ctkDICOMQueryJob* newQueryJob = new ctkDICOMQueryJob;
   newQueryJob->setMaximumPatientsQuery(this->maximumConcurrentJobsPerType());
+  newQueryJob->setResponseBatchSize(this->responseBatchSize());
   newQueryJob->setServer(*this->server());
   newQueryJob->setFilters(this->filters());
   newQueryJob->setDICOMLevel(this->dicomLevel());
@@ -44,6 +44,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMQueryJob : public ctkDICOMJob
 {
   Q_OBJECT
   Q_PROPERTY(int maximumPatientsQuery READ maximumPatientsQuery WRITE setMaximumPatientsQuery);
+  Q_PROPERTY(int responseBatchSize READ responseBatchSize WRITE setResponseBatchSize);
 
 public:
   typedef ctkDICOMJob Superclass;
@@ -85,6 +86,14 @@ public:
   int maximumPatientsQuery() const;
   ///@}
 
+  ///@{
+  /// Number of C-FIND responses inserted at once while the query is running.
+  /// See ctkDICOMQuery::responseBatchSize.
+  /// Default is 0 (responses are inserted when the query is done).
+  void setResponseBatchSize(const int& responseBatchSize);
+  int responseBatchSize() const;
+  ///@}
+
   ///@{
   /// Server
   Q_INVOKABLE ctkDICOMServer* server() const;
@@ -48,6 +48,7 @@ public:
   ctkDICOMServer* Server;
   QMap<QString, QVariant> Filters;
   int MaximumPatientsQuery;
+  int ResponseBatchSize;
 };
 
 #endif
@@ -44,6 +44,8 @@ ctkDICOMQueryWorkerPrivate::ctkDICOMQueryWorkerPrivate(ctkDICOMQueryWorker* obje
  : q_ptr(object)
 {
   this->Query = QSharedPointer<ctkDICOMQuery>(new ctkDICOMQuery);
+  QObject::connect(this->Query.data(), &ctkDICOMQuery::jobResponseSetAvailable,
+                   this, &ctkDICOMQueryWorkerPrivate::onJobResponseSetAvailable, Qt::DirectConnection);
 }
 
 //------------------------------------------------------------------------------
@@ -76,6 +78,29 @@ void ctkDICOMQueryWorkerPrivate::setQueryParameters()
   this->Query->setJobUID(queryJob->jobUID());
   this->Query->setFilters(queryJob->filters());
   this->Query->setMaximumPatientsQuery(queryJob->maximumPatientsQuery());
+  this->Query->setResponseBatchSize(queryJob->responseBatchSize());
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMQueryWorkerPrivate::onJobResponseSetAvailable(QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet)
+{
+  Q_Q(ctkDICOMQueryWorker);
+
+  QSharedPointer<ctkDICOMQueryJob> queryJob =
+    qSharedPointerObjectCast<ctkDICOMQueryJob>(q->Job);
+  QSharedPointer<ctkDICOMScheduler> scheduler =
+    qobject_cast<QSharedPointer<ctkDICOMScheduler>>(q->Scheduler);
+  if (!queryJob || !scheduler)
+  {
+    return;
+  }
+
+  // The job refers to the inserter of its first batch
+  QString inserterJobUID = scheduler->insertJobResponseSet(jobResponseSet);
+  if (queryJob->referenceInserterJobUID().isEmpty())
+  {
+    queryJob->setReferenceInserterJobUID(inserterJobUID);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -143,6 +168,7 @@ void ctkDICOMQueryWorker::run()
   }
 
   queryJob->setStatus(ctkAbstractJob::JobStatus::Running);
+  d->Query->setAssociationPool(scheduler->associationPoolShared());
 
   logger.debug(QString("ctkDICOMQueryWorker : running job %1 in thread %2.\n")
                        .arg(queryJob->jobUID())
@@ -202,8 +228,11 @@ void ctkDICOMQueryWorker::run()
 
   if (d->Query->jobResponseSetsShared().count() > 0)
   {
-    queryJob->setReferenceInserterJobUID
-      (scheduler->insertJobResponseSets(d->Query->jobResponseSetsShared()));
+    QString inserterJobUID = scheduler->insertJobResponseSets(d->Query->jobResponseSetsShared());
+    if (queryJob->referenceInserterJobUID().isEmpty())
+    {
+      queryJob->setReferenceInserterJobUID(inserterJobUID);
+    }
   }
 
   d->forwardQueryLimitWarnings(queryJob);
@@ -49,6 +49,10 @@ public:
   void forwardQueryLimitWarnings(const QSharedPointer<ctkDICOMQueryJob>& queryJob);
 
   QSharedPointer<ctkDICOMQuery> Query;
+
+public Q_SLOTS:
+  /// Insert a batch of responses while the query is running
+  void onJobResponseSetAvailable(QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet);
 };
 
 #endif
@@ -19,13 +19,16 @@
 =========================================================================*/
 
 // Qt includes
+#include <QFile>
 #include <QMutex>
+#include <QUuid>
 
 // ctkCore includes
 #include <ctkPimpl.h>
 
 // ctkDICOMCore includes
 #include "ctkDICOMRetrieve.h"
+#include "ctkDICOMAssociationPool.h"
 #include "ctkDICOMJobResponseSet.h"
 
 // DCMTK includes
@@ -155,10 +158,34 @@ public:
       jobResponseSet->setSeriesInstanceUID(this->retrieve->seriesInstanceUID());
       jobResponseSet->setSOPInstanceUID(qInstanceUID);
       jobResponseSet->setConnectionName(this->retrieve->connectionName());
-      jobResponseSet->setDataset(incomingObject);
       jobResponseSet->setJobUID(this->retrieve->jobUID());
       jobResponseSet->setCopyFile(true);
 
+      QString spoolDirectory = this->retrieve->spoolDirectory();
+      if (!spoolDirectory.isEmpty())
+      {
+        // Write the instance right away so that only its header is kept in memory
+        QString spooledFilePath = spoolDirectory + "/" + this->retrieve->jobUID() + "-" + qInstanceUID + ".dcm";
+        DcmFileFormat fileFormat(incomingObject, OFFalse /* take ownership */);
+        OFCondition status = fileFormat.saveFile(spooledFilePath.toStdString().c_str(), EXS_Unknown);
+        if (status.good())
+        {
+          jobResponseSet->setFilePath(spooledFilePath);
+          jobResponseSet->setMoveFile(true);
+        }
+        else
+        {
+          LOG_AND_EMIT_WARN(QString("Could not spool %1 to %2: %3. The dataset is kept in memory.")
+                              .arg(qInstanceUID, spooledFilePath, QString(status.text())), this->retrieve->warn)
+          QFile::remove(spooledFilePath);
+          jobResponseSet->setDataset(fileFormat.getAndRemoveDataset());
+        }
+      }
+      else
+      {
+        jobResponseSet->setDataset(incomingObject);
+      }
+
       // To Do: this should be emitted for all the RetrieveTypes, but we should change the insert in the
       // ctkDICOMRetrieveWorker to happen every 10 frames (configurable).
       // i.e. a slot in ctkDICOMRetrieveWorker with a counter. When the counter > batchLimit -> insert
@@ -224,7 +251,22 @@ public:
   /// \warning: releaseAssociation is not a thread safe method.
   /// If called concurrently from different threads DCMTK can crash.
   /// Therefore use this method instead of calling directly SCU->releaseAssociation()
-  OFCondition releaseAssociation();
+  /// If the association was leased from the association pool and \a reusable is true,
+  /// then it is returned to the pool instead of being released.
+  OFCondition releaseAssociation(bool reusable = true);
+
+  /// Clear the job response sets and reset the memory statistics.
+  void clearJobResponseSets();
+
+  /// Number of bytes of the datasets held by \a jobResponseSet.
+  static qint64 datasetsMemory(QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet);
+
+  /// Create a SCU with the presentation contexts used for retrieving.
+  QSharedPointer<ctkDICOMRetrieveSCUPrivate> createSCU() const;
+  /// Replace the SCU by \a scu (or by a new SCU if null), copying the connection settings
+  /// of the current SCU. Must be called with AssociationMutex locked.
+  /// Returns the previous SCU.
+  QSharedPointer<ctkDICOMRetrieveSCUPrivate> replaceSCU(QSharedPointer<ctkDICOMRetrieveSCUPrivate> scu);
 
   bool Canceled;
   bool KeepAssociationOpen;
@@ -241,10 +283,16 @@ public:
   QString JobUID;
 
   QSharedPointer<ctkDICOMDatabase> Database;
-  ctkDICOMRetrieveSCUPrivate *SCU;
+  QSharedPointer<ctkDICOMRetrieveSCUPrivate> SCU;
+  QSharedPointer<ctkDICOMAssociationPool> AssociationPool;
+  QString AssociationPoolKey;
+  bool AssociationLeased;
   T_ASC_PresentationContextID PresentationContext;
   QString MoveDestinationAETitle;
   QList<QSharedPointer<ctkDICOMJobResponseSet>> JobResponseSets;
+  QString SpoolDirectory;
+  qint64 JobResponseSetsMemory;
+  qint64 MemoryHighWaterMark;
 
   bool initializeSCU(const QString& patientID,
                      const QString& studyInstanceUID,
@@ -276,7 +324,10 @@ ctkDICOMRetrievePrivate::ctkDICOMRetrievePrivate(ctkDICOMRetrieve& obj)
   this->KeepAssociationOpen = true;
   this->ConnectionParamsChanged = false;
   this->AssociationClosing = false;
+  this->AssociationLeased = false;
   this->LastRetrieveType = ctkDICOMRetrieve::RetrieveNone;
+  this->JobResponseSetsMemory = 0;
+  this->MemoryHighWaterMark = 0;
 
   // Register the JPEG libraries in case we need them
   // (registration only happens once, so it's okay to call repeatedly)
@@ -289,24 +340,8 @@ ctkDICOMRetrievePrivate::ctkDICOMRetrievePrivate(ctkDICOMRetrieve& obj)
   // register RLE decompression codec
   DcmRLEDecoderRegistration::registerCodecs();
 
-  OFList<OFString> transferSyntaxes;
-  transferSyntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
-  transferSyntaxes.push_back(UID_BigEndianExplicitTransferSyntax);
-  transferSyntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
-
   this->PresentationContext = 0;
-  this->SCU = new ctkDICOMRetrieveSCUPrivate();
-  this->SCU->addPresentationContext(
-    UID_MOVEStudyRootQueryRetrieveInformationModel, transferSyntaxes);
-  this->SCU->addPresentationContext(
-    UID_GETStudyRootQueryRetrieveInformationModel, transferSyntaxes);
-
-  for (Uint16 index = 0; index < numberOfDcmLongSCUStorageSOPClassUIDs; index++)
-  {
-    this->SCU->addPresentationContext(dcmLongSCUStorageSOPClassUIDs[index],
-      transferSyntaxes, ASC_SC_ROLE_SCP);
-  }
-
+  this->SCU = this->createSCU();
   this->SCU->setACSETimeout(3);
   this->SCU->setConnectionTimeout(3);
   this->SCU->setStorageDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation).toStdString().c_str());
@@ -315,21 +350,16 @@ ctkDICOMRetrievePrivate::ctkDICOMRetrievePrivate(ctkDICOMRetrieve& obj)
 //------------------------------------------------------------------------------
 ctkDICOMRetrievePrivate::~ctkDICOMRetrievePrivate()
 {
-  if (this->SCU && this->SCU->isConnected())
+  if (this->SCU && (this->AssociationLeased || this->SCU->isConnected()))
   {
     this->releaseAssociation();
   }
 
-  if (this->SCU)
-  {
-    delete this->SCU;
-  }
-
   this->JobResponseSets.clear();
 }
 
 //------------------------------------------------------------------------------
-OFCondition ctkDICOMRetrievePrivate::releaseAssociation()
+OFCondition ctkDICOMRetrievePrivate::releaseAssociation(bool reusable)
 {
   OFCondition status = EC_IllegalCall;
   if (!this->SCU)
@@ -343,13 +373,105 @@ OFCondition ctkDICOMRetrievePrivate::releaseAssociation()
     return status;
   }
 
+  if (this->AssociationLeased && reusable && !this->Canceled && this->SCU->isConnected())
+  {
+    // Hand the association over to the pool and continue with a new SCU
+    this->AssociationLeased = false;
+    this->AssociationPool->returnAssociation(this->AssociationPoolKey, this->replaceSCU(nullptr));
+    return EC_Normal;
+  }
+
   this->AssociationClosing = true;
-  status = this->SCU->releaseAssociation();
+  if (this->SCU->isConnected())
+  {
+    status = this->SCU->releaseAssociation();
+  }
   this->AssociationClosing = false;
 
+  if (this->AssociationLeased)
+  {
+    // The SCU is kept because this method may be called from one of its callbacks,
+    // only the pool slot is given back.
+    this->AssociationLeased = false;
+    this->AssociationPool->returnAssociation(this->AssociationPoolKey, QSharedPointer<DcmSCU>(), false);
+  }
+
   return status;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMRetrievePrivate::clearJobResponseSets()
+{
+  this->JobResponseSets.clear();
+  this->JobResponseSetsMemory = 0;
+  this->MemoryHighWaterMark = 0;
+}
+
+//------------------------------------------------------------------------------
+qint64 ctkDICOMRetrievePrivate::datasetsMemory(QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet)
+{
+  qint64 memory = 0;
+  if (!jobResponseSet)
+  {
+    return memory;
+  }
+
+  foreach (QSharedPointer<ctkDICOMItem> dataset, jobResponseSet->datasetsShared())
+  {
+    if (dataset && dataset->GetDcmItemPointer())
+    {
+      memory += dataset->GetDcmItemPointer()->getLength(EXS_LittleEndianExplicit);
+    }
+  }
+  return memory;
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMRetrieveSCUPrivate> ctkDICOMRetrievePrivate::createSCU() const
+{
+  OFList<OFString> transferSyntaxes;
+  transferSyntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+  transferSyntaxes.push_back(UID_BigEndianExplicitTransferSyntax);
+  transferSyntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+
+  QSharedPointer<ctkDICOMRetrieveSCUPrivate> scu =
+    QSharedPointer<ctkDICOMRetrieveSCUPrivate>(new ctkDICOMRetrieveSCUPrivate);
+  scu->addPresentationContext(
+    UID_MOVEStudyRootQueryRetrieveInformationModel, transferSyntaxes);
+  scu->addPresentationContext(
+    UID_GETStudyRootQueryRetrieveInformationModel, transferSyntaxes);
+
+  for (Uint16 index = 0; index < numberOfDcmLongSCUStorageSOPClassUIDs; index++)
+  {
+    scu->addPresentationContext(dcmLongSCUStorageSOPClassUIDs[index],
+      transferSyntaxes, ASC_SC_ROLE_SCP);
+  }
+
+  return scu;
+}
+
+//------------------------------------------------------------------------------
+QSharedPointer<ctkDICOMRetrieveSCUPrivate> ctkDICOMRetrievePrivate::replaceSCU(QSharedPointer<ctkDICOMRetrieveSCUPrivate> scu)
+{
+  QSharedPointer<ctkDICOMRetrieveSCUPrivate> previousSCU = this->SCU;
+  if (!scu)
+  {
+    scu = this->createSCU();
+  }
+  scu->setAETitle(previousSCU->getAETitle());
+  scu->setPeerAETitle(previousSCU->getPeerAETitle());
+  scu->setPeerHostName(previousSCU->getPeerHostName());
+  scu->setPeerPort(previousSCU->getPeerPort());
+  scu->setACSETimeout(previousSCU->getACSETimeout());
+  scu->setConnectionTimeout(previousSCU->getConnectionTimeout());
+  scu->setStorageDir(previousSCU->getStorageDir());
+  scu->setVerbosePCMode(false);
+  scu->retrieve = previousSCU->retrieve;
+  previousSCU->retrieve = 0;
+  this->SCU = scu;
+  return previousSCU;
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMRetrievePrivate::initializeSCU(const QString& patientID,
                                             const QString& studyInstanceUID,
@@ -365,6 +487,21 @@ bool ctkDICOMRetrievePrivate::initializeSCU(const QString& patientID,
   {
     this->releaseAssociation();
   }
+  // Lease an already negotiated association if available
+  if (!this->SCU->isConnected() && this->AssociationPool && !this->AssociationLeased)
+  {
+    this->AssociationPoolKey = ctkDICOMAssociationPool::associationKey(
+      "RETRIEVE", q->callingAETitle(), q->calledAETitle(), q->host(), q->port());
+    QSharedPointer<ctkDICOMRetrieveSCUPrivate> pooledSCU =
+      qSharedPointerDynamicCast<ctkDICOMRetrieveSCUPrivate>(this->AssociationPool->leaseAssociation(this->AssociationPoolKey));
+    this->AssociationLeased = true;
+    if (pooledSCU && pooledSCU->isConnected())
+    {
+      QMutexLocker locker(&this->AssociationMutex);
+      this->replaceSCU(pooledSCU);
+      LOG_AND_EMIT_DEBUG(QString("Reusing pooled association"), q->debug);
+    }
+  }
   // Connect to server if not already connected
   if (!this->SCU->isConnected())
   {
@@ -372,6 +509,7 @@ bool ctkDICOMRetrievePrivate::initializeSCU(const QString& patientID,
     if (!this->SCU->initNetwork().good())
     {
       LOG_AND_EMIT_ERROR(QString("Error initializing the network"), q->error);
+      this->releaseAssociation(false);
       return false;
     }
     // Negotiate (i.e. start the) association
@@ -379,6 +517,7 @@ bool ctkDICOMRetrievePrivate::initializeSCU(const QString& patientID,
     if (!this->SCU->negotiateAssociation().good())
     {
       LOG_AND_EMIT_ERROR(QString("Error negotiating association"), q->error);
+      this->releaseAssociation(false);
       return false;
     }
   }
@@ -441,7 +580,7 @@ bool ctkDICOMRetrievePrivate::move(const QString& patientID,
 {
   Q_Q(ctkDICOMRetrieve);
 
-  this->JobResponseSets.clear();
+  this->clearJobResponseSets();
   this->PatientID = patientID;
   this->StudyInstanceUID = studyInstanceUID;
   this->SeriesInstanceUID = seriesInstanceUID;
@@ -506,7 +645,7 @@ bool ctkDICOMRetrievePrivate::move(const QString& patientID,
   // Close association if we do not want to explicitly keep it open
   if (!this->KeepAssociationOpen)
   {
-    this->releaseAssociation();
+    this->releaseAssociation(status.good());
   }
   // Free some (little) memory
   delete retrieveParameters;
@@ -625,7 +764,7 @@ bool ctkDICOMRetrievePrivate::get(const QString& patientID,
 {
   Q_Q(ctkDICOMRetrieve);
 
-  this->JobResponseSets.clear();
+  this->clearJobResponseSets();
   this->PatientID = patientID;
   this->StudyInstanceUID = studyInstanceUID;
   this->SeriesInstanceUID = seriesInstanceUID;
@@ -695,7 +834,7 @@ bool ctkDICOMRetrievePrivate::get(const QString& patientID,
   // Close association if we do not want to explicitly keep it open
   if (!this->KeepAssociationOpen)
   {
-    this->releaseAssociation();
+    this->releaseAssociation(status.good());
   }
   // Free some (little) memory
   delete retrieveParameters;
@@ -809,6 +948,63 @@ CTK_GET_CPP(ctkDICOMRetrieve, QString, seriesInstanceUID, SeriesInstanceUID)
 CTK_GET_CPP(ctkDICOMRetrieve, QString, sopInstanceUID, SOPInstanceUID)
 CTK_SET_CPP(ctkDICOMRetrieve, const bool, setKeepAssociationOpen, KeepAssociationOpen);
 CTK_GET_CPP(ctkDICOMRetrieve, bool, keepAssociationOpen, KeepAssociationOpen)
+CTK_GET_CPP(ctkDICOMRetrieve, QString, spoolDirectory, SpoolDirectory)
+CTK_GET_CPP(ctkDICOMRetrieve, qint64, memoryHighWaterMark, MemoryHighWaterMark)
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieve::setSpoolDirectory(const QString& spoolDirectory)
+{
+  Q_D(ctkDICOMRetrieve);
+  d->SpoolDirectory = spoolDirectory;
+  if (!spoolDirectory.isEmpty())
+  {
+    QDir().mkpath(spoolDirectory);
+  }
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieve::removeSpooledFiles()
+{
+  Q_D(ctkDICOMRetrieve);
+  foreach (QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet, d->JobResponseSets)
+  {
+    if (jobResponseSet->moveFile() && !jobResponseSet->filePath().isEmpty())
+    {
+      QFile::remove(jobResponseSet->filePath());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMRetrieve::removeStaleSpooledFiles(const QString& spoolDirectory, const QStringList& activeJobUIDs)
+{
+  if (spoolDirectory.isEmpty())
+  {
+    return 0;
+  }
+  int numberOfRemovedFiles = 0;
+  QDir directory(spoolDirectory);
+  foreach (const QString& fileName, directory.entryList(QStringList("*-*.dcm"), QDir::Files))
+  {
+    // The job UID is a UUID without braces, followed by '-' and the SOP instance UID
+    QString jobUID = fileName.left(36);
+    if (fileName.length() <= 37 || fileName.at(36) != '-' || QUuid(jobUID).isNull()
+        || activeJobUIDs.contains(jobUID))
+    {
+      continue;
+    }
+    if (QFile::remove(directory.filePath(fileName)))
+    {
+      numberOfRemovedFiles++;
+    }
+  }
+  if (numberOfRemovedFiles > 0)
+  {
+    QString infoStr = QString("Removed %1 stale spooled files from %2").arg(numberOfRemovedFiles).arg(spoolDirectory);
+    DCMTK_LOG4CPLUS_INFO_STR(rootLogRetrieve, infoStr.toStdString().c_str());
+  }
+  return numberOfRemovedFiles;
+}
 
 //------------------------------------------------------------------------------
 void ctkDICOMRetrieve::setCallingAETitle(const QString& callingAETitle)
@@ -915,6 +1111,27 @@ void ctkDICOMRetrieve::setDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabas
   d->Database = dicomDatabase;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieve::setAssociationPool(ctkDICOMAssociationPool& associationPool)
+{
+  Q_D(ctkDICOMRetrieve);
+  d->AssociationPool = QSharedPointer<ctkDICOMAssociationPool>(&associationPool, skipDelete);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMRetrieve::setAssociationPool(QSharedPointer<ctkDICOMAssociationPool> associationPool)
+{
+  Q_D(ctkDICOMRetrieve);
+  d->AssociationPool = associationPool;
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMAssociationPool* ctkDICOMRetrieve::associationPool() const
+{
+  Q_D(const ctkDICOMRetrieve);
+  return d->AssociationPool.data();
+}
+
 //------------------------------------------------------------------------------
 ctkDICOMDatabase* ctkDICOMRetrieve::dicomDatabase()const
 {
@@ -960,13 +1177,18 @@ void ctkDICOMRetrieve::addJobResponseSet(QSharedPointer<ctkDICOMJobResponseSet>
 {
   Q_D(ctkDICOMRetrieve);
   d->JobResponseSets.append(jobResponseSet);
+  d->JobResponseSetsMemory += ctkDICOMRetrievePrivate::datasetsMemory(jobResponseSet);
+  d->MemoryHighWaterMark = qMax(d->MemoryHighWaterMark, d->JobResponseSetsMemory);
 }
 
 //------------------------------------------------------------------------------
 void ctkDICOMRetrieve::removeJobResponseSet(QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet)
 {
   Q_D(ctkDICOMRetrieve);
-  d->JobResponseSets.removeOne(jobResponseSet);
+  if (d->JobResponseSets.removeOne(jobResponseSet))
+  {
+    d->JobResponseSetsMemory -= ctkDICOMRetrievePrivate::datasetsMemory(jobResponseSet);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -1027,7 +1249,12 @@ bool ctkDICOMRetrieve::getStudy(const QString& studyInstanceUID,
   }
 
   LOG_AND_EMIT_DEBUG(QString("Starting getStudy"), debug)
-  return d->get(patientID, studyInstanceUID, "", "", ctkDICOMRetrieve::RetrieveStudy);
+  if (!d->get(patientID, studyInstanceUID, "", "", ctkDICOMRetrieve::RetrieveStudy))
+  {
+    this->removeSpooledFiles();
+    return false;
+  }
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -1063,7 +1290,12 @@ bool ctkDICOMRetrieve::getSeries(const QString& studyInstanceUID,
   }
 
   LOG_AND_EMIT_DEBUG(QString("Starting getSeries"), debug)
-  return d->get(patientID, studyInstanceUID, seriesInstanceUID, "", ctkDICOMRetrieve::RetrieveSeries);
+  if (!d->get(patientID, studyInstanceUID, seriesInstanceUID, "", ctkDICOMRetrieve::RetrieveSeries))
+  {
+    this->removeSpooledFiles();
+    return false;
+  }
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -1103,7 +1335,12 @@ bool ctkDICOMRetrieve::getSOPInstance(const QString& studyInstanceUID,
   }
 
   LOG_AND_EMIT_DEBUG(QString("Starting getSOPInstance"), debug)
-  return d->get(patientID, studyInstanceUID, seriesInstanceUID, SOPInstanceUID, ctkDICOMRetrieve::RetrieveSOPInstance);
+  if (!d->get(patientID, studyInstanceUID, seriesInstanceUID, SOPInstanceUID, ctkDICOMRetrieve::RetrieveSOPInstance))
+  {
+    this->removeSpooledFiles();
+    return false;
+  }
+  return true;
 }
 
 //------------------------------------------------------------------------------
@@ -1114,7 +1351,12 @@ void ctkDICOMRetrieve::cancel()
 
   if (d->PresentationContext != 0)
   {
-    d->SCU->sendCANCELRequest(d->PresentationContext);
+    QSharedPointer<ctkDICOMRetrieveSCUPrivate> scu;
+    {
+      QMutexLocker locker(&d->AssociationMutex);
+      scu = d->SCU;
+    }
+    scu->sendCANCELRequest(d->PresentationContext);
     d->PresentationContext = 0;
   }
 }
@@ -34,6 +34,7 @@
 #include "ctkErrorLogLevel.h"
 
 class ctkDICOMRetrievePrivate;
+class ctkDICOMAssociationPool;
 class ctkDICOMJobResponse;
 
 /// \ingroup DICOM_Core
@@ -51,6 +52,7 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMRetrieve : public QObject
   Q_PROPERTY(QString seriesInstanceUID READ seriesInstanceUID);
   Q_PROPERTY(QString studyInstanceUID READ studyInstanceUID);
   Q_PROPERTY(QString jobUID READ jobUID WRITE setJobUID);
+  Q_PROPERTY(QString spoolDirectory READ spoolDirectory WRITE setSpoolDirectory);
 
 public:
   explicit ctkDICOMRetrieve(QObject* parent = 0);
@@ -121,6 +123,42 @@ public:
   QSharedPointer<ctkDICOMDatabase> dicomDatabaseShared() const;
   ///@}
 
+  ///@{
+  /// Pool from which associations are leased instead of negotiating a new
+  /// association for each retrieve. The association is returned to the pool
+  /// when it would be released otherwise (see keepAssociationOpen).
+  /// No pool by default.
+  Q_INVOKABLE void setAssociationPool(ctkDICOMAssociationPool& associationPool);
+  void setAssociationPool(QSharedPointer<ctkDICOMAssociationPool> associationPool);
+  Q_INVOKABLE ctkDICOMAssociationPool* associationPool() const;
+  ///@}
+
+  ///@{
+  /// Directory where the instances received with CGET are written as soon as
+  /// they arrive (the directory is created if needed). Only the header of the
+  /// spooled instances is kept in the job response sets, and the files are moved
+  /// into the database when the response sets are inserted.
+  /// The spooled files are removed if the get operation fails (see removeSpooledFiles()).
+  /// Empty by default (the received datasets are kept in memory).
+  void setSpoolDirectory(const QString& spoolDirectory);
+  QString spoolDirectory() const;
+  ///@}
+
+  /// Remove the files spooled by the last get operation that are still
+  /// referenced by the job response sets.
+  Q_INVOKABLE void removeSpooledFiles();
+
+  /// Remove the files left in \a spoolDirectory by get operations of jobs that are
+  /// not listed in \a activeJobUIDs, for example when the application crashed or
+  /// was killed before the files were inserted in the database.
+  /// Only the spooled files (named <jobUID>-<SOPInstanceUID>.dcm) are removed.
+  /// \return the number of removed files
+  static int removeStaleSpooledFiles(const QString& spoolDirectory, const QStringList& activeJobUIDs);
+
+  /// Peak number of bytes of DICOM datasets held by the job response sets
+  /// during the last operation.
+  Q_INVOKABLE qint64 memoryHighWaterMark() const;
+
   ///@{
   /// Access the list of datasets from the last operation.
   Q_INVOKABLE QList<ctkDICOMJobResponseSet*> jobResponseSets() const;
@@ -147,6 +147,9 @@ void ctkDICOMRetrieveWorker::run()
   }
 
   retrieveJob->setStatus(ctkAbstractJob::JobStatus::Running);
+  d->Retrieve->setAssociationPool(scheduler->associationPoolShared());
+
+  d->Retrieve->setSpoolDirectory(scheduler->retrieveSpoolDirectory());
 
   logger.debug(QString("ctkDICOMRetrieveWorker : running job %1 in thread %2.\n")
                        .arg(retrieveJob->jobUID())
@@ -237,8 +240,11 @@ void ctkDICOMRetrieveWorker::run()
       //case ctkDICOMServer::WADO: // To Do
   }
 
+  retrieveJob->setMemoryHighWaterMark(d->Retrieve->memoryHighWaterMark());
+
   if (d->Retrieve->wasCanceled())
   {
+    d->Retrieve->removeSpooledFiles();
     this->onJobCanceled(d->Retrieve->wasCanceled());
     return;
   }
@@ -257,8 +263,7 @@ void ctkDICOMRetrieveWorker::run()
   {
     // To Do: this insert should happen in batch of 10 frames (configurable),
     // instead of at the end of operation (all frames requested)).
-    // This would avoid memory usage spikes when requesting a series with a lot of frames.
-    // NOTE: the memory should be released as soon as the response is inserted.
+    // With spoolRetrievedInstances, only the headers are kept in memory.
     retrieveJob->setReferenceInserterJobUID
       (scheduler->insertJobResponseSets(d->Retrieve->jobResponseSetsShared()));
   }
@@ -26,12 +26,14 @@
 #include <ctkAbstractWorker.h>
 
 // ctkDICOMCore includes
+#include "ctkDICOMAssociationPool.h"
 #include "ctkDICOMEchoJob.h"
 #include "ctkDICOMThumbnailGeneratorJob.h"
 #include "ctkDICOMInserterJob.h"
 #include "ctkDICOMJobResponseSet.h"
 #include "ctkDICOMModalities.h"
 #include "ctkDICOMQueryJob.h"
+#include "ctkDICOMRetrieve.h"
 #include "ctkDICOMRetrieveJob.h"
 #include "ctkDICOMScheduler.h"
 #include "ctkDICOMServer.h"
@@ -120,6 +122,8 @@ ctkDICOMSchedulerPrivate::ctkDICOMSchedulerPrivate(ctkDICOMScheduler& obj)
 
   dcmtk::log4cplus::Logger rootLog = dcmtk::log4cplus::Logger::getRoot();
   rootLog.addAppender(this->Appender);
+
+  this->AssociationPool = QSharedPointer<ctkDICOMAssociationPool>(new ctkDICOMAssociationPool);
 }
 
 //------------------------------------------------------------------------------
@@ -177,6 +181,26 @@ ctkDICOMServer* ctkDICOMSchedulerPrivate::getServerFromProxyServersByConnectionN
   return nullptr;
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMSchedulerPrivate::jobMatchesDICOMUIDs(ctkDICOMJob* job,
+                                                   const QStringList& patientIDs,
+                                                   const QStringList& studyInstanceUIDs,
+                                                   const QStringList& seriesInstanceUIDs,
+                                                   const QStringList& sopInstanceUIDs)
+{
+  if ((!job->patientID().isEmpty() && patientIDs.contains(job->patientID())) ||
+      (!job->studyInstanceUID().isEmpty() && studyInstanceUIDs.contains(job->studyInstanceUID())) ||
+      (!job->seriesInstanceUID().isEmpty() && seriesInstanceUIDs.contains(job->seriesInstanceUID())) ||
+      (!job->sopInstanceUID().isEmpty() && sopInstanceUIDs.contains(job->sopInstanceUID())))
+  {
+    return true;
+  }
+
+  ctkDICOMThumbnailGeneratorJob* thumbnailGeneratorJob = qobject_cast<ctkDICOMThumbnailGeneratorJob*>(job);
+  return thumbnailGeneratorJob &&
+    thumbnailGeneratorJob->containsItems(patientIDs, studyInstanceUIDs, seriesInstanceUIDs, sopInstanceUIDs);
+}
+
 //------------------------------------------------------------------------------
 // ctkDICOMScheduler methods
 
@@ -215,6 +239,7 @@ void ctkDICOMScheduler::queryPatients(QThread::Priority priority)
       QSharedPointer<ctkDICOMQueryJob>(new ctkDICOMQueryJob);
     job->setServer(*server);
     job->setMaximumPatientsQuery(d->MaximumPatientsQuery);
+    job->setResponseBatchSize(d->QueryResponseBatchSize);
     job->setFilters(d->Filters);
     job->setDICOMLevel(ctkDICOMQueryJob::DICOMLevels::Patients);
     job->setMaximumNumberOfRetry(d->MaximumNumberOfRetry);
@@ -251,6 +276,7 @@ void ctkDICOMScheduler::queryStudies(const QString& patientID,
     QSharedPointer<ctkDICOMQueryJob> job =
       QSharedPointer<ctkDICOMQueryJob>(new ctkDICOMQueryJob);
     job->setServer(*server);
+    job->setResponseBatchSize(d->QueryResponseBatchSize);
     job->setFilters(d->Filters);
     job->setDICOMLevel(ctkDICOMQueryJob::DICOMLevels::Studies);
     job->setPatientID(patientID);
@@ -291,6 +317,7 @@ void ctkDICOMScheduler::querySeries(const QString& patientID,
     QSharedPointer<ctkDICOMQueryJob> job =
       QSharedPointer<ctkDICOMQueryJob>(new ctkDICOMQueryJob);
     job->setServer(*server);
+    job->setResponseBatchSize(d->QueryResponseBatchSize);
     job->setFilters(d->Filters);
     job->setDICOMLevel(ctkDICOMQueryJob::DICOMLevels::Series);
     job->setPatientID(patientID);
@@ -322,6 +349,7 @@ void ctkDICOMScheduler::queryInstances(const QString& patientID,
     QSharedPointer<ctkDICOMQueryJob> job =
       QSharedPointer<ctkDICOMQueryJob>(new ctkDICOMQueryJob);
     job->setServer(*server);
+    job->setResponseBatchSize(d->QueryResponseBatchSize);
     job->setFilters(d->Filters);
     job->setDICOMLevel(ctkDICOMQueryJob::DICOMLevels::Instances);
     job->setPatientID(patientID);
@@ -495,31 +523,75 @@ void ctkDICOMScheduler::generateThumbnail(const QString &originalFilePath,
                                           const QString &modality,
                                           QColor backgroundColor,
                                           QThread::Priority priority)
+{
+  ctkDICOMThumbnailGeneratorItem item;
+  item.DicomFilePath = originalFilePath;
+  item.PatientID = patientID;
+  item.StudyInstanceUID = studyInstanceUID;
+  item.SeriesInstanceUID = seriesInstanceUID;
+  item.SOPInstanceUID = sopInstanceUID;
+  item.Modality = modality;
+  this->generateThumbnails({item}, backgroundColor, priority);
+}
+
+//----------------------------------------------------------------------------
+void ctkDICOMScheduler::generateThumbnails(const QList<ctkDICOMThumbnailGeneratorItem>& items,
+                                           QColor backgroundColor,
+                                           QThread::Priority priority)
 {
   Q_D(ctkDICOMScheduler);
 
-  // Do not generate thumbnails for modalities that do not have meaningful image thumbnails
-  if (ctkDICOMModalities::ExcludedFromThumbnailGeneration.contains(modality))
+  QList<ctkDICOMThumbnailGeneratorItem> thumbnailItems;
+  for (const ctkDICOMThumbnailGeneratorItem& item : items)
   {
-    // Do not generate thumbnails for excluded modalities
+    // Do not generate thumbnails for modalities that do not have meaningful image thumbnails
     // To Do: refactor the ctkDICOMThumbnailGenerator to handle properly these cases
+    if (!ctkDICOMModalities::ExcludedFromThumbnailGeneration.contains(item.Modality))
+    {
+      thumbnailItems.append(item);
+    }
+  }
+  if (thumbnailItems.isEmpty())
+  {
     return;
   }
 
-  QSharedPointer<ctkDICOMThumbnailGeneratorJob> job =
-    QSharedPointer<ctkDICOMThumbnailGeneratorJob>(new ctkDICOMThumbnailGeneratorJob);
-  job->setDatabaseFilename(d->DicomDatabase->databaseFilename());
-  job->setDicomFilePath(originalFilePath);
-  job->setModality(modality);
-  job->setBackgroundColor(backgroundColor);
-  job->setPatientID(patientID);
-  job->setStudyInstanceUID(studyInstanceUID);
-  job->setSeriesInstanceUID(seriesInstanceUID);
-  job->setSOPInstanceUID(sopInstanceUID);
-  job->setMaximumNumberOfRetry(0);
-  job->setPriority(priority);
+  int batchSize = qMax(d->ThumbnailBatchSize, 1);
+  int numberOfBatchedItems = 0;
 
-  d->insertJob(job);
+  QMutexLocker locker(&d->BatchThumbnailGeneratorJobMutex);
+  QSharedPointer<ctkDICOMThumbnailGeneratorJob> batchJob = d->BatchThumbnailGeneratorJob.toStrongRef();
+  if (batchJob &&
+      batchJob->priority() == priority &&
+      batchJob->backgroundColor() == backgroundColor &&
+      batchJob->numberOfItems() < batchSize)
+  {
+    QList<ctkDICOMThumbnailGeneratorItem> batchItems =
+      thumbnailItems.mid(0, batchSize - batchJob->numberOfItems());
+    if (batchJob->appendItems(batchItems))
+    {
+      numberOfBatchedItems = batchItems.count();
+    }
+  }
+
+  while (numberOfBatchedItems < thumbnailItems.count())
+  {
+    QList<ctkDICOMThumbnailGeneratorItem> batchItems = thumbnailItems.mid(numberOfBatchedItems, batchSize);
+    numberOfBatchedItems += batchItems.count();
+
+    QSharedPointer<ctkDICOMThumbnailGeneratorJob> job =
+      QSharedPointer<ctkDICOMThumbnailGeneratorJob>(new ctkDICOMThumbnailGeneratorJob);
+    job->setDatabaseFilename(d->DicomDatabase->databaseFilename());
+    job->setPackedThumbnailStorage(d->DicomDatabase->packedThumbnailStorage());
+    job->setModality(batchItems.first().Modality);
+    job->setBackgroundColor(backgroundColor);
+    job->appendItems(batchItems);
+    job->setMaximumNumberOfRetry(0);
+    job->setPriority(priority);
+
+    d->BatchThumbnailGeneratorJob = job;
+    d->insertJob(job);
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -537,9 +609,27 @@ QString ctkDICOMScheduler::insertJobResponseSets(const QList<QSharedPointer<ctkD
 {
   Q_D(ctkDICOMScheduler);
 
+  QMutexLocker locker(&d->CoalescingInserterJobMutex);
+  if (d->InsertCoalescingWindow > 0)
+  {
+    QSharedPointer<ctkDICOMInserterJob> coalescingJob = d->CoalescingInserterJob.toStrongRef();
+    if (coalescingJob &&
+        coalescingJob->priority() == priority &&
+        coalescingJob->appendJobResponseSets(jobResponseSets))
+    {
+      return coalescingJob->jobUID();
+    }
+  }
+
   QSharedPointer<ctkDICOMInserterJob> job =
     QSharedPointer<ctkDICOMInserterJob>(new ctkDICOMInserterJob);
   job->copyJobResponseSets(jobResponseSets);
+  if (d->InsertCoalescingWindow > 0)
+  {
+    job->setCoalescingWindow(d->InsertCoalescingWindow);
+    job->setMaximumCoalescedJobResponseSets(d->MaximumCoalescedJobResponseSets);
+    d->CoalescingInserterJob = job;
+  }
   job->setMaximumNumberOfRetry(d->MaximumNumberOfRetry);
   job->setRetryDelay(d->RetryDelay);
   job->setDatabaseFilename(d->DicomDatabase->databaseFilename());
@@ -574,6 +664,20 @@ QSharedPointer<ctkDICOMDatabase> ctkDICOMScheduler::dicomDatabaseShared() const
   return d->DicomDatabase;
 }
 
+//----------------------------------------------------------------------------
+ctkDICOMAssociationPool* ctkDICOMScheduler::associationPool() const
+{
+  Q_D(const ctkDICOMScheduler);
+  return d->AssociationPool.data();
+}
+
+//----------------------------------------------------------------------------
+QSharedPointer<ctkDICOMAssociationPool> ctkDICOMScheduler::associationPoolShared() const
+{
+  Q_D(const ctkDICOMScheduler);
+  return d->AssociationPool;
+}
+
 //----------------------------------------------------------------------------
 void ctkDICOMScheduler::setDicomDatabase(ctkDICOMDatabase& dicomDatabase)
 {
@@ -876,10 +980,7 @@ void ctkDICOMScheduler::waitForFinishByDICOMUIDs(const QStringList& patientIDs,
           continue;
         }
 
-        if ((!dicomJob->patientID().isEmpty() && patientIDs.contains(dicomJob->patientID())) ||
-          (!dicomJob->studyInstanceUID().isEmpty() && studyInstanceUIDs.contains(dicomJob->studyInstanceUID())) ||
-          (!dicomJob->seriesInstanceUID().isEmpty() && seriesInstanceUIDs.contains(dicomJob->seriesInstanceUID())) ||
-          (!dicomJob->sopInstanceUID().isEmpty() && sopInstanceUIDs.contains(dicomJob->sopInstanceUID())))
+        if (d->jobMatchesDICOMUIDs(dicomJob, patientIDs, studyInstanceUIDs, seriesInstanceUIDs, sopInstanceUIDs))
         {
           if (job->status() != ctkAbstractJob::JobStatus::Finished)
           {
@@ -942,13 +1043,7 @@ QList<QSharedPointer<ctkAbstractJob>> ctkDICOMScheduler::getJobsByDICOMUIDs(cons
         continue;
       }
 
-      if (
-        (
-          (!dicomJob->patientID().isEmpty() && patientIDs.contains(dicomJob->patientID())) ||
-          (!dicomJob->studyInstanceUID().isEmpty() && studyInstanceUIDs.contains(dicomJob->studyInstanceUID())) ||
-          (!dicomJob->seriesInstanceUID().isEmpty() && seriesInstanceUIDs.contains(dicomJob->seriesInstanceUID())) ||
-          (!dicomJob->sopInstanceUID().isEmpty() && sopInstanceUIDs.contains(dicomJob->sopInstanceUID()))
-        )
+      if (d->jobMatchesDICOMUIDs(dicomJob, patientIDs, studyInstanceUIDs, seriesInstanceUIDs, sopInstanceUIDs)
         && (statusFilters.isEmpty() || statusFilters.contains(job->status()))
       )
       {
@@ -1009,10 +1104,19 @@ void ctkDICOMScheduler::stopJobsByDICOMUIDs(const QStringList& patientIDs,
         continue;
       }
 
-      if ((!dicomJob->patientID().isEmpty() && patientIDs.contains(dicomJob->patientID())) ||
-          (!dicomJob->studyInstanceUID().isEmpty() && studyInstanceUIDs.contains(dicomJob->studyInstanceUID())) ||
-          (!dicomJob->seriesInstanceUID().isEmpty() && seriesInstanceUIDs.contains(dicomJob->seriesInstanceUID())) ||
-          (!dicomJob->sopInstanceUID().isEmpty() && sopInstanceUIDs.contains(dicomJob->sopInstanceUID())))
+      // The thumbnails of other series batched in the same job are still generated
+      ctkDICOMThumbnailGeneratorJob* thumbnailGeneratorJob = qobject_cast<ctkDICOMThumbnailGeneratorJob*>(dicomJob);
+      if (thumbnailGeneratorJob &&
+          thumbnailGeneratorJob->removeItems(patientIDs, studyInstanceUIDs, seriesInstanceUIDs, sopInstanceUIDs) > 0)
+      {
+        if (thumbnailGeneratorJob->numberOfItems() == 0)
+        {
+          jobsUIDs.append(dicomJob->jobUID());
+        }
+        continue;
+      }
+
+      if (d->jobMatchesDICOMUIDs(dicomJob, patientIDs, studyInstanceUIDs, seriesInstanceUIDs, sopInstanceUIDs))
       {
         jobsUIDs.append(dicomJob->jobUID());
       }
@@ -1051,14 +1155,17 @@ void ctkDICOMScheduler::raiseJobsPriorityForSeries(const QStringList& selectedSe
         continue;
       }
 
-      if (!selectedSeriesInstanceUIDs.contains(dicomJob->seriesInstanceUID()))
+      // Batches spanning several series have no series UID, their items are matched
+      QThread::Priority jobPriority = priority;
+      if (!d->jobMatchesDICOMUIDs(dicomJob, QStringList(), QStringList(), selectedSeriesInstanceUIDs, QStringList()))
       {
-        priority = QThread::Priority::LowPriority;
+        jobPriority = QThread::Priority::LowPriority;
       }
 
-      job->setPriority(priority);
+      d->setJobPriority(job, jobPriority);
     }
   }
+  d->queueJobsInThreadPool();
 }
 
 //------------------------------------------------------------------------------
@@ -1075,6 +1182,102 @@ int ctkDICOMScheduler::maximumPatientsQuery()
   return d->MaximumPatientsQuery;
 }
 
+//------------------------------------------------------------------------------
+void ctkDICOMScheduler::setQueryResponseBatchSize(int queryResponseBatchSize)
+{
+  Q_D(ctkDICOMScheduler);
+  d->QueryResponseBatchSize = queryResponseBatchSize;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMScheduler::queryResponseBatchSize()
+{
+  Q_D(const ctkDICOMScheduler);
+  return d->QueryResponseBatchSize;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMScheduler::setSpoolRetrievedInstances(bool spoolRetrievedInstances)
+{
+  Q_D(ctkDICOMScheduler);
+  d->SpoolRetrievedInstances = spoolRetrievedInstances;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMScheduler::spoolRetrievedInstances()
+{
+  Q_D(const ctkDICOMScheduler);
+  return d->SpoolRetrievedInstances;
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMScheduler::retrieveSpoolDirectory()
+{
+  Q_D(ctkDICOMScheduler);
+  if (!d->SpoolRetrievedInstances || !d->DicomDatabase || d->DicomDatabase->isInMemory())
+  {
+    return QString();
+  }
+
+  QString spoolDirectory = d->DicomDatabase->databaseDirectory() + "/spool";
+  QMutexLocker cleanedLocker(&d->CleanedSpoolDirectoriesMutex);
+  if (!d->CleanedSpoolDirectories.contains(spoolDirectory))
+  {
+    // The files of the jobs of this scheduler (running, or waiting for their
+    // response sets to be inserted) are kept
+    QStringList activeJobUIDs;
+    {
+      QReadLocker locker(&d->QueueLock);
+      activeJobUIDs = d->JobsQueue.keys();
+    }
+    ctkDICOMRetrieve::removeStaleSpooledFiles(spoolDirectory, activeJobUIDs);
+    d->CleanedSpoolDirectories.insert(spoolDirectory);
+  }
+  return spoolDirectory;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMScheduler::setInsertCoalescingWindow(int insertCoalescingWindow)
+{
+  Q_D(ctkDICOMScheduler);
+  d->InsertCoalescingWindow = insertCoalescingWindow;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMScheduler::insertCoalescingWindow()
+{
+  Q_D(const ctkDICOMScheduler);
+  return d->InsertCoalescingWindow;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMScheduler::setMaximumCoalescedJobResponseSets(int maximumCoalescedJobResponseSets)
+{
+  Q_D(ctkDICOMScheduler);
+  d->MaximumCoalescedJobResponseSets = maximumCoalescedJobResponseSets;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMScheduler::maximumCoalescedJobResponseSets()
+{
+  Q_D(const ctkDICOMScheduler);
+  return d->MaximumCoalescedJobResponseSets;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMScheduler::setThumbnailBatchSize(int thumbnailBatchSize)
+{
+  Q_D(ctkDICOMScheduler);
+  d->ThumbnailBatchSize = thumbnailBatchSize;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMScheduler::thumbnailBatchSize()
+{
+  Q_D(const ctkDICOMScheduler);
+  return d->ThumbnailBatchSize;
+}
+
 //----------------------------------------------------------------------------
 ctkDICOMStorageListenerJob* ctkDICOMScheduler::listenerJob()
 {
@@ -1163,6 +1366,17 @@ void ctkDICOMScheduler::onJobFinished(ctkAbstractJob* job)
     job->addLog(appender->messageByThreadID(job->runningThreadID()));
   }
 
+  ctkDICOMInserterJob* inserterJob = qobject_cast<ctkDICOMInserterJob*>(job);
+  if (inserterJob)
+  {
+    QList<QVariant> datas;
+    foreach (ctkDICOMJobResponseSet* jobResponseSet, inserterJob->jobResponseSets())
+    {
+      datas.append(jobResponseSet->toVariant());
+    }
+    emit this->jobResponseSetsInserted(datas);
+  }
+
   ctkJobScheduler::onJobFinished(job);
 }
 
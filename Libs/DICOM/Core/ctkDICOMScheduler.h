@@ -27,7 +27,10 @@
 // Qt includes
 #include <QObject>
 #include <QMap>
+#include <QMutex>
+#include <QSet>
 #include <QSharedPointer>
+#include <QWeakPointer>
 
 // ctkCore includes
 #include <ctkJobScheduler.h>
@@ -36,11 +39,15 @@
 // ctkDICOMCore includes
 #include "ctkDICOMCoreExport.h"
 #include "ctkDICOMDatabase.h"
+class ctkDICOMAssociationPool;
 class ctkDICOMJob;
 class ctkDICOMIndexer;
+class ctkDICOMInserterJob;
 class ctkDICOMServer;
 class ctkDICOMStorageListenerJob;
+class ctkDICOMThumbnailGeneratorJob;
 struct ctkDICOMJobDetail;
+struct ctkDICOMThumbnailGeneratorItem;
 
 /// \ingroup DICOM_Core
 class  ctkDICOMSchedulerPrivate; // Forward decalaration needed within this file
@@ -48,6 +55,11 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMScheduler : public ctkJobScheduler
 {
   Q_OBJECT
   Q_PROPERTY(int maximumPatientsQuery READ maximumPatientsQuery WRITE setMaximumPatientsQuery);
+  Q_PROPERTY(int queryResponseBatchSize READ queryResponseBatchSize WRITE setQueryResponseBatchSize);
+  Q_PROPERTY(bool spoolRetrievedInstances READ spoolRetrievedInstances WRITE setSpoolRetrievedInstances);
+  Q_PROPERTY(int insertCoalescingWindow READ insertCoalescingWindow WRITE setInsertCoalescingWindow);
+  Q_PROPERTY(int maximumCoalescedJobResponseSets READ maximumCoalescedJobResponseSets WRITE setMaximumCoalescedJobResponseSets);
+  Q_PROPERTY(int thumbnailBatchSize READ thumbnailBatchSize WRITE setThumbnailBatchSize);
 
 public:
   typedef ctkJobScheduler Superclass;
@@ -124,6 +136,16 @@ public:
                                      QColor backgroundColor = Qt::white,
                                      QThread::Priority priority = QThread::HighPriority);
 
+  /// Generate the thumbnails of \a items.
+  /// The thumbnails are generated by ctkDICOMThumbnailGeneratorJob batches of at most
+  /// thumbnailBatchSize items. Thumbnails requested while a batch with the same priority
+  /// and background color is waiting to run are added to it.
+  /// The thumbnails not generated yet can be cancelled with stopJobsByDICOMUIDs(),
+  /// the other thumbnails of the batch are still generated.
+  void generateThumbnails(const QList<ctkDICOMThumbnailGeneratorItem>& items,
+                          QColor backgroundColor = Qt::white,
+                          QThread::Priority priority = QThread::HighPriority);
+
   ///@{
   /// Insert results from a job
   QString insertJobResponseSet(const QSharedPointer<ctkDICOMJobResponseSet>& jobResponseSet,
@@ -144,6 +166,14 @@ public:
   /// (not Python-wrappable).
   void setDicomDatabase(QSharedPointer<ctkDICOMDatabase> dicomDatabase);
 
+  /// Return the pool of DIMSE associations shared by the query and retrieve workers.
+  /// Its parameters (maximum associations per server, idle timeout) can be adjusted,
+  /// see ctkDICOMAssociationPool.
+  Q_INVOKABLE ctkDICOMAssociationPool* associationPool() const;
+  /// Return the association pool as a shared pointer
+  /// (not Python-wrappable).
+  QSharedPointer<ctkDICOMAssociationPool> associationPoolShared() const;
+
   ///@{
   /// Filters are keyword/value pairs as generated by
   /// the ctkDICOMWidgets in a human readable (and editable)
@@ -222,6 +252,63 @@ public:
   int maximumPatientsQuery();
   ///@}
 
+  ///@{
+  /// Number of C-FIND responses handed over to an inserter job at once while a
+  /// query job is still running, so that large queries show up progressively
+  /// and do not keep all the matches in memory.
+  /// See ctkDICOMQuery::responseBatchSize.
+  /// Default is 0 (responses are inserted when the query job is done).
+  void setQueryResponseBatchSize(int queryResponseBatchSize);
+  int queryResponseBatchSize();
+  ///@}
+
+  ///@{
+  /// Write the instances received by retrieve jobs (CGET) to the "spool" folder
+  /// of the database directory as soon as they arrive, instead of keeping them in
+  /// memory until they are inserted. The inserter jobs then only handle the headers
+  /// and move the files into the database.
+  /// Ignored for in-memory databases.
+  /// See ctkDICOMRetrieve::spoolDirectory.
+  /// Default is false.
+  void setSpoolRetrievedInstances(bool spoolRetrievedInstances);
+  bool spoolRetrievedInstances();
+  ///@}
+
+  /// Return the directory where the retrieve jobs spool the received instances,
+  /// or an empty string if spoolRetrievedInstances is disabled or the database is in memory.
+  /// The first time a spool directory is returned, the files left in it by retrieve
+  /// jobs that are not known to the scheduler (see ctkDICOMRetrieve::removeStaleSpooledFiles())
+  /// are removed.
+  QString retrieveSpoolDirectory();
+
+  ///@{
+  /// Time window in milliseconds during which the response sets passed to
+  /// insertJobResponseSets() are coalesced into the same inserter job.
+  /// The response sets of all the query and retrieve jobs finishing within the window
+  /// (or while the previous inserter job is running) are inserted in a single database
+  /// transaction, followed by a single update of the displayed fields, and
+  /// jobResponseSetsInserted() is emitted once for all of them.
+  /// Default is 0 (each call creates its own inserter job).
+  void setInsertCoalescingWindow(int insertCoalescingWindow);
+  int insertCoalescingWindow();
+  ///@}
+
+  ///@{
+  /// Maximum number of response sets coalesced into the same inserter job.
+  /// See ctkDICOMInserterJob::maximumCoalescedJobResponseSets.
+  /// Default is 500.
+  void setMaximumCoalescedJobResponseSets(int maximumCoalescedJobResponseSets);
+  int maximumCoalescedJobResponseSets();
+  ///@}
+
+  ///@{
+  /// Maximum number of thumbnails generated by a single thumbnail generator job.
+  /// 1 creates a job for each thumbnail.
+  /// Default is 20.
+  void setThumbnailBatchSize(int thumbnailBatchSize);
+  int thumbnailBatchSize();
+  ///@}
+
   ///@{
   /// Return the listener Job.
   Q_INVOKABLE ctkDICOMStorageListenerJob* listenerJob();
@@ -238,6 +325,9 @@ public Q_SLOTS:
 Q_SIGNALS:
   /// Emitted when a server is modified
   void serverModified(const QString&);
+  /// Emitted once when an inserter job is finished, with the ctkDICOMJobDetail
+  /// of all the response sets it inserted.
+  void jobResponseSetsInserted(QList<QVariant>);
 
 protected:
   ctkDICOMScheduler(ctkDICOMSchedulerPrivate* pimpl, QObject* parent);
@@ -260,13 +350,37 @@ public:
   bool isServerAllowed(ctkDICOMServer* server, const QStringList& allowedSeversForPatient);
   ctkDICOMServer* getServerFromProxyServersByConnectionName(const QString&);
   bool isJobDuplicate(ctkDICOMJob* job);
+  /// Return true if the UIDs of \a job, or of one of the thumbnails of a thumbnail
+  /// generator job, match any of the given UIDs.
+  static bool jobMatchesDICOMUIDs(ctkDICOMJob* job,
+                                  const QStringList& patientIDs,
+                                  const QStringList& studyInstanceUIDs,
+                                  const QStringList& seriesInstanceUIDs,
+                                  const QStringList& sopInstanceUIDs);
 
   QSharedPointer<ctkDICOMDatabase> DicomDatabase;
+  QSharedPointer<ctkDICOMAssociationPool> AssociationPool;
   QList<QSharedPointer<ctkDICOMServer>> Servers;
   QMap<QString, QMetaObject::Connection> ServersConnections;
   QMap<QString, QVariant> Filters;
 
   int MaximumPatientsQuery{0}; // unlimited by default
+  int QueryResponseBatchSize{0}; // insert when done by default
+  bool SpoolRetrievedInstances{false};
+  // Spool directories already cleaned of stale files
+  QSet<QString> CleanedSpoolDirectories;
+  QMutex CleanedSpoolDirectoriesMutex;
+  int InsertCoalescingWindow{0}; // no coalescing by default
+  int MaximumCoalescedJobResponseSets{500};
+
+  // Inserter job accepting the response sets while coalescing
+  QWeakPointer<ctkDICOMInserterJob> CoalescingInserterJob;
+  QMutex CoalescingInserterJobMutex;
+
+  int ThumbnailBatchSize{20};
+  // Thumbnail generator job accepting thumbnails until it starts
+  QWeakPointer<ctkDICOMThumbnailGeneratorJob> BatchThumbnailGeneratorJob;
+  QMutex BatchThumbnailGeneratorJobMutex;
 
   dcmtk::log4cplus::SharedAppenderPtr Appender;
 };
@@ -23,7 +23,6 @@
 
 // Qt includes
 #include <QDebug>
-#include <QPixmap>
 #include <QTimer>
 #include <QPainter>
 #include <QFile>
@@ -38,6 +37,8 @@
 #include "ctkDICOMScheduler.h"
 #include "ctkDICOMJobResponseSet.h"
 #include "ctkDICOMJob.h"
+#include "ctkDICOMThumbnailCache.h"
+#include "ctkDICOMThumbnailGeneratorJob.h"
 
 static ctkLogger logger("org.commontk.DICOM.Core.DICOMSeriesModel");
 
@@ -89,12 +90,20 @@ public:
   void populateSeriesData();
   void loadSeriesForStudy();
   void clean();
-  void generateThumbnailForSeries(const QString& seriesInstanceUID);
+  /// Generate the thumbnail of the series if needed. If \a thumbnailItems is not null,
+  /// the thumbnail to generate is appended to it instead of being scheduled.
+  void generateThumbnailForSeries(const QString& seriesInstanceUID,
+                                  QList<ctkDICOMThumbnailGeneratorItem>* thumbnailItems = nullptr);
   int findSeriesLinearIndex(const QString& seriesInstanceUID) const;
   bool seriesMatchesFilters(const ctkDICOMSeriesModelPrivate::SeriesData& series) const;
   bool matchesModalityFilter(const QString& modality) const;
   bool matchesDescriptionFilter(const QString& description) const;
   QString getDICOMCenterFrameFromInstances(QStringList instancesList);
+  /// Packed thumbnail path of the instance if it is in a thumbnail store, the thumbnail
+  /// file path otherwise. Both can be read with ctkDICOMThumbnailCache.
+  QString thumbnailPathForInstance(const QString& studyInstanceUID,
+                                   const QString& seriesInstanceUID,
+                                   const QString& sopInstanceUID) const;
   void updateSeriesVisibility(int seriesIndex);
 
   QList<SeriesData> SeriesList;
@@ -218,6 +227,9 @@ void ctkDICOMSeriesModelPrivate::loadSeriesForStudy()
     return;
   }
 
+  // Get fields and instance counts of all series of the study at once
+  QMap<QString, QMap<QString, QString> > databaseSeriesFields = this->DicomDatabase->seriesFieldsForStudy(this->StudyFilter);
+
   // Create a map of existing series for quick lookup
   QMap<QString, int> existingSeriesMap;
   for (int seriesIndex = 0; seriesIndex < this->SeriesList.size(); ++seriesIndex)
@@ -241,17 +253,12 @@ void ctkDICOMSeriesModelPrivate::loadSeriesForStudy()
       SeriesData& existingSeries = this->SeriesList[existingIndex];
 
       // Update dynamic fields
-      QStringList instances = this->DicomDatabase->instancesForSeries(seriesInstanceUID);
-      int newInstanceCount = instances.count();
-
-      QStringList files = this->DicomDatabase->filesForSeries(seriesInstanceUID);
-      files.removeAll(QString(""));
-      int newInstancesLoaded = files.count();
+      QMap<QString, QString> seriesFields = databaseSeriesFields.value(seriesInstanceUID);
+      int newInstanceCount = seriesFields.value("InstanceCount").toInt();
+      int newInstancesLoaded = seriesFields.value("LoadedInstanceCount").toInt();
+      int urlCount = seriesFields.value("URLCount").toInt();
 
-      QStringList urls = this->DicomDatabase->urlsForSeries(seriesInstanceUID);
-      urls.removeAll(QString(""));
-
-      bool newIsCloud = (newInstanceCount > 0 && urls.count() > 0 && newInstancesLoaded < newInstanceCount);
+      bool newIsCloud = (newInstanceCount > 0 && urlCount > 0 && newInstancesLoaded < newInstanceCount);
       bool newIsLoaded = false;
       bool newIsVisible = this->seriesMatchesFilters(existingSeries);
 
@@ -312,19 +319,34 @@ void ctkDICOMSeriesModelPrivate::loadSeriesForStudy()
     // Fix YYYY-MM-DD format in YYYYMMDD
     patientBirthDate.remove('-');
     QList<SeriesData> newSeriesData;
+    QStringList loadedSeriesInstanceUIDs = this->DicomDatabase->loadedSeriesInstanceUIDs();
+
+    // Get DICOM Rows/Columns from first instance of all new series (lightweight query)
+    QStringList firstInstanceUIDs;
+    foreach (const QString& seriesInstanceUID, newSeriesUIDs)
+    {
+      QString firstInstanceUID = databaseSeriesFields.value(seriesInstanceUID).value("FirstInstanceUID");
+      if (!firstInstanceUID.isEmpty())
+      {
+        firstInstanceUIDs << firstInstanceUID;
+      }
+    }
+    QMap<QString, QMap<QString, QString> > firstInstanceValues =
+      this->DicomDatabase->instanceValuesForTags(firstInstanceUIDs, QStringList() << "0028,0010" << "0028,0011");
 
     // Load series data for new series
     foreach (const QString& seriesInstanceUID, newSeriesUIDs)
     {
+      QMap<QString, QString> seriesFields = databaseSeriesFields.value(seriesInstanceUID);
       SeriesData series;
       series.seriesInstanceUID = seriesInstanceUID;
       series.studyInstanceUID = this->StudyFilter;
       series.patientName = patientName;
       series.patientID = patientID;
       series.patientBirthDate = patientBirthDate;
-      series.seriesNumber = this->DicomDatabase->fieldForSeries("SeriesNumber", seriesInstanceUID);
-      series.modality = this->DicomDatabase->fieldForSeries("Modality", seriesInstanceUID);
-      series.seriesDescription = this->DicomDatabase->fieldForSeries("SeriesDescription", seriesInstanceUID);
+      series.seriesNumber = seriesFields.value("SeriesNumber");
+      series.modality = seriesFields.value("Modality");
+      series.seriesDescription = seriesFields.value("SeriesDescription");
       if (series.seriesDescription.isEmpty())
       {
         series.seriesDescription = "UNDEFINED";
@@ -332,22 +354,13 @@ void ctkDICOMSeriesModelPrivate::loadSeriesForStudy()
       series.isVisible = this->seriesMatchesFilters(series);
 
       // Get instance counts
-      QStringList instances = this->DicomDatabase->instancesForSeries(series.seriesInstanceUID);
-      series.instanceCount = instances.count();
-
-      QStringList files = this->DicomDatabase->filesForSeries(series.seriesInstanceUID);
-      files.removeAll(QString(""));
-      series.instancesLoaded = files.count();
-
-      QStringList urls = this->DicomDatabase->urlsForSeries(series.seriesInstanceUID);
-      urls.removeAll(QString(""));
-
-      series.rows = 0;
-      series.columns = 0;
+      series.instanceCount = seriesFields.value("InstanceCount").toInt();
+      series.instancesLoaded = seriesFields.value("LoadedInstanceCount").toInt();
+      int urlCount = seriesFields.value("URLCount").toInt();
 
       // Determine cloud status
-      series.isCloud = series.instanceCount > 0 && urls.count() > 0 && series.instancesLoaded < series.instanceCount;
-      series.isLoaded = this->DicomDatabase->loadedSeriesInstanceUIDs().contains(seriesInstanceUID);
+      series.isCloud = series.instanceCount > 0 && urlCount > 0 && series.instancesLoaded < series.instanceCount;
+      series.isLoaded = loadedSeriesInstanceUIDs.contains(seriesInstanceUID);
 
       // Initialize other fields
       series.operationProgress = 0;
@@ -358,14 +371,10 @@ void ctkDICOMSeriesModelPrivate::loadSeriesForStudy()
       // This significantly improves initial loading performance
       series.centerInstanceUID = QString();
 
-      // Get DICOM Rows/Columns from first instance if available (lightweight query)
-      if (!instances.isEmpty())
-      {
-        QString rowsStr = this->DicomDatabase->instanceValue(instances.first(), "0028,0010");
-        QString colsStr = this->DicomDatabase->instanceValue(instances.first(), "0028,0011");
-        series.rows = rowsStr.toInt();
-        series.columns = colsStr.toInt();
-      }
+      // DICOM Rows/Columns of the first instance
+      QMap<QString, QString> firstInstanceFields = firstInstanceValues.value(seriesFields.value("FirstInstanceUID"));
+      series.rows = firstInstanceFields.value("0028,0010").toInt();
+      series.columns = firstInstanceFields.value("0028,0011").toInt();
 
       newSeriesData.append(series);
     }
@@ -421,7 +430,8 @@ void ctkDICOMSeriesModelPrivate::updateSeriesVisibility(int seriesIndex)
 }
 
 //----------------------------------------------------------------------------
-void ctkDICOMSeriesModelPrivate::generateThumbnailForSeries(const QString& seriesInstanceUID)
+void ctkDICOMSeriesModelPrivate::generateThumbnailForSeries(const QString& seriesInstanceUID,
+                                                            QList<ctkDICOMThumbnailGeneratorItem>* thumbnailItems)
 {
   Q_Q(ctkDICOMSeriesModel);
   if (!this->DicomDatabase || seriesInstanceUID.isEmpty())
@@ -461,21 +471,17 @@ void ctkDICOMSeriesModelPrivate::generateThumbnailForSeries(const QString& serie
     return;
   }
 
-  QString thumbnailPath = this->DicomDatabase->thumbnailPathForInstance(
+  QString thumbnailPath = this->thumbnailPathForInstance(
     series.studyInstanceUID, series.seriesInstanceUID, series.centerInstanceUID);
-  if (!thumbnailPath.isEmpty() && QFile::exists(thumbnailPath))
-  {
-    QPixmap cachedThumbnail(thumbnailPath);
-    if (!cachedThumbnail.isNull())
-    {
-      // Use cached thumbnail
-      series.thumbnailPath = thumbnailPath;
-      series.thumbnailGenerated = true;
-      QModelIndex index = q->createIndex(linearIndex, 0);
-      emit q->dataChanged(index, index, {q->ThumbnailPathRole, q->ThumbnailGeneratedRole});
-      q->onThumbnailGenerated(series.seriesInstanceUID, thumbnailPath);
-      return;
-    }
+  if (ctkDICOMThumbnailCache::isValidThumbnailFile(thumbnailPath))
+  {
+    // Use cached thumbnail
+    series.thumbnailPath = thumbnailPath;
+    series.thumbnailGenerated = true;
+    QModelIndex index = q->createIndex(linearIndex, 0);
+    emit q->dataChanged(index, index, {q->ThumbnailPathRole, q->ThumbnailGeneratedRole});
+    q->onThumbnailGenerated(series.seriesInstanceUID, thumbnailPath);
+    return;
   }
 
   // Get the file path for this instance
@@ -485,6 +491,19 @@ void ctkDICOMSeriesModelPrivate::generateThumbnailForSeries(const QString& serie
     return;
   }
 
+  if (thumbnailItems)
+  {
+    ctkDICOMThumbnailGeneratorItem item;
+    item.DicomFilePath = dicomFilePath;
+    item.PatientID = series.patientID;
+    item.StudyInstanceUID = series.studyInstanceUID;
+    item.SeriesInstanceUID = series.seriesInstanceUID;
+    item.SOPInstanceUID = series.centerInstanceUID;
+    item.Modality = series.modality;
+    thumbnailItems->append(item);
+    return;
+  }
+
   // Request thumbnail generation from scheduler directly
   if (this->Scheduler)
   {
@@ -497,6 +516,21 @@ void ctkDICOMSeriesModelPrivate::generateThumbnailForSeries(const QString& serie
   }
 }
 
+//----------------------------------------------------------------------------
+QString ctkDICOMSeriesModelPrivate::thumbnailPathForInstance(const QString& studyInstanceUID,
+                                                             const QString& seriesInstanceUID,
+                                                             const QString& sopInstanceUID) const
+{
+  QString thumbnailPath = this->DicomDatabase->packedThumbnailPathForInstance(
+    studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+  if (thumbnailPath.isEmpty())
+  {
+    thumbnailPath = this->DicomDatabase->thumbnailPathForInstance(
+      studyInstanceUID, seriesInstanceUID, sopInstanceUID);
+  }
+  return thumbnailPath;
+}
+
 //----------------------------------------------------------------------------
 QString ctkDICOMSeriesModelPrivate::getDICOMCenterFrameFromInstances(QStringList instancesList)
 {
@@ -573,6 +607,8 @@ ctkDICOMSeriesModel::ctkDICOMSeriesModel(QObject* parent)
   : Superclass(parent)
   , d_ptr(new ctkDICOMSeriesModelPrivate(*this))
 {
+  this->connect(ctkDICOMThumbnailCache::instance(), &ctkDICOMThumbnailCache::thumbnailLoaded,
+                this, &ctkDICOMSeriesModel::onThumbnailLoaded);
 }
 
 //----------------------------------------------------------------------------
@@ -933,6 +969,8 @@ void ctkDICOMSeriesModel::refreshSeries(const QString &seriesInstanceUID)
 void ctkDICOMSeriesModel::generateThumbnails(bool regenerate)
 {
   Q_D(ctkDICOMSeriesModel);
+  // The thumbnails are scheduled together to be generated by batches
+  QList<ctkDICOMThumbnailGeneratorItem> thumbnailItems;
   for (ctkDICOMSeriesModelPrivate::SeriesData& series : d->SeriesList)
   {
     if (regenerate)
@@ -940,7 +978,11 @@ void ctkDICOMSeriesModel::generateThumbnails(bool regenerate)
       series.thumbnailGenerated = false;
       emit this->dataChanged(createIndex(0, 0), createIndex(d->SeriesList.size() - 1, 0), {ThumbnailGeneratedRole});
     }
-    d->generateThumbnailForSeries(series.seriesInstanceUID);
+    d->generateThumbnailForSeries(series.seriesInstanceUID, &thumbnailItems);
+  }
+  if (d->Scheduler && !thumbnailItems.isEmpty())
+  {
+    d->Scheduler->generateThumbnails(thumbnailItems);
   }
 }
 
@@ -1585,6 +1627,15 @@ void ctkDICOMSeriesModel::updateGUIFromScheduler(const QVariant& data, const boo
     return;
   }
 
+  if (td.JobType == ctkDICOMJobResponseSet::JobType::ThumbnailGenerator)
+  {
+    // Thumbnail generator jobs report each generated thumbnail
+    QString thumbnailPath = d->thumbnailPathForInstance(
+      td.StudyInstanceUID, td.SeriesInstanceUID, td.SOPInstanceUID);
+    this->onThumbnailGenerated(td.SeriesInstanceUID, thumbnailPath);
+    return;
+  }
+
   QStringList instancesList = d->DicomDatabase->instancesForSeries(td.SeriesInstanceUID);
   if (instancesList.isEmpty())
   {
@@ -1767,12 +1818,6 @@ void ctkDICOMSeriesModel::onJobFinished(const QVariant& data)
     QModelIndex index = this->createIndex(linearIndex, 0);
     emit this->dataChanged(index, index, {IsCloudRole, OperationStatusRole, OperationProgressRole, InstancesLoadedRole});
   }
-  else if (td.JobType == ctkDICOMJobResponseSet::JobType::ThumbnailGenerator)
-  {
-    QString thumbnailPath = d->DicomDatabase->thumbnailPathForInstance(
-      td.StudyInstanceUID, td.SeriesInstanceUID, td.SOPInstanceUID);
-    this->onThumbnailGenerated(td.SeriesInstanceUID, thumbnailPath);
-  }
 }
 
 //----------------------------------------------------------------------------
@@ -1853,20 +1898,17 @@ void ctkDICOMSeriesModel::onThumbnailGenerated(const QString& seriesInstanceUID,
   }
 
   ctkDICOMSeriesModelPrivate::SeriesData& seriesData = d->SeriesList[linearIndex];
-  if (!thumbnailPath.isEmpty() && QFile::exists(thumbnailPath))
+  if (ctkDICOMThumbnailCache::isValidThumbnailFile(thumbnailPath))
   {
-    QPixmap thumbnail(thumbnailPath);
-    if (!thumbnail.isNull())
-    {
-      // Scale and cache the thumbnail
-      seriesData.thumbnailPath = thumbnailPath;
-      seriesData.thumbnailGenerated = true;
+    // Start decoding the thumbnail in the background for the delegates
+    ctkDICOMThumbnailCache::instance()->requestThumbnail(thumbnailPath);
+    seriesData.thumbnailPath = thumbnailPath;
+    seriesData.thumbnailGenerated = true;
 
-      // Notify views that thumbnail is ready - linear model uses row = linearIndex, column = 0
-      QModelIndex index = this->createIndex(linearIndex, 0);
-      emit this->dataChanged(index, index, {IsCloudRole, ThumbnailPathRole, ThumbnailGeneratedRole});
-      emit this->thumbnailReady(index);
-    }
+    // Notify views that thumbnail is ready - linear model uses row = linearIndex, column = 0
+    QModelIndex index = this->createIndex(linearIndex, 0);
+    emit this->dataChanged(index, index, {IsCloudRole, ThumbnailPathRole, ThumbnailGeneratedRole});
+    emit this->thumbnailReady(index);
   }
   else
   {
@@ -1876,6 +1918,21 @@ void ctkDICOMSeriesModel::onThumbnailGenerated(const QString& seriesInstanceUID,
   }
 }
 
+//----------------------------------------------------------------------------
+void ctkDICOMSeriesModel::onThumbnailLoaded(const QString& thumbnailPath)
+{
+  Q_D(ctkDICOMSeriesModel);
+  for (int linearIndex = 0; linearIndex < d->SeriesList.size(); ++linearIndex)
+  {
+    if (d->SeriesList[linearIndex].thumbnailPath != thumbnailPath)
+    {
+      continue;
+    }
+    QModelIndex index = this->createIndex(linearIndex, 0);
+    emit this->dataChanged(index, index, {ThumbnailPathRole});
+  }
+}
+
 //----------------------------------------------------------------------------
 void ctkDICOMSeriesModel::onLoadedSeriesChanged(const QStringList &seriesInstanceUIDs)
 {
@@ -216,6 +216,8 @@ public slots:
   void onJobFailed(const QVariant& data);
   void onJobUserStopped(const QVariant& data);
   void onThumbnailGenerated(const QString& seriesInstanceUID, const QString& thumbnailPath);
+  /// Notify the views when a thumbnail has been decoded by ctkDICOMThumbnailCache
+  void onThumbnailLoaded(const QString& thumbnailPath);
   void onLoadedSeriesChanged(const QStringList& seriesInstanceUIDs);
 
 signals:
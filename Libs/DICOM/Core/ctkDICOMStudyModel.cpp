@@ -279,6 +279,17 @@ void ctkDICOMStudyModelPrivate::populateStudies()
   // Fix YYYY-MM-DD format in YYYYMMDD
   patientBirthDate.remove('-');
 
+  // Get fields of all studies of the patient at once
+  QMap<QString, QMap<QString, QString> > databaseStudiesFields;
+  foreach (const QString& studyInstanceUID, studiesList)
+  {
+    if (!existingStudyUIDs.contains(studyInstanceUID))
+    {
+      databaseStudiesFields = this->DicomDatabase->studiesFieldsForPatient(this->PatientUID);
+      break;
+    }
+  }
+
   foreach (const QString& studyInstanceUID, studiesList)
   {
     this->createSeriesModel(studyInstanceUID);
@@ -295,15 +306,16 @@ void ctkDICOMStudyModelPrivate::populateStudies()
     if (!existingStudyUIDs.contains(studyInstanceUID))
     {
       StudyData study;
+      QMap<QString, QString> studyFields = databaseStudiesFields.value(studyInstanceUID);
       study.studyInstanceUID = studyInstanceUID;
-      study.studyID = this->DicomDatabase->fieldForStudy("StudyID", studyInstanceUID);
-      study.studyDescription = this->DicomDatabase->fieldForStudy("StudyDescription", studyInstanceUID);
-      study.studyDate = this->DicomDatabase->fieldForStudy("StudyDate", studyInstanceUID);
+      study.studyID = studyFields.value("StudyID");
+      study.studyDescription = studyFields.value("StudyDescription");
+      study.studyDate = studyFields.value("StudyDate");
       // Fix YYYY-MM-DD format in YYYYMMDD
       study.studyDate.remove('-');
-      study.studyTime = this->DicomDatabase->fieldForStudy("StudyTime", studyInstanceUID);
-      study.accessionNumber = this->DicomDatabase->fieldForStudy("AccessionNumber", studyInstanceUID);
-      study.modalitiesInStudy = this->DicomDatabase->fieldForStudy("ModalitiesInStudy", studyInstanceUID);
+      study.studyTime = studyFields.value("StudyTime");
+      study.accessionNumber = studyFields.value("AccessionNumber");
+      study.modalitiesInStudy = studyFields.value("ModalitiesInStudy");
 
       // Get patient information
       // First get the patient UID for this study
@@ -0,0 +1,405 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QCache>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageReader>
+#include <QPointer>
+#include <QRunnable>
+#include <QThreadPool>
+
+// CTK includes
+#include <ctkLogger.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMThumbnailCache.h"
+#include "ctkDICOMThumbnailStore.h"
+
+// STD includes
+#include <limits>
+
+static ctkLogger logger("org.commontk.DICOM.Core.DICOMThumbnailCache");
+
+//------------------------------------------------------------------------------
+class ctkDICOMThumbnailCacheDecodeTask : public QRunnable
+{
+public:
+  ctkDICOMThumbnailCacheDecodeTask(ctkDICOMThumbnailCache* cache, const QString& thumbnailPath, const QString& key)
+    : Cache(cache)
+    , ThumbnailPath(thumbnailPath)
+    , Key(key)
+  {
+  }
+
+  void run() override
+  {
+    QImage image;
+    QString storeFilePath;
+    QString key;
+    if (ctkDICOMThumbnailStore::splitPackedThumbnailPath(this->ThumbnailPath, storeFilePath, key))
+    {
+      image = QImage::fromData(ctkDICOMThumbnailStore::readThumbnail(storeFilePath, key));
+    }
+    else
+    {
+      QImageReader reader(this->ThumbnailPath);
+      image = reader.read();
+    }
+    // The conversion to QPixmap must be done in the GUI thread
+    QMetaObject::invokeMethod(this->Cache, "onThumbnailDecoded", Qt::QueuedConnection,
+                              Q_ARG(QString, this->ThumbnailPath),
+                              Q_ARG(QString, this->Key),
+                              Q_ARG(QImage, image));
+  }
+
+protected:
+  ctkDICOMThumbnailCache* Cache;
+  QString ThumbnailPath;
+  QString Key;
+};
+
+//------------------------------------------------------------------------------
+class ctkDICOMThumbnailCachePrivate
+{
+  Q_DECLARE_PUBLIC(ctkDICOMThumbnailCache);
+
+protected:
+  ctkDICOMThumbnailCache* const q_ptr;
+
+public:
+  ctkDICOMThumbnailCachePrivate(ctkDICOMThumbnailCache& obj);
+  ~ctkDICOMThumbnailCachePrivate();
+
+  struct ThumbnailEntry
+  {
+    QString Key;
+    QPixmap Pixmap;
+    QColor BackgroundColor;
+    /// Pixmap scaled for the last requested size
+    QPixmap ScaledPixmap;
+  };
+
+  static QString thumbnailKey(const QString& thumbnailPath);
+  /// Memory used by the entry, in kilobytes (unit of the QCache cost)
+  static int entryCost(const ThumbnailEntry& entry);
+  void startDecoding(const QString& thumbnailPath, const QString& key);
+
+  /// Decoded thumbnails by file path
+  QCache<QString, ThumbnailEntry> Cache;
+  /// Key of the file content being decoded, by file path
+  QHash<QString, QString> PendingKeys;
+  /// Key of the file content that could not be decoded, by file path
+  QHash<QString, QString> FailedKeys;
+  QThreadPool ThreadPool;
+};
+
+//------------------------------------------------------------------------------
+// ctkDICOMThumbnailCachePrivate methods
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailCachePrivate::ctkDICOMThumbnailCachePrivate(ctkDICOMThumbnailCache& obj)
+  : q_ptr(&obj)
+{
+  this->Cache.setMaxCost(64 * 1024);
+  this->ThreadPool.setMaxThreadCount(2);
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailCachePrivate::~ctkDICOMThumbnailCachePrivate()
+{
+  this->ThreadPool.clear();
+  this->ThreadPool.waitForDone();
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMThumbnailCachePrivate::thumbnailKey(const QString& thumbnailPath)
+{
+  QString storeFilePath;
+  QString storeKey;
+  if (ctkDICOMThumbnailStore::splitPackedThumbnailPath(thumbnailPath, storeFilePath, storeKey))
+  {
+    // Records are only appended to the store, the offset changes when the thumbnail is written again
+    qint64 offset = ctkDICOMThumbnailStore::thumbnailOffset(storeFilePath, storeKey);
+    if (offset < 0)
+    {
+      return QString();
+    }
+    return QString("%1|%2").arg(thumbnailPath).arg(offset);
+  }
+
+  QFileInfo fileInfo(thumbnailPath);
+  if (!fileInfo.exists())
+  {
+    return QString();
+  }
+  return QString("%1|%2|%3").arg(thumbnailPath)
+                            .arg(fileInfo.lastModified().toMSecsSinceEpoch())
+                            .arg(fileInfo.size());
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailCachePrivate::entryCost(const ThumbnailEntry& entry)
+{
+  qint64 bytes = qint64(entry.Pixmap.width()) * entry.Pixmap.height() * entry.Pixmap.depth() / 8;
+  bytes += qint64(entry.ScaledPixmap.width()) * entry.ScaledPixmap.height() * entry.ScaledPixmap.depth() / 8;
+  return static_cast<int>(bytes / 1024) + 1;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailCachePrivate::startDecoding(const QString& thumbnailPath, const QString& key)
+{
+  Q_Q(ctkDICOMThumbnailCache);
+  if (this->PendingKeys.value(thumbnailPath) == key ||
+      this->FailedKeys.value(thumbnailPath) == key)
+  {
+    return;
+  }
+  this->PendingKeys[thumbnailPath] = key;
+  this->ThreadPool.start(new ctkDICOMThumbnailCacheDecodeTask(q, thumbnailPath, key));
+}
+
+//------------------------------------------------------------------------------
+// ctkDICOMThumbnailCache methods
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailCache::ctkDICOMThumbnailCache(QObject* parentObject)
+  : QObject(parentObject)
+  , d_ptr(new ctkDICOMThumbnailCachePrivate(*this))
+{
+}
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailCache::~ctkDICOMThumbnailCache() = default;
+
+//------------------------------------------------------------------------------
+ctkDICOMThumbnailCache* ctkDICOMThumbnailCache::instance()
+{
+  // Owned by the application so that the pixmaps are released before the GUI is torn down
+  static QPointer<ctkDICOMThumbnailCache> sharedCache;
+  if (!sharedCache)
+  {
+    sharedCache = new ctkDICOMThumbnailCache(QCoreApplication::instance());
+  }
+  return sharedCache;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailCache::setMaximumCacheSize(qint64 maximumCacheSize)
+{
+  Q_D(ctkDICOMThumbnailCache);
+  qint64 maximumCost = qBound<qint64>(0, maximumCacheSize / 1024, std::numeric_limits<int>::max());
+  d->Cache.setMaxCost(static_cast<int>(maximumCost));
+}
+
+//------------------------------------------------------------------------------
+qint64 ctkDICOMThumbnailCache::maximumCacheSize() const
+{
+  Q_D(const ctkDICOMThumbnailCache);
+  return qint64(d->Cache.maxCost()) * 1024;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailCache::setNumberOfThreads(int numberOfThreads)
+{
+  Q_D(ctkDICOMThumbnailCache);
+  if (numberOfThreads < 1)
+  {
+    return;
+  }
+  d->ThreadPool.setMaxThreadCount(numberOfThreads);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailCache::numberOfThreads() const
+{
+  Q_D(const ctkDICOMThumbnailCache);
+  return d->ThreadPool.maxThreadCount();
+}
+
+//------------------------------------------------------------------------------
+QPixmap ctkDICOMThumbnailCache::thumbnail(const QString& thumbnailPath,
+                                          const QSize& size,
+                                          QColor* backgroundColor)
+{
+  Q_D(ctkDICOMThumbnailCache);
+  if (thumbnailPath.isEmpty())
+  {
+    return QPixmap();
+  }
+
+  QString key = d->thumbnailKey(thumbnailPath);
+  if (key.isEmpty())
+  {
+    return QPixmap();
+  }
+
+  ctkDICOMThumbnailCachePrivate::ThumbnailEntry* entry = d->Cache.object(thumbnailPath);
+  if (!entry || entry->Key != key)
+  {
+    d->startDecoding(thumbnailPath, key);
+    return QPixmap();
+  }
+
+  if (backgroundColor)
+  {
+    *backgroundColor = entry->BackgroundColor;
+  }
+  if (!size.isValid())
+  {
+    return entry->Pixmap;
+  }
+
+  QSize scaledSize = entry->Pixmap.size().scaled(size, Qt::KeepAspectRatio);
+  if (scaledSize == entry->Pixmap.size())
+  {
+    return entry->Pixmap;
+  }
+  if (entry->ScaledPixmap.size() == scaledSize)
+  {
+    return entry->ScaledPixmap;
+  }
+
+  // Re-insert the entry so that the scaled pixmap is accounted in the cache cost
+  ctkDICOMThumbnailCachePrivate::ThumbnailEntry* scaledEntry =
+    new ctkDICOMThumbnailCachePrivate::ThumbnailEntry(*entry);
+  scaledEntry->ScaledPixmap = entry->Pixmap.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+  QPixmap scaledPixmap = scaledEntry->ScaledPixmap;
+  d->Cache.insert(thumbnailPath, scaledEntry, d->entryCost(*scaledEntry));
+  return scaledPixmap;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailCache::requestThumbnail(const QString& thumbnailPath)
+{
+  Q_D(ctkDICOMThumbnailCache);
+  QString key = d->thumbnailKey(thumbnailPath);
+  if (key.isEmpty())
+  {
+    return;
+  }
+  ctkDICOMThumbnailCachePrivate::ThumbnailEntry* entry = d->Cache.object(thumbnailPath);
+  if (entry && entry->Key == key)
+  {
+    return;
+  }
+  d->startDecoding(thumbnailPath, key);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailCache::isThumbnailLoaded(const QString& thumbnailPath) const
+{
+  Q_D(const ctkDICOMThumbnailCache);
+  ctkDICOMThumbnailCachePrivate::ThumbnailEntry* entry = d->Cache.object(thumbnailPath);
+  return entry && entry->Key == d->thumbnailKey(thumbnailPath);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailCache::removeThumbnail(const QString& thumbnailPath)
+{
+  Q_D(ctkDICOMThumbnailCache);
+  d->Cache.remove(thumbnailPath);
+  d->PendingKeys.remove(thumbnailPath);
+  d->FailedKeys.remove(thumbnailPath);
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailCache::clear()
+{
+  Q_D(ctkDICOMThumbnailCache);
+  d->ThreadPool.clear();
+  d->Cache.clear();
+  // Results of the decoding already running are ignored
+  d->PendingKeys.clear();
+  d->FailedKeys.clear();
+}
+
+//------------------------------------------------------------------------------
+qint64 ctkDICOMThumbnailCache::cacheSize() const
+{
+  Q_D(const ctkDICOMThumbnailCache);
+  return qint64(d->Cache.totalCost()) * 1024;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailCache::numberOfThumbnails() const
+{
+  Q_D(const ctkDICOMThumbnailCache);
+  return d->Cache.count();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailCache::isValidThumbnailFile(const QString& thumbnailPath)
+{
+  if (thumbnailPath.isEmpty())
+  {
+    return false;
+  }
+  QString storeFilePath;
+  QString key;
+  if (ctkDICOMThumbnailStore::splitPackedThumbnailPath(thumbnailPath, storeFilePath, key))
+  {
+    return ctkDICOMThumbnailStore::thumbnailOffset(storeFilePath, key) >= 0;
+  }
+  QImageReader reader(thumbnailPath);
+  return reader.canRead();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailCache::onThumbnailDecoded(const QString& thumbnailPath,
+                                                const QString& key,
+                                                const QImage& image)
+{
+  Q_D(ctkDICOMThumbnailCache);
+  if (d->PendingKeys.value(thumbnailPath) != key)
+  {
+    // Canceled, or the file was modified while it was decoded
+    return;
+  }
+  d->PendingKeys.remove(thumbnailPath);
+
+  if (image.isNull())
+  {
+    logger.warn(QString("Failed to decode thumbnail %1").arg(thumbnailPath));
+    d->FailedKeys[thumbnailPath] = key;
+    return;
+  }
+
+  ctkDICOMThumbnailCachePrivate::ThumbnailEntry* entry = new ctkDICOMThumbnailCachePrivate::ThumbnailEntry;
+  entry->Key = key;
+  entry->Pixmap = QPixmap::fromImage(image);
+  entry->BackgroundColor = QColor(image.pixel(0, 0));
+  int cost = d->entryCost(*entry);
+  if (cost > d->Cache.maxCost())
+  {
+    // Remembered as failed, otherwise it would be decoded again at each request
+    logger.warn(QString("Thumbnail %1 is larger than the maximum cache size").arg(thumbnailPath));
+    d->FailedKeys[thumbnailPath] = key;
+    delete entry;
+    return;
+  }
+  d->FailedKeys.remove(thumbnailPath);
+  d->Cache.insert(thumbnailPath, entry, cost);
+
+  emit this->thumbnailLoaded(thumbnailPath);
+}
@@ -0,0 +1,126 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMThumbnailCache_h
+#define __ctkDICOMThumbnailCache_h
+
+// Qt includes
+#include <QColor>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+
+// ctkDICOMCore includes
+#include "ctkDICOMCoreExport.h"
+class ctkDICOMThumbnailCachePrivate;
+
+/// \ingroup DICOM_Core
+///
+/// Cache of decoded thumbnail pixmaps shared by the series and study models and delegates.
+///
+/// Thumbnails are identified by their file path, last modification time and file size,
+/// therefore a thumbnail file that is regenerated is decoded again. Thumbnails stored in
+/// a packed thumbnail store are referred to with their packed thumbnail path (see
+/// ctkDICOMThumbnailStore::packedThumbnailPath()).
+/// Thumbnails are decoded in a background thread: thumbnail() returns a null pixmap until
+/// the decoded pixmap is available, and thumbnailLoaded() is emitted when it is.
+/// The memory used by the decoded pixmaps is bounded by maximumCacheSize, the least
+/// recently used thumbnails are released first.
+///
+/// The cache must be used from the GUI thread.
+class CTK_DICOM_CORE_EXPORT ctkDICOMThumbnailCache : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(qint64 maximumCacheSize READ maximumCacheSize WRITE setMaximumCacheSize);
+  Q_PROPERTY(int numberOfThreads READ numberOfThreads WRITE setNumberOfThreads);
+
+public:
+  explicit ctkDICOMThumbnailCache(QObject* parent = 0);
+  virtual ~ctkDICOMThumbnailCache();
+
+  /// Cache shared by the DICOM models and delegates.
+  static ctkDICOMThumbnailCache* instance();
+
+  ///@{
+  /// Maximum memory in bytes used by the decoded thumbnails.
+  /// 64 MB by default.
+  void setMaximumCacheSize(qint64 maximumCacheSize);
+  qint64 maximumCacheSize() const;
+  ///@}
+
+  ///@{
+  /// Number of threads decoding thumbnail files.
+  /// 2 by default.
+  void setNumberOfThreads(int numberOfThreads);
+  int numberOfThreads() const;
+  ///@}
+
+  /// Return the thumbnail stored in \a thumbnailPath scaled to fit in \a size
+  /// (keeping the aspect ratio), or not scaled if \a size is invalid.
+  /// If the file is not decoded yet, the decoding is started and a null pixmap is returned.
+  /// \a backgroundColor, if not null, is set to the color of the top-left pixel of the
+  /// thumbnail, which can be used to fill the area around the scaled thumbnail.
+  QPixmap thumbnail(const QString& thumbnailPath,
+                    const QSize& size = QSize(),
+                    QColor* backgroundColor = nullptr);
+
+  /// Start decoding \a thumbnailPath in the background if it is not already cached.
+  Q_INVOKABLE void requestThumbnail(const QString& thumbnailPath);
+
+  /// Return true if the current content of \a thumbnailPath is decoded.
+  Q_INVOKABLE bool isThumbnailLoaded(const QString& thumbnailPath) const;
+
+  /// Release the decoded thumbnail of \a thumbnailPath.
+  Q_INVOKABLE void removeThumbnail(const QString& thumbnailPath);
+
+  /// Release all the decoded thumbnails and cancel the pending decoding.
+  Q_INVOKABLE void clear();
+
+  ///@{
+  /// Statistics
+  /// Memory in bytes used by the decoded thumbnails.
+  Q_INVOKABLE qint64 cacheSize() const;
+  Q_INVOKABLE int numberOfThumbnails() const;
+  ///@}
+
+  /// Return true if \a thumbnailPath exists and has a supported image format, or if
+  /// it is a packed thumbnail path of a thumbnail in its store.
+  /// Only the file header is read, the image is not decoded.
+  Q_INVOKABLE static bool isValidThumbnailFile(const QString& thumbnailPath);
+
+Q_SIGNALS:
+  /// Emitted when the thumbnail of \a thumbnailPath has been decoded and can be
+  /// retrieved with thumbnail().
+  void thumbnailLoaded(const QString& thumbnailPath);
+
+protected Q_SLOTS:
+  void onThumbnailDecoded(const QString& thumbnailPath, const QString& key, const QImage& image);
+
+protected:
+  QScopedPointer<ctkDICOMThumbnailCachePrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(ctkDICOMThumbnailCache);
+  Q_DISABLE_COPY(ctkDICOMThumbnailCache);
+};
+
+#endif
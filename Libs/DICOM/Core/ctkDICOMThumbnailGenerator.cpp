@@ -30,6 +30,8 @@
 #include <QtSvg/QSvgRenderer>
 
 // DCMTK includes
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcfilefo.h"
 #include "dcmtk/dcmimgle/dcmimage.h"
 
 //------------------------------------------------------------------------------
@@ -46,12 +48,20 @@ public:
   ctkDICOMThumbnailGeneratorPrivate(ctkDICOMThumbnailGenerator&);
   virtual ~ctkDICOMThumbnailGeneratorPrivate();
 
+  /// Load the dataset of \a dcmImagePath. The pixel data is not loaded,
+  /// it is read when the frames are rendered.
+  bool loadFile(const QString& dcmImagePath, DcmFileFormat& fileFormat);
+  /// Render the icon image of \a fileFormat if it is suitable for the thumbnail.
+  bool generateIconThumbnail(DcmFileFormat& fileFormat, QImage& image);
+
 protected:
   ctkDICOMThumbnailGenerator* const q_ptr;
 
   int Width;
   int Height;
   bool SmoothResize;
+  bool ScaleBeforeRendering;
+  bool UseIconImage;
 
 private:
   Q_DISABLE_COPY( ctkDICOMThumbnailGeneratorPrivate );
@@ -63,6 +73,8 @@ ctkDICOMThumbnailGeneratorPrivate::ctkDICOMThumbnailGeneratorPrivate(ctkDICOMThu
   , Width(256)
   , Height(256)
   , SmoothResize(false)
+  , ScaleBeforeRendering(true)
+  , UseIconImage(false)
 {
 }
 
@@ -71,6 +83,46 @@ ctkDICOMThumbnailGeneratorPrivate::~ctkDICOMThumbnailGeneratorPrivate()
 {
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGeneratorPrivate::loadFile(const QString& dcmImagePath, DcmFileFormat& fileFormat)
+{
+  // Elements larger than the default maximum read length (such as the pixel data)
+  // are only read when accessed.
+  OFCondition status = fileFormat.loadFile(QDir::toNativeSeparators(dcmImagePath).toUtf8().data());
+  if (status.bad())
+  {
+    QString warn = QString("Could not load DICOM file %1 for thumbnail: %2").arg(dcmImagePath).arg(status.text());
+    DCMTK_LOG4CPLUS_WARN_STR(rootLogThumbnailGenerator, warn.toStdString().c_str());
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGeneratorPrivate::generateIconThumbnail(DcmFileFormat& fileFormat, QImage& image)
+{
+  Q_Q(ctkDICOMThumbnailGenerator);
+  DcmDataset* dataset = fileFormat.getDataset();
+  DcmItem* iconItem = nullptr;
+  if (!dataset || dataset->findAndGetSequenceItem(DCM_IconImageSequence, iconItem, 0).bad() || !iconItem)
+  {
+    return false;
+  }
+  DicomImage iconImage(iconItem, dataset->getOriginalXfer());
+  if (iconImage.getStatus() != EIS_Normal)
+  {
+    return false;
+  }
+  // The icon is large enough if it does not need to be enlarged to fit the thumbnail.
+  bool largeEnough = static_cast<int>(iconImage.getWidth()) >= this->Width
+    || static_cast<int>(iconImage.getHeight()) >= this->Height;
+  if (!largeEnough && !this->UseIconImage)
+  {
+    return false;
+  }
+  return q->generateThumbnail(&iconImage, image);
+}
+
 
 //------------------------------------------------------------------------------
 ctkDICOMThumbnailGenerator::ctkDICOMThumbnailGenerator(QObject* parentValue)
@@ -126,6 +178,34 @@ void ctkDICOMThumbnailGenerator::setSmoothResize(bool on)
   d->SmoothResize = on;
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGenerator::scaleBeforeRendering()const
+{
+  Q_D(const ctkDICOMThumbnailGenerator);
+  return d->ScaleBeforeRendering;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailGenerator::setScaleBeforeRendering(bool on)
+{
+  Q_D(ctkDICOMThumbnailGenerator);
+  d->ScaleBeforeRendering = on;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGenerator::useIconImage()const
+{
+  Q_D(const ctkDICOMThumbnailGenerator);
+  return d->UseIconImage;
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailGenerator::setUseIconImage(bool on)
+{
+  Q_D(ctkDICOMThumbnailGenerator);
+  d->UseIconImage = on;
+}
+
 //------------------------------------------------------------------------------
 bool ctkDICOMThumbnailGenerator::generateThumbnail(DicomImage *dcmImage, QImage& image)
 {
@@ -152,14 +232,37 @@ bool ctkDICOMThumbnailGenerator::generateThumbnail(DicomImage *dcmImage, QImage&
       dcmImage->setMinMaxWindow(OFTrue /* ignore extreme values */);
     }
   }
+  // Scale the pixel data down to the thumbnail size before rendering, so that the
+  // VOI transformation and the conversion to 8 bits are only applied to the thumbnail
+  // pixels. The window selected above is kept by the scaled image.
+  QScopedPointer<DicomImage> scaledImage;
+  DicomImage* renderedImage = dcmImage;
+  QSize imageSize(static_cast<int>(dcmImage->getWidth()), static_cast<int>(dcmImage->getHeight()));
+  if (d->ScaleBeforeRendering && d->Width > 0 && d->Height > 0
+    && (imageSize.width() > d->Width || imageSize.height() > d->Height))
+  {
+    QSize scaledSize = imageSize.scaled(d->Width, d->Height, Qt::KeepAspectRatio);
+    scaledImage.reset(dcmImage->createScaledImage(
+      static_cast<unsigned long>(qMax(scaledSize.width(), 1)),
+      static_cast<unsigned long>(qMax(scaledSize.height(), 1)),
+      d->SmoothResize ? 1 : 0 /* interpolate */, 0 /* aspect */));
+    if (scaledImage && scaledImage->getStatus() == EIS_Normal)
+    {
+      renderedImage = scaledImage.data();
+    }
+    else
+    {
+      DCMTK_LOG4CPLUS_DEBUG_STR(rootLogThumbnailGenerator, "Scaling of DICOM image failed, rendering full resolution image");
+    }
+  }
   /* get image extension and prepare image header */
-  const unsigned long width = dcmImage->getWidth();
-  const unsigned long height = dcmImage->getHeight();
+  const unsigned long width = renderedImage->getWidth();
+  const unsigned long height = renderedImage->getHeight();
   unsigned long offset = 0;
   unsigned long length = 0;
   QString header;
 
-  if (dcmImage->isMonochrome())
+  if (renderedImage->isMonochrome())
   {
     // write PGM header (binary monochrome image format)
     header = QString("P5 %1 %2 255\n").arg(width).arg(height);
@@ -180,7 +283,7 @@ bool ctkDICOMThumbnailGenerator::generateThumbnail(DicomImage *dcmImage, QImage&
   buffer.resize(length);
 
   /* render pixel data to buffer */
-  if (dcmImage->getOutputData(static_cast<void *>(buffer.data() + offset), length - offset, 8, 0))
+  if (renderedImage->getOutputData(static_cast<void *>(buffer.data() + offset), length - offset, 8, 0))
   {
     if (!image.loadFromData( buffer ))
     {
@@ -188,8 +291,12 @@ bool ctkDICOMThumbnailGenerator::generateThumbnail(DicomImage *dcmImage, QImage&
       return false;
     }
   }
-  image = image.scaled( d->Width, d->Height, Qt::KeepAspectRatio,
-    (d->SmoothResize ? Qt::SmoothTransformation : Qt::FastTransformation) );
+  QSize thumbnailSize = image.size().scaled(d->Width, d->Height, Qt::KeepAspectRatio);
+  if (image.size() != thumbnailSize)
+  {
+    image = image.scaled( d->Width, d->Height, Qt::KeepAspectRatio,
+      (d->SmoothResize ? Qt::SmoothTransformation : Qt::FastTransformation) );
+  }
   return true;
 }
 
@@ -209,14 +316,39 @@ bool ctkDICOMThumbnailGenerator::generateThumbnail(DicomImage *dcmImage, const Q
 //------------------------------------------------------------------------------
 bool ctkDICOMThumbnailGenerator::generateThumbnail(const QString& dcmImagePath, QImage& image)
 {
-  DicomImage dcmImage(QDir::toNativeSeparators(dcmImagePath).toUtf8().data());
+  Q_D(ctkDICOMThumbnailGenerator);
+  DcmFileFormat fileFormat;
+  if (!d->loadFile(dcmImagePath, fileFormat))
+  {
+    return false;
+  }
+  if (d->generateIconThumbnail(fileFormat, image))
+  {
+    return true;
+  }
+  // Only the first frame is read and rendered
+  DicomImage dcmImage(&fileFormat, fileFormat.getDataset()->getOriginalXfer(),
+                      CIF_UsePartialAccessToPixelData, 0, 1);
   return this->generateThumbnail(&dcmImage, image);
 }
 
 //------------------------------------------------------------------------------
 bool ctkDICOMThumbnailGenerator::generateThumbnail(const QString& dcmImagePath, const QString& thumbnailPath)
 {
-  DicomImage dcmImage(QDir::toNativeSeparators(dcmImagePath).toUtf8().data());
+  Q_D(ctkDICOMThumbnailGenerator);
+  DcmFileFormat fileFormat;
+  if (!d->loadFile(dcmImagePath, fileFormat))
+  {
+    return false;
+  }
+  QImage image;
+  if (d->generateIconThumbnail(fileFormat, image))
+  {
+    return image.save(thumbnailPath, "PNG");
+  }
+  // Only the first frame is read and rendered
+  DicomImage dcmImage(&fileFormat, fileFormat.getDataset()->getOriginalXfer(),
+                      CIF_UsePartialAccessToPixelData, 0, 1);
   return this->generateThumbnail(&dcmImage, thumbnailPath);
 }
 
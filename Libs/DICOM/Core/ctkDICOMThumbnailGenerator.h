@@ -43,6 +43,8 @@ class CTK_DICOM_CORE_EXPORT ctkDICOMThumbnailGenerator : public ctkDICOMAbstract
   Q_PROPERTY(int width READ width WRITE setWidth)
   Q_PROPERTY(int height READ height WRITE setHeight)
   Q_PROPERTY(bool smoothResize READ smoothResize WRITE setSmoothResize)
+  Q_PROPERTY(bool scaleBeforeRendering READ scaleBeforeRendering WRITE setScaleBeforeRendering)
+  Q_PROPERTY(bool useIconImage READ useIconImage WRITE setUseIconImage)
 
 public:
   ///  \brief Construct a ctkDICOMThumbnailGenerator object
@@ -52,6 +54,10 @@ public:
   virtual bool generateThumbnail(DicomImage* dcmImage, const QString& thumbnailPath);
 
   Q_INVOKABLE bool generateThumbnail(DicomImage *dcmImage, QImage& image);
+  /// Generate the thumbnail of the DICOM file \a dcmImagePath.
+  /// Only the first frame is read. If the file contains an icon image
+  /// (IconImageSequence) that is large enough for the thumbnail size, or any icon
+  /// image if useIconImage is true, the icon image is rendered instead of the frame.
   Q_INVOKABLE bool generateThumbnail(const QString& dcmImagePath, QImage& image);
   Q_INVOKABLE bool generateThumbnail(const QString& dcmImagePath, const QString& thumbnailPath);
 
@@ -74,6 +80,18 @@ public:
   void setSmoothResize(bool on);
   /// Get thumbnail height
   bool smoothResize() const;
+  /// Set whether images larger than the thumbnail are scaled down before the
+  /// VOI transformation and the conversion to 8 bits (DicomImage::createScaledImage),
+  /// instead of rendering the full resolution image and scaling the rendered image.
+  /// True by default.
+  void setScaleBeforeRendering(bool on);
+  bool scaleBeforeRendering() const;
+  /// Set whether the icon image embedded in the DICOM files (IconImageSequence)
+  /// is used even when it is smaller than the thumbnail. Icon images that are at
+  /// least as large as the thumbnail are always used.
+  /// False by default.
+  void setUseIconImage(bool on);
+  bool useIconImage() const;
 
 protected:
   QScopedPointer<ctkDICOMThumbnailGeneratorPrivate> d_ptr;
@@ -46,9 +46,62 @@ ctkDICOMThumbnailGeneratorJobPrivate::~ctkDICOMThumbnailGeneratorJobPrivate()
 {
 }
 
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGeneratorJobPrivate::itemMatches(const ctkDICOMThumbnailGeneratorItem& item,
+                                                      const QStringList& patientIDs,
+                                                      const QStringList& studyInstanceUIDs,
+                                                      const QStringList& seriesInstanceUIDs,
+                                                      const QStringList& sopInstanceUIDs)
+{
+  return (!item.PatientID.isEmpty() && patientIDs.contains(item.PatientID)) ||
+         (!item.StudyInstanceUID.isEmpty() && studyInstanceUIDs.contains(item.StudyInstanceUID)) ||
+         (!item.SeriesInstanceUID.isEmpty() && seriesInstanceUIDs.contains(item.SeriesInstanceUID)) ||
+         (!item.SOPInstanceUID.isEmpty() && sopInstanceUIDs.contains(item.SOPInstanceUID));
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailGeneratorJobPrivate::updateDICOMUIDs()
+{
+  Q_Q(ctkDICOMThumbnailGeneratorJob);
+  if (this->Items.isEmpty())
+  {
+    return;
+  }
+  const ctkDICOMThumbnailGeneratorItem& firstItem = this->Items.first();
+  QString patientID = firstItem.PatientID;
+  QString studyInstanceUID = firstItem.StudyInstanceUID;
+  QString seriesInstanceUID = firstItem.SeriesInstanceUID;
+  QString sopInstanceUID = firstItem.SOPInstanceUID;
+  for (const ctkDICOMThumbnailGeneratorItem& item : std::as_const(this->Items))
+  {
+    if (item.PatientID != patientID)
+    {
+      patientID.clear();
+    }
+    if (item.StudyInstanceUID != studyInstanceUID)
+    {
+      studyInstanceUID.clear();
+    }
+    if (item.SeriesInstanceUID != seriesInstanceUID)
+    {
+      seriesInstanceUID.clear();
+    }
+    if (item.SOPInstanceUID != sopInstanceUID)
+    {
+      sopInstanceUID.clear();
+    }
+  }
+  q->setPatientID(patientID);
+  q->setStudyInstanceUID(studyInstanceUID);
+  q->setSeriesInstanceUID(seriesInstanceUID);
+  q->setSOPInstanceUID(sopInstanceUID);
+}
+
 //------------------------------------------------------------------------------
 CTK_GET_CPP(ctkDICOMThumbnailGeneratorJob, QString, databaseFilename, DatabaseFilename);
 CTK_SET_CPP(ctkDICOMThumbnailGeneratorJob, QString, setDatabaseFilename, DatabaseFilename);
+CTK_GET_CPP(ctkDICOMThumbnailGeneratorJob, bool, packedThumbnailStorage, PackedThumbnailStorage);
+CTK_SET_CPP(ctkDICOMThumbnailGeneratorJob, bool, setPackedThumbnailStorage, PackedThumbnailStorage);
 CTK_GET_CPP(ctkDICOMThumbnailGeneratorJob, QString, dicomFilePath, DicomFilePath);
 CTK_SET_CPP(ctkDICOMThumbnailGeneratorJob, QString, setDicomFilePath, DicomFilePath);
 CTK_GET_CPP(ctkDICOMThumbnailGeneratorJob, QString, modality, Modality);
@@ -74,6 +127,89 @@ ctkDICOMThumbnailGeneratorJob::ctkDICOMThumbnailGeneratorJob(ctkDICOMThumbnailGe
 //------------------------------------------------------------------------------
 ctkDICOMThumbnailGeneratorJob::~ctkDICOMThumbnailGeneratorJob() = default;
 
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGeneratorJob::appendItems(const QList<ctkDICOMThumbnailGeneratorItem>& items)
+{
+  Q_D(ctkDICOMThumbnailGeneratorJob);
+  QMutexLocker locker(&d->ItemsMutex);
+  if (this->status() >= ctkAbstractJob::JobStatus::Running)
+  {
+    return false;
+  }
+
+  d->Items.append(items);
+  d->updateDICOMUIDs();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailGeneratorJob::removeItems(const QStringList& patientIDs,
+                                               const QStringList& studyInstanceUIDs,
+                                               const QStringList& seriesInstanceUIDs,
+                                               const QStringList& sopInstanceUIDs)
+{
+  Q_D(ctkDICOMThumbnailGeneratorJob);
+  QMutexLocker locker(&d->ItemsMutex);
+  int numberOfItems = d->Items.count();
+  for (int index = d->Items.count() - 1; index >= 0; --index)
+  {
+    if (ctkDICOMThumbnailGeneratorJobPrivate::itemMatches(
+          d->Items[index], patientIDs, studyInstanceUIDs, seriesInstanceUIDs, sopInstanceUIDs))
+    {
+      d->Items.removeAt(index);
+    }
+  }
+  return numberOfItems - d->Items.count();
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGeneratorJob::containsItems(const QStringList& patientIDs,
+                                                  const QStringList& studyInstanceUIDs,
+                                                  const QStringList& seriesInstanceUIDs,
+                                                  const QStringList& sopInstanceUIDs) const
+{
+  Q_D(const ctkDICOMThumbnailGeneratorJob);
+  QMutexLocker locker(&d->ItemsMutex);
+  for (const ctkDICOMThumbnailGeneratorItem& item : d->Items)
+  {
+    if (ctkDICOMThumbnailGeneratorJobPrivate::itemMatches(
+          item, patientIDs, studyInstanceUIDs, seriesInstanceUIDs, sopInstanceUIDs))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailGeneratorJob::takeNextItem(ctkDICOMThumbnailGeneratorItem& item)
+{
+  Q_D(ctkDICOMThumbnailGeneratorJob);
+  QMutexLocker locker(&d->ItemsMutex);
+  if (d->Items.isEmpty())
+  {
+    return false;
+  }
+  item = d->Items.takeFirst();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+QList<ctkDICOMThumbnailGeneratorItem> ctkDICOMThumbnailGeneratorJob::items() const
+{
+  Q_D(const ctkDICOMThumbnailGeneratorJob);
+  QMutexLocker locker(&d->ItemsMutex);
+  return d->Items;
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailGeneratorJob::numberOfItems() const
+{
+  Q_D(const ctkDICOMThumbnailGeneratorJob);
+  QMutexLocker locker(&d->ItemsMutex);
+  return d->Items.count();
+}
+
 //----------------------------------------------------------------------------
 QString ctkDICOMThumbnailGeneratorJob::loggerReport(const QString& status)
 {
@@ -100,6 +236,13 @@ ctkAbstractJob* ctkDICOMThumbnailGeneratorJob::clone() const
   newThumbnailGeneratorJob->setBackgroundColor(this->backgroundColor());
   newThumbnailGeneratorJob->setModality(this->modality());
   newThumbnailGeneratorJob->setDicomFilePath(this->dicomFilePath());
+  newThumbnailGeneratorJob->setPackedThumbnailStorage(this->packedThumbnailStorage());
+  newThumbnailGeneratorJob->setDatabaseFilename(this->databaseFilename());
+  newThumbnailGeneratorJob->setPatientID(this->patientID());
+  newThumbnailGeneratorJob->setStudyInstanceUID(this->studyInstanceUID());
+  newThumbnailGeneratorJob->setSeriesInstanceUID(this->seriesInstanceUID());
+  newThumbnailGeneratorJob->setSOPInstanceUID(this->sopInstanceUID());
+  newThumbnailGeneratorJob->appendItems(this->items());
 
   return newThumbnailGeneratorJob;
 }
@@ -26,8 +26,10 @@
 
 // Qt includes
 #include <QColor>
+#include <QList>
 #include <QObject>
 #include <QSharedPointer>
+#include <QStringList>
 
 // ctkCore includes
 class ctkAbstractWorker;
@@ -38,10 +40,28 @@ class ctkAbstractWorker;
 class ctkDICOMThumbnailGeneratorJobPrivate;
 
 /// \ingroup DICOM_Core
+/// Thumbnail generated by a ctkDICOMThumbnailGeneratorJob
+struct CTK_DICOM_CORE_EXPORT ctkDICOMThumbnailGeneratorItem
+{
+  QString DicomFilePath;
+  QString PatientID;
+  QString StudyInstanceUID;
+  QString SeriesInstanceUID;
+  QString SOPInstanceUID;
+  QString Modality;
+};
+
+/// \ingroup DICOM_Core
+///
+/// Job generating the thumbnails of a list of instances (see appendItems()) in a single
+/// worker, which reuses its database connection and thumbnail generator for all of them.
+/// A progress job detail is emitted for each generated thumbnail.
+/// If no item is appended, the thumbnail of dicomFilePath is generated.
 class CTK_DICOM_CORE_EXPORT ctkDICOMThumbnailGeneratorJob : public ctkDICOMJob
 {
   Q_OBJECT
   Q_PROPERTY(QString databaseFilename READ databaseFilename WRITE setDatabaseFilename);
+  Q_PROPERTY(bool packedThumbnailStorage READ packedThumbnailStorage WRITE setPackedThumbnailStorage);
   Q_PROPERTY(QString dicomFilePath READ dicomFilePath WRITE setDicomFilePath);
   Q_PROPERTY(QString modality READ modality WRITE setModality);
   Q_PROPERTY(QColor backgroundColor READ backgroundColor WRITE setBackgroundColor);
@@ -58,7 +78,16 @@ public:
   ///}@
 
   ///@{
-  /// Dicom file path
+  /// Store the thumbnail in the packed thumbnail store of the study
+  /// \sa ctkDICOMDatabase::packedThumbnailStorage
+  /// False by default.
+  void setPackedThumbnailStorage(bool packedThumbnailStorage);
+  bool packedThumbnailStorage() const;
+  ///@}
+
+  ///@{
+  /// Dicom file path of the thumbnail generated when the job has no items.
+  /// Empty for the batch jobs created by ctkDICOMScheduler::generateThumbnails.
   void setDicomFilePath(QString dicomFilePath);
   QString dicomFilePath() const;
   ///@}
@@ -75,6 +104,41 @@ public:
   QColor backgroundColor() const;
   ///@}
 
+  /// Append thumbnails to generate.
+  /// The patient, study, series and SOP instance UIDs of the job are set to the
+  /// UIDs shared by all the items, or cleared if they differ.
+  /// Return false if the worker is already running or the job is stopped, the items
+  /// are not appended in that case.
+  /// This method is thread safe.
+  bool appendItems(const QList<ctkDICOMThumbnailGeneratorItem>& items);
+
+  /// Remove the thumbnails not generated yet that match any of the given UIDs.
+  /// Return the number of removed items.
+  /// This method is thread safe.
+  int removeItems(const QStringList& patientIDs,
+                  const QStringList& studyInstanceUIDs,
+                  const QStringList& seriesInstanceUIDs,
+                  const QStringList& sopInstanceUIDs);
+
+  /// Return true if a thumbnail not generated yet matches any of the given UIDs.
+  /// This method is thread safe.
+  bool containsItems(const QStringList& patientIDs,
+                     const QStringList& studyInstanceUIDs,
+                     const QStringList& seriesInstanceUIDs,
+                     const QStringList& sopInstanceUIDs) const;
+
+  /// Remove the next thumbnail to generate from the items and return it in \a item.
+  /// Return false if there are no more items.
+  /// This method is thread safe.
+  bool takeNextItem(ctkDICOMThumbnailGeneratorItem& item);
+
+  ///@{
+  /// Thumbnails not generated yet.
+  /// These methods are thread safe.
+  QList<ctkDICOMThumbnailGeneratorItem> items() const;
+  int numberOfItems() const;
+  ///@}
+
   /// Logger report string formatting for specific task
   Q_INVOKABLE QString loggerReport(const QString& status) override;
 
@@ -26,6 +26,7 @@
 
 // Qt includes
 #include <QColor>
+#include <QMutex>
 #include <QObject>
 
 // ctkDICOMCore includes
@@ -44,11 +45,23 @@ public:
   ctkDICOMThumbnailGeneratorJobPrivate(ctkDICOMThumbnailGeneratorJob* object);
   virtual ~ctkDICOMThumbnailGeneratorJobPrivate();
 
+  static bool itemMatches(const ctkDICOMThumbnailGeneratorItem& item,
+                          const QStringList& patientIDs,
+                          const QStringList& studyInstanceUIDs,
+                          const QStringList& seriesInstanceUIDs,
+                          const QStringList& sopInstanceUIDs);
+  /// Set the UIDs of the job to the UIDs shared by all the items.
+  void updateDICOMUIDs();
+
 public:
   QString DatabaseFilename;
+  bool PackedThumbnailStorage{false};
   QString DicomFilePath;
   QString Modality;
   QColor BackgroundColor;
+
+  QList<ctkDICOMThumbnailGeneratorItem> Items;
+  mutable QMutex ItemsMutex;
 };
 
 #endif
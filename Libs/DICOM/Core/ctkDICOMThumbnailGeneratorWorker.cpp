@@ -95,6 +95,21 @@ void ctkDICOMThumbnailGeneratorWorker::run()
     return;
   }
 
+  // A batch job has no file path, it has nothing left to generate if all
+  // its items were removed before it started
+  if (thumbnailGeneratorJob->numberOfItems() == 0 &&
+      !thumbnailGeneratorJob->dicomFilePath().isEmpty())
+  {
+    ctkDICOMThumbnailGeneratorItem item;
+    item.DicomFilePath = thumbnailGeneratorJob->dicomFilePath();
+    item.PatientID = thumbnailGeneratorJob->patientID();
+    item.StudyInstanceUID = thumbnailGeneratorJob->studyInstanceUID();
+    item.SeriesInstanceUID = thumbnailGeneratorJob->seriesInstanceUID();
+    item.SOPInstanceUID = thumbnailGeneratorJob->sopInstanceUID();
+    item.Modality = thumbnailGeneratorJob->modality();
+    thumbnailGeneratorJob->appendItems({item});
+  }
+
   thumbnailGeneratorJob->setStatus(ctkAbstractJob::JobStatus::Running);
 
   logger.debug(QString("ctkDICOMThumbnailGeneratorWorker : running job %1 in thread %2.\n")
@@ -105,14 +120,34 @@ void ctkDICOMThumbnailGeneratorWorker::run()
   QString dbConnectionName =
     "db_" + QString::number(reinterpret_cast<quint64>(QThread::currentThreadId()), 16);
   database.openDatabase(thumbnailGeneratorJob->databaseFilename(), dbConnectionName);
+  database.setPackedThumbnailStorage(thumbnailGeneratorJob->packedThumbnailStorage());
   QSharedPointer<ctkDICOMThumbnailGenerator> thumbnailGenerator =
     QSharedPointer<ctkDICOMThumbnailGenerator>(new ctkDICOMThumbnailGenerator);
   database.setThumbnailGenerator(thumbnailGenerator.data());
-  database.storeThumbnailFile(thumbnailGeneratorJob->dicomFilePath(),
-                              thumbnailGeneratorJob->studyInstanceUID(),
-                              thumbnailGeneratorJob->seriesInstanceUID(),
-                              thumbnailGeneratorJob->sopInstanceUID(),
-                              thumbnailGeneratorJob->modality());
+
+  // Items removed from the job while it runs (see ctkDICOMScheduler::stopJobsByDICOMUIDs)
+  // are not generated.
+  ctkDICOMThumbnailGeneratorItem item;
+  while (!d->wasCancelled && thumbnailGeneratorJob->takeNextItem(item))
+  {
+    database.storeThumbnailFile(item.DicomFilePath,
+                                item.StudyInstanceUID,
+                                item.SeriesInstanceUID,
+                                item.SOPInstanceUID,
+                                item.Modality);
+
+    QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet =
+      QSharedPointer<ctkDICOMJobResponseSet>(new ctkDICOMJobResponseSet);
+
+    jobResponseSet->setJobType(ctkDICOMJobResponseSet::JobType::ThumbnailGenerator);
+    jobResponseSet->setPatientID(item.PatientID);
+    jobResponseSet->setStudyInstanceUID(item.StudyInstanceUID);
+    jobResponseSet->setSeriesInstanceUID(item.SeriesInstanceUID);
+    jobResponseSet->setSOPInstanceUID(item.SOPInstanceUID);
+    jobResponseSet->setJobUID(thumbnailGeneratorJob->jobUID());
+
+    thumbnailGeneratorJob->progressJobDetail(jobResponseSet->toVariant());
+  }
   database.closeDatabase();
 
   if (d->wasCancelled)
@@ -120,17 +155,6 @@ void ctkDICOMThumbnailGeneratorWorker::run()
     this->onJobCanceled(d->wasCancelled);
     return;
   }
-  QSharedPointer<ctkDICOMJobResponseSet> jobResponseSet =
-    QSharedPointer<ctkDICOMJobResponseSet>(new ctkDICOMJobResponseSet);
-
-  jobResponseSet->setJobType(ctkDICOMJobResponseSet::JobType::ThumbnailGenerator);
-  jobResponseSet->setPatientID(thumbnailGeneratorJob->patientID());
-  jobResponseSet->setStudyInstanceUID(thumbnailGeneratorJob->studyInstanceUID());
-  jobResponseSet->setSeriesInstanceUID(thumbnailGeneratorJob->seriesInstanceUID());
-  jobResponseSet->setSOPInstanceUID(thumbnailGeneratorJob->sopInstanceUID());
-  jobResponseSet->setJobUID(thumbnailGeneratorJob->jobUID());
-
-  thumbnailGeneratorJob->progressJobDetail(jobResponseSet->toVariant());
   thumbnailGeneratorJob->setStatus(ctkAbstractJob::JobStatus::Finished);
 }
 
@@ -0,0 +1,547 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+// Qt includes
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+// CTK includes
+#include <ctkLogger.h>
+
+// ctkDICOMCore includes
+#include "ctkDICOMThumbnailStore.h"
+
+// STD includes
+#include <algorithm>
+
+static ctkLogger logger("org.commontk.DICOM.Core.DICOMThumbnailStore");
+
+namespace
+{
+
+/// Signature written at the beginning of the store files, it includes the format version
+const QByteArray StoreSignature("CTKTHMB1");
+
+//------------------------------------------------------------------------------
+struct ThumbnailRecord
+{
+  /// Offset of the encoded thumbnail in the file
+  qint64 DataOffset;
+  quint32 DataSize;
+  qint64 DateTime;
+  /// Size of the record including the header
+  qint64 RecordSize;
+};
+
+//------------------------------------------------------------------------------
+struct StoreIndex
+{
+  /// Size of the part of the file that is indexed
+  qint64 IndexedSize = 0;
+  QHash<QString, ThumbnailRecord> Records;
+  /// Size of the live records and of the superseded or removal records
+  qint64 LiveBytes = 0;
+  qint64 DeadBytes = 0;
+};
+
+//------------------------------------------------------------------------------
+QMutex& storeMutex()
+{
+  static QMutex mutex;
+  return mutex;
+}
+
+//------------------------------------------------------------------------------
+QHash<QString, StoreIndex>& storeIndexes()
+{
+  static QHash<QString, StoreIndex> indexes;
+  return indexes;
+}
+
+//------------------------------------------------------------------------------
+// Index the records appended since the last call. storeMutex() must be locked.
+// Return nullptr if the file does not exist or is not a store file.
+StoreIndex* updateIndex(const QString& storeFilePath)
+{
+  QFileInfo fileInfo(storeFilePath);
+  if (!fileInfo.exists())
+  {
+    storeIndexes().remove(storeFilePath);
+    return nullptr;
+  }
+
+  StoreIndex& index = storeIndexes()[storeFilePath];
+  qint64 fileSize = fileInfo.size();
+  if (fileSize == index.IndexedSize)
+  {
+    return &index;
+  }
+  if (fileSize < index.IndexedSize)
+  {
+    // The file has been rewritten
+    index = StoreIndex();
+  }
+
+  QFile file(storeFilePath);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    logger.error(QString("Failed to open thumbnail store %1: %2").arg(storeFilePath).arg(file.errorString()));
+    storeIndexes().remove(storeFilePath);
+    return nullptr;
+  }
+  if (index.IndexedSize == 0)
+  {
+    if (file.read(StoreSignature.size()) != StoreSignature)
+    {
+      logger.error(QString("%1 is not a thumbnail store").arg(storeFilePath));
+      storeIndexes().remove(storeFilePath);
+      return nullptr;
+    }
+    index.IndexedSize = StoreSignature.size();
+  }
+  file.seek(index.IndexedSize);
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  while (index.IndexedSize < fileSize)
+  {
+    QString key;
+    qint64 dateTime = 0;
+    quint32 dataSize = 0;
+    stream >> key >> dateTime >> dataSize;
+    if (stream.status() != QDataStream::Ok)
+    {
+      break;
+    }
+    qint64 dataOffset = file.pos();
+    qint64 recordEnd = dataOffset + dataSize;
+    if (recordEnd > fileSize || !file.seek(recordEnd))
+    {
+      // Incomplete record, it is indexed once it is completely written
+      break;
+    }
+    qint64 recordSize = recordEnd - index.IndexedSize;
+    index.IndexedSize = recordEnd;
+
+    QHash<QString, ThumbnailRecord>::iterator previousRecord = index.Records.find(key);
+    if (previousRecord != index.Records.end())
+    {
+      index.LiveBytes -= previousRecord->RecordSize;
+      index.DeadBytes += previousRecord->RecordSize;
+      index.Records.erase(previousRecord);
+    }
+    if (dataSize == 0)
+    {
+      // Removal record
+      index.DeadBytes += recordSize;
+      continue;
+    }
+    ThumbnailRecord record;
+    record.DataOffset = dataOffset;
+    record.DataSize = dataSize;
+    record.DateTime = dateTime;
+    record.RecordSize = recordSize;
+    index.Records.insert(key, record);
+    index.LiveBytes += recordSize;
+  }
+  return &index;
+}
+
+//------------------------------------------------------------------------------
+// Append records to the store. storeMutex() must be locked.
+bool appendRecords(const QString& storeFilePath, const QList<QPair<QString, QByteArray> >& records)
+{
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index && QFile::exists(storeFilePath))
+  {
+    return false;
+  }
+
+  QFileInfo fileInfo(storeFilePath);
+  if (!fileInfo.dir().exists() && !fileInfo.dir().mkpath("."))
+  {
+    logger.error(QString("Failed to create directory %1").arg(fileInfo.dir().path()));
+    return false;
+  }
+
+  QFile file(storeFilePath);
+  if (!file.open(QIODevice::ReadWrite))
+  {
+    logger.error(QString("Failed to open thumbnail store %1: %2").arg(storeFilePath).arg(file.errorString()));
+    return false;
+  }
+  if (index && file.size() > index->IndexedSize)
+  {
+    // Drop a record that was not completely written
+    file.resize(index->IndexedSize);
+  }
+  if (file.size() == 0)
+  {
+    file.write(StoreSignature);
+  }
+  file.seek(file.size());
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+  qint64 dateTime = QDateTime::currentMSecsSinceEpoch();
+  for (const QPair<QString, QByteArray>& record : records)
+  {
+    stream << record.first << dateTime << quint32(record.second.size());
+    stream.writeRawData(record.second.constData(), record.second.size());
+  }
+  file.close();
+  if (stream.status() != QDataStream::Ok || file.error() != QFileDevice::NoError)
+  {
+    logger.error(QString("Failed to write thumbnail store %1: %2").arg(storeFilePath).arg(file.errorString()));
+    return false;
+  }
+
+  updateIndex(storeFilePath);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Rewrite the store with the live records only when the superseded records take
+// more space than the live ones. storeMutex() must be locked.
+bool compactIfNeeded(const QString& storeFilePath)
+{
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index || index->DeadBytes <= index->LiveBytes)
+  {
+    return true;
+  }
+  if (index->Records.isEmpty())
+  {
+    storeIndexes().remove(storeFilePath);
+    return QFile::remove(storeFilePath);
+  }
+
+  QByteArray content;
+  {
+    QFile file(storeFilePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      logger.error(QString("Failed to open thumbnail store %1: %2").arg(storeFilePath).arg(file.errorString()));
+      return false;
+    }
+    content = file.readAll();
+  }
+
+  // Keep the order of the records so that sequential reads stay sequential
+  QList<QPair<QString, ThumbnailRecord> > records;
+  for (QHash<QString, ThumbnailRecord>::const_iterator it = index->Records.constBegin();
+       it != index->Records.constEnd(); ++it)
+  {
+    records << qMakePair(it.key(), it.value());
+  }
+  std::sort(records.begin(), records.end(),
+            [](const QPair<QString, ThumbnailRecord>& record1, const QPair<QString, ThumbnailRecord>& record2)
+            {
+              return record1.second.DataOffset < record2.second.DataOffset;
+            });
+
+  QSaveFile saveFile(storeFilePath);
+  if (!saveFile.open(QIODevice::WriteOnly))
+  {
+    logger.error(QString("Failed to compact thumbnail store %1: %2").arg(storeFilePath).arg(saveFile.errorString()));
+    return false;
+  }
+  saveFile.write(StoreSignature);
+  QDataStream stream(&saveFile);
+  stream.setVersion(QDataStream::Qt_5_0);
+  for (const QPair<QString, ThumbnailRecord>& record : records)
+  {
+    stream << record.first << record.second.DateTime << record.second.DataSize;
+    stream.writeRawData(content.constData() + record.second.DataOffset, record.second.DataSize);
+  }
+  if (stream.status() != QDataStream::Ok || !saveFile.commit())
+  {
+    logger.error(QString("Failed to compact thumbnail store %1: %2").arg(storeFilePath).arg(saveFile.errorString()));
+    return false;
+  }
+
+  storeIndexes().remove(storeFilePath);
+  updateIndex(storeFilePath);
+  return true;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+QString ctkDICOMThumbnailStore::fileExtension()
+{
+  return ".ctkthumbs";
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::writeThumbnails(const QString& storeFilePath, const QMap<QString, QByteArray>& thumbnails)
+{
+  QList<QPair<QString, QByteArray> > records;
+  for (QMap<QString, QByteArray>::const_iterator it = thumbnails.constBegin(); it != thumbnails.constEnd(); ++it)
+  {
+    if (it.key().isEmpty() || it.value().isEmpty())
+    {
+      logger.warn(QString("Empty thumbnail %1 is not stored in %2").arg(it.key()).arg(storeFilePath));
+      continue;
+    }
+    records << qMakePair(it.key(), it.value());
+  }
+  if (records.isEmpty())
+  {
+    return true;
+  }
+
+  QMutexLocker locker(&storeMutex());
+  return appendRecords(storeFilePath, records) && compactIfNeeded(storeFilePath);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::writeThumbnail(const QString& storeFilePath, const QString& key, const QByteArray& data)
+{
+  QMap<QString, QByteArray> thumbnails;
+  thumbnails.insert(key, data);
+  return ctkDICOMThumbnailStore::writeThumbnails(storeFilePath, thumbnails);
+}
+
+//------------------------------------------------------------------------------
+QByteArray ctkDICOMThumbnailStore::readThumbnail(const QString& storeFilePath, const QString& key)
+{
+  QMutexLocker locker(&storeMutex());
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index || !index->Records.contains(key))
+  {
+    return QByteArray();
+  }
+  const ThumbnailRecord& record = index->Records[key];
+
+  QFile file(storeFilePath);
+  if (!file.open(QIODevice::ReadOnly) || !file.seek(record.DataOffset))
+  {
+    logger.error(QString("Failed to read thumbnail store %1: %2").arg(storeFilePath).arg(file.errorString()));
+    return QByteArray();
+  }
+  return file.read(record.DataSize);
+}
+
+//------------------------------------------------------------------------------
+QMap<QString, QByteArray> ctkDICOMThumbnailStore::readThumbnails(const QString& storeFilePath)
+{
+  QMap<QString, QByteArray> thumbnails;
+  QMutexLocker locker(&storeMutex());
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index || index->Records.isEmpty())
+  {
+    return thumbnails;
+  }
+
+  QFile file(storeFilePath);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    logger.error(QString("Failed to read thumbnail store %1: %2").arg(storeFilePath).arg(file.errorString()));
+    return thumbnails;
+  }
+  QByteArray content = file.read(index->IndexedSize);
+  for (QHash<QString, ThumbnailRecord>::const_iterator it = index->Records.constBegin();
+       it != index->Records.constEnd(); ++it)
+  {
+    thumbnails.insert(it.key(), content.mid(it->DataOffset, it->DataSize));
+  }
+  return thumbnails;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::removeThumbnails(const QString& storeFilePath, const QStringList& keys)
+{
+  QMutexLocker locker(&storeMutex());
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index)
+  {
+    return true;
+  }
+
+  QList<QPair<QString, QByteArray> > records;
+  for (const QString& key : keys)
+  {
+    if (index->Records.contains(key))
+    {
+      records << qMakePair(key, QByteArray());
+    }
+  }
+  if (records.isEmpty())
+  {
+    return true;
+  }
+  if (records.size() == index->Records.size())
+  {
+    storeIndexes().remove(storeFilePath);
+    if (!QFile::remove(storeFilePath))
+    {
+      logger.warn(QString("Failed to remove thumbnail store %1").arg(storeFilePath));
+      return false;
+    }
+    return true;
+  }
+  return appendRecords(storeFilePath, records) && compactIfNeeded(storeFilePath);
+}
+
+//------------------------------------------------------------------------------
+QStringList ctkDICOMThumbnailStore::keys(const QString& storeFilePath)
+{
+  QMutexLocker locker(&storeMutex());
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index)
+  {
+    return QStringList();
+  }
+  return index->Records.keys();
+}
+
+//------------------------------------------------------------------------------
+qint64 ctkDICOMThumbnailStore::thumbnailOffset(const QString& storeFilePath, const QString& key)
+{
+  QMutexLocker locker(&storeMutex());
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index || !index->Records.contains(key))
+  {
+    return -1;
+  }
+  return index->Records[key].DataOffset;
+}
+
+//------------------------------------------------------------------------------
+QDateTime ctkDICOMThumbnailStore::thumbnailDateTime(const QString& storeFilePath, const QString& key)
+{
+  QMutexLocker locker(&storeMutex());
+  StoreIndex* index = updateIndex(storeFilePath);
+  if (!index || !index->Records.contains(key))
+  {
+    return QDateTime();
+  }
+  return QDateTime::fromMSecsSinceEpoch(index->Records[key].DateTime);
+}
+
+//------------------------------------------------------------------------------
+int ctkDICOMThumbnailStore::importThumbnailDirectory(const QString& directory,
+                                                     const QString& storeFilePath,
+                                                     bool removeFiles)
+{
+  QDir thumbnailDirectory(directory);
+  if (!thumbnailDirectory.exists())
+  {
+    return 0;
+  }
+
+  QMap<QString, QByteArray> thumbnails;
+  QStringList thumbnailFilePaths;
+  QDirIterator it(directory, QStringList("*.png"), QDir::Files, QDirIterator::Subdirectories);
+  while (it.hasNext())
+  {
+    QString thumbnailFilePath = it.next();
+    QFile thumbnailFile(thumbnailFilePath);
+    if (!thumbnailFile.open(QIODevice::ReadOnly))
+    {
+      logger.warn(QString("Failed to read thumbnail %1: %2").arg(thumbnailFilePath).arg(thumbnailFile.errorString()));
+      continue;
+    }
+    QString key = thumbnailDirectory.relativeFilePath(thumbnailFilePath);
+    key.chop(QString(".png").size());
+    thumbnails.insert(key, thumbnailFile.readAll());
+    thumbnailFilePaths << thumbnailFilePath;
+  }
+  if (thumbnails.isEmpty())
+  {
+    return 0;
+  }
+  if (!ctkDICOMThumbnailStore::writeThumbnails(storeFilePath, thumbnails))
+  {
+    return -1;
+  }
+
+  if (removeFiles)
+  {
+    QStringList foldersToRemove;
+    for (const QString& thumbnailFilePath : thumbnailFilePaths)
+    {
+      if (!QFile::remove(thumbnailFilePath))
+      {
+        logger.warn(QString("Failed to remove thumbnail %1").arg(thumbnailFilePath));
+        continue;
+      }
+      QString fileFolder = QFileInfo(thumbnailFilePath).absolutePath();
+      if (!foldersToRemove.contains(fileFolder))
+      {
+        foldersToRemove << fileFolder;
+      }
+    }
+    // Folders that still contain files are not removed
+    for (const QString& folderToRemove : foldersToRemove)
+    {
+      QDir().rmpath(folderToRemove);
+    }
+  }
+  return thumbnails.size();
+}
+
+//------------------------------------------------------------------------------
+void ctkDICOMThumbnailStore::clearIndex()
+{
+  QMutexLocker locker(&storeMutex());
+  storeIndexes().clear();
+}
+
+//------------------------------------------------------------------------------
+QString ctkDICOMThumbnailStore::packedThumbnailPath(const QString& storeFilePath, const QString& key)
+{
+  return storeFilePath + "#" + key;
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::isPackedThumbnailPath(const QString& thumbnailPath)
+{
+  QString storeFilePath;
+  QString key;
+  return ctkDICOMThumbnailStore::splitPackedThumbnailPath(thumbnailPath, storeFilePath, key);
+}
+
+//------------------------------------------------------------------------------
+bool ctkDICOMThumbnailStore::splitPackedThumbnailPath(const QString& thumbnailPath, QString& storeFilePath, QString& key)
+{
+  int separatorIndex = thumbnailPath.lastIndexOf('#');
+  if (separatorIndex < 0)
+  {
+    return false;
+  }
+  QString storeFilePathCandidate = thumbnailPath.left(separatorIndex);
+  QString keyCandidate = thumbnailPath.mid(separatorIndex + 1);
+  if (keyCandidate.isEmpty() || !storeFilePathCandidate.endsWith(ctkDICOMThumbnailStore::fileExtension()))
+  {
+    return false;
+  }
+  storeFilePath = storeFilePathCandidate;
+  key = keyCandidate;
+  return true;
+}
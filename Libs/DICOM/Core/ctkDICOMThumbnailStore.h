@@ -0,0 +1,106 @@
+/*=========================================================================
+
+  Library:   CTK
+
+  Copyright (c) Kitware Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=========================================================================*/
+
+#ifndef __ctkDICOMThumbnailStore_h
+#define __ctkDICOMThumbnailStore_h
+
+// Qt includes
+#include <QByteArray>
+#include <QDateTime>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// ctkDICOMCore includes
+#include "ctkDICOMCoreExport.h"
+
+/// \ingroup DICOM_Core
+///
+/// Packed thumbnail container: the encoded thumbnails of a study stored in a single file.
+///
+/// A store file starts with a signature followed by records made of the thumbnail key,
+/// the time it was written and the encoded (PNG) thumbnail. Records are only appended:
+/// a thumbnail that is written again supersedes the previous record with the same key,
+/// and removed thumbnails are recorded with an empty record. The file is compacted
+/// when superseded records take more space than the live ones.
+///
+/// The offset of the thumbnails is indexed in memory the first time a store file is
+/// accessed, and the index is updated incrementally when records are appended, therefore
+/// reading one thumbnail is a single seek and reading all the thumbnails of a study is a
+/// single sequential read.
+///
+/// A thumbnail of a store is referred to with a "packed thumbnail path" made of the store
+/// file path and the key separated by '#' (see packedThumbnailPath()), which can be used
+/// wherever a thumbnail file path is expected by ctkDICOMThumbnailCache.
+///
+/// All methods are thread safe. Store files must not be modified by several processes
+/// at the same time.
+class CTK_DICOM_CORE_EXPORT ctkDICOMThumbnailStore
+{
+public:
+  /// Extension of the store files.
+  static QString fileExtension();
+
+  /// Write (or replace) the thumbnails \a thumbnails (encoded data by key) in
+  /// \a storeFilePath. The file and its directory are created if needed.
+  static bool writeThumbnails(const QString& storeFilePath, const QMap<QString, QByteArray>& thumbnails);
+  static bool writeThumbnail(const QString& storeFilePath, const QString& key, const QByteArray& data);
+
+  /// Return the encoded thumbnail \a key, or an empty array if it is not in the store.
+  static QByteArray readThumbnail(const QString& storeFilePath, const QString& key);
+
+  /// Return all the encoded thumbnails of the store by key.
+  static QMap<QString, QByteArray> readThumbnails(const QString& storeFilePath);
+
+  /// Remove the thumbnails \a keys. The store file is removed when it becomes empty.
+  static bool removeThumbnails(const QString& storeFilePath, const QStringList& keys);
+
+  /// Keys of the thumbnails in the store.
+  static QStringList keys(const QString& storeFilePath);
+
+  /// Offset of thumbnail \a key in the store file, or -1 if it is not in the store.
+  /// The offset changes each time the thumbnail is written, it can be used to detect
+  /// modifications.
+  static qint64 thumbnailOffset(const QString& storeFilePath, const QString& key);
+
+  /// Time thumbnail \a key was written, or an invalid date time if it is not in the store.
+  static QDateTime thumbnailDateTime(const QString& storeFilePath, const QString& key);
+
+  /// Write the PNG files found in \a directory (recursively) in \a storeFilePath.
+  /// The keys are the paths of the files relative to \a directory without the extension.
+  /// If \a removeFiles is true, the files (and the directories left empty) are removed
+  /// once they are stored.
+  /// Return the number of stored thumbnails, or -1 in case of error.
+  static int importThumbnailDirectory(const QString& directory,
+                                      const QString& storeFilePath,
+                                      bool removeFiles = true);
+
+  /// Release the in-memory index of the store files.
+  static void clearIndex();
+
+  ///@{
+  /// Packed thumbnail paths
+  static QString packedThumbnailPath(const QString& storeFilePath, const QString& key);
+  static bool isPackedThumbnailPath(const QString& thumbnailPath);
+  static bool splitPackedThumbnailPath(const QString& thumbnailPath, QString& storeFilePath, QString& key);
+  ///@}
+};
+
+#endif
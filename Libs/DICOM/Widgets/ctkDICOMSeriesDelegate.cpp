@@ -22,7 +22,6 @@
 =========================================================================*/
 
 // Qt includes
-#include <QFile>
 #include <QPainter>
 #include <QPainterPath>
 #include <QApplication>
@@ -46,6 +45,7 @@
 #include "ctkDICOMSeriesDelegate.h"
 #include "ctkDICOMSeriesModel.h"
 #include "ctkDICOMSeriesTableView.h"
+#include "ctkDICOMThumbnailCache.h"
 
 // STD includes
 #include <cmath>
@@ -195,12 +195,11 @@ void ctkDICOMSeriesDelegate::paintThumbnail(QPainter* painter, const QRect& rect
 
   // Get thumbnail data
   QString thumbnailPath = index.data(ctkDICOMSeriesModel::ThumbnailPathRole).toString();
-  QPixmap thumbnail;
-  if (!thumbnailPath.isEmpty() && QFile::exists(thumbnailPath))
-  {
-    thumbnail = QPixmap(thumbnailPath);
-  }
-  else
+  // Decoded in the background and scaled to the rect once: the placeholder is
+  // drawn until the thumbnail is available
+  QColor fillColor = Qt::black;
+  QPixmap thumbnail = ctkDICOMThumbnailCache::instance()->thumbnail(thumbnailPath, rect.size(), &fillColor);
+  if (thumbnail.isNull())
   {
     QSize thumbnailSize(128, 128);
     if (index.model())
@@ -216,7 +215,8 @@ void ctkDICOMSeriesDelegate::paintThumbnail(QPainter* painter, const QRect& rect
     {
       // Create placeholder pixmap with modality text)
       thumbnail = QPixmap(thumbnailSize);
-      thumbnail.fill(Qt::white);
+      fillColor = Qt::white;
+      thumbnail.fill(fillColor);
 
       QPainter painter(&thumbnail);
       painter.setRenderHint(QPainter::Antialiasing);
@@ -252,19 +252,16 @@ void ctkDICOMSeriesDelegate::paintThumbnail(QPainter* painter, const QRect& rect
   // Draw thumbnail or placeholder
   if (!thumbnail.isNull() && thumbnail.width() > 0 && thumbnail.height() > 0)
   {
-    // Get the fill color from the top-left pixel of the original thumbnail
-    QColor fillColor = Qt::black; // Default fallback
-    QImage image = thumbnail.toImage();
-    if (!image.isNull())
-    {
-      fillColor = QColor(image.pixel(0, 0));
-    }
-
     // Fill the entire rect with the background color first
+    // (top-left pixel of the original thumbnail)
     painter->fillRect(rect, fillColor);
 
     // Scale thumbnail to fit while maintaining aspect ratio
-    QPixmap scaledThumbnail = thumbnail.scaled(rect.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QPixmap scaledThumbnail = thumbnail;
+    if (thumbnail.size() != thumbnail.size().scaled(rect.size(), Qt::KeepAspectRatio))
+    {
+      scaledThumbnail = thumbnail.scaled(rect.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
 
     // Center the thumbnail
     QRect thumbRect = rect;
@@ -19,33 +19,30 @@
 
 =============================================================================*/
 
+#ifndef CTKTESTPLUGINLSACTIVATOR_P_H
+#define CTKTESTPLUGINLSACTIVATOR_P_H
 
-#ifndef CTKEATOPICHANDLERFILTERS_P_H
-#define CTKEATOPICHANDLERFILTERS_P_H
+#include <QScopedPointer>
 
-#include <QString>
+#include <ctkPluginLSctivator.h>
+#include <ctkTestPluginLSService.h>
 
-/**
- * The factory for <tt>ctkEventHandler</tt> filters based on a certain topic.
- */
-template<class Impl>
-struct ctkEATopicHandlerFilters
+class ctkTestPluginLSActivator : public QObject,
+                                public ctkPluginLSctivator
 {
-  /**
-   * Create a filter that will match all <tt>ctkEventHandler</tt> services that match
-   * the given topic.
-   *
-   * @param topic The topic to match
-   *
-   * @return A filter that will match all <tt>ctkEventHandler</tt> services for
-   *      the given topic.
-   */
-  QString createFilterForTopic(const QString& topic)
-  {
-    return static_cast<Impl*>(this)->createFilterForTopic(topic);
-  }
-
-  virtual ~ctkEATopicHandlerFilters() {}
+  Q_OBJECT
+  Q_INTERFACES(ctkPluginLSctivator)
+  Q_PLUGIN_METADATA(IID "pluginLS_test")
+
+public:
+
+  void start(ctkPluginContext* context);
+  void stop(ctkPluginContext* context);
+
+private:
+
+  QScopedPointer<ctkTestPluginLSService> s;
+
 };
 
-#endif // CTKEATOPICHANDLERFILTERS_P_H
+#endif // CTKTESTPLUGINLSACTIVATOR_P_H
@@ -0,0 +1,35 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+#ifndef CTKTESTPLUGINLSSERVICE_H
+#define CTKTESTPLUGINLSSERVICE_H
+
+#include <qglobal.h>
+
+struct ctkTestPluginLSService
+{
+  virtual ~ctkTestPluginLSService() {}
+};
+
+Q_DECLARE_INTERFACE(ctkTestPluginLSService, "org.commontk.pluginLStest.TestPluginLSService")
+
+#endif // CTKTESTPLUGINLSSERVICE_H
@@ -0,0 +1,8 @@
+set(Plugin-Name "pluginLS_test")
+set(Plugin-Version "1.0.0")
+set(Plugin-Description "Test plugin for framework, lazy pluginLS_test declaring its service")
+set(Plugin-Vendor "CommonTK")
+set(Plugin-ContactAddress "http://commontk.org")
+set(Plugin-Category "test")
+set(Provide-Service "org.commontk.pluginLStest.TestPluginLSService;service.ranking=5")
+set(Custom-Headers "Provide-Service")
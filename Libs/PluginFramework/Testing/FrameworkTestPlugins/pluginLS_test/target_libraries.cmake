@@ -0,0 +1,9 @@
+#
+# See CMake/ctkFunctionGetTargetLibraries.cmake
+#
+# This file should list the libraries required to build the current CTK plugin.
+#
+
+set(target_libraries
+  CTKPluginFramework
+  )
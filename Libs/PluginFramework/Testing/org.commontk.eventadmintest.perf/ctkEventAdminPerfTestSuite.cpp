@@ -56,6 +56,8 @@ ctkEventAdminPerfTestSuite::ctkEventAdminPerfTestSuite(ctkPluginContext *context
   , nHandlers(40)
   , nEvent1Handled(0)
   , nEvent2Handled(0)
+  , nTopics(100)
+  , nTopicEventsHandled(0)
   , eventAdmin(0)
 {
 }
@@ -88,6 +90,42 @@ void ctkEventAdminPerfTestSuite::addHandlers()
   }
 }
 
+//----------------------------------------------------------------------------
+void ctkEventAdminPerfTestSuite::addTopicHandlers()
+{
+  qDebug() << "Adding" << nTopics * 5 << "event handlers for" << nTopics << "topics";
+  for (int i = 0; i < nTopics; ++i)
+  {
+    // Handlers of one topic, half of them with a filter
+    for (int j = 0; j < 4; ++j)
+    {
+      TestEventHandler* h = new TestEventHandler(nTopicEventsHandled);
+      handlers.push_back(h);
+      ctkDictionary props;
+      props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/perf/%1").arg(i));
+      if (j % 2)
+      {
+        props.insert(ctkEventConstants::EVENT_FILTER, "(level>=0)");
+      }
+      handlerRegistrations.push_back(pc->registerService<ctkEventHandler>(h, props));
+    }
+
+    // Handlers of the sub-topics of another topic
+    TestEventHandler* h = new TestEventHandler(nTopicEventsHandled);
+    handlers.push_back(h);
+    ctkDictionary props;
+    props.insert(ctkEventConstants::EVENT_TOPIC, QString("org/commontk/other/%1/*").arg(i));
+    handlerRegistrations.push_back(pc->registerService<ctkEventHandler>(h, props));
+  }
+
+  // Handlers of all the topics
+  TestEventHandler* h = new TestEventHandler(nTopicEventsHandled);
+  handlers.push_back(h);
+  ctkDictionary props;
+  props.insert(ctkEventConstants::EVENT_TOPIC, "org/commontk/*");
+  handlerRegistrations.push_back(pc->registerService<ctkEventHandler>(h, props));
+}
+
 //----------------------------------------------------------------------------
 void ctkEventAdminPerfTestSuite::removeHandlers()
 {
@@ -185,6 +223,43 @@ void ctkEventAdminPerfTestSuite::testPostEvents()
   QTest::qWait(10000);
 }
 
+//----------------------------------------------------------------------------
+void ctkEventAdminPerfTestSuite::testSendEventsManyTopics()
+{
+  // Replace the handlers of the previous tests
+  removeHandlers();
+  addTopicHandlers();
+  nTopicEventsHandled = 0;
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 14, 0))
+  QElapsedTimer t;
+#else
+  QTime t;
+#endif
+  t.start();
+  for (int i = 0; i < nSendEvents; ++i)
+  {
+    ctkDictionary props;
+    props.insert("level", i);
+    ctkEvent event(QString("org/commontk/perf/%1").arg(i % nTopics), props);
+    eventAdmin->sendEvent(event);
+  }
+  int ms = t.elapsed();
+
+  // Each event is handled by the 4 handlers of its topic and the handler of all the topics
+  QCOMPARE(nTopicEventsHandled, nSendEvents * 5);
+  qDebug() << "Sending" << nSendEvents << "synchronous events to" << handlers.size()
+           << "event handlers took" << ms << "ms"
+           << "(" << (nSendEvents * 1000.0 / qMax(ms, 1)) << "events/s )";
+
+  // Events of a sub-topic
+  nTopicEventsHandled = 0;
+  eventAdmin->sendEvent(ctkEvent("org/commontk/other/7/sub"));
+  QCOMPARE(nTopicEventsHandled, 2);
+  eventAdmin->sendEvent(ctkEvent("org/commontk/other/7"));
+  QCOMPARE(nTopicEventsHandled, 3);
+}
+
 //----------------------------------------------------------------------------
 void ctkEventAdminPerfTestSuite::cleanupTestCase()
 {
@@ -48,6 +48,9 @@ private:
   int nEvent1Handled;
   int nEvent2Handled;
 
+  int nTopics;
+  int nTopicEventsHandled;
+
   ctkEventAdmin* eventAdmin;
 
   QList<ctkEventHandler*> handlers;
@@ -65,11 +68,14 @@ private:
   void sendEvents();
   void postEvents();
 
+  void addTopicHandlers();
+
 private Q_SLOTS:
 
   void initTestCase();
   void testSendEvents();
   void testPostEvents();
+  void testSendEventsManyTopics();
   void cleanupTestCase();
 };
 
@@ -24,13 +24,46 @@
 
 #include <ctkPluginContext.h>
 #include <ctkHighPrecisionTimer.h>
+#include <ctkLDAPSearchFilter.h>
 
 #undef REGISTERED
 #include <ctkServiceEvent.h>
 
+#include <QAtomicInt>
 #include <QTest>
+#include <QThread>
 #include <QDebug>
 
+namespace {
+
+//----------------------------------------------------------------------------
+class ctkServiceLookupThread : public QThread
+{
+public:
+
+  ctkServiceLookupThread(ctkPluginContext* pc, QAtomicInt& stop)
+    : pc(pc), stop(stop), lookups(0)
+  {}
+
+  ctkPluginContext* pc;
+  QAtomicInt& stop;
+  qint64 lookups;
+
+protected:
+
+  void run() override
+  {
+    while (!stop.loadAcquire())
+    {
+      pc->getServiceReference<IPerfTestService>();
+      pc->getServiceReferences<IPerfTestService>("(service.pid=my.service.1)");
+      lookups += 2;
+    }
+  }
+};
+
+}
+
 //----------------------------------------------------------------------------
 ctkPluginFrameworkPerfRegistryTestSuite::ctkPluginFrameworkPerfRegistryTestSuite(ctkPluginContext* context)
   : QObject(0)
@@ -136,6 +169,68 @@ void ctkPluginFrameworkPerfRegistryTestSuite::registerServices(int n)
   }
 }
 
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfRegistryTestSuite::testGetServiceReferences()
+{
+  int n = 1000;
+  log() << "getting service references with a filter" << n << "times";
+
+  ctkHighPrecisionTimer t;
+  t.start();
+  for(int i = 0; i < n; i++)
+  {
+    QList<ctkServiceReference> refs =
+        pc->getServiceReferences<IPerfTestService>("(service.pid=my.service.500)");
+    QCOMPARE(refs.size(), 1);
+  }
+  int ms = t.elapsedMilli();
+  log() << "get service references took" << ms << "ms";
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfRegistryTestSuite::testFilterMatches()
+{
+  int n = 100000;
+  ctkDictionary props;
+  props.insert("service.pid", "my.service.42");
+  props.insert("perf.service.value", 42);
+  props.insert("perf.service.name", "PerfTestService");
+
+  QStringList filters;
+  filters << "(perf.service.value>=0)"
+          << "(&(Perf.Service.Name=PerfTestService)(service.pid=my.service.42))"
+          << "(|(service.pid=my.service.1*)(perf.service.value=42))"
+          << "(&(!(service.pid=other))(perf.service.name=Perf*)(service.pid=my.service.42))";
+
+  foreach(QString filterString, filters)
+  {
+    ctkHighPrecisionTimer t;
+    t.start();
+    for(int i = 0; i < n; i++)
+    {
+      ctkLDAPSearchFilter filter(filterString);
+      Q_UNUSED(filter)
+    }
+    int parseMs = t.elapsedMilli();
+
+    ctkLDAPSearchFilter filter(filterString);
+    int nMatched = 0;
+    t.start();
+    for(int i = 0; i < n; i++)
+    {
+      if (filter.match(props))
+      {
+        ++nMatched;
+      }
+    }
+    int matchMs = t.elapsedMilli();
+    QCOMPARE(nMatched, n);
+
+    log() << filterString << ":" << (n * 1000.0 / qMax(parseMs, 1)) << "parses/s,"
+          << (n * 1000.0 / qMax(matchMs, 1)) << "matches/s";
+  }
+}
+
 //----------------------------------------------------------------------------
 void ctkPluginFrameworkPerfRegistryTestSuite::testModifyServices()
 {
@@ -195,6 +290,43 @@ void ctkPluginFrameworkPerfRegistryTestSuite::unregisterServices()
 }
 
 
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkPerfRegistryTestSuite::testConcurrentLookups()
+{
+  int nThreads = qMax(2, QThread::idealThreadCount());
+  int n = 200;
+  log() << "looking up services in" << nThreads << "threads while registering"
+        << n << "services";
+
+  QAtomicInt stop(0);
+  QList<ctkServiceLookupThread*> threads;
+  for(int i = 0; i < nThreads; i++)
+  {
+    threads.push_back(new ctkServiceLookupThread(pc, stop));
+    threads.back()->start();
+  }
+
+  ctkHighPrecisionTimer t;
+  t.start();
+  registerServices(n);
+  unregisterServices();
+  int ms = t.elapsedMilli();
+  stop.storeRelease(1);
+
+  qint64 lookups = 0;
+  foreach(ctkServiceLookupThread* thread, threads)
+  {
+    thread->wait();
+    lookups += thread->lookups;
+  }
+  qDeleteAll(threads);
+  qDeleteAll(services);
+  services.clear();
+
+  log() << "register and unregister took" << ms << "ms,"
+        << (lookups * 1000.0 / qMax(ms, 1)) << "lookups/s";
+}
+
 //----------------------------------------------------------------------------
 ctkServiceListener::ctkServiceListener(ctkPluginFrameworkPerfRegistryTestSuite* ts)
   : ts(ts)
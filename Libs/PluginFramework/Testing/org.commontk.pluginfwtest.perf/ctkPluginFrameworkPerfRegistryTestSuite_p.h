@@ -78,9 +78,13 @@ private Q_SLOTS:
 
   void testAddListeners();
   void testRegisterServices();
+  void testGetServiceReferences();
+  void testFilterMatches();
 
   void testModifyServices();
   void testUnregisterServices();
+
+  void testConcurrentLookups();
 };
 
 class ctkServiceListener : public QObject
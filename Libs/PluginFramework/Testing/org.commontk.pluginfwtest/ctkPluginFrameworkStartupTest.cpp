@@ -0,0 +1,236 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include <ctkPlugin.h>
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <ctkPluginEvent.h>
+#include <ctkPluginException.h>
+#include <ctkPluginFramework.h>
+#include <ctkPluginFrameworkEvent.h>
+#include <ctkPluginFrameworkFactory.h>
+
+#include <ctkPluginFrameworkTestUtil.h>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+
+//----------------------------------------------------------------------------
+/**
+ * Starts a framework whose plug-ins are started on launch, sequentially and
+ * in parallel, and checks the start order and the startup trace.
+ *
+ * The plug-ins are installed so that pluginSL3_test and pluginSL4_test, which
+ * require pluginSL1_test, come before it in the list of plug-ins to start.
+ */
+class ctkPluginFrameworkStartupTest : public QObject
+{
+  Q_OBJECT
+
+public Q_SLOTS:
+
+  void pluginChanged(const ctkPluginEvent& event);
+
+private Q_SLOTS:
+
+  void initTestCase();
+
+  void testSequentialStart();
+  void testParallelStart();
+
+private:
+
+  QString pluginDir;
+  QTemporaryDir storageDir;
+
+  /** Symbolic names of the started plug-ins, in start order */
+  QStringList startedPlugins;
+
+  ctkProperties frameworkProperties() const;
+
+  /**
+   * Start a framework from the storage prepared by initTestCase(), and
+   * record the plug-ins started on launch.
+   */
+  void launch(const ctkProperties& props);
+
+  void verifyStartOrder() const;
+};
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkStartupTest::pluginChanged(const ctkPluginEvent& event)
+{
+  if (event.getType() == ctkPluginEvent::STARTED)
+  {
+    startedPlugins.push_back(event.getPlugin()->getSymbolicName());
+  }
+}
+
+//----------------------------------------------------------------------------
+ctkProperties ctkPluginFrameworkStartupTest::frameworkProperties() const
+{
+  ctkProperties props;
+  props.insert(ctkPluginConstants::FRAMEWORK_STORAGE, storageDir.path());
+  props.insert("pluginfw.testDir", pluginDir);
+
+#if defined(Q_CC_GNU) && ((__GNUC__ < 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ < 5)))
+  props.insert(ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS, QVariant::fromValue<QLibrary::LoadHints>(QLibrary::ExportExternalSymbolsHint));
+#endif
+
+  return props;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkStartupTest::initTestCase()
+{
+#ifdef CMAKE_INTDIR
+  pluginDir = qApp->applicationDirPath() + "/../test_plugins/" CMAKE_INTDIR "/";
+#else
+  pluginDir = qApp->applicationDirPath() + "/test_plugins/";
+#endif
+  QVERIFY(storageDir.isValid());
+
+  // Record the plug-ins to start on launch in the framework storage
+  ctkProperties props = frameworkProperties();
+  props.insert(ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN, ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT);
+  QScopedPointer<ctkPluginFrameworkFactory> fwFactory(new ctkPluginFrameworkFactory(props));
+  QSharedPointer<ctkPluginFramework> framework = fwFactory->getFramework();
+  try
+  {
+    framework->start();
+    ctkPluginContext* pc = framework->getPluginContext();
+
+    QList<QSharedPointer<ctkPlugin> > plugins;
+    plugins << ctkPluginFrameworkTestUtil::installPlugin(pc, "pluginSL3_test");
+    plugins << ctkPluginFrameworkTestUtil::installPlugin(pc, "pluginA_test");
+    plugins << ctkPluginFrameworkTestUtil::installPlugin(pc, "pluginSL4_test");
+    plugins << ctkPluginFrameworkTestUtil::installPlugin(pc, "pluginSL1_test");
+
+    // Start the required plug-in first, since starting the other plug-ins
+    // starts it transiently
+    plugins.back()->start();
+    foreach(QSharedPointer<ctkPlugin> plugin, plugins)
+    {
+      plugin->start();
+    }
+  }
+  catch (const ctkPluginException& pe)
+  {
+    QFAIL(qPrintable(QString("Preparing the framework storage failed: ") + pe.what()));
+  }
+
+  framework->stop();
+  framework->waitForStop(5000);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkStartupTest::launch(const ctkProperties& props)
+{
+  startedPlugins.clear();
+
+  QScopedPointer<ctkPluginFrameworkFactory> fwFactory(new ctkPluginFrameworkFactory(props));
+  QSharedPointer<ctkPluginFramework> framework = fwFactory->getFramework();
+  try
+  {
+    framework->init();
+    framework->getPluginContext()->connectPluginListener(this, SLOT(pluginChanged(ctkPluginEvent)), Qt::DirectConnection);
+    framework->start();
+  }
+  catch (const ctkPluginException& pe)
+  {
+    QFAIL(qPrintable(QString("Starting the framework failed: ") + pe.what()));
+  }
+  QCOMPARE(framework->getState(), ctkPlugin::ACTIVE);
+
+  framework->stop();
+  framework->waitForStop(5000);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkStartupTest::verifyStartOrder() const
+{
+  QCOMPARE(startedPlugins.size(), 4);
+
+  // All plug-ins have the default start level, so the launch order is kept
+  // except for the plug-ins required by a plug-in started before them
+  QStringList expected;
+  expected << "pluginSL1.test" << "pluginSL3.test" << "pluginA.test" << "pluginSL4.test";
+  QCOMPARE(startedPlugins, expected);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkStartupTest::testSequentialStart()
+{
+  launch(frameworkProperties());
+  verifyStartOrder();
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginFrameworkStartupTest::testParallelStart()
+{
+  launch(frameworkProperties());
+  const QStringList sequentialPlugins = startedPlugins;
+
+  const QString traceFile = storageDir.filePath("startup_trace.json");
+  ctkProperties props = frameworkProperties();
+  props.insert(ctkPluginConstants::FRAMEWORK_PARALLEL_START, true);
+  props.insert(ctkPluginConstants::FRAMEWORK_STARTUP_TRACE, traceFile);
+  launch(props);
+
+  QCOMPARE(QSet<QString>(startedPlugins.begin(), startedPlugins.end()),
+           QSet<QString>(sequentialPlugins.begin(), sequentialPlugins.end()));
+  verifyStartOrder();
+
+  QFile file(traceFile);
+  QVERIFY2(file.open(QIODevice::ReadOnly), "Startup trace not written");
+  QJsonParseError error;
+  QJsonDocument trace = QJsonDocument::fromJson(file.readAll(), &error);
+  QVERIFY2(error.error == QJsonParseError::NoError, qPrintable(error.errorString()));
+  QVERIFY(trace.isObject());
+
+  // Each started plug-in has complete events for the three phases
+  QSet<QString> eventNames;
+  foreach(const QJsonValue& value, trace.object().value("traceEvents").toArray())
+  {
+    QJsonObject event = value.toObject();
+    QCOMPARE(event.value("ph").toString(), QString("X"));
+    QVERIFY(event.value("dur").toDouble() >= 0);
+    eventNames.insert(event.value("name").toString());
+  }
+  foreach(const QString& symbolicName, startedPlugins)
+  {
+    QVERIFY2(eventNames.contains("resolve " + symbolicName), qPrintable(symbolicName));
+    QVERIFY2(eventNames.contains("load " + symbolicName), qPrintable(symbolicName));
+    QVERIFY2(eventNames.contains("activate " + symbolicName), qPrintable(symbolicName));
+  }
+  QVERIFY(trace.object().value("otherData").isObject());
+}
+
+// ----------------------------------------------------------------------------
+QTEST_GUILESS_MAIN(ctkPluginFrameworkStartupTest)
+#include "ctkPluginFrameworkStartupTest.moc"
@@ -26,6 +26,7 @@
 #include <ctkPluginConstants.h>
 #include <ctkPluginException.h>
 #include <ctkServiceException.h>
+#include <ctkServiceTracker.h>
 
 #include <QDir>
 #include <QTest>
@@ -539,6 +540,99 @@ void ctkPluginFrameworkTestSuite::frame070a()
   QVERIFY2(versionA1 != versionA, "framework test plug-in, update of plug-in failed, version info unchanged :FRAME070A:Fail");
 }
 
+//----------------------------------------------------------------------------
+// Starts the lazy pluginLS_test and checks that the service declared in its
+// manifest is registered before the plug-in library is loaded, and that
+// getting the service activates the plug-in.
+void ctkPluginFrameworkTestSuite::frame080a()
+{
+  const QString lsService = "org.commontk.pluginLStest.TestPluginLSService";
+  QSharedPointer<ctkPlugin> pLS;
+
+  try
+  {
+    pLS = ctkPluginFrameworkTestUtil::installPlugin(pc, "pluginLS_test");
+    pLS->start(ctkPlugin::START_ACTIVATION_POLICY);
+  }
+  catch (const ctkPluginException& pe)
+  {
+    qDebug() << "framework test plugin" << pe << ":FRAME080A:FAIL";
+    QFAIL("framework test plug-in, install or start of pluginLS_test failed :FRAME080A:FAIL");
+  }
+
+  QVERIFY2(pLS->getState() == ctkPlugin::STARTING,
+           "framework test plug-in, pluginLS_test should wait for lazy activation :FRAME080A:FAIL");
+
+  ctkServiceReference sr = pc->getServiceReference(lsService);
+  QVERIFY2(sr, "framework test plug-in, declared service of pluginLS_test not registered :FRAME080A:FAIL");
+  QVERIFY(sr.getPlugin() == pLS);
+  QCOMPARE(sr.getProperty(ctkPluginConstants::SERVICE_RANKING).toInt(), 5);
+  QVERIFY(!sr.getProperty("activated").toBool());
+  const qlonglong serviceId = sr.getProperty(ctkPluginConstants::SERVICE_ID).toLongLong();
+
+  QObject* service = pc->getService(sr);
+  QVERIFY2(service, "framework test plug-in, no service object for the declared service :FRAME080A:FAIL");
+  QVERIFY(service->inherits(lsService.toLatin1()));
+  QVERIFY2(pLS->getState() == ctkPlugin::ACTIVE,
+           "framework test plug-in, pluginLS_test not activated by getService :FRAME080A:FAIL");
+
+  // The service registered by the activator is bound to the declared one
+  QCOMPARE(pc->getServiceReferences(lsService).size(), 1);
+  QCOMPARE(sr.getProperty(ctkPluginConstants::SERVICE_ID).toLongLong(), serviceId);
+  QCOMPARE(sr.getProperty(ctkPluginConstants::SERVICE_RANKING).toInt(), 5);
+  QVERIFY(sr.getProperty("activated").toBool());
+  pc->ungetService(sr);
+
+  pLS->stop();
+  QVERIFY2(!pc->getServiceReference(lsService),
+           "framework test plug-in, service of pluginLS_test still registered after stop :FRAME080A:FAIL");
+  pLS->uninstall();
+}
+
+//----------------------------------------------------------------------------
+// Opens a service tracker on the service declared by pluginLS_test before
+// starting it. The tracker gets the service as soon as it is registered,
+// which activates the plug-in immediately; the service registered by the
+// activator must still be bound to the declared one.
+void ctkPluginFrameworkTestSuite::frame085a()
+{
+  const QString lsService = "org.commontk.pluginLStest.TestPluginLSService";
+  ctkServiceTracker<> tracker(pc, lsService);
+  tracker.open();
+  QVERIFY(tracker.isEmpty());
+
+  QSharedPointer<ctkPlugin> pLS;
+  try
+  {
+    pLS = ctkPluginFrameworkTestUtil::installPlugin(pc, "pluginLS_test");
+    pLS->start(ctkPlugin::START_ACTIVATION_POLICY);
+  }
+  catch (const ctkPluginException& pe)
+  {
+    qDebug() << "framework test plugin" << pe << ":FRAME085A:FAIL";
+    QFAIL("framework test plug-in, install or start of pluginLS_test failed :FRAME085A:FAIL");
+  }
+
+  QVERIFY2(pLS->getState() == ctkPlugin::ACTIVE,
+           "framework test plug-in, pluginLS_test not activated by the service tracker :FRAME085A:FAIL");
+  QCOMPARE(tracker.size(), 1);
+  QVERIFY2(tracker.getService(),
+           "framework test plug-in, no service object in the service tracker :FRAME085A:FAIL");
+
+  QList<ctkServiceReference> srs = pc->getServiceReferences(lsService);
+  QVERIFY2(srs.size() == 1,
+           "framework test plug-in, declared service of pluginLS_test registered twice :FRAME085A:FAIL");
+  QCOMPARE(srs.front().getProperty(ctkPluginConstants::SERVICE_RANKING).toInt(), 5);
+  QVERIFY(srs.front().getProperty("activated").toBool());
+  QVERIFY(tracker.getServiceReference() == srs.front());
+
+  tracker.close();
+  pLS->stop();
+  QVERIFY2(!pc->getServiceReference(lsService),
+           "framework test plug-in, service of pluginLS_test still registered after stop :FRAME085A:FAIL");
+  pLS->uninstall();
+}
+
 //----------------------------------------------------------------------------
 void ctkPluginFrameworkTestSuite::frameworkListener(const ctkPluginFrameworkEvent& fwEvent)
 {
@@ -23,10 +23,12 @@ limitations under the License.
 
 #include <ctkException.h>
 
+#include <QMutex>
 #include <QSet>
 #include <QVariant>
 #include <QStringList>
 
+#include <algorithm>
 #include <stdexcept>
 
 const int ctkLDAPExpr::AND     =  0;
@@ -99,19 +101,23 @@ class ctkLDAPExprData : public QSharedData
 public:
 
   ctkLDAPExprData( int op, QList<ctkLDAPExpr> args )
-    : m_operator(op), m_args(args)
+    : m_operator(op), m_args(args), m_evalArgs(args), m_cost(1),
+    m_hasWildcard(false), m_isPresence(false)
   {
   }
 
   ctkLDAPExprData( int op, QString attrName, QString attrValue )
-    : m_operator(op), m_attrName(attrName), m_attrValue(attrValue)
+    : m_operator(op), m_attrName(attrName), m_attrValue(attrValue), m_cost(1),
+    m_hasWildcard(false), m_isPresence(false)
   {
   }
 
   ctkLDAPExprData( const ctkLDAPExprData& other )
     : QSharedData(other), m_operator(other.m_operator),
     m_args(other.m_args), m_attrName(other.m_attrName),
-    m_attrValue(other.m_attrValue)
+    m_attrValue(other.m_attrValue), m_evalArgs(other.m_evalArgs),
+    m_cost(other.m_cost), m_hasWildcard(other.m_hasWildcard),
+    m_isPresence(other.m_isPresence), m_approxValue(other.m_approxValue)
   {
   }
 
@@ -123,8 +129,34 @@ public:
   QString m_attrName;
   //!
   QString m_attrValue;
+
+  //! The arguments in evaluation order, cheapest first
+  QList<ctkLDAPExpr> m_evalArgs;
+  //! Estimated evaluation cost of the expression
+  int m_cost;
+  //! True if the attribute value contains a wildcard
+  bool m_hasWildcard;
+  //! True if the expression only checks the presence of the attribute
+  bool m_isPresence;
+  //! The attribute value prepared for approximate comparisons
+  QString m_approxValue;
 };
 
+namespace {
+
+//! Process-wide cache of the parsed filter strings
+struct ctkLDAPExprCache
+{
+  static const int MaximumSize = 1024;
+
+  QMutex mutex;
+  QHash<QString, ctkLDAPExpr> exprs;
+};
+
+Q_GLOBAL_STATIC(ctkLDAPExprCache, ldapExprCache)
+
+}
+
 //----------------------------------------------------------------------------
 ctkLDAPExpr::ctkLDAPExpr()
 {
@@ -133,6 +165,31 @@ ctkLDAPExpr::ctkLDAPExpr()
 
 //----------------------------------------------------------------------------
 ctkLDAPExpr::ctkLDAPExpr( const QString &filter )
+{
+  ctkLDAPExprCache* cache = ldapExprCache();
+  {
+    QMutexLocker lock(&cache->mutex);
+    d = cache->exprs.value(filter).d;
+  }
+  if (d)
+  {
+    return;
+  }
+
+  // Invalid filter strings throw and are not cached
+  ctkLDAPExpr expr = parse(filter);
+
+  QMutexLocker lock(&cache->mutex);
+  if (cache->exprs.size() >= ctkLDAPExprCache::MaximumSize)
+  {
+    cache->exprs.clear();
+  }
+  cache->exprs.insert(filter, expr);
+  d = expr.d;
+}
+
+//----------------------------------------------------------------------------
+ctkLDAPExpr ctkLDAPExpr::parse( const QString &filter )
 {
   ParseState ps(filter);
 
@@ -151,19 +208,36 @@ ctkLDAPExpr::ctkLDAPExpr( const QString &filter )
     ps.error(GARBAGE + " '" + ps.rest() + "'");
   }
 
-  d = expr.d;
+  return expr;
 }
 
 //----------------------------------------------------------------------------
 ctkLDAPExpr::ctkLDAPExpr( int op, const QList<ctkLDAPExpr> &args )
   : d(new ctkLDAPExprData(op, args))
 {
+  // AND and OR stop at the first deciding argument, evaluate the cheap ones first
+  std::stable_sort(d->m_evalArgs.begin(), d->m_evalArgs.end(),
+                   [](const ctkLDAPExpr& a, const ctkLDAPExpr& b) { return a.d->m_cost < b.d->m_cost; });
+  for (int i = 0; i < args.size(); i++)
+  {
+    d->m_cost += args[i].d->m_cost;
+  }
 }
 
 //----------------------------------------------------------------------------
 ctkLDAPExpr::ctkLDAPExpr( int op, const QString &attrName, const QString &attrValue )
   : d(new ctkLDAPExprData(op, attrName, attrValue))
 {
+  d->m_isPresence = (op == EQ && attrValue == WILDCARD_QString);
+  d->m_hasWildcard = attrValue.contains(WILDCARD);
+  if (op == APPROX)
+  {
+    d->m_approxValue = fixupString(attrValue);
+  }
+  if ((op != EQ || d->m_hasWildcard) && !d->m_isPresence)
+  {
+    d->m_cost = 2;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -282,40 +356,90 @@ bool ctkLDAPExpr::query( const QString &filter, const ctkDictionary &pd )
 
 //----------------------------------------------------------------------------
 bool ctkLDAPExpr::evaluate( const ctkServiceProperties &p, bool matchCase ) const
+{
+  return evaluateProperties(p, matchCase);
+}
+
+//----------------------------------------------------------------------------
+bool ctkLDAPExpr::evaluate( const ctkDictionary &p, bool matchCase ) const
+{
+  return evaluateProperties(p, matchCase);
+}
+
+//----------------------------------------------------------------------------
+int ctkLDAPExpr::cacheSize()
+{
+  ctkLDAPExprCache* cache = ldapExprCache();
+  QMutexLocker lock(&cache->mutex);
+  return cache->exprs.size();
+}
+
+//----------------------------------------------------------------------------
+void ctkLDAPExpr::clearCache()
+{
+  ctkLDAPExprCache* cache = ldapExprCache();
+  QMutexLocker lock(&cache->mutex);
+  cache->exprs.clear();
+}
+
+//----------------------------------------------------------------------------
+template<class Properties>
+bool ctkLDAPExpr::evaluateProperties( const Properties &p, bool matchCase ) const
 {
   if ((d->m_operator & SIMPLE) != 0) {
-    // try case sensitive match first
-    int index = p.findCaseSensitive(d->m_attrName);
-    if (index < 0 && !matchCase) index = p.find(d->m_attrName);
-    return index < 0 ? false : compare(p.value(index), d->m_operator, d->m_attrValue);
+    return compare(findValue(p, d->m_attrName, matchCase), d->m_operator, d->m_attrValue);
   } else { // (d->m_operator & COMPLEX) != 0
     switch (d->m_operator) {
     case AND:
-      for (int i = 0; i < d->m_args.length( ); i++) {
-        if (!d->m_args[i].evaluate(p, matchCase))
+      for (int i = 0; i < d->m_evalArgs.length( ); i++) {
+        if (!d->m_evalArgs[i].evaluateProperties(p, matchCase))
           return false;
       }
       return true;
     case OR:
-      for (int i = 0; i < d->m_args.length( ); i++) {
-        if (d->m_args[i].evaluate(p, matchCase))
+      for (int i = 0; i < d->m_evalArgs.length( ); i++) {
+        if (d->m_evalArgs[i].evaluateProperties(p, matchCase))
           return true;
       }
       return false;
     case NOT:
-      return !d->m_args[0].evaluate(p, matchCase);
+      return !d->m_args[0].evaluateProperties(p, matchCase);
     default:
       return false; // Cannot happen
     }
   }
 }
 
+//----------------------------------------------------------------------------
+QVariant ctkLDAPExpr::findValue( const ctkServiceProperties &p, const QString &key, bool matchCase )
+{
+  // try case sensitive match first
+  int index = p.findCaseSensitive(key);
+  if (index < 0 && !matchCase) index = p.find(key);
+  return p.value(index);
+}
+
+//----------------------------------------------------------------------------
+QVariant ctkLDAPExpr::findValue( const ctkDictionary &p, const QString &key, bool matchCase )
+{
+  // try case sensitive match first
+  ctkDictionary::const_iterator it = p.constFind(key);
+  if (it != p.constEnd()) return it.value();
+  if (!matchCase) {
+    for (it = p.constBegin(); it != p.constEnd(); ++it) {
+      if (it.key().compare(key, Qt::CaseInsensitive) == 0)
+        return it.value();
+    }
+  }
+  return QVariant();
+}
+
 //----------------------------------------------------------------------------
 bool ctkLDAPExpr::compare( const QVariant &obj, int op, const QString &s ) const
 {
   if (obj.isNull())
     return false;
-  if (op == EQ && s == WILDCARD_QString )
+  if (d->m_isPresence)
     return true;
   try {
     if ( obj.canConvert<QString>( ) ) {
@@ -384,7 +508,7 @@ bool ctkLDAPExpr::compare( const QVariant &obj, int op, const QString &s ) const
 }
 
 //----------------------------------------------------------------------------
-bool ctkLDAPExpr::compareString( const QString &s1, int op, const QString &s2 )
+bool ctkLDAPExpr::compareString( const QString &s1, int op, const QString &s2 ) const
 {
   switch(op) {
   case LE:
@@ -392,9 +516,10 @@ bool ctkLDAPExpr::compareString( const QString &s1, int op, const QString &s2 )
   case GE:
     return s1.compare(s2) >= 0;
   case EQ:
-    return patSubstr(s1,s2);
+    // values without wildcard do not need pattern matching
+    return d->m_hasWildcard ? patSubstr(s1,s2) : (!s1.isNull() && s1 == s2);
   case APPROX:
-    return fixupString(s2) == fixupString(s1);
+    return d->m_approxValue == fixupString(s1);
   default:
     return false;
   }
@@ -64,7 +64,13 @@ public:
    */
   ctkLDAPExpr();
 
-  //!
+  /**
+   * Parses the given filter string. Parsed expressions are kept in a process-wide
+   * cache keyed by the filter string, so that parsing a filter string again only
+   * costs a lookup.
+   *
+   * @throws ctkInvalidArgumentException if the filter string is invalid.
+   */
   ctkLDAPExpr(const QString &filter);
 
   //!
@@ -126,6 +132,18 @@ public:
   //! Evaluate this LDAP filter.
   bool evaluate(const ctkServiceProperties &p, bool matchCase) const;
 
+  /**
+   * Evaluate this LDAP filter against a dictionary. Unlike converting the
+   * dictionary to ctkServiceProperties, the keys are looked up in place.
+   */
+  bool evaluate(const ctkDictionary &p, bool matchCase) const;
+
+  //! Number of parsed expressions in the filter string cache.
+  static int cacheSize();
+
+  //! Remove all the parsed expressions from the filter string cache.
+  static void clearCache();
+
   //!
   const QString toString() const;
 
@@ -140,17 +158,30 @@ private:
   //!
   ctkLDAPExpr(int op, const QString &attrName, const QString &attrValue);
 
+  //!
+  static ctkLDAPExpr parse(const QString &filter);
+
   //!
   static ctkLDAPExpr parseExpr(ParseState &ps);
 
   //!
   static ctkLDAPExpr parseSimple(ParseState &ps);
 
+  //!
+  template<class Properties>
+  bool evaluateProperties(const Properties &p, bool matchCase) const;
+
+  //!
+  static QVariant findValue(const ctkServiceProperties &p, const QString &key, bool matchCase);
+
+  //!
+  static QVariant findValue(const ctkDictionary &p, const QString &key, bool matchCase);
+
   //!
   bool compare(const QVariant &obj, int op, const QString &s) const;
 
   //!
-  static bool compareString(const QString &s1, int op, const QString &s2);
+  bool compareString(const QString &s1, int op, const QString &s2) const;
 
   //!
   static QString fixupString(const QString &s);
@@ -107,6 +107,9 @@ void ctkPlugin::start(const StartOptions& options)
     d->pluginContext.reset(new ctkPluginContext(this->d_func()));
     ctkPluginEvent pluginEvent(ctkPluginEvent::LAZY_ACTIVATION, d->q_ptr);
     d->fwCtx->listeners.emitPluginChanged(pluginEvent);
+    // Declared services are available before the plugin is activated.
+    // Announcing them may already activate the plugin.
+    d->registerDeclaredServices();
   }
   else
   {
@@ -31,6 +31,8 @@ const QString ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN = "org.commontk.plugin
 const QString ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT = "onFirstInit";
 const QString ctkPluginConstants::FRAMEWORK_PLUGIN_LOAD_HINTS = "org.commontk.pluginfw.loadhints";
 const QString ctkPluginConstants::FRAMEWORK_PRELOAD_LIBRARIES = "org.commontk.pluginfw.preloadlibs";
+const QString ctkPluginConstants::FRAMEWORK_PARALLEL_START = "org.commontk.pluginfw.parallelstart";
+const QString ctkPluginConstants::FRAMEWORK_STARTUP_TRACE = "org.commontk.pluginfw.startuptrace";
 
 const QString ctkPluginConstants::PLUGIN_SYMBOLICNAME = "Plugin-SymbolicName";
 const QString ctkPluginConstants::PLUGIN_COPYRIGHT = "Plugin-Copyright";
@@ -40,6 +42,7 @@ const QString ctkPluginConstants::PLUGIN_VENDOR = "Plugin-Vendor";
 const QString ctkPluginConstants::PLUGIN_LOCALIZATION = "Plugin-Localization";
 const QString ctkPluginConstants::PLUGIN_LOCALIZATION_DEFAULT_BASENAME = "CTK-INF/l10n/plugin";
 const QString ctkPluginConstants::REQUIRE_PLUGIN = "Require-Plugin";
+const QString ctkPluginConstants::PROVIDE_SERVICE = "Provide-Service";
 const QString ctkPluginConstants::PLUGIN_VERSION_ATTRIBUTE = "plugin-version";
 const QString ctkPluginConstants::PLUGIN_VERSION = "Plugin-Version";
 const QString ctkPluginConstants::PLUGIN_ACTIVATIONPOLICY = "Plugin-ActivationPolicy";
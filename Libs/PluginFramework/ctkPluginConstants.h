@@ -122,6 +122,31 @@ struct CTK_PLUGINFW_EXPORT ctkPluginConstants {
    */
   static const QString FRAMEWORK_PRELOAD_LIBRARIES; // = "org.commontk.pluginfw.preloadlibs"
 
+  /**
+   * Specifies if the plug-ins started together during framework launch are
+   * started in parallel. The value of this property must be of type bool and
+   * defaults to <code>false</code>.
+   *
+   * In parallel mode, the shared libraries of the plug-ins are loaded by a pool
+   * of worker threads while the plug-in activators are run. Plug-ins are started
+   * by increasing start level, and a plug-in is started only after the plug-ins
+   * it requires (see REQUIRE_PLUGIN). Plug-in activators are always run in the
+   * thread starting the framework, since the objects they create are expected
+   * to live in that thread.
+   */
+  static const QString FRAMEWORK_PARALLEL_START; // = "org.commontk.pluginfw.parallelstart"
+
+  /**
+   * Specifies the file to which the startup timeline of the framework is written.
+   * The value of this property must be of type QString. The timeline contains the
+   * time spent to resolve each plug-in, to load its shared library and to run its
+   * activator, in the Trace Event Format, which can be displayed by Chromium based
+   * web browsers (chrome://tracing) or by https://ui.perfetto.dev. The file is
+   * written at the end of the framework launch, and again when the framework is
+   * stopped to include the lazily started plug-ins activated in the meantime.
+   */
+  static const QString FRAMEWORK_STARTUP_TRACE; // = "org.commontk.pluginfw.startuptrace"
+
   /**
    * Manifest header identifying the plugin's symbolic name.
    *
@@ -195,6 +220,35 @@ struct CTK_PLUGINFW_EXPORT ctkPluginConstants {
    */
   static const QString REQUIRE_PLUGIN; // = "Require-Plugin"
 
+  /**
+   * Manifest header declaring the services registered by the plugin activator.
+   *
+   * <p>
+   * Each entry lists the class names under which a service is registered,
+   * followed by its properties, for example:
+   * <code>org.commontk.service.Foo;service.ranking=10;vendor=CommonTK, org.commontk.service.Bar</code>.
+   * When a plugin with the lazy activation policy is started, the framework
+   * registers its declared services without loading the plugin library. The
+   * first call to ctkPluginContext::getService() for one of these services
+   * activates the plugin, and the service object registered by the activator
+   * under the same class names is bound to the declared registration.
+   * Note that a ctkServiceTracker gets the service when it is added, so a
+   * tracker opened on one of these services activates the plugin as soon
+   * as the service is registered.
+   *
+   * <p>
+   * In a <code>manifest_headers.cmake</code> file, this header is set as a custom header:
+   * <pre>
+   * set(Provide-Service "org.commontk.service.Foo;service.ranking=10")
+   * set(Custom-Headers "Provide-Service")
+   * </pre>
+   *
+   * <p>
+   * The attribute value may be retrieved from the <code>QHash</code>
+   * object returned by the <code>ctkPlugin::getHeaders</code> method.
+   */
+  static const QString PROVIDE_SERVICE; // = "Provide-Service"
+
   /**
    * Manifest header attribute identifying a range of versions for a plugin
    * specified in the <code>Require-Plugin</code> manifest headers.
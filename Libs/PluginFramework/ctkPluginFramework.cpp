@@ -25,6 +25,7 @@
 #include "ctkPluginFramework.h"
 #include "ctkPluginFramework_p.h"
 #include "ctkPluginFrameworkContext_p.h"
+#include "ctkPluginStartScheduler_p.h"
 
 #include "service/event/ctkEvent.h"
 
@@ -133,26 +134,22 @@ void ctkPluginFramework::start(const ctkPlugin::StartOptions& options)
   d->activate(d->pluginContext.data());
 
   // Start plugins according to their autostart setting.
+  ctkPluginStartScheduler scheduler(d->fwCtx);
   QStringListIterator i(pluginsToStart);
   while (i.hasNext())
   {
     QSharedPointer<ctkPlugin> plugin = d->fwCtx->plugins->getPlugin(i.next());
-    try {
-      const int autostartSetting = plugin->d_func()->archive->getAutostartSetting();
-      // Launch must not change the autostart setting of a plugin
-      StartOptions option = ctkPlugin::START_TRANSIENT;
-      if (ctkPlugin::START_ACTIVATION_POLICY == autostartSetting)
-      {
-        // Transient start according to the plugins activation policy.
-        option |= ctkPlugin::START_ACTIVATION_POLICY;
-      }
-      plugin->start(option);
-    }
-    catch (const ctkPluginException& pe)
+    const int autostartSetting = plugin->d_func()->archive->getAutostartSetting();
+    // Launch must not change the autostart setting of a plugin
+    StartOptions option = ctkPlugin::START_TRANSIENT;
+    if (ctkPlugin::START_ACTIVATION_POLICY == autostartSetting)
     {
-      d->fwCtx->listeners.frameworkError(plugin, pe);
+      // Transient start according to the plugins activation policy.
+      option |= ctkPlugin::START_ACTIVATION_POLICY;
     }
+    scheduler.addPlugin(plugin, option);
   }
+  scheduler.start(true);
 
   {
     ctkPluginPrivate::Locker sync(&d->lock);
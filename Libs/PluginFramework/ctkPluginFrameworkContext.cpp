@@ -103,6 +103,8 @@ void ctkPluginFrameworkContext::init()
     }
   }
 
+  startupTimeline.setTraceFile(props.value(ctkPluginConstants::FRAMEWORK_STARTUP_TRACE).toString());
+
   if (firstInit && ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN_ONFIRSTINIT
       == props[ctkPluginConstants::FRAMEWORK_STORAGE_CLEAN])
   {
@@ -32,6 +32,7 @@
 #include "ctkPlugins_p.h"
 #include "ctkPluginFrameworkListeners_p.h"
 #include "ctkPluginFrameworkDebug_p.h"
+#include "ctkPluginStartupTimeline_p.h"
 
 
 class ctkPlugin;
@@ -103,6 +104,11 @@ public:
    */
   ctkPluginFrameworkDebug debug;
 
+  /**
+   * Time spent to start the plug-ins.
+   */
+  ctkPluginStartupTimeline startupTimeline;
+
   /**
    * Construct a framework context
    *
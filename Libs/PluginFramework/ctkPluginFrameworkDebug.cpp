@@ -37,6 +37,7 @@ QString ctkPluginFrameworkDebug::OPTION_DEBUG_SERVICE_REFERENCE = CTK_OSGI + "/d
 QString ctkPluginFrameworkDebug::OPTION_DEBUG_STARTLEVEL = CTK_OSGI + "/debug/startlevel";
 QString ctkPluginFrameworkDebug::OPTION_DEBUG_URL = CTK_OSGI + "/debug/url";
 QString ctkPluginFrameworkDebug::OPTION_DEBUG_RESOLVE = CTK_OSGI + "/debug/resolve";
+QString ctkPluginFrameworkDebug::OPTION_DEBUG_STARTUP = CTK_OSGI + "/debug/startup";
 
 //----------------------------------------------------------------------------
 ctkPluginFrameworkDebug::ctkPluginFrameworkDebug()
@@ -54,5 +55,6 @@ ctkPluginFrameworkDebug::ctkPluginFrameworkDebug()
     startlevel = dbgOptions->getBooleanOption(OPTION_DEBUG_STARTLEVEL, false);
     url = dbgOptions->getBooleanOption(OPTION_DEBUG_URL, false);
     resolve = dbgOptions->getBooleanOption(OPTION_DEBUG_RESOLVE, false);
+    startup = dbgOptions->getBooleanOption(OPTION_DEBUG_STARTUP, false);
   }
 }
@@ -93,6 +93,12 @@ public:
   static QString OPTION_DEBUG_RESOLVE;
   bool resolve;
 
+  /**
+   * Report the time spent to start each plug-in during framework launch
+   */
+  static QString OPTION_DEBUG_STARTUP;
+  bool startup;
+
 };
 
 #endif // CTKPLUGINFRAMEWORKDEBUG_P_H
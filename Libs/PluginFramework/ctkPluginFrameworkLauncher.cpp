@@ -26,6 +26,7 @@
 #include "ctkPluginContext.h"
 #include "ctkPluginException.h"
 #include "ctkPlugin_p.h"
+#include "ctkPluginStartScheduler_p.h"
 #include "ctkDefaultApplicationLauncher_p.h"
 #include "ctkLocationManager_p.h"
 #include "ctkBasicLocation_p.h"
@@ -357,15 +358,13 @@ public:
       }
     }
 
+    QSharedPointer<ctkPlugin> framework = fwFactory->getFramework();
+    ctkPluginStartScheduler scheduler(framework->d_func()->fwCtx);
     foreach(QSharedPointer<ctkPlugin> plugin, startEntries)
     {
-      this->resolvePlugin(plugin);
-    }
-
-    foreach(QSharedPointer<ctkPlugin> plugin, startEntries)
-    {
-      plugin->start(startOptions);
+      scheduler.addPlugin(plugin, startOptions);
     }
+    scheduler.start(false);
   }
 
 
@@ -179,6 +179,8 @@ void ctkPluginFrameworkPrivate::shutdown0(bool restart, bool wasActive)
 
     if (wasActive)
     {
+      // Include the plug-ins activated since the launch
+      fwCtx->startupTimeline.writeTrace();
       stopAllPlugins();
       deactivate(this->pluginContext.data());
     }
@@ -0,0 +1,227 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "ctkPluginStartScheduler_p.h"
+
+#include "ctkPlugin_p.h"
+#include "ctkPluginConstants.h"
+#include "ctkPluginException.h"
+#include "ctkPluginFrameworkContext_p.h"
+#include "ctkPluginStartupTimeline_p.h"
+
+#include <QFuture>
+#include <QHash>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+ctkPluginStartScheduler::ctkPluginStartScheduler(ctkPluginFrameworkContext* fwCtx)
+  : fwCtx(fwCtx)
+{
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartScheduler::addPlugin(const QSharedPointer<ctkPlugin>& plugin,
+                                        const ctkPlugin::StartOptions& options)
+{
+  Entry entry;
+  entry.plugin = plugin;
+  entry.options = options;
+  entries.push_back(entry);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartScheduler::start(bool reportErrors)
+{
+  ctkPluginStartupTimeline& timeline = fwCtx->startupTimeline;
+  const qint64 since = timeline.elapsed();
+
+  // The Require-Plugin entries are parsed at install, so the start order
+  // is known before resolving
+  const QList<Entry> order = getStartOrder();
+
+  // Resolve first to avoid dead lock. Resolving in start order resolves the
+  // required plugins on their own, instead of as part of the plugins
+  // requiring them, so that each one gets its resolve time.
+  foreach(const Entry& entry, order)
+  {
+    ctkPluginPrivate* pp = entry.plugin->d_func();
+    if (pp->state == ctkPlugin::INSTALLED)
+    {
+      const qint64 start = timeline.elapsed();
+      pp->getUpdatedState();
+      timeline.addEvent(pp->id, pp->symbolicName, ctkPluginStartupTimeline::RESOLVE, start);
+    }
+  }
+
+  QHash<ctkPluginPrivate*, QFuture<void> > loads;
+  if (fwCtx->props.value(ctkPluginConstants::FRAMEWORK_PARALLEL_START).toBool())
+  {
+    // The pool runs the loads in submission order, so the libraries
+    // needed first are loaded first
+    foreach(const Entry& entry, order)
+    {
+      if (isActivated(entry))
+      {
+        ctkPluginPrivate* pp = entry.plugin->d_func();
+        loads.insert(pp, QtConcurrent::run(&loaderPool, [this, pp]() { loadPluginLibrary(pp); }));
+      }
+    }
+  }
+
+  foreach(const Entry& entry, order)
+  {
+    ctkPluginPrivate* pp = entry.plugin->d_func();
+    if (loads.contains(pp))
+    {
+      loads[pp].waitForFinished();
+    }
+    else if (isActivated(entry))
+    {
+      // Load the library separately to record its load time
+      loadPluginLibrary(pp);
+    }
+
+    try
+    {
+      const qint64 start = timeline.elapsed();
+      entry.plugin->start(entry.options);
+      timeline.addEvent(pp->id, pp->symbolicName, ctkPluginStartupTimeline::ACTIVATE, start);
+    }
+    catch (const ctkPluginException& pe)
+    {
+      if (!reportErrors)
+      {
+        reportTimeline(since);
+        throw;
+      }
+      fwCtx->listeners.frameworkError(entry.plugin, pe);
+    }
+  }
+
+  reportTimeline(since);
+}
+
+//----------------------------------------------------------------------------
+QList<ctkPluginStartScheduler::Entry> ctkPluginStartScheduler::getStartOrder() const
+{
+  QList<Entry> sortedEntries = entries;
+  std::stable_sort(sortedEntries.begin(), sortedEntries.end(), startLevelLessThan);
+
+  QList<bool> visited;
+  for (int i = 0; i < sortedEntries.size(); ++i)
+  {
+    visited.push_back(false);
+  }
+
+  QList<Entry> order;
+  for (int i = 0; i < sortedEntries.size(); ++i)
+  {
+    addInStartOrder(i, sortedEntries, visited, order);
+  }
+  return order;
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginStartScheduler::startLevelLessThan(const Entry& e1, const Entry& e2)
+{
+  return e1.plugin->d_func()->getStartLevel() < e2.plugin->d_func()->getStartLevel();
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartScheduler::addInStartOrder(int index, const QList<Entry>& sortedEntries,
+                                              QList<bool>& visited, QList<Entry>& order) const
+{
+  if (visited[index]) return;
+  // Mark before visiting the requirements, to stop on cyclic requirements
+  visited[index] = true;
+
+  const Entry& entry = sortedEntries[index];
+  foreach(const ctkRequirePlugin* pr, entry.plugin->d_func()->require)
+  {
+    QList<ctkPlugin*> pl = fwCtx->plugins->getPlugins(pr->name, pr->pluginRange);
+    if (pl.isEmpty()) continue;
+
+    // The first plugin in the list (highest version number) is
+    // the one started by ctkPluginPrivate::startDependencies()
+    for (int i = 0; i < sortedEntries.size(); ++i)
+    {
+      if (sortedEntries[i].plugin.data() == pl.front())
+      {
+        addInStartOrder(i, sortedEntries, visited, order);
+        break;
+      }
+    }
+  }
+  order.push_back(entry);
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginStartScheduler::isActivated(const Entry& entry) const
+{
+  ctkPluginPrivate* pp = entry.plugin->d_func();
+  return pp->state == ctkPlugin::RESOLVED &&
+      (!(entry.options & ctkPlugin::START_ACTIVATION_POLICY) || pp->eagerActivation);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartScheduler::loadPluginLibrary(ctkPluginPrivate* plugin)
+{
+  ctkPluginStartupTimeline& timeline = fwCtx->startupTimeline;
+  const qint64 start = timeline.elapsed();
+  plugin->loadPluginLibrary();
+  timeline.addEvent(plugin->id, plugin->symbolicName, ctkPluginStartupTimeline::LOAD, start);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartScheduler::reportTimeline(qint64 since) const
+{
+  ctkPluginStartupTimeline& timeline = fwCtx->startupTimeline;
+
+  // Lazily started plugins stay in the STARTING state, without their
+  // library loaded, until they are used
+  int deferred = 0;
+  foreach(const Entry& entry, entries)
+  {
+    ctkPluginPrivate* pp = entry.plugin->d_func();
+    if (pp->state == ctkPlugin::STARTING)
+    {
+      timeline.addDeferredPlugin(pp->id);
+      ++deferred;
+    }
+  }
+
+  if (fwCtx->debug.startup)
+  {
+    foreach(const ctkPluginStartupTimeline::Event& event, timeline.getEvents())
+    {
+      if (event.start < since) continue;
+      qDebug() << "startup:" << qPrintable(ctkPluginStartupTimeline::phaseName(event.phase))
+               << "#" << event.pluginId << event.symbolicName
+               << "at" << event.start / 1000 << "ms took" << event.duration / 1000.0 << "ms";
+    }
+    qDebug() << "startup:" << deferred << "of" << entries.size()
+             << "plugin libraries deferred until the first use of their services";
+  }
+
+  timeline.writeTrace();
+}
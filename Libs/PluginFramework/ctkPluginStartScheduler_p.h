@@ -0,0 +1,115 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CTKPLUGINSTARTSCHEDULER_P_H
+#define CTKPLUGINSTARTSCHEDULER_P_H
+
+#include "ctkPlugin.h"
+
+#include <QList>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+
+class ctkPluginFrameworkContext;
+class ctkPluginPrivate;
+
+/**
+ * \ingroup PluginFramework
+ *
+ * Starts a set of plug-ins during framework launch.
+ *
+ * The plug-ins are resolved first, then started by increasing start level.
+ * A plug-in is started after the plug-ins of the set it requires, which is
+ * the order in which they would be activated by ctkPluginPrivate::startDependencies()
+ * anyway. If the FRAMEWORK_PARALLEL_START framework property is set, the shared
+ * libraries of the plug-ins which are activated eagerly are loaded by a pool of
+ * worker threads, in start order, while the activators are called in the
+ * current thread.
+ *
+ * The time spent in each phase is recorded in the startup timeline of the
+ * framework, which is written to the file given by the FRAMEWORK_STARTUP_TRACE
+ * framework property, together with the number of lazily started plug-ins
+ * whose library was not loaded.
+ */
+class ctkPluginStartScheduler
+{
+
+public:
+
+  ctkPluginStartScheduler(ctkPluginFrameworkContext* fwCtx);
+
+  void addPlugin(const QSharedPointer<ctkPlugin>& plugin,
+                 const ctkPlugin::StartOptions& options);
+
+  /**
+   * Resolve and start the added plug-ins.
+   *
+   * @param reportErrors If <code>true</code>, an exception thrown while starting
+   *        a plug-in is reported as a framework error and the remaining plug-ins
+   *        are started. Otherwise, the exception is thrown to the caller.
+   * @throws ctkPluginException If a plug-in could not be started and
+   *         <code>reportErrors</code> is <code>false</code>.
+   */
+  void start(bool reportErrors);
+
+private:
+
+  struct Entry
+  {
+    QSharedPointer<ctkPlugin> plugin;
+    ctkPlugin::StartOptions options;
+  };
+
+  ctkPluginFrameworkContext* fwCtx;
+
+  QList<Entry> entries;
+
+  /**
+   * Threads loading the plug-in libraries. Declared last so that pending
+   * loads are finished before the entries are destroyed.
+   */
+  QThreadPool loaderPool;
+
+  /**
+   * Return the entries sorted by start level and Require-Plugin dependencies.
+   */
+  QList<Entry> getStartOrder() const;
+
+  static bool startLevelLessThan(const Entry& e1, const Entry& e2);
+
+  void addInStartOrder(int index, const QList<Entry>& sortedEntries,
+                       QList<bool>& visited, QList<Entry>& order) const;
+
+  /**
+   * Return true if starting the plug-in of the entry calls its activator,
+   * i.e. if its library is loaded.
+   */
+  bool isActivated(const Entry& entry) const;
+
+  void loadPluginLibrary(ctkPluginPrivate* plugin);
+
+  void reportTimeline(qint64 since) const;
+
+};
+
+
+#endif // CTKPLUGINSTARTSCHEDULER_P_H
@@ -0,0 +1,186 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#include "ctkPluginStartupTimeline_p.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+//----------------------------------------------------------------------------
+ctkPluginStartupTimeline::ctkPluginStartupTimeline()
+{
+  clock.start();
+}
+
+//----------------------------------------------------------------------------
+qint64 ctkPluginStartupTimeline::elapsed() const
+{
+  return clock.nsecsElapsed() / 1000;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartupTimeline::addEvent(long pluginId, const QString& symbolicName,
+                                        Phase phase, qint64 start, bool deferred)
+{
+  Event event;
+  event.pluginId = pluginId;
+  event.symbolicName = symbolicName;
+  event.phase = phase;
+  event.start = start;
+  event.duration = elapsed() - start;
+  event.threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+  event.deferred = deferred;
+
+  QMutexLocker lock(&mutex);
+  events.push_back(event);
+}
+
+//----------------------------------------------------------------------------
+QList<ctkPluginStartupTimeline::Event> ctkPluginStartupTimeline::getEvents() const
+{
+  QMutexLocker lock(&mutex);
+  return events;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartupTimeline::addDeferredPlugin(long pluginId)
+{
+  QMutexLocker lock(&mutex);
+  deferredPlugins.insert(pluginId);
+}
+
+//----------------------------------------------------------------------------
+int ctkPluginStartupTimeline::getDeferredPluginCount() const
+{
+  QMutexLocker lock(&mutex);
+  return deferredPlugins.size();
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginStartupTimeline::isDeferredPlugin(long pluginId) const
+{
+  QMutexLocker lock(&mutex);
+  return deferredPlugins.contains(pluginId);
+}
+
+//----------------------------------------------------------------------------
+int ctkPluginStartupTimeline::getDeferredActivationCount() const
+{
+  int count = 0;
+  foreach(const Event& event, getEvents())
+  {
+    if (event.deferred && event.phase == ACTIVATE) ++count;
+  }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+qint64 ctkPluginStartupTimeline::getDeferredActivationTime() const
+{
+  qint64 time = 0;
+  foreach(const Event& event, getEvents())
+  {
+    if (event.deferred) time += event.duration;
+  }
+  return time;
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginStartupTimeline::setTraceFile(const QString& fileName)
+{
+  QMutexLocker lock(&mutex);
+  traceFile = fileName;
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginStartupTimeline::writeTrace() const
+{
+  QString fileName;
+  {
+    QMutexLocker lock(&mutex);
+    fileName = traceFile;
+  }
+  if (fileName.isEmpty()) return true;
+
+  if (!write(fileName))
+  {
+    qWarning() << "Could not write the plugin framework startup trace to" << fileName;
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool ctkPluginStartupTimeline::write(const QString& fileName) const
+{
+  QJsonArray traceEvents;
+  foreach(const Event& event, getEvents())
+  {
+    QJsonObject args;
+    args["pluginId"] = static_cast<qint64>(event.pluginId);
+    args["deferred"] = event.deferred;
+
+    QJsonObject traceEvent;
+    traceEvent["name"] = QString("%1 %2").arg(phaseName(event.phase), event.symbolicName);
+    traceEvent["cat"] = phaseName(event.phase);
+    traceEvent["ph"] = QString("X");
+    traceEvent["ts"] = event.start;
+    traceEvent["dur"] = event.duration;
+    traceEvent["pid"] = QCoreApplication::applicationPid();
+    traceEvent["tid"] = static_cast<qint64>(event.threadId);
+    traceEvent["args"] = args;
+    traceEvents.append(traceEvent);
+  }
+
+  QJsonObject trace;
+  trace["traceEvents"] = traceEvents;
+  trace["displayTimeUnit"] = QString("ms");
+
+  QJsonObject otherData;
+  otherData["deferredPlugins"] = getDeferredPluginCount();
+  otherData["deferredActivations"] = getDeferredActivationCount();
+  otherData["deferredActivationTime"] = getDeferredActivationTime();
+  trace["otherData"] = otherData;
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    return false;
+  }
+  return file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact)) != -1;
+}
+
+//----------------------------------------------------------------------------
+QString ctkPluginStartupTimeline::phaseName(Phase phase)
+{
+  switch (phase)
+  {
+  case RESOLVE: return "resolve";
+  case LOAD: return "load";
+  case ACTIVATE: return "activate";
+  }
+  return QString();
+}
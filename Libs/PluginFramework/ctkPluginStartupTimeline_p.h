@@ -0,0 +1,154 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+#ifndef CTKPLUGINSTARTUPTIMELINE_P_H
+#define CTKPLUGINSTARTUPTIMELINE_P_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+
+/**
+ * \ingroup PluginFramework
+ *
+ * Records the time spent to start the plug-ins of a framework.
+ *
+ * Each plug-in start is split in three phases: the resolution of the
+ * plug-in, the loading of its shared library and the call of its activator.
+ * The activation of the lazily started plug-ins is deferred until the
+ * first use of one of the services declared in their manifest. The
+ * timeline also records how many of them were deferred and the time
+ * spent to activate them afterwards.
+ * Events can be added from any thread.
+ */
+class ctkPluginStartupTimeline
+{
+
+public:
+
+  enum Phase {
+    RESOLVE,
+    LOAD,
+    ACTIVATE
+  };
+
+  struct Event
+  {
+    long pluginId;
+    QString symbolicName;
+    Phase phase;
+    /** Start time in microseconds, relative to the creation of the timeline */
+    qint64 start;
+    /** Duration in microseconds */
+    qint64 duration;
+    /** Identifier of the thread in which the phase ran */
+    quintptr threadId;
+    /**
+     * True if the phase ran on the first use of a declared service, for a plug-in
+     * recorded by addDeferredPlugin() at the end of the framework launch
+     */
+    bool deferred;
+  };
+
+  ctkPluginStartupTimeline();
+
+  /**
+   * Time elapsed since the creation of the timeline, in microseconds.
+   */
+  qint64 elapsed() const;
+
+  /**
+   * Record that the given phase of a plug-in ran in the current thread
+   * from <code>start</code> until now.
+   */
+  void addEvent(long pluginId, const QString& symbolicName, Phase phase, qint64 start,
+                bool deferred = false);
+
+  QList<Event> getEvents() const;
+
+  /**
+   * Record that the library of a plug-in was not loaded during the
+   * framework launch, because the plug-in is lazily activated.
+   */
+  void addDeferredPlugin(long pluginId);
+
+  /**
+   * Number of plug-ins whose library was not loaded during the framework launch.
+   */
+  int getDeferredPluginCount() const;
+
+  /**
+   * Return true if the plug-in was recorded by addDeferredPlugin().
+   */
+  bool isDeferredPlugin(long pluginId) const;
+
+  /**
+   * Number of deferred plug-ins activated since the framework launch.
+   */
+  int getDeferredActivationCount() const;
+
+  /**
+   * Time in microseconds spent to load and activate the deferred plug-ins
+   * after the framework launch. This time would have been spent during the
+   * launch otherwise, the deferred plug-ins which are never activated save
+   * their whole load and activation time.
+   */
+  qint64 getDeferredActivationTime() const;
+
+  /**
+   * Set the file to which writeTrace() writes the timeline.
+   */
+  void setTraceFile(const QString& fileName);
+
+  /**
+   * Write the recorded events in the Trace Event Format to the trace file,
+   * if it is set. The trace is written at the end of the framework launch and
+   * when the framework is stopped, to include the deferred activations.
+   *
+   * @return <code>false</code> if the trace file could not be written.
+   */
+  bool writeTrace() const;
+
+  /**
+   * Write the recorded events to <code>fileName</code> in the Trace Event Format.
+   *
+   * @return <code>true</code> if the file could be written.
+   */
+  bool write(const QString& fileName) const;
+
+  static QString phaseName(Phase phase);
+
+private:
+
+  QElapsedTimer clock;
+
+  mutable QMutex mutex;
+  QList<Event> events;
+  QSet<long> deferredPlugins;
+  QString traceFile;
+
+};
+
+
+#endif // CTKPLUGINSTARTUPTIMELINE_P_H
@@ -721,6 +721,122 @@ void ctkPluginPrivate::startDependencies()
   }
 }
 
+//----------------------------------------------------------------------------
+bool ctkPluginPrivate::loadPluginLibrary()
+{
+  QMutexLocker lock(&pluginLoaderLock);
+  if (!pluginLoader.isLoaded())
+  {
+    pluginLoader.load();
+  }
+  return pluginLoader.isLoaded();
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginPrivate::registerDeclaredServices()
+{
+  QString provideString = archive->getAttribute(ctkPluginConstants::PROVIDE_SERVICE);
+  if (provideString.isEmpty()) return;
+
+  QList<QMap<QString, QStringList> > provideList;
+  try
+  {
+    provideList = ctkPluginFrameworkUtil::parseEntries(ctkPluginConstants::PROVIDE_SERVICE,
+                                                       provideString, false, true, false);
+  }
+  catch (const ctkInvalidArgumentException& e)
+  {
+    fwCtx->listeners.frameworkError(q_func(), e);
+    return;
+  }
+
+  // The services are announced only when all of them are known as declared
+  // services, since a service listener, e.g. a ctkServiceTracker, may get
+  // a service and thereby activate this plugin from within the event.
+  QList<ctkServiceRegistration> placeholders;
+  QListIterator<QMap<QString, QStringList> > i(provideList);
+  while (i.hasNext() && state == ctkPlugin::STARTING)
+  {
+    const QMap<QString, QStringList>& e = i.next();
+    ctkDictionary props;
+    for (QMap<QString, QStringList>::const_iterator param = e.begin(); param != e.end(); ++param)
+    {
+      if (param.key().startsWith('$')) continue;
+      if (param.key() == ctkPluginConstants::SERVICE_RANKING)
+      {
+        props.insert(param.key(), param.value().front().toInt());
+      }
+      else
+      {
+        props.insert(param.key(), param.value().front());
+      }
+    }
+    ctkServiceRegistration sr = fwCtx->services->registerDeclaredService(this, e.value("$keys"), props);
+    placeholders.push_back(sr);
+    declaredServices.push_back(sr);
+  }
+
+  if (fwCtx->debug.lazy_activation)
+  {
+    qDebug() << "registered" << placeholders.size() << "declared services of #" << this->id;
+  }
+
+  QListIterator<ctkServiceRegistration> j(placeholders);
+  while (j.hasNext())
+  {
+    // Once activated or stopped, the declared services which are not bound
+    // to a service object must not be announced
+    if (state != ctkPlugin::STARTING)
+    {
+      unregisterDeclaredServices();
+    }
+    fwCtx->services->announceDeclaredService(j.next());
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginPrivate::activateOnServiceUse()
+{
+  if (state != ctkPlugin::STARTING) return;
+  // The activator itself may get its declared services before registering them
+  if (operation.fetchAndAddOrdered(0) == ACTIVATING) return;
+
+  if (fwCtx->debug.lazy_activation)
+  {
+    qDebug() << "activating #" << this->id << "on the first use of a declared service";
+  }
+
+  // A plug-in activated by another one during the framework launch is not deferred
+  ctkPluginStartupTimeline& timeline = fwCtx->startupTimeline;
+  const bool deferred = timeline.isDeferredPlugin(id);
+  qint64 start = timeline.elapsed();
+  loadPluginLibrary();
+  timeline.addEvent(id, symbolicName, ctkPluginStartupTimeline::LOAD, start, deferred);
+
+  start = timeline.elapsed();
+  finalizeActivation();
+  timeline.addEvent(id, symbolicName, ctkPluginStartupTimeline::ACTIVATE, start, deferred);
+}
+
+//----------------------------------------------------------------------------
+void ctkPluginPrivate::unregisterDeclaredServices()
+{
+  QList<ctkServiceRegistration> srs = declaredServices;
+  declaredServices.clear();
+  QMutableListIterator<ctkServiceRegistration> i(srs);
+  while (i.hasNext())
+  {
+    try
+    {
+      i.next().unregister();
+    }
+    catch (const ctkIllegalStateException& /*ignore*/)
+    {
+      // Already unregistered
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 ctkPluginException* ctkPluginPrivate::start0()
 {
@@ -730,8 +846,7 @@ ctkPluginException* ctkPluginPrivate::start0()
 
   ctkPluginException::Type error_type = ctkPluginException::MANIFEST_ERROR;
   try {
-    pluginLoader.load();
-    if (!pluginLoader.isLoaded())
+    if (!loadPluginLibrary())
     {
       error_type = ctkPluginException::ACTIVATOR_ERROR;
       throw ctkPluginException(QString("Loading plugin %1 failed: %2").arg(pluginLoader.fileName(), pluginLoader.errorString()),
@@ -760,6 +875,14 @@ ctkPluginException* ctkPluginPrivate::start0()
       }
     }
     state = ctkPlugin::ACTIVE;
+
+    // Declared services not registered by the activator are not provided
+    if (!declaredServices.isEmpty())
+    {
+      qWarning() << "Plugin" << symbolicName << "did not register" << declaredServices.size()
+                 << "of the services declared in its" << ctkPluginConstants::PROVIDE_SERVICE << "manifest header";
+      unregisterDeclaredServices();
+    }
   }
   catch (const ctkException& e)
   {
@@ -801,6 +924,9 @@ void ctkPluginPrivate::removePluginResources()
   // automatic disconnect due to Qt signal slot
   //fwCtx->listeners.removeAllListeners(this);
 
+  // The declared services are unregistered below, with the other services
+  declaredServices.clear();
+
   QList<ctkServiceRegistration> srs = fwCtx->services->getRegisteredByPlugin(this);
   QMutableListIterator<ctkServiceRegistration> i(srs);
   while (i.hasNext())
@@ -25,6 +25,7 @@
 #include "ctkPlugin.h"
 #include "ctkPluginException.h"
 #include "ctkRequirePlugin_p.h"
+#include "ctkServiceRegistration.h"
 
 #include <QHash>
 #include <QPluginLoader>
@@ -132,6 +133,30 @@ public:
    */
   void setStateInstalled(bool sendEvent);
 
+  /**
+   * Load the shared library of this plugin, if not already loaded.
+   * This does not create the plugin activator and can be called from
+   * any thread.
+   *
+   * @return <code>true</code> if the library is loaded.
+   */
+  bool loadPluginLibrary();
+
+  /**
+   * Register the services declared in the Provide-Service manifest header
+   * of this lazily started plugin.
+   */
+  void registerDeclaredServices();
+
+  /**
+   * Finalize the lazy activation of this plugin on the first use of
+   * one of its declared services. Nothing is done if the activation
+   * is already in progress.
+   *
+   * @throws ctkPluginException If the activation fails.
+   */
+  void activateOnServiceUse();
+
   /**
    * Purge any old files associated with this plug-in.
    */
@@ -245,6 +270,12 @@ public:
    */
   QPluginLoader pluginLoader;
 
+  /**
+   * Serializes loading of the plugin library, which may happen
+   * in a worker thread during a parallel framework start
+   */
+  QMutex pluginLoaderLock;
+
   /**
    * Time when the plugin was last modified
    */
@@ -287,6 +318,12 @@ public:
   /** List of ctkRequirePlugin entries. */
   QList<ctkRequirePlugin*> require;
 
+  /**
+   * Registrations of the services declared in the manifest, which are
+   * waiting for the activator to register their service object.
+   */
+  QList<ctkServiceRegistration> declaredServices;
+
 private:
 
   /** Remember if plugin was started */
@@ -310,6 +347,11 @@ private:
    */
   void removePluginResources();
 
+  /**
+   * Unregister the declared services which have no service object.
+   */
+  void unregisterDeclaredServices();
+
   ctkPlugin::State getUpdatedState_unlocked();
 
 };
@@ -49,10 +49,37 @@ ctkServiceReferencePrivate::~ctkServiceReferencePrivate()
 //----------------------------------------------------------------------------
 QObject* ctkServiceReferencePrivate::getService(QSharedPointer<ctkPlugin> plugin)
 {
+  // A service declared in the manifest of a lazily started plugin gets its
+  // service object when the plugin is activated. The activation must happen
+  // without holding the propsLock, since the activator binds the service
+  // object to this registration.
+  ctkPluginPrivate* declaringPlugin = 0;
+  {
+    QMutexLocker lock(&registration->propsLock);
+    if (registration->available && registration->service == 0)
+    {
+      declaringPlugin = registration->plugin;
+    }
+  }
+  if (declaringPlugin)
+  {
+    try
+    {
+      declaringPlugin->activateOnServiceUse();
+    }
+    catch (const ctkException& pe)
+    {
+      ctkServiceException se("Activating the plugin declaring the service failed",
+                             ctkServiceException::FACTORY_EXCEPTION, pe);
+      plugin->d_func()->fwCtx->listeners.frameworkError(declaringPlugin->q_func(), se);
+      return 0;
+    }
+  }
+
   QObject* s = 0;
   {
     QMutexLocker lock(&registration->propsLock);
-    if (registration->available)
+    if (registration->available && registration->service != 0)
     {
       int count = registration->dependents.value(plugin);
       if (count == 0)
@@ -26,7 +26,7 @@ ctkServiceRegistrationPrivate::ctkServiceRegistrationPrivate(
   ctkPluginPrivate* plugin, QObject* service,
   const ctkDictionary& props)
   : ref(1), service(service), plugin(plugin), reference(this),
-    properties(props), available(true), unregistering(false),
+    properties(props), available(true), unregistering(false), announced(true),
     propsLock()
 {
 
@@ -50,3 +50,10 @@ QObject* ctkServiceRegistrationPrivate::getService()
 {
   return service;
 }
+
+//----------------------------------------------------------------------------
+void ctkServiceRegistrationPrivate::bindService(QObject* service)
+{
+  QMutexLocker lock(&propsLock);
+  this->service = service;
+}
@@ -56,7 +56,8 @@ protected:
   QAtomicInt ref;
 
   /**
-   * Service or ctkServiceFactory object.
+   * Service or ctkServiceFactory object, or 0 for a service declared
+   * in the manifest of a plugin which is not activated yet.
    */
   QObject* service;
 
@@ -101,6 +102,13 @@ public:
    */
   volatile bool unregistering;
 
+  /**
+   * Has the REGISTERED event been sent. A service declared in a plugin
+   * manifest is registered before its event is sent, see
+   * ctkServices::announceDeclaredService().
+   */
+  volatile bool announced;
+
   /**
    * Lock object for synchronous event delivery.
    */
@@ -123,6 +131,11 @@ public:
 
   virtual QObject* getService();
 
+  /**
+   * Set the service object of a declared service.
+   */
+  void bindService(QObject* service);
+
 private:
 
   Q_DISABLE_COPY(ctkServiceRegistrationPrivate)
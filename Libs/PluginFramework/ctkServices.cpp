@@ -63,7 +63,7 @@ ctkDictionary ctkServices::createServiceProperties(const ctkDictionary& in,
 
 //----------------------------------------------------------------------------
 ctkServices::ctkServices(ctkPluginFrameworkContext* fwCtx)
-  : mutex(), framework(fwCtx)
+  : mutex(), framework(fwCtx), currentSnapshot(new Snapshot())
 {
 
 }
@@ -77,11 +77,25 @@ ctkServices::~ctkServices()
 //----------------------------------------------------------------------------
 void ctkServices::clear()
 {
-  services.clear();
-  classServices.clear();
+  QMutexLocker lock(&mutex);
+  publish(std::make_shared<const Snapshot>());
   framework = 0;
 }
 
+//----------------------------------------------------------------------------
+std::shared_ptr<const ctkServices::Snapshot> ctkServices::snapshot() const
+{
+  QMutexLocker lock(&snapshotMutex);
+  return currentSnapshot;
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::publish(const std::shared_ptr<const Snapshot>& newSnapshot)
+{
+  QMutexLocker lock(&snapshotMutex);
+  currentSnapshot = newSnapshot;
+}
+
 //----------------------------------------------------------------------------
 ctkServiceRegistration ctkServices::registerService(ctkPluginPrivate* plugin,
                              const QStringList& classes,
@@ -113,26 +127,128 @@ ctkServiceRegistration ctkServices::registerService(ctkPluginPrivate* plugin,
     }
   }
 
+  // A service declared in the plugin manifest keeps the registration
+  // made when the plugin was lazily started
+  for (int i = 0; i < plugin->declaredServices.size(); ++i)
+  {
+    ctkServiceRegistration declared = plugin->declaredServices[i];
+    QStringList declaredClasses = declared.d_func()->properties.value(ctkPluginConstants::OBJECTCLASS).toStringList();
+    QStringList sortedClasses = classes;
+    declaredClasses.sort();
+    sortedClasses.sort();
+    if (declaredClasses == sortedClasses)
+    {
+      plugin->declaredServices.removeAt(i);
+      bindDeclaredService(declared, service, properties);
+      return declared;
+    }
+  }
+
   ctkServiceRegistration res(plugin, service,
                              createServiceProperties(properties, classes));
+  addServiceRegistration(plugin, res, classes);
+  return res;
+}
+
+//----------------------------------------------------------------------------
+ctkServiceRegistration ctkServices::registerDeclaredService(ctkPluginPrivate* plugin,
+                                                            const QStringList& classes,
+                                                            const ctkDictionary& properties)
+{
+  ctkServiceRegistration res(plugin, 0, createServiceProperties(properties, classes));
+  res.d_func()->announced = false;
+  insertServiceRegistration(res, classes);
+  return res;
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::announceDeclaredService(const ctkServiceRegistration& sr)
+{
+  ctkServiceRegistrationPrivate* reg = const_cast<ctkServiceRegistrationPrivate*>(sr.d_func());
+  {
+    QMutexLocker lock(&reg->propsLock);
+    if (!reg->available) return;
+    reg->announced = true;
+  }
+  sendRegisteredEvent(reg->plugin, sr);
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::bindDeclaredService(ctkServiceRegistration& declared, QObject* service,
+                                      const ctkDictionary& properties)
+{
+  declared.d_func()->bindService(service);
+
+  // The properties given by the activator override the declared ones
+  ctkDictionary props = declared.d_func()->properties;
+  props.remove(ctkPluginConstants::OBJECTCLASS);
+  props.remove(ctkPluginConstants::SERVICE_ID);
+  for (ctkDictionary::const_iterator i = properties.begin(); i != properties.end(); ++i)
+  {
+    props.insert(i.key(), i.value());
+  }
+
+  // A declared service which is not announced yet gets its properties
+  // without MODIFIED event, its REGISTERED event carries them
+  ctkServiceRegistrationPrivate* reg = declared.d_func();
+  bool announced = true;
+  QStringList classes;
+  bool rankChanged = false;
   {
-    QMutexLocker lock(&mutex);
-    services.insert(res, classes);
-    for (QStringListIterator i(classes); i.hasNext(); )
+    QMutexLocker lock(&reg->propsLock);
+    announced = reg->announced;
+    if (!announced)
     {
-      QString currClass = i.next();
-      QList<ctkServiceRegistration>& s = classServices[currClass];
-      QList<ctkServiceRegistration>::iterator ip =
-          std::lower_bound(s.begin(), s.end(), res, ServiceRegistrationComparator());
-      s.insert(ip, res);
+      int oldRank = reg->properties.value(ctkPluginConstants::SERVICE_RANKING).toInt();
+      classes = reg->properties.value(ctkPluginConstants::OBJECTCLASS).toStringList();
+      qlonglong sid = reg->properties.value(ctkPluginConstants::SERVICE_ID).toLongLong();
+      reg->properties = createServiceProperties(props, classes, sid);
+      rankChanged = oldRank != reg->properties.value(ctkPluginConstants::SERVICE_RANKING).toInt();
     }
   }
+  if (announced)
+  {
+    declared.setProperties(props);
+  }
+  else if (rankChanged)
+  {
+    updateServiceRegistrationOrder(declared, classes);
+  }
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::addServiceRegistration(ctkPluginPrivate* plugin, const ctkServiceRegistration& res,
+                                         const QStringList& classes)
+{
+  insertServiceRegistration(res, classes);
+  sendRegisteredEvent(plugin, res);
+}
+
+//----------------------------------------------------------------------------
+void ctkServices::insertServiceRegistration(const ctkServiceRegistration& res,
+                                            const QStringList& classes)
+{
+  QMutexLocker lock(&mutex);
+  std::shared_ptr<Snapshot> newSnapshot = std::make_shared<Snapshot>(*currentSnapshot);
+  newSnapshot->services.insert(res, classes);
+  for (QStringListIterator i(classes); i.hasNext(); )
+  {
+    QString currClass = i.next();
+    QList<ctkServiceRegistration>& s = newSnapshot->classServices[currClass];
+    QList<ctkServiceRegistration>::iterator ip =
+        std::lower_bound(s.begin(), s.end(), res, ServiceRegistrationComparator());
+    s.insert(ip, res);
+  }
+  publish(newSnapshot);
+}
 
+//----------------------------------------------------------------------------
+void ctkServices::sendRegisteredEvent(ctkPluginPrivate* plugin, const ctkServiceRegistration& res)
+{
   ctkServiceReference r = res.getReference();
   plugin->fwCtx->listeners.serviceChanged(
       plugin->fwCtx->listeners.getMatchingServiceSlots(r),
       ctkServiceEvent(ctkServiceEvent::REGISTERED, r));
-  return res;
 }
 
 //----------------------------------------------------------------------------
@@ -140,12 +256,14 @@ void ctkServices::updateServiceRegistrationOrder(const ctkServiceRegistration& s
                                               const QStringList& classes)
 {
   QMutexLocker lock(&mutex);
+  std::shared_ptr<Snapshot> newSnapshot = std::make_shared<Snapshot>(*currentSnapshot);
   for (QStringListIterator i(classes); i.hasNext(); )
   {
-    QList<ctkServiceRegistration>& s = classServices[i.next()];
+    QList<ctkServiceRegistration>& s = newSnapshot->classServices[i.next()];
     s.removeAll(sr);
     s.insert(std::lower_bound(s.begin(), s.end(), sr, ServiceRegistrationComparator()), sr);
   }
+  publish(newSnapshot);
 }
 
 //----------------------------------------------------------------------------
@@ -157,16 +275,14 @@ bool ctkServices::checkServiceClass(QObject* service, const QString& cls) const
 //----------------------------------------------------------------------------
 QList<ctkServiceRegistration> ctkServices::get(const QString& clazz) const
 {
-  QMutexLocker lock(&mutex);
-  return classServices.value(clazz);
+  return snapshot()->classServices.value(clazz);
 }
 
 //----------------------------------------------------------------------------
 ctkServiceReference ctkServices::get(ctkPluginPrivate* plugin, const QString& clazz) const
 {
-  QMutexLocker lock(&mutex);
   try {
-    QList<ctkServiceReference> srs = get_unlocked(clazz, QString(), plugin);
+    QList<ctkServiceReference> srs = get_unlocked(*snapshot(), clazz, QString(), plugin);
     if (framework->debug.service_reference)
     {
       qDebug() << "get service ref" << clazz << "for plugin"
@@ -186,12 +302,12 @@ ctkServiceReference ctkServices::get(ctkPluginPrivate* plugin, const QString& cl
 QList<ctkServiceReference> ctkServices::get(const QString& clazz, const QString& filter,
                                             ctkPluginPrivate* plugin) const
 {
-  QMutexLocker lock(&mutex);
-  return get_unlocked(clazz, filter, plugin);
+  return get_unlocked(*snapshot(), clazz, filter, plugin);
 }
 
 //----------------------------------------------------------------------------
-QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const QString& filter,
+QList<ctkServiceReference> ctkServices::get_unlocked(const Snapshot& snapshot,
+                                                     const QString& clazz, const QString& filter,
                                                      ctkPluginPrivate* plugin) const
 {
   Q_UNUSED(plugin)
@@ -210,7 +326,7 @@ QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const
         v.clear();
         foreach (QString className, matched)
         {
-          const QList<ctkServiceRegistration>& cl = classServices[className];
+          const QList<ctkServiceRegistration>& cl = snapshot.classServices[className];
           v += cl;
         }
         if (!v.isEmpty())
@@ -224,17 +340,17 @@ QList<ctkServiceReference> ctkServices::get_unlocked(const QString& clazz, const
       }
       else
       {
-        s = new QListIterator<ctkServiceRegistration>(services.keys());
+        s = new QListIterator<ctkServiceRegistration>(snapshot.services.keys());
       }
     }
     else
     {
-      s = new QListIterator<ctkServiceRegistration>(services.keys());
+      s = new QListIterator<ctkServiceRegistration>(snapshot.services.keys());
     }
   }
   else
   {
-    QList<ctkServiceRegistration> v = classServices.value(clazz);
+    QList<ctkServiceRegistration> v = snapshot.classServices.value(clazz);
     if (!v.isEmpty())
     {
       s = new QListIterator<ctkServiceRegistration>(v);
@@ -272,29 +388,31 @@ void ctkServices::removeServiceRegistration(const ctkServiceRegistration& sr)
   QMutexLocker lock(&mutex);
 
   QStringList classes = sr.d_func()->properties.value(ctkPluginConstants::OBJECTCLASS).toStringList();
-  services.remove(sr);
+  std::shared_ptr<Snapshot> newSnapshot = std::make_shared<Snapshot>(*currentSnapshot);
+  newSnapshot->services.remove(sr);
   for (QStringListIterator i(classes); i.hasNext(); )
   {
     QString currClass = i.next();
-    QList<ctkServiceRegistration>& s = classServices[currClass];
+    QList<ctkServiceRegistration>& s = newSnapshot->classServices[currClass];
     if (s.size() > 1)
     {
       s.removeAll(sr);
     }
     else
     {
-      classServices.remove(currClass);
+      newSnapshot->classServices.remove(currClass);
     }
   }
+  publish(newSnapshot);
 }
 
 //----------------------------------------------------------------------------
 QList<ctkServiceRegistration> ctkServices::getRegisteredByPlugin(ctkPluginPrivate* p) const
 {
-  QMutexLocker lock(&mutex);
+  std::shared_ptr<const Snapshot> services = snapshot();
 
   QList<ctkServiceRegistration> res;
-  for (QHashIterator<ctkServiceRegistration, QStringList> i(services); i.hasNext(); )
+  for (QHashIterator<ctkServiceRegistration, QStringList> i(services->services); i.hasNext(); )
   {
     ctkServiceRegistration sr = i.next().key();
     if (sr.d_func()->plugin == p)
@@ -308,10 +426,10 @@ QList<ctkServiceRegistration> ctkServices::getRegisteredByPlugin(ctkPluginPrivat
 //----------------------------------------------------------------------------
 QList<ctkServiceRegistration> ctkServices::getUsedByPlugin(QSharedPointer<ctkPlugin> p) const
 {
-  QMutexLocker lock(&mutex);
+  std::shared_ptr<const Snapshot> services = snapshot();
 
   QList<ctkServiceRegistration> res;
-  for (QHashIterator<ctkServiceRegistration, QStringList> i(services); i.hasNext(); )
+  for (QHashIterator<ctkServiceRegistration, QStringList> i(services->services); i.hasNext(); )
   {
     ctkServiceRegistration sr = i.next().key();
     if (sr.d_func()->isUsedByPlugin(p))
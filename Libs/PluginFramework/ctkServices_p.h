@@ -28,6 +28,8 @@
 #include <QMutex>
 #include <QStringList>
 
+#include <memory>
+
 #include "ctkPlugin_p.h"
 #include "ctkServiceRegistration.h"
 
@@ -36,11 +38,19 @@
  * \ingroup PluginFramework
  *
  * Here we handle all the services that are registered in the framework.
+ *
+ * The registered services are published as immutable snapshots. Lookups
+ * read the current snapshot without holding the mutex, while register,
+ * unregister and reordering operations are serialized by the mutex and
+ * publish a modified copy of the snapshot.
  */
 class ctkServices {
 
 public:
 
+  /**
+   * Serializes the modifications of the registered services.
+   */
   mutable QMutex mutex;
 
   /**
@@ -57,18 +67,30 @@ public:
                                  long sid = -1);
 
   /**
-   * All registered services in the current framework.
-   * Mapping of registered service to class names under which
-   * the service is registered.
+   * The registered services at a given time.
    */
-  QHash<ctkServiceRegistration, QStringList> services;
+  struct Snapshot
+  {
+    /**
+     * All registered services in the current framework.
+     * Mapping of registered service to class names under which
+     * the service is registered.
+     */
+    QHash<ctkServiceRegistration, QStringList> services;
+
+    /**
+     * Mapping of classname to registered service.
+     * The List of registered services are ordered with the highest
+     * ranked service first.
+     */
+    QHash<QString, QList<ctkServiceRegistration> > classServices;
+  };
 
   /**
-   * Mapping of classname to registered service.
-   * The List of registered services are ordered with the highest
-   * ranked service first.
+   * Get the current snapshot of the registered services.
+   * The snapshot is never modified, it can be read without locking the mutex.
    */
-  QHash<QString, QList<ctkServiceRegistration> > classServices;
+  std::shared_ptr<const Snapshot> snapshot() const;
 
 
   ctkPluginFrameworkContext* framework;
@@ -100,6 +122,30 @@ public:
                                const ctkDictionary& properties);
 
 
+  /**
+   * Register a service declared in the manifest of a plugin, which has no
+   * service object until the plugin activator registers the service
+   * under the same classes. No service event is sent, see
+   * announceDeclaredService().
+   *
+   * @param plugin The plugin declaring the service.
+   * @param classes The class names under which the service can be located.
+   * @param properties The declared properties for this service.
+   * @return A ctkServiceRegistration object.
+   */
+  ctkServiceRegistration registerDeclaredService(ctkPluginPrivate* plugin,
+                                                 const QStringList& classes,
+                                                 const ctkDictionary& properties);
+
+  /**
+   * Send the REGISTERED event of a service returned by registerDeclaredService().
+   * Nothing is sent if the service has been unregistered in the meantime.
+   *
+   * @param sr The registration of the declared service.
+   */
+  void announceDeclaredService(const ctkServiceRegistration& sr);
+
+
   /**
    * Service ranking changed, reorder registered services
    * according to ranking.
@@ -181,7 +227,31 @@ public:
 
 private:
 
-  QList<ctkServiceReference> get_unlocked(const QString& clazz, const QString& filter,
+  std::shared_ptr<const Snapshot> currentSnapshot;
+
+  /**
+   * Guards the copy and the replacement of the currentSnapshot pointer.
+   * It is only held while the pointer is copied.
+   */
+  mutable QMutex snapshotMutex;
+
+  /**
+   * Publish a new snapshot. The mutex must be locked.
+   */
+  void publish(const std::shared_ptr<const Snapshot>& newSnapshot);
+
+  void addServiceRegistration(ctkPluginPrivate* plugin, const ctkServiceRegistration& res,
+                              const QStringList& classes);
+
+  void insertServiceRegistration(const ctkServiceRegistration& res, const QStringList& classes);
+
+  void sendRegisteredEvent(ctkPluginPrivate* plugin, const ctkServiceRegistration& res);
+
+  void bindDeclaredService(ctkServiceRegistration& declared, QObject* service,
+                           const ctkDictionary& properties);
+
+  QList<ctkServiceReference> get_unlocked(const Snapshot& snapshot,
+                                          const QString& clazz, const QString& filter,
                                           ctkPluginPrivate* plugin) const;
 
 };
@@ -223,10 +223,6 @@ void ctkEAConfiguration::startOrUpdate()
   CTK_DEBUG(ctkEventAdminActivator::getLogService())
       << PROP_REQUIRE_TOPIC << "=" << requireTopic;
 
-  ctkEventAdminService::TopicHandlerFiltersInterface* topicHandlerFilters =
-      new ctkEventAdminService::TopicHandlerFilters(
-        new ctkEventAdminService::TopicCacheMap(cacheSize), requireTopic);
-
   ctkEventAdminService::FiltersInterface* filters =
       new ctkEventAdminService::Filters(
         new ctkEventAdminService::LDAPCacheMap(cacheSize), pluginContext);
@@ -260,7 +256,7 @@ void ctkEAConfiguration::startOrUpdate()
   // below (and not in this HandlerTasks object!)
   ctkEventAdminService::HandlerTasksInterface* handlerTasks =
       new ctkEventAdminService::BlacklistingHandlerTasks(
-        pluginContext, new ctkEventAdminService::BlackList(), topicHandlerFilters, filters);
+        pluginContext, new ctkEventAdminService::BlackList(), requireTopic, filters);
 
   if (admin == 0)
   {
@@ -31,7 +31,6 @@
 
 #include "handler/ctkEACleanBlackList_p.h"
 #include "util/ctkEALeastRecentlyUsedCacheMap_p.h"
-#include "handler/ctkEACacheTopicHandlerFilters_p.h"
 #include "handler/ctkEACacheFilters_p.h"
 #include "tasks/ctkEASyncDeliverTasks_p.h"
 #include "tasks/ctkEAAsyncDeliverTasks_p.h"
@@ -49,14 +48,11 @@ public:
   typedef ctkEACleanBlackList BlackList;
   typedef ctkEABlackList<BlackList> BlackListInterface;
 
-  typedef ctkEALeastRecentlyUsedCacheMap<QString, QString> TopicCacheMap;
-  typedef ctkEACacheTopicHandlerFilters<TopicCacheMap> TopicHandlerFilters;
-  typedef ctkEATopicHandlerFilters<TopicHandlerFilters> TopicHandlerFiltersInterface;
   typedef ctkEALeastRecentlyUsedCacheMap<QString, ctkLDAPSearchFilter> LDAPCacheMap;
   typedef ctkEACacheFilters<LDAPCacheMap> Filters;
   typedef ctkEAFilters<Filters> FiltersInterface;
 
-  typedef ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> BlacklistingHandlerTasks;
+  typedef ctkEABlacklistingHandlerTasks<BlackList, Filters> BlacklistingHandlerTasks;
   typedef ctkEAHandlerTasks<BlacklistingHandlerTasks> HandlerTasksInterface;
 
   typedef ctkEAHandlerTask<BlacklistingHandlerTasks> HandlerTask;
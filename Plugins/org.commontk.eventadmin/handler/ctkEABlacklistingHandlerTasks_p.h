@@ -30,28 +30,27 @@
 #include <service/event/ctkEventConstants.h>
 #include <service/event/ctkEventHandler.h>
 
-#include "ctkEATopicHandlerFilters_p.h"
+#include "ctkEATopicHandlerIndex_p.h"
 #include "ctkEAFilters_p.h"
 #include "ctkEABlackList_p.h"
 
 /**
  * This class is an implementation of the ctkEAHandlerTasks interface that does provide
- * blacklisting of event handlers. Furthermore, handlers are determined from the
- * framework on any call to <tt>createHandlerTasks()</tt> hence, there is no
- * book-keeping of <tt>ctkEventHandler</tt> services while they come and go but a
- * query for each sent event. In order to do this, an ldap-filter is created that
- * will match applicable <tt>ctkEventHandler</tt> references. In order to ease some of
- * the overhead pains of this approach some light caching is going on.
+ * blacklisting of event handlers. Furthermore, handlers are looked up in a
+ * <tt>ctkEATopicHandlerIndex</tt> that keeps track of the <tt>ctkEventHandler</tt>
+ * services while they come and go, hence there is no query of the framework for
+ * each sent event. The EVENT_FILTER of each handler is compiled when the handler
+ * is indexed.
  */
-template<class BlackList, class TopicHandlerFilters, class Filters>
+template<class BlackList, class Filters>
 class ctkEABlacklistingHandlerTasks :
     public ctkEAHandlerTasks<
-    ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> >
+    ctkEABlacklistingHandlerTasks<BlackList, Filters> >
 {
 
 private:
 
-  typedef ctkEABlacklistingHandlerTasks<BlackList, TopicHandlerFilters, Filters> Self;
+  typedef ctkEABlacklistingHandlerTasks<BlackList, Filters> Self;
 
   // The blacklist that holds blacklisted event handler service references
   ctkEABlackList<BlackList>* const blackList;
@@ -59,14 +58,35 @@ private:
   // The context of the plugin used to get the actual event handler services
   ctkPluginContext* const context;
 
-  // Used to create the filters that can determine applicable event handlers for
-  // a given event
-  ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters;
-
   // Used to create the filters that are used to determine whether an applicable
   // event handler is interested in a particular event
   ctkEAFilters<Filters>* filters;
 
+  /*
+   * The index of the event handlers that compiles the EVENT_FILTER of the
+   * handlers with the filters factory
+   */
+  class FiltersTopicHandlerIndex : public ctkEATopicHandlerIndex
+  {
+  public:
+    FiltersTopicHandlerIndex(ctkPluginContext* context, bool requireTopic,
+                             ctkEAFilters<Filters>* filters)
+      : ctkEATopicHandlerIndex(context, requireTopic), filters(filters)
+    {}
+
+  protected:
+    ctkLDAPSearchFilter createFilter(const QString& filter)
+    {
+      return filters->createFilter(filter);
+    }
+
+  private:
+    ctkEAFilters<Filters>* filters;
+  };
+
+  // Used to determine the applicable event handlers for a given event
+  FiltersTopicHandlerIndex* topicHandlerIndex;
+
 public:
 
   /**
@@ -74,12 +94,12 @@ public:
    *
    * @param context The context of the plugin
    * @param blackList The set to use for keeping track of blacklisted references
-   * @param topicHandlerFilters The factory for topic handler filters
+   * @param requireTopic Ignore handlers that do not provide a topic
    * @param filters The factory for <tt>ctkLDAPSearchFilter</tt> objects
    */
   ctkEABlacklistingHandlerTasks(ctkPluginContext* context,
                                 ctkEABlackList<BlackList>* blackList,
-                                ctkEATopicHandlerFilters<TopicHandlerFilters>* topicHandlerFilters,
+                                bool requireTopic,
                                 ctkEAFilters<Filters>* filters);
 
   ~ctkEABlacklistingHandlerTasks();
@@ -0,0 +1,305 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#include "ctkEATopicHandlerIndex_p.h"
+
+#include <ctkException.h>
+#include <ctkPluginConstants.h>
+#include <ctkPluginContext.h>
+#include <service/event/ctkEventConstants.h>
+#include <service/event/ctkEventHandler.h>
+
+#include <QReadLocker>
+#include <QWriteLocker>
+
+struct ctkEATopicHandlerIndex::Node
+{
+  // The child nodes by topic token
+  QHash<QString, Node*> children;
+
+  // The handlers whose topic ends at this node
+  QList<HandlerPtr> handlers;
+
+  // The handlers whose topic is the path of this node followed by "/*"
+  QList<HandlerPtr> wildcardHandlers;
+
+  ~Node()
+  {
+    qDeleteAll(children);
+  }
+
+  bool isEmpty() const
+  {
+    return children.isEmpty() && handlers.isEmpty() && wildcardHandlers.isEmpty();
+  }
+};
+
+namespace {
+
+// Split a handler topic into the tokens of the trie path and tell
+// whether the topic ends with a wildcard
+QStringList splitHandlerTopic(const QString& topic, bool& wildcard)
+{
+  wildcard = false;
+  if (topic == QLatin1String("*"))
+  {
+    wildcard = true;
+    return QStringList();
+  }
+  QStringList tokens = topic.split('/');
+  if (tokens.size() > 1 && tokens.last() == QLatin1String("*"))
+  {
+    wildcard = true;
+    tokens.removeLast();
+  }
+  return tokens;
+}
+
+// Append the handler unless a handler registered with several topics
+// was already found
+void appendHandlers(QList<ctkEATopicHandlerIndex::HandlerPtr>& result,
+                    const QList<ctkEATopicHandlerIndex::HandlerPtr>& handlers)
+{
+  foreach (const ctkEATopicHandlerIndex::HandlerPtr& handler, handlers)
+  {
+    if (handler->topics.size() < 2 || !result.contains(handler))
+    {
+      result.push_back(handler);
+    }
+  }
+}
+
+}
+
+ctkEATopicHandlerIndex::ctkEATopicHandlerIndex(ctkPluginContext* context, bool requireTopic)
+  : context(context), requireTopic(requireTopic), isOpen(false), root(new Node())
+{
+}
+
+ctkEATopicHandlerIndex::~ctkEATopicHandlerIndex()
+{
+  close();
+  delete root;
+}
+
+void ctkEATopicHandlerIndex::open()
+{
+  if (isOpen)
+  {
+    return;
+  }
+  isOpen = true;
+
+  // Connect first so that handlers registered in the meantime are not missed
+  context->connectServiceListener(this, "serviceChanged",
+                                  QString("(") + ctkPluginConstants::OBJECTCLASS + "="
+                                  + qobject_interface_iid<ctkEventHandler*>() + ")");
+
+  QList<ctkServiceReference> refs = context->getServiceReferences<ctkEventHandler>();
+  QWriteLocker l(&lock);
+  foreach (const ctkServiceReference& ref, refs)
+  {
+    if (!handlers.contains(getServiceId(ref)))
+    {
+      addHandler(ref);
+    }
+  }
+}
+
+void ctkEATopicHandlerIndex::close()
+{
+  if (!isOpen)
+  {
+    return;
+  }
+  isOpen = false;
+
+  context->disconnectServiceListener(this, "serviceChanged");
+
+  QWriteLocker l(&lock);
+  delete root;
+  root = new Node();
+  allTopicsHandlers.clear();
+  handlers.clear();
+}
+
+QList<ctkEATopicHandlerIndex::HandlerPtr> ctkEATopicHandlerIndex::getHandlers(const QString& topic) const
+{
+  // As a simple example, the handlers of the topic org/commontk/TEST are the
+  // wildcard handlers of the root (topic=*), of org (topic=org/*) and of
+  // org/commontk (topic=org/commontk/*) and the handlers of org/commontk/TEST
+  QList<HandlerPtr> result;
+  QStringList tokens = topic.split('/');
+
+  QReadLocker l(&lock);
+  result = allTopicsHandlers;
+  const Node* node = root;
+  foreach (const QString& token, tokens)
+  {
+    appendHandlers(result, node->wildcardHandlers);
+    node = node->children.value(token);
+    if (!node)
+    {
+      return result;
+    }
+  }
+  appendHandlers(result, node->handlers);
+  return result;
+}
+
+int ctkEATopicHandlerIndex::size() const
+{
+  QReadLocker l(&lock);
+  return handlers.size();
+}
+
+ctkLDAPSearchFilter ctkEATopicHandlerIndex::createFilter(const QString& filter)
+{
+  return ctkLDAPSearchFilter(filter);
+}
+
+void ctkEATopicHandlerIndex::serviceChanged(const ctkServiceEvent& event)
+{
+  QWriteLocker l(&lock);
+  switch (event.getType())
+  {
+  case ctkServiceEvent::REGISTERED:
+  case ctkServiceEvent::MODIFIED:
+    // The topics or the filter of a modified handler may have changed,
+    // addHandler() replaces the indexed handler
+    addHandler(event.getServiceReference());
+    break;
+  case ctkServiceEvent::UNREGISTERING:
+  case ctkServiceEvent::MODIFIED_ENDMATCH:
+    removeHandler(event.getServiceReference());
+    break;
+  }
+}
+
+void ctkEATopicHandlerIndex::addHandler(const ctkServiceReference& ref)
+{
+  QSharedPointer<Handler> handler(new Handler());
+  handler->ref = ref;
+
+  QVariant topics = ref.getProperty(ctkEventConstants::EVENT_TOPIC);
+  handler->topics = topics.toStringList();
+  if (handler->topics.isEmpty() && !topics.toString().isEmpty())
+  {
+    handler->topics << topics.toString();
+  }
+
+  QString filter = ref.getProperty(ctkEventConstants::EVENT_FILTER).toString();
+  if (!filter.isEmpty())
+  {
+    try
+    {
+      handler->filter = createFilter(filter);
+    }
+    catch (const ctkInvalidArgumentException& e)
+    {
+      handler->filterError = e.what();
+    }
+  }
+
+  removeHandler(ref);
+  handlers.insert(getServiceId(ref), handler);
+
+  if (!topics.isValid())
+  {
+    if (!requireTopic)
+    {
+      allTopicsHandlers.push_back(handler);
+    }
+    return;
+  }
+  foreach (const QString& topic, handler->topics)
+  {
+    insertTopic(topic, handler);
+  }
+}
+
+void ctkEATopicHandlerIndex::removeHandler(const ctkServiceReference& ref)
+{
+  HandlerPtr handler = handlers.take(getServiceId(ref));
+  if (!handler)
+  {
+    return;
+  }
+  allTopicsHandlers.removeAll(handler);
+  foreach (const QString& topic, handler->topics)
+  {
+    removeTopic(topic, handler);
+  }
+}
+
+void ctkEATopicHandlerIndex::insertTopic(const QString& topic, const HandlerPtr& handler)
+{
+  bool wildcard = false;
+  QStringList tokens = splitHandlerTopic(topic, wildcard);
+  Node* node = root;
+  foreach (const QString& token, tokens)
+  {
+    Node*& child = node->children[token];
+    if (!child)
+    {
+      child = new Node();
+    }
+    node = child;
+  }
+  QList<HandlerPtr>& nodeHandlers = wildcard ? node->wildcardHandlers : node->handlers;
+  if (!nodeHandlers.contains(handler))
+  {
+    nodeHandlers.push_back(handler);
+  }
+}
+
+void ctkEATopicHandlerIndex::removeTopic(const QString& topic, const HandlerPtr& handler)
+{
+  bool wildcard = false;
+  QStringList tokens = splitHandlerTopic(topic, wildcard);
+  QList<Node*> path;
+  Node* node = root;
+  foreach (const QString& token, tokens)
+  {
+    path.push_back(node);
+    node = node->children.value(token);
+    if (!node)
+    {
+      return;
+    }
+  }
+  (wildcard ? node->wildcardHandlers : node->handlers).removeAll(handler);
+
+  // Remove the nodes that are not used anymore
+  for (int i = tokens.size() - 1; i >= 0 && node->isEmpty(); --i)
+  {
+    Node* parent = path.at(i);
+    delete parent->children.take(tokens.at(i));
+    node = parent;
+  }
+}
+
+qlonglong ctkEATopicHandlerIndex::getServiceId(const ctkServiceReference& ref)
+{
+  return ref.getProperty(ctkPluginConstants::SERVICE_ID).toLongLong();
+}
@@ -0,0 +1,161 @@
+/*=============================================================================
+
+  Library: CTK
+
+  Copyright (c) German Cancer Research Center,
+    Division of Medical and Biological Informatics
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+=============================================================================*/
+
+
+
+#ifndef CTKEATOPICHANDLERINDEX_P_H
+#define CTKEATOPICHANDLERINDEX_P_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QStringList>
+
+#include <ctkLDAPSearchFilter.h>
+#include <ctkServiceEvent.h>
+#include <ctkServiceReference.h>
+
+class ctkPluginContext;
+
+/**
+ * An index of the registered <tt>ctkEventHandler</tt> services by topic. The index
+ * is a trie of topic tokens (the parts of a topic separated by <tt>/</tt>) that is
+ * maintained from the service events of the handlers. Handlers registered with a
+ * topic ending with <tt>/*</tt> (or with the <tt>*</tt> topic) are stored as wildcard
+ * handlers of the node of the topic prefix. The handlers of a topic are therefore
+ * resolved in a number of steps that only depends on the number of tokens of the
+ * topic, instead of evaluating a topic filter against every handler.
+ *
+ * The <tt>EVENT_FILTER</tt> of a handler is compiled once, when the handler is
+ * added to the index.
+ *
+ * The index is thread safe.
+ */
+class ctkEATopicHandlerIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+
+  /**
+   * An indexed event handler.
+   */
+  struct Handler
+  {
+    // The service reference of the handler
+    ctkServiceReference ref;
+
+    // The topics of the handler
+    QStringList topics;
+
+    // The compiled EVENT_FILTER of the handler, or a null filter if the handler
+    // has no EVENT_FILTER
+    ctkLDAPSearchFilter filter;
+
+    // The error message if the EVENT_FILTER of the handler is invalid
+    QString filterError;
+  };
+
+  typedef QSharedPointer<const Handler> HandlerPtr;
+
+  /**
+   * The constructor of the index. The index is empty until <tt>open()</tt>
+   * is called.
+   *
+   * @param context The context of the plugin used to track the event handlers
+   * @param requireTopic Ignore handlers that do not provide a topic
+   */
+  ctkEATopicHandlerIndex(ctkPluginContext* context, bool requireTopic);
+
+  ~ctkEATopicHandlerIndex();
+
+  /**
+   * Start tracking the event handler services and add the registered ones
+   * to the index.
+   */
+  void open();
+
+  /**
+   * Stop tracking the event handler services and clear the index.
+   */
+  void close();
+
+  /**
+   * Get the handlers registered for the given topic.
+   *
+   * @param topic The topic of an event
+   *
+   * @return The handlers of the topic, each handler appears once
+   */
+  QList<HandlerPtr> getHandlers(const QString& topic) const;
+
+  /**
+   * Get the number of indexed handlers.
+   */
+  int size() const;
+
+protected:
+
+  /**
+   * Compile the EVENT_FILTER of a handler.
+   *
+   * @param filter The non-empty filter string
+   * @throws ctkInvalidArgumentException if the filter string is invalid
+   */
+  virtual ctkLDAPSearchFilter createFilter(const QString& filter);
+
+protected Q_SLOTS:
+
+  void serviceChanged(const ctkServiceEvent& event);
+
+private:
+
+  struct Node;
+
+  ctkPluginContext* const context;
+
+  const bool requireTopic;
+
+  bool isOpen;
+
+  mutable QReadWriteLock lock;
+
+  // The root of the topic trie
+  Node* root;
+
+  // Handlers without topic, delivered all the events unless a topic is required
+  QList<HandlerPtr> allTopicsHandlers;
+
+  // The indexed handlers by service id
+  QHash<qlonglong, HandlerPtr> handlers;
+
+  void addHandler(const ctkServiceReference& ref);
+  void removeHandler(const ctkServiceReference& ref);
+
+  void insertTopic(const QString& topic, const HandlerPtr& handler);
+  void removeTopic(const QString& topic, const HandlerPtr& handler);
+
+  static qlonglong getServiceId(const ctkServiceReference& ref);
+};
+
+#endif // CTKEATOPICHANDLERINDEX_P_H